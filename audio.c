@@ -6,13 +6,14 @@
 #include "vera_psg.h"
 #include "vera_pcm.h"
 #include "ym2151.h"
+#include "machine.h"
+#include "runahead.h"
+#include "lockstep.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-#define SAMPLERATE (25000000 / 512)
-
 #ifdef __EMSCRIPTEN__
 	#define SAMPLES_PER_BUFFER (1024)
 #else
@@ -20,14 +21,20 @@
 #endif
 
 static SDL_AudioDeviceID audio_dev;
-static int               vera_clks = 0;
-static int               cpu_clks  = 0;
 static int16_t **        buffers;
 static int               rdidx    = 0;
 static int               wridx    = 0;
 static int               buf_cnt  = 0;
 static int               num_bufs = 0;
 
+// where the sound goes instead of the device, on this thread (for libx16emu)
+static THREAD_LOCAL audio_sink_t sink;
+static THREAD_LOCAL void *sink_user;
+
+// rendering position of the current machine
+#define vera_clks (machine->audio.vera_clks)
+#define cpu_clks  (machine->audio.cpu_clks)
+
 static void
 audio_callback(void *userdata, Uint8 *stream, int len)
 {
@@ -76,7 +83,7 @@ audio_init(const char *dev_name, int num_audio_buffers)
 
 	// Setup SDL audio
 	memset(&desired, 0, sizeof(desired));
-	desired.freq     = SAMPLERATE;
+	desired.freq     = AUDIO_SAMPLERATE;
 	desired.format   = AUDIO_S16SYS;
 	desired.samples  = SAMPLES_PER_BUFFER;
 	desired.channels = 2;
@@ -131,40 +138,89 @@ audio_render(int cpu_clocks)
 	while (vera_clks >= 512 * SAMPLES_PER_BUFFER) {
 		vera_clks -= 512 * SAMPLES_PER_BUFFER;
 
-		if (audio_dev != 0) {
-			int16_t psg_buf[2 * SAMPLES_PER_BUFFER];
-			psg_render(psg_buf, SAMPLES_PER_BUFFER);
+		// the chips run even without a device: the PCM FIFO has to drain
+		int16_t psg_buf[2 * SAMPLES_PER_BUFFER];
+		psg_render(psg_buf, SAMPLES_PER_BUFFER);
 
-			int16_t pcm_buf[2 * SAMPLES_PER_BUFFER];
-			pcm_render(pcm_buf, SAMPLES_PER_BUFFER);
+		int16_t pcm_buf[2 * SAMPLES_PER_BUFFER];
+		pcm_render(pcm_buf, SAMPLES_PER_BUFFER);
 
-			int16_t ym_buf[2 * SAMPLES_PER_BUFFER];
-			YM_stream_update((uint16_t *)ym_buf, SAMPLES_PER_BUFFER);
+		int16_t ym_buf[2 * SAMPLES_PER_BUFFER];
+		YM_stream_update((uint16_t *)ym_buf, SAMPLES_PER_BUFFER);
 
-			bool buf_available;
-			SDL_LockAudioDevice(audio_dev);
-			buf_available = buf_cnt < num_bufs;
-			SDL_UnlockAudioDevice(audio_dev);
+		if (runahead_speculating() || lockstep_checking()) {
+			continue;
+		}
+		if (sink) {
+			int16_t buf[2 * SAMPLES_PER_BUFFER];
+			for (int i = 0; i < 2 * SAMPLES_PER_BUFFER; i++) {
+				buf[i] = ((int)psg_buf[i] + (int)pcm_buf[i] + (int)ym_buf[i]) / 3;
+			}
+			sink(buf, SAMPLES_PER_BUFFER, sink_user);
+			continue;
+		}
+		if (audio_dev == 0) {
+			continue;
+		}
 
-			if (buf_available) {
-				// Mix PSG, PCM and YM output
-				int16_t *buf = buffers[wridx];
-				for (int i = 0; i < 2 * SAMPLES_PER_BUFFER; i++) {
-					buf[i] = ((int)psg_buf[i] + (int)pcm_buf[i] + (int)ym_buf[i]) / 3;
-				}
-
-				SDL_LockAudioDevice(audio_dev);
-				wridx++;
-				if (wridx == num_bufs) {
-					wridx = 0;
-				}
-				buf_cnt++;
-				SDL_UnlockAudioDevice(audio_dev);
+		bool buf_available;
+		SDL_LockAudioDevice(audio_dev);
+		buf_available = buf_cnt < num_bufs;
+		SDL_UnlockAudioDevice(audio_dev);
+
+		if (buf_available) {
+			// Mix PSG, PCM and YM output
+			int16_t *buf = buffers[wridx];
+			for (int i = 0; i < 2 * SAMPLES_PER_BUFFER; i++) {
+				buf[i] = ((int)psg_buf[i] + (int)pcm_buf[i] + (int)ym_buf[i]) / 3;
 			}
+
+			SDL_LockAudioDevice(audio_dev);
+			wridx++;
+			if (wridx == num_bufs) {
+				wridx = 0;
+			}
+			buf_cnt++;
+			SDL_UnlockAudioDevice(audio_dev);
 		}
 	}
 }
 
+// Passes the sound of the machines run on this thread to a function instead
+// of the device, as stereo frames at AUDIO_SAMPLERATE; NULL for the device.
+void
+audio_set_sink(audio_sink_t s, void *user)
+{
+	sink = s;
+	sink_user = user;
+}
+
+// CPU clocks until audio_render() renders the next buffer, the only time the
+// PCM FIFO (and so the AFLOW IRQ) changes; may be early, never late
+int
+audio_cycles_to_render(void)
+{
+	int missing = 512 * SAMPLES_PER_BUFFER - vera_clks;
+	int cycles = (missing + 24) / 25 * 8 - cpu_clks;
+	return cycles > 1 ? cycles : 1;
+}
+
+// Microseconds of sound queued beyond half of the buffers, negative if
+// there is less; 0 without a device
+int32_t
+audio_ahead_usec(void)
+{
+	if (audio_dev == 0) {
+		return 0;
+	}
+
+	SDL_LockAudioDevice(audio_dev);
+	int queued = buf_cnt;
+	SDL_UnlockAudioDevice(audio_dev);
+
+	return (int32_t)((int64_t)(2 * queued - num_bufs) * SAMPLES_PER_BUFFER * 1000000 / (2 * AUDIO_SAMPLERATE));
+}
+
 void
 audio_usage(void)
 {
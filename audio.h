@@ -6,8 +6,20 @@
 
 #include <SDL.h>
 
+#define AUDIO_SAMPLERATE (25000000 / 512)
+
+typedef struct {
+	int vera_clks; // VERA clocks not yet rendered
+	int cpu_clks;  // CPU clocks not yet converted to VERA clocks
+} audio_state_t;
+
+typedef void (*audio_sink_t)(const int16_t *samples, int frames, void *user);
+
 void audio_init(const char *dev_name, int num_audio_buffers);
 void audio_close(void);
 void audio_render(int cpu_clocks);
+void audio_set_sink(audio_sink_t s, void *user);
+int audio_cycles_to_render(void);
+int32_t audio_ahead_usec(void);
 
 void audio_usage(void);
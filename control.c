@@ -0,0 +1,626 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef __APPLE__
+#define _XOPEN_SOURCE   700
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glue.h"
+#include "machine.h"
+#include "control.h"
+
+// -control listens on a Unix socket for one client at a time, which can stop
+// and run the machine, read and write its memory and registers, load
+// programs, take screenshots and set breakpoints. The emulator looks for
+// commands at the end of every frame; while the machine is stopped, it
+// serves them right away.
+//
+// Every command is a 12 byte header: the command, a bank, two zero bytes,
+// then a 32 bit address and a 32 bit length, little-endian. WRITE,
+// WRITE_VRAM, SET_REGS and LOAD_PRG are followed by length bytes of data.
+// Every reply is an 8 byte header: a status (0: OK, 1: unknown command,
+// 2: failed), why the machine is stopped (0 if it runs), two zero bytes and
+// the 32 bit length of the data that follows.
+//
+// PAUSE      stop at the end of the frame; replies once stopped
+// RESUME     run on; replies right away
+// RUN        run address frames (0: until a breakpoint) and stop; replies
+//            once stopped
+// STEP       run address instructions and stop; replies once stopped
+// READ       length bytes from address on, as the CPU sees them with the RAM
+//            (at $A000) or ROM (at $C000) bank given; I/O without side
+//            effects
+// WRITE      the data to address on; banked RAM like READ, I/O as the CPU
+//            writes it, not to ROM
+// READ_VRAM  length bytes of VRAM from address on
+// WRITE_VRAM the data to VRAM from address on
+// GET_REGS   the registers (see get_regs())
+// SET_REGS   them; the stop reason and clock are ignored
+// LOAD_PRG   the PRG file at the path in the data, at its own load address
+//            or at address if that is below $10000; replies with the 16 bit
+//            start and end
+// SCREEN     the framebuffer, 640x480 pixels of 32 bit 0x00RRGGBB in host
+//            byte order; below the line VERA is on, it still holds the
+//            frame before
+// BREAK      stop before the CPU executes address with the bank given
+//            mapped ($FF: any); fails above $FFFF and for banks that don't
+//            exist
+// UNBREAK    remove that breakpoint again
+//
+// The replies to PAUSE, RUN and STEP carry the registers. Nothing the client
+// does is recorded by -record.
+
+#define CONTROL_PAUSE      0x01
+#define CONTROL_RESUME     0x02
+#define CONTROL_RUN        0x03
+#define CONTROL_STEP       0x04
+#define CONTROL_READ       0x10
+#define CONTROL_WRITE      0x11
+#define CONTROL_READ_VRAM  0x12
+#define CONTROL_WRITE_VRAM 0x13
+#define CONTROL_GET_REGS   0x20
+#define CONTROL_SET_REGS   0x21
+#define CONTROL_LOAD_PRG   0x30
+#define CONTROL_SCREEN     0x40
+#define CONTROL_BREAK      0x50
+#define CONTROL_UNBREAK    0x51
+
+#define STATUS_OK          0
+#define STATUS_UNKNOWN     1
+#define STATUS_FAILED      2
+
+// why the machine is stopped
+#define STOP_NONE          0
+#define STOP_PAUSE         1
+#define STOP_FRAMES        2
+#define STOP_STEPS         3
+#define STOP_BREAKPOINT    4
+
+#define COMMAND_SIZE 12
+#define REPLY_SIZE 8
+#define REGS_SIZE 16
+#define MAX_LENGTH (16 << 20) // of the data of a command or reply
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+bool
+control_init(const char *path)
+{
+	printf("-control is not supported on this platform.\n");
+	return false;
+}
+
+void
+control_close()
+{
+}
+
+bool
+control_active()
+{
+	return false;
+}
+
+void
+control_frame()
+{
+}
+
+bool
+control_stopped()
+{
+	return false;
+}
+
+bool
+control_stepping()
+{
+	return false;
+}
+
+bool
+control_serve()
+{
+	return true;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "rom_symbols.h"
+#include "runahead.h"
+#include "lockstep.h"
+#include "loadsave.h"
+
+// milliseconds to wait for a command at a time while stopped, between
+// looking whether the emulator is to quit
+#define WAIT_MS 20
+
+static struct {
+	int fd; // listening
+	int client; // -1 if none
+	char *path;
+
+	uint8_t *data; // of the current command or reply
+	uint32_t data_size;
+
+	int stop; // why the machine is stopped, STOP_NONE while it runs
+	bool reply_stop; // the client waits for it to stop
+	uint32_t frames; // left to run, 0 for no limit
+	uint32_t steps; // instructions to run, 0 if not stepping
+	uint32_t step_from; // cpu->instructions when they started
+
+	// where the machine last went on from, so a breakpoint there doesn't
+	// stop it again before it executed anything
+	uint16_t resume_pc;
+	uint32_t resume_instructions;
+} control = { -1, -1 };
+
+// Listens on a Unix socket at path, replacing whatever was there.
+bool
+control_init(const char *path)
+{
+	struct sockaddr_un address;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		printf("The socket path %s is too long!\n", path);
+		return false;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	control.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (control.fd < 0) {
+		perror("socket");
+		return false;
+	}
+	unlink(path);
+	if (bind(control.fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(control.fd, 1) < 0) {
+		perror(path);
+		close(control.fd);
+		control.fd = -1;
+		return false;
+	}
+	fcntl(control.fd, F_SETFL, fcntl(control.fd, F_GETFL) | O_NONBLOCK);
+	control.path = strdup(path);
+
+	// a client that goes away mustn't take the emulator with it
+	signal(SIGPIPE, SIG_IGN);
+	return true;
+}
+
+void
+control_close()
+{
+	if (control.fd < 0) {
+		return;
+	}
+	if (control.client >= 0) {
+		close(control.client);
+		control.client = -1;
+	}
+	close(control.fd);
+	control.fd = -1;
+	if (control.path) {
+		unlink(control.path);
+		free(control.path);
+		control.path = NULL;
+	}
+	free(control.data);
+	control.data = NULL;
+	control.data_size = 0;
+}
+
+bool
+control_active()
+{
+	return control.fd >= 0;
+}
+
+static void
+stop(int reason)
+{
+	control.stop = reason;
+	control.frames = 0;
+	control.steps = 0;
+}
+
+static void
+go()
+{
+	control.stop = STOP_NONE;
+	control.resume_pc = machine->cpu.pc;
+	control.resume_instructions = machine->cpu.instructions;
+}
+
+// The client went away. The machine runs on without it.
+static void
+disconnect()
+{
+	close(control.client);
+	control.client = -1;
+	control.reply_stop = false;
+	stop(STOP_NONE);
+	go();
+}
+
+static bool
+read_all(void *data, uint32_t length)
+{
+	uint8_t *p = data;
+	while (length) {
+		ssize_t n = read(control.client, p, length);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		length -= n;
+	}
+	return true;
+}
+
+static bool
+write_all(const void *data, uint32_t length)
+{
+	const uint8_t *p = data;
+	while (length) {
+		ssize_t n = write(control.client, p, length);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		length -= n;
+	}
+	return true;
+}
+
+static bool
+reply(int status, const void *data, uint32_t length)
+{
+	uint8_t header[REPLY_SIZE] = {
+		status, control.stop, 0, 0,
+		length, length >> 8, length >> 16, length >> 24
+	};
+	return write_all(header, sizeof(header)) && write_all(data, length);
+}
+
+// room for length bytes of data
+static uint8_t *
+buffer(uint32_t length)
+{
+	if (length > control.data_size) {
+		uint8_t *p = realloc(control.data, length);
+		if (!p) {
+			return NULL;
+		}
+		control.data = p;
+		control.data_size = length;
+	}
+	return control.data;
+}
+
+// pc, a, x, y, sp, p, whether in WAI, the RAM and ROM banks, why the machine
+// is stopped, a zero byte and the 32 bit CPU clock
+static void
+get_regs(uint8_t *r)
+{
+	const cpu6502_t *cpu = &machine->cpu;
+	uint32_t clock = cpu->clockticks6502;
+
+	r[0] = cpu->pc & 0xff;
+	r[1] = cpu->pc >> 8;
+	r[2] = cpu->a;
+	r[3] = cpu->x;
+	r[4] = cpu->y;
+	r[5] = cpu->sp;
+	r[6] = cpu->status;
+	r[7] = cpu->waiting;
+	r[8] = memory_get_ram_bank();
+	r[9] = memory_get_rom_bank();
+	r[10] = control.stop;
+	r[11] = 0;
+	r[12] = clock;
+	r[13] = clock >> 8;
+	r[14] = clock >> 16;
+	r[15] = clock >> 24;
+}
+
+static void
+set_regs(const uint8_t *r)
+{
+	cpu6502_t *cpu = &machine->cpu;
+
+	cpu->pc = r[0] | r[1] << 8;
+	cpu->a = r[2];
+	cpu->x = r[3];
+	cpu->y = r[4];
+	cpu->sp = r[5];
+	cpu->status = r[6];
+	cpu->waiting = r[7];
+	memory_set_ram_bank(r[8]);
+	memory_set_rom_bank(r[9]);
+}
+
+static void
+read_memory(uint8_t *p, uint32_t address, uint8_t bank, uint32_t length)
+{
+	for (uint32_t i = 0; i < length; i++) {
+		p[i] = real_read6502(address + i, true, bank);
+	}
+}
+
+static void
+write_memory(const uint8_t *p, uint32_t address, uint8_t bank, uint32_t length)
+{
+	uint8_t *RAM = machine->memory.RAM;
+	uint32_t bank_base = 0xa000 + (bank % num_ram_banks) * 8192;
+
+	for (uint32_t i = 0; i < length; i++) {
+		uint16_t a = address + i;
+		if (a < 0x9f00) {
+			RAM[a] = p[i];
+		} else if (a < 0xa000) {
+			write6502(a, p[i]);
+		} else if (a < 0xc000) {
+			RAM[bank_base + a - 0xa000] = p[i];
+		}
+	}
+	memory_invalidate_code();
+}
+
+// whether a breakpoint can be at address with the bank given mapped
+static bool
+valid_breakpoint(uint32_t address, uint8_t bank)
+{
+	if (address > 0xffff) {
+		return false;
+	}
+	if (bank == 0xff || address < 0xa000) {
+		return true;
+	}
+	return bank < (address < 0xc000 ? num_ram_banks : NUM_ROM_BANKS);
+}
+
+static void
+breakpoint()
+{
+	const cpu6502_t *cpu = &machine->cpu;
+
+	if (control.client < 0 || control.stop) {
+		return;
+	}
+	if (cpu->pc == control.resume_pc && cpu->instructions == control.resume_instructions) {
+		// it was just stopped here
+		return;
+	}
+	stop(STOP_BREAKPOINT);
+}
+
+// the client changed the machine
+static void
+changed()
+{
+	runahead_invalidate();
+	lockstep_invalidate();
+}
+
+// Reads and carries out a command. Returns false if the client is gone.
+static bool
+handle_command()
+{
+	uint8_t header[COMMAND_SIZE];
+	if (!read_all(header, sizeof(header))) {
+		return false;
+	}
+	int command = header[0];
+	uint8_t bank = header[1];
+	uint32_t address = header[4] | header[5] << 8 | header[6] << 16 | (uint32_t)header[7] << 24;
+	uint32_t length = header[8] | header[9] << 8 | header[10] << 16 | (uint32_t)header[11] << 24;
+	uint8_t regs[REGS_SIZE];
+	uint8_t *p = NULL;
+
+	switch (command) {
+		case CONTROL_WRITE:
+		case CONTROL_WRITE_VRAM:
+		case CONTROL_SET_REGS:
+		case CONTROL_LOAD_PRG:
+			// +1 for the terminator of a path
+			if (length > MAX_LENGTH || !(p = buffer(length + 1)) || !read_all(p, length)) {
+				return false;
+			}
+			break;
+		case CONTROL_READ:
+		case CONTROL_READ_VRAM:
+			if (length > MAX_LENGTH || !(p = buffer(length))) {
+				return false;
+			}
+			break;
+	}
+
+	switch (command) {
+		case CONTROL_PAUSE:
+			if (control.stop) {
+				get_regs(regs);
+				return reply(STATUS_OK, regs, sizeof(regs));
+			}
+			stop(STOP_PAUSE);
+			control.reply_stop = true;
+			return true;
+		case CONTROL_RESUME:
+			stop(STOP_NONE);
+			go();
+			return reply(STATUS_OK, NULL, 0);
+		case CONTROL_RUN:
+			stop(STOP_NONE);
+			go();
+			control.frames = address;
+			control.reply_stop = true;
+			return true;
+		case CONTROL_STEP:
+			stop(STOP_NONE);
+			go();
+			control.steps = address ? address : 1;
+			control.step_from = machine->cpu.instructions;
+			control.reply_stop = true;
+			return true;
+		case CONTROL_READ:
+			read_memory(p, address, bank, length);
+			return reply(STATUS_OK, p, length);
+		case CONTROL_WRITE:
+			write_memory(p, address, bank, length);
+			changed();
+			return reply(STATUS_OK, NULL, 0);
+		case CONTROL_READ_VRAM:
+			for (uint32_t i = 0; i < length; i++) {
+				p[i] = video_space_read((address + i) & 0x1ffff);
+			}
+			return reply(STATUS_OK, p, length);
+		case CONTROL_WRITE_VRAM:
+			for (uint32_t i = 0; i < length; i++) {
+				video_space_write((address + i) & 0x1ffff, p[i]);
+			}
+			changed();
+			return reply(STATUS_OK, NULL, 0);
+		case CONTROL_GET_REGS:
+			get_regs(regs);
+			return reply(STATUS_OK, regs, sizeof(regs));
+		case CONTROL_SET_REGS:
+			if (length < REGS_SIZE) {
+				return reply(STATUS_FAILED, NULL, 0);
+			}
+			set_regs(p);
+			changed();
+			return reply(STATUS_OK, NULL, 0);
+		case CONTROL_LOAD_PRG: {
+			p[length] = 0;
+			SDL_RWops *f = SDL_RWFromFile((char *)p, "rb");
+			uint16_t start, end;
+			if (!f || !load_prg(f, address <= 0xffff ? (int)address : -1, &start, &end)) {
+				return reply(STATUS_FAILED, NULL, 0);
+			}
+			regs[0] = start & 0xff;
+			regs[1] = start >> 8;
+			regs[2] = end & 0xff;
+			regs[3] = end >> 8;
+			changed();
+			return reply(STATUS_OK, regs, 4);
+		}
+		case CONTROL_SCREEN:
+			return reply(STATUS_OK, machine->video.framebuffer, sizeof(machine->video.framebuffer));
+		case CONTROL_BREAK:
+		case CONTROL_UNBREAK: {
+			if (!valid_breakpoint(address, bank)) {
+				return reply(STATUS_FAILED, NULL, 0);
+			}
+			int b = bank == 0xff ? MEMORY_ALL_BANKS : bank;
+			memory_remove_trap(address, b, breakpoint);
+			if (command == CONTROL_BREAK && !memory_add_trap(address, b, breakpoint)) {
+				return reply(STATUS_FAILED, NULL, 0);
+			}
+			// cached code doesn't know about the new breakpoint
+			free6502(&machine->cpu);
+			return reply(STATUS_OK, NULL, 0);
+		}
+		default:
+			return reply(STATUS_UNKNOWN, NULL, 0);
+	}
+}
+
+// Waits up to ms milliseconds for a client to connect or the one connected
+// to send something. Returns true if there is a command to read.
+static bool
+wait_command(int ms)
+{
+	if (control.client < 0) {
+		struct pollfd pfd = { control.fd, POLLIN, 0 };
+		if (poll(&pfd, 1, ms) <= 0) {
+			return false;
+		}
+		control.client = accept(control.fd, NULL, NULL);
+		if (control.client < 0) {
+			return false;
+		}
+		// the listening socket doesn't pass on O_NONBLOCK everywhere
+		fcntl(control.client, F_SETFL, fcntl(control.client, F_GETFL) & ~O_NONBLOCK);
+		ms = 0;
+	}
+	struct pollfd pfd = { control.client, POLLIN, 0 };
+	return poll(&pfd, 1, ms) > 0;
+}
+
+// Called at the end of every frame: counts the frames to run and carries out
+// the commands that have come in. Stopping is up to control_serve().
+void
+control_frame()
+{
+	if (control.fd < 0) {
+		return;
+	}
+	if (control.frames && !--control.frames) {
+		stop(STOP_FRAMES);
+	}
+	while (!control.stop && !control.reply_stop && wait_command(0)) {
+		if (!handle_command()) {
+			disconnect();
+		}
+	}
+}
+
+// Whether the machine is to stop before the next instruction.
+bool
+control_stopped()
+{
+	if (control.steps && machine->cpu.instructions - control.step_from >= control.steps) {
+		stop(STOP_STEPS);
+	}
+	return control.stop != STOP_NONE;
+}
+
+// Whether the machine has to run one instruction at a time.
+bool
+control_stepping()
+{
+	return control.steps != 0;
+}
+
+// Serves commands while the machine is stopped. Returns false if the
+// emulator is to quit.
+bool
+control_serve()
+{
+	if (control.reply_stop) {
+		uint8_t regs[REGS_SIZE];
+		get_regs(regs);
+		control.reply_stop = false;
+		if (!reply(STATUS_OK, regs, sizeof(regs))) {
+			disconnect();
+		}
+	}
+	while (control.stop) {
+		if (!video_idle()) {
+			return false;
+		}
+		if (wait_command(WAIT_MS) && !handle_command()) {
+			disconnect();
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,18 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _CONTROL_H_
+#define _CONTROL_H_
+
+#include <stdbool.h>
+
+bool control_init(const char *path);
+void control_close(void);
+bool control_active(void);
+void control_frame(void);
+bool control_stopped(void);
+bool control_stepping(void);
+bool control_serve(void);
+
+#endif
@@ -15,11 +15,11 @@
 //
 // *******************************************************************************************
 
-static void ind0() {
+static void ind0(cpu6502_t *cpu) {
     uint16_t eahelp, eahelp2;
-    eahelp = (uint16_t)read6502(pc++);
+    eahelp = (uint16_t)read6502(cpu->pc++);
     eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //zero-page wraparound
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
 }
 
 
@@ -29,17 +29,37 @@ static void ind0() {
 //
 // *******************************************************************************************
 
-static void ainx() { 		// absolute indexed branch
+static void ainx(cpu6502_t *cpu) { 		// absolute indexed branch
     uint16_t eahelp, eahelp2;
-    eahelp = (uint16_t)read6502(pc) | (uint16_t)((uint16_t)read6502(pc+1) << 8);
-    eahelp = (eahelp + (uint16_t)x) & 0xFFFF;
+    eahelp = (uint16_t)read6502(cpu->pc) | (uint16_t)((uint16_t)read6502(cpu->pc+1) << 8);
+    eahelp = (eahelp + (uint16_t)cpu->x) & 0xFFFF;
 #if 0
     eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //replicate 6502 page-boundary wraparound bug
 #else
     eahelp2 = eahelp + 1; // the 65c02 doesn't have the bug
 #endif
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    pc += 2;
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
+    cpu->pc += 2;
+}
+
+// *******************************************************************************************
+//
+//								Increment and decrement A
+//
+// *******************************************************************************************
+
+static void inca(cpu6502_t *cpu) {
+    cpu->a++;
+
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
+}
+
+static void deca(cpu6502_t *cpu) {
+    cpu->a--;
+
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
 }
 
 // *******************************************************************************************
@@ -48,8 +68,8 @@ static void ainx() { 		// absolute indexed branch
 //
 // *******************************************************************************************
 
-static void stz() {
-    putvalue(0);
+static void stz(cpu6502_t *cpu) {
+    putvalue(cpu, 0);
 }
 
 // *******************************************************************************************
@@ -58,11 +78,11 @@ static void stz() {
 //
 // *******************************************************************************************
 
-static void bra() {
-    oldpc = pc;
-    pc += reladdr;
-    if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-        else clockticks6502++;
+static void bra(cpu6502_t *cpu) {
+    cpu->oldpc = cpu->pc;
+    cpu->pc += cpu->reladdr;
+    if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+        else cpu->clockticks6502++;
 }
 
 // *******************************************************************************************
@@ -71,26 +91,26 @@ static void bra() {
 //
 // *******************************************************************************************
 
-static void phx() {
-    push8(x);
+static void phx(cpu6502_t *cpu) {
+    push8(cpu, cpu->x);
 }
 
-static void plx() {
-    x = pull8();
+static void plx(cpu6502_t *cpu) {
+    cpu->x = pull8(cpu);
    
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void phy() {
-    push8(y);
+static void phy(cpu6502_t *cpu) {
+    push8(cpu, cpu->y);
 }
 
-static void ply() {
-    y = pull8();
+static void ply(cpu6502_t *cpu) {
+    cpu->y = pull8(cpu);
   
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(cpu->y);
+    signcalc(cpu->y);
 }
 
 // *******************************************************************************************
@@ -99,20 +119,20 @@ static void ply() {
 //
 // *******************************************************************************************
 
-static void tsb() {
-    value = getvalue(); 							// Read memory
-    result = (uint16_t)a & value;  					// calculate A & memory
-    zerocalc(result); 								// Set Z flag from this.
-    result = value | a; 							// Write back value read, A bits are set.
-    putvalue(result);
+static void tsb(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu); 							// Read memory
+    cpu->result = (uint16_t)cpu->a & cpu->value;  					// calculate A & memory
+    zerocalc(cpu->result); 								// Set Z flag from this.
+    cpu->result = cpu->value | cpu->a; 							// Write back value read, A bits are set.
+    putvalue(cpu, cpu->result);
 }
 
-static void trb() {
-    value = getvalue(); 							// Read memory
-    result = (uint16_t)a & value;  					// calculate A & memory
-    zerocalc(result); 								// Set Z flag from this.
-    result = value & (a ^ 0xFF); 					// Write back value read, A bits are clear.
-    putvalue(result);
+static void trb(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu); 							// Read memory
+    cpu->result = (uint16_t)cpu->a & cpu->value;  					// calculate A & memory
+    zerocalc(cpu->result); 								// Set Z flag from this.
+    cpu->result = cpu->value & (cpu->a ^ 0xFF); 					// Write back value read, A bits are clear.
+    putvalue(cpu, cpu->result);
 }
 
 // *******************************************************************************************
@@ -121,7 +141,7 @@ static void trb() {
 //
 // *******************************************************************************************
 
-static void dbg() {
+static void dbg(cpu6502_t *cpu) {
     DEBUGBreakToDebugger();                          // Invoke debugger.
 }
 
@@ -131,8 +151,8 @@ static void dbg() {
 //
 // *******************************************************************************************
 
-static void wai() {
-	if (~status & FLAG_INTERRUPT) waiting = 1;
+static void wai(cpu6502_t *cpu) {
+	if (~cpu->status & FLAG_INTERRUPT) cpu->waiting = 1;
 }
 
 // *******************************************************************************************
@@ -140,43 +160,43 @@ static void wai() {
 //                                     BBR and BBS
 //
 // *******************************************************************************************
-static void bbr(uint16_t bitmask)
+static void bbr(cpu6502_t *cpu, uint16_t bitmask)
 {
-	if ((getvalue() & bitmask) == 0) {
-		oldpc = pc;
-		pc += reladdr;
-		if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-		else clockticks6502++;
+	if ((getvalue(cpu) & bitmask) == 0) {
+		cpu->oldpc = cpu->pc;
+		cpu->pc += cpu->reladdr;
+		if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+		else cpu->clockticks6502++;
 	}
 }
 
-static void bbr0() { bbr(0x01); }
-static void bbr1() { bbr(0x02); }
-static void bbr2() { bbr(0x04); }
-static void bbr3() { bbr(0x08); }
-static void bbr4() { bbr(0x10); }
-static void bbr5() { bbr(0x20); }
-static void bbr6() { bbr(0x40); }
-static void bbr7() { bbr(0x80); }
+static void bbr0(cpu6502_t *cpu) { bbr(cpu, 0x01); }
+static void bbr1(cpu6502_t *cpu) { bbr(cpu, 0x02); }
+static void bbr2(cpu6502_t *cpu) { bbr(cpu, 0x04); }
+static void bbr3(cpu6502_t *cpu) { bbr(cpu, 0x08); }
+static void bbr4(cpu6502_t *cpu) { bbr(cpu, 0x10); }
+static void bbr5(cpu6502_t *cpu) { bbr(cpu, 0x20); }
+static void bbr6(cpu6502_t *cpu) { bbr(cpu, 0x40); }
+static void bbr7(cpu6502_t *cpu) { bbr(cpu, 0x80); }
 
-static void bbs(uint16_t bitmask)
+static void bbs(cpu6502_t *cpu, uint16_t bitmask)
 {
-	if ((getvalue() & bitmask) != 0) {
-		oldpc = pc;
-		pc += reladdr;
-		if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-		else clockticks6502++;
+	if ((getvalue(cpu) & bitmask) != 0) {
+		cpu->oldpc = cpu->pc;
+		cpu->pc += cpu->reladdr;
+		if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+		else cpu->clockticks6502++;
 	}
 }
 
-static void bbs0() { bbs(0x01); }
-static void bbs1() { bbs(0x02); }
-static void bbs2() { bbs(0x04); }
-static void bbs3() { bbs(0x08); }
-static void bbs4() { bbs(0x10); }
-static void bbs5() { bbs(0x20); }
-static void bbs6() { bbs(0x40); }
-static void bbs7() { bbs(0x80); }
+static void bbs0(cpu6502_t *cpu) { bbs(cpu, 0x01); }
+static void bbs1(cpu6502_t *cpu) { bbs(cpu, 0x02); }
+static void bbs2(cpu6502_t *cpu) { bbs(cpu, 0x04); }
+static void bbs3(cpu6502_t *cpu) { bbs(cpu, 0x08); }
+static void bbs4(cpu6502_t *cpu) { bbs(cpu, 0x10); }
+static void bbs5(cpu6502_t *cpu) { bbs(cpu, 0x20); }
+static void bbs6(cpu6502_t *cpu) { bbs(cpu, 0x40); }
+static void bbs7(cpu6502_t *cpu) { bbs(cpu, 0x80); }
 
 // *******************************************************************************************
 //
@@ -184,20 +204,20 @@ static void bbs7() { bbs(0x80); }
 //
 // *******************************************************************************************
 
-static void smb0() { putvalue(getvalue() | 0x01); }
-static void smb1() { putvalue(getvalue() | 0x02); }
-static void smb2() { putvalue(getvalue() | 0x04); }
-static void smb3() { putvalue(getvalue() | 0x08); }
-static void smb4() { putvalue(getvalue() | 0x10); }
-static void smb5() { putvalue(getvalue() | 0x20); }
-static void smb6() { putvalue(getvalue() | 0x40); }
-static void smb7() { putvalue(getvalue() | 0x80); }
-
-static void rmb0() { putvalue(getvalue() & ~0x01); }
-static void rmb1() { putvalue(getvalue() & ~0x02); }
-static void rmb2() { putvalue(getvalue() & ~0x04); }
-static void rmb3() { putvalue(getvalue() & ~0x08); }
-static void rmb4() { putvalue(getvalue() & ~0x10); }
-static void rmb5() { putvalue(getvalue() & ~0x20); }
-static void rmb6() { putvalue(getvalue() & ~0x40); }
-static void rmb7() { putvalue(getvalue() & ~0x80); }
+static void smb0(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x01); }
+static void smb1(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x02); }
+static void smb2(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x04); }
+static void smb3(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x08); }
+static void smb4(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x10); }
+static void smb5(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x20); }
+static void smb6(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x40); }
+static void smb7(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) | 0x80); }
+
+static void rmb0(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x01); }
+static void rmb1(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x02); }
+static void rmb2(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x04); }
+static void rmb3(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x08); }
+static void rmb4(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x10); }
+static void rmb5(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x20); }
+static void rmb6(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x40); }
+static void rmb7(cpu6502_t *cpu) { putvalue(cpu, getvalue(cpu) & ~0x80); }
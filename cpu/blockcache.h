@@ -0,0 +1,181 @@
+// *******************************************************************************************
+// *******************************************************************************************
+//
+//		File:		blockcache.h
+//		Purpose:	Pre-decoded basic block cache.
+//
+//		Straight-line code is decoded once into arrays of micro-ops holding the
+//		opcode and its resolved operand, keyed by the pc and a tag
+//		from the memory system naming the host memory (and so the bank) the code was
+//		read from. The tag changes whenever that memory is written, which drops the
+//		blocks decoded from it. ROM is never written, so KERNAL and BASIC blocks stay
+//		cached for the whole run. Every CPU has a cache of its own.
+//
+// *******************************************************************************************
+// *******************************************************************************************
+
+#define BLOCKCACHE_SIZE 2048		// number of cached blocks, power of two
+#define BLOCK_MAX_OPS   16			// longest straight-line run per block
+
+typedef struct {
+    uint16_t operand;				// operand bytes as a little-endian word
+    uint16_t next;					// address of the following instruction
+    uint8_t opcode;
+} blockop;
+
+typedef struct {
+    uint8_t length;
+    uint8_t last;					// control never falls through to the next instruction
+    uint8_t cycles;
+    uint8_t mode;					// BM_* address mode
+    uint8_t action;					// BA_* instruction
+} blockinfo;
+
+typedef struct block {
+    uint64_t tag;
+    uint16_t pc;
+    uint8_t count;
+    blockop ops[BLOCK_MAX_OPS];
+
+    // JIT state
+    uint16_t hits;					// times executed by the interpreter
+    uint8_t nojit;					// can't be translated
+    uint8_t binary;					// native code assumes the D flag is clear
+    void (*native)();
+} block;
+
+uint8_t blockcache6502 = 0;
+
+// *******************************************************************************************
+//
+//					Address modes working on pre-decoded operands
+//
+// *******************************************************************************************
+
+static void bc_imp(cpu6502_t *cpu, const blockop *op) {
+}
+
+static void bc_acc(cpu6502_t *cpu, const blockop *op) {
+}
+
+static void bc_imm(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->next - 1;				// the operand byte itself
+}
+
+static void bc_zp(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->operand;
+}
+
+static void bc_zpx(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = (op->operand + (uint16_t)cpu->x) & 0xFF; //zero-page wraparound
+}
+
+static void bc_zpy(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = (op->operand + (uint16_t)cpu->y) & 0xFF; //zero-page wraparound
+}
+
+static void bc_rel(cpu6502_t *cpu, const blockop *op) {
+    cpu->reladdr = op->operand;
+    if (cpu->reladdr & 0x80) cpu->reladdr |= 0xFF00;
+}
+
+static void bc_abso(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->operand;
+}
+
+static void bc_absx(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->operand + (uint16_t)cpu->x;
+    if ((op->operand & 0xFF00) != (cpu->ea & 0xFF00)) cpu->penaltyaddr = 1;
+}
+
+static void bc_absy(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->operand + (uint16_t)cpu->y;
+    if ((op->operand & 0xFF00) != (cpu->ea & 0xFF00)) cpu->penaltyaddr = 1;
+}
+
+static void bc_ind(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = (uint16_t)read6502(op->operand) | ((uint16_t)read6502(op->operand + 1) << 8);
+}
+
+static void bc_indx(cpu6502_t *cpu, const blockop *op) {
+    uint16_t eahelp = (op->operand + (uint16_t)cpu->x) & 0xFF; //zero-page wraparound for table pointer
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502((eahelp + 1) & 0xFF) << 8);
+}
+
+static void bc_indy(cpu6502_t *cpu, const blockop *op) {
+    uint16_t startpage;
+    cpu->ea = (uint16_t)read6502(op->operand) | ((uint16_t)read6502((op->operand + 1) & 0xFF) << 8);
+    startpage = cpu->ea & 0xFF00;
+    cpu->ea += (uint16_t)cpu->y;
+    if (startpage != (cpu->ea & 0xFF00)) cpu->penaltyaddr = 1;
+}
+
+static void bc_ind0(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = (uint16_t)read6502(op->operand) | ((uint16_t)read6502((op->operand + 1) & 0xFF) << 8);
+}
+
+static void bc_ainx(cpu6502_t *cpu, const blockop *op) {
+    uint16_t eahelp = op->operand + (uint16_t)cpu->x;
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp + 1) << 8);
+}
+
+static void bc_zprel(cpu6502_t *cpu, const blockop *op) {
+    cpu->ea = op->operand & 0xFF;
+    cpu->reladdr = op->operand >> 8;
+    if (cpu->reladdr & 0x80) cpu->reladdr |= 0xFF00;
+}
+
+#include "blocktable.h"
+
+// *******************************************************************************************
+//
+//									Decode and lookup
+//
+// *******************************************************************************************
+
+static void blockdecode(block *b, uint16_t address, uint64_t tag) {
+    b->tag = tag;
+    b->pc = address;
+    b->count = 0;
+    b->hits = 0;
+    b->nojit = 0;
+    b->native = NULL;
+
+    while (b->count < BLOCK_MAX_OPS) {
+        // the host has to get control before a trap runs
+        if (b->count && memory_is_trap(address)) break;
+
+        uint8_t op = read6502(address);
+        const blockinfo *info = &blocktable[op];
+
+        // operands must come from the same page, it is the one the tag covers
+        if ((address & 0xFF) + info->length > 0x100) break;
+
+        blockop *bop = &b->ops[b->count++];
+        bop->opcode = op;
+        bop->next = address + info->length;
+        if (info->length == 2) {
+            bop->operand = read6502(address + 1);
+        } else if (info->length == 3) {
+            bop->operand = (uint16_t)read6502(address + 1) | ((uint16_t)read6502(address + 2) << 8);
+        } else {
+            bop->operand = 0;
+        }
+
+        if (info->last) break;
+        address = bop->next;
+        if (!(address & 0xFF)) break;
+    }
+}
+
+// returns the block starting at address, or NULL if it can't be cached
+static block *blocklookup(cpu6502_t *cpu, uint16_t address) {
+    uint64_t tag = memory_code_tag(address);
+    if (!tag) return NULL;
+
+    block *b = &cpu->blockcache[(address ^ ((uint32_t)tag << 4)) & (BLOCKCACHE_SIZE - 1)];
+    if (b->tag != tag || b->pc != address) {
+        blockdecode(b, address, tag);
+    }
+    return b->count ? b : NULL;
+}
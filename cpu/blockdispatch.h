@@ -0,0 +1,793 @@
+/* Generated by buildtables.py */
+
+#ifdef DISPATCH_COMPUTED_GOTO
+static const void *const dispatchtable[256] = {
+	/* 0 */ &&op_00, &&op_01, &&op_02, &&op_03, &&op_04, &&op_05, &&op_06, &&op_07, &&op_08, &&op_09, &&op_0A, &&op_0B, &&op_0C, &&op_0D, &&op_0E, &&op_0F,
+	/* 1 */ &&op_10, &&op_11, &&op_12, &&op_13, &&op_14, &&op_15, &&op_16, &&op_17, &&op_18, &&op_19, &&op_1A, &&op_1B, &&op_1C, &&op_1D, &&op_1E, &&op_1F,
+	/* 2 */ &&op_20, &&op_21, &&op_22, &&op_23, &&op_24, &&op_25, &&op_26, &&op_27, &&op_28, &&op_29, &&op_2A, &&op_2B, &&op_2C, &&op_2D, &&op_2E, &&op_2F,
+	/* 3 */ &&op_30, &&op_31, &&op_32, &&op_33, &&op_34, &&op_35, &&op_36, &&op_37, &&op_38, &&op_39, &&op_3A, &&op_3B, &&op_3C, &&op_3D, &&op_3E, &&op_3F,
+	/* 4 */ &&op_40, &&op_41, &&op_42, &&op_43, &&op_44, &&op_45, &&op_46, &&op_47, &&op_48, &&op_49, &&op_4A, &&op_4B, &&op_4C, &&op_4D, &&op_4E, &&op_4F,
+	/* 5 */ &&op_50, &&op_51, &&op_52, &&op_53, &&op_54, &&op_55, &&op_56, &&op_57, &&op_58, &&op_59, &&op_5A, &&op_5B, &&op_5C, &&op_5D, &&op_5E, &&op_5F,
+	/* 6 */ &&op_60, &&op_61, &&op_62, &&op_63, &&op_64, &&op_65, &&op_66, &&op_67, &&op_68, &&op_69, &&op_6A, &&op_6B, &&op_6C, &&op_6D, &&op_6E, &&op_6F,
+	/* 7 */ &&op_70, &&op_71, &&op_72, &&op_73, &&op_74, &&op_75, &&op_76, &&op_77, &&op_78, &&op_79, &&op_7A, &&op_7B, &&op_7C, &&op_7D, &&op_7E, &&op_7F,
+	/* 8 */ &&op_80, &&op_81, &&op_82, &&op_83, &&op_84, &&op_85, &&op_86, &&op_87, &&op_88, &&op_89, &&op_8A, &&op_8B, &&op_8C, &&op_8D, &&op_8E, &&op_8F,
+	/* 9 */ &&op_90, &&op_91, &&op_92, &&op_93, &&op_94, &&op_95, &&op_96, &&op_97, &&op_98, &&op_99, &&op_9A, &&op_9B, &&op_9C, &&op_9D, &&op_9E, &&op_9F,
+	/* A */ &&op_A0, &&op_A1, &&op_A2, &&op_A3, &&op_A4, &&op_A5, &&op_A6, &&op_A7, &&op_A8, &&op_A9, &&op_AA, &&op_AB, &&op_AC, &&op_AD, &&op_AE, &&op_AF,
+	/* B */ &&op_B0, &&op_B1, &&op_B2, &&op_B3, &&op_B4, &&op_B5, &&op_B6, &&op_B7, &&op_B8, &&op_B9, &&op_BA, &&op_BB, &&op_BC, &&op_BD, &&op_BE, &&op_BF,
+	/* C */ &&op_C0, &&op_C1, &&op_C2, &&op_C3, &&op_C4, &&op_C5, &&op_C6, &&op_C7, &&op_C8, &&op_C9, &&op_CA, &&op_CB, &&op_CC, &&op_CD, &&op_CE, &&op_CF,
+	/* D */ &&op_D0, &&op_D1, &&op_D2, &&op_D3, &&op_D4, &&op_D5, &&op_D6, &&op_D7, &&op_D8, &&op_D9, &&op_DA, &&op_DB, &&op_DC, &&op_DD, &&op_DE, &&op_DF,
+	/* E */ &&op_E0, &&op_E1, &&op_E2, &&op_E3, &&op_E4, &&op_E5, &&op_E6, &&op_E7, &&op_E8, &&op_E9, &&op_EA, &&op_EB, &&op_EC, &&op_ED, &&op_EE, &&op_EF,
+	/* F */ &&op_F0, &&op_F1, &&op_F2, &&op_F3, &&op_F4, &&op_F5, &&op_F6, &&op_F7, &&op_F8, &&op_F9, &&op_FA, &&op_FB, &&op_FC, &&op_FD, &&op_FE, &&op_FF
+};
+#endif
+
+DISPATCH_BEGIN
+OPCODE(00) /* brk imp */
+	bc_imp(cpu, op); brk(cpu);
+	NEXT(7)
+OPCODE(01) /* ora indx */
+	bc_indx(cpu, op); ora(cpu);
+	NEXT(6)
+OPCODE(02) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(03) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(04) /* tsb zp */
+	bc_zp(cpu, op); tsb(cpu);
+	NEXT(5)
+OPCODE(05) /* ora zp */
+	bc_zp(cpu, op); ora(cpu);
+	NEXT(3)
+OPCODE(06) /* asl zp */
+	bc_zp(cpu, op); asl(cpu);
+	NEXT(5)
+OPCODE(07) /* rmb0 zp */
+	bc_zp(cpu, op); rmb0(cpu);
+	NEXT(5)
+OPCODE(08) /* php imp */
+	bc_imp(cpu, op); php(cpu);
+	NEXT(3)
+OPCODE(09) /* ora imm */
+	bc_imm(cpu, op); ora(cpu);
+	NEXT(2)
+OPCODE(0A) /* asl acc */
+	bc_acc(cpu, op); asla(cpu);
+	NEXT(2)
+OPCODE(0B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(0C) /* tsb abso */
+	bc_abso(cpu, op); tsb(cpu);
+	NEXT(6)
+OPCODE(0D) /* ora abso */
+	bc_abso(cpu, op); ora(cpu);
+	NEXT(4)
+OPCODE(0E) /* asl abso */
+	bc_abso(cpu, op); asl(cpu);
+	NEXT(6)
+OPCODE(0F) /* bbr0 zprel */
+	bc_zprel(cpu, op); bbr0(cpu);
+	NEXT(2)
+OPCODE(10) /* bpl rel */
+	bc_rel(cpu, op); bpl(cpu);
+	NEXT(2)
+OPCODE(11) /* ora indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); ora(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(12) /* ora ind0 */
+	bc_ind0(cpu, op); ora(cpu);
+	NEXT(5)
+OPCODE(13) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(14) /* trb zp */
+	bc_zp(cpu, op); trb(cpu);
+	NEXT(5)
+OPCODE(15) /* ora zpx */
+	bc_zpx(cpu, op); ora(cpu);
+	NEXT(4)
+OPCODE(16) /* asl zpx */
+	bc_zpx(cpu, op); asl(cpu);
+	NEXT(6)
+OPCODE(17) /* rmb1 zp */
+	bc_zp(cpu, op); rmb1(cpu);
+	NEXT(5)
+OPCODE(18) /* clc imp */
+	bc_imp(cpu, op); clc(cpu);
+	NEXT(2)
+OPCODE(19) /* ora absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); ora(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1A) /* inc acc */
+	bc_acc(cpu, op); inca(cpu);
+	NEXT(2)
+OPCODE(1B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(1C) /* trb abso */
+	bc_abso(cpu, op); trb(cpu);
+	NEXT(6)
+OPCODE(1D) /* ora absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); ora(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1E) /* asl absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); asl(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1F) /* bbr1 zprel */
+	bc_zprel(cpu, op); bbr1(cpu);
+	NEXT(2)
+OPCODE(20) /* jsr abso */
+	bc_abso(cpu, op); jsr(cpu);
+	NEXT(6)
+OPCODE(21) /* and indx */
+	bc_indx(cpu, op); and(cpu);
+	NEXT(6)
+OPCODE(22) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(23) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(24) /* bit zp */
+	bc_zp(cpu, op); bit(cpu);
+	NEXT(3)
+OPCODE(25) /* and zp */
+	bc_zp(cpu, op); and(cpu);
+	NEXT(3)
+OPCODE(26) /* rol zp */
+	bc_zp(cpu, op); rol(cpu);
+	NEXT(5)
+OPCODE(27) /* rmb2 zp */
+	bc_zp(cpu, op); rmb2(cpu);
+	NEXT(5)
+OPCODE(28) /* plp imp */
+	bc_imp(cpu, op); plp(cpu);
+	NEXT(4)
+OPCODE(29) /* and imm */
+	bc_imm(cpu, op); and(cpu);
+	NEXT(2)
+OPCODE(2A) /* rol acc */
+	bc_acc(cpu, op); rola(cpu);
+	NEXT(2)
+OPCODE(2B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(2C) /* bit abso */
+	bc_abso(cpu, op); bit(cpu);
+	NEXT(4)
+OPCODE(2D) /* and abso */
+	bc_abso(cpu, op); and(cpu);
+	NEXT(4)
+OPCODE(2E) /* rol abso */
+	bc_abso(cpu, op); rol(cpu);
+	NEXT(6)
+OPCODE(2F) /* bbr2 zprel */
+	bc_zprel(cpu, op); bbr2(cpu);
+	NEXT(2)
+OPCODE(30) /* bmi rel */
+	bc_rel(cpu, op); bmi(cpu);
+	NEXT(2)
+OPCODE(31) /* and indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); and(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(32) /* and ind0 */
+	bc_ind0(cpu, op); and(cpu);
+	NEXT(5)
+OPCODE(33) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(34) /* bit zpx */
+	bc_zpx(cpu, op); bit(cpu);
+	NEXT(4)
+OPCODE(35) /* and zpx */
+	bc_zpx(cpu, op); and(cpu);
+	NEXT(4)
+OPCODE(36) /* rol zpx */
+	bc_zpx(cpu, op); rol(cpu);
+	NEXT(6)
+OPCODE(37) /* rmb3 zp */
+	bc_zp(cpu, op); rmb3(cpu);
+	NEXT(5)
+OPCODE(38) /* sec imp */
+	bc_imp(cpu, op); sec(cpu);
+	NEXT(2)
+OPCODE(39) /* and absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); and(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3A) /* dec acc */
+	bc_acc(cpu, op); deca(cpu);
+	NEXT(2)
+OPCODE(3B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(3C) /* bit absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); bit(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3D) /* and absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); and(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3E) /* rol absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); rol(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3F) /* bbr3 zprel */
+	bc_zprel(cpu, op); bbr3(cpu);
+	NEXT(2)
+OPCODE(40) /* rti imp */
+	bc_imp(cpu, op); rti(cpu);
+	NEXT(6)
+OPCODE(41) /* eor indx */
+	bc_indx(cpu, op); eor(cpu);
+	NEXT(6)
+OPCODE(42) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(43) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(44) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(45) /* eor zp */
+	bc_zp(cpu, op); eor(cpu);
+	NEXT(3)
+OPCODE(46) /* lsr zp */
+	bc_zp(cpu, op); lsr(cpu);
+	NEXT(5)
+OPCODE(47) /* rmb4 zp */
+	bc_zp(cpu, op); rmb4(cpu);
+	NEXT(5)
+OPCODE(48) /* pha imp */
+	bc_imp(cpu, op); pha(cpu);
+	NEXT(3)
+OPCODE(49) /* eor imm */
+	bc_imm(cpu, op); eor(cpu);
+	NEXT(2)
+OPCODE(4A) /* lsr acc */
+	bc_acc(cpu, op); lsra(cpu);
+	NEXT(2)
+OPCODE(4B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(4C) /* jmp abso */
+	bc_abso(cpu, op); jmp(cpu);
+	NEXT(3)
+OPCODE(4D) /* eor abso */
+	bc_abso(cpu, op); eor(cpu);
+	NEXT(4)
+OPCODE(4E) /* lsr abso */
+	bc_abso(cpu, op); lsr(cpu);
+	NEXT(6)
+OPCODE(4F) /* bbr4 zprel */
+	bc_zprel(cpu, op); bbr4(cpu);
+	NEXT(2)
+OPCODE(50) /* bvc rel */
+	bc_rel(cpu, op); bvc(cpu);
+	NEXT(2)
+OPCODE(51) /* eor indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); eor(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(52) /* eor ind0 */
+	bc_ind0(cpu, op); eor(cpu);
+	NEXT(5)
+OPCODE(53) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(54) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(55) /* eor zpx */
+	bc_zpx(cpu, op); eor(cpu);
+	NEXT(4)
+OPCODE(56) /* lsr zpx */
+	bc_zpx(cpu, op); lsr(cpu);
+	NEXT(6)
+OPCODE(57) /* rmb5 zp */
+	bc_zp(cpu, op); rmb5(cpu);
+	NEXT(5)
+OPCODE(58) /* cli imp */
+	bc_imp(cpu, op); cli(cpu);
+	NEXT(2)
+OPCODE(59) /* eor absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); eor(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5A) /* phy imp */
+	bc_imp(cpu, op); phy(cpu);
+	NEXT(3)
+OPCODE(5B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(5C) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(5D) /* eor absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); eor(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5E) /* lsr absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); lsr(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5F) /* bbr5 zprel */
+	bc_zprel(cpu, op); bbr5(cpu);
+	NEXT(2)
+OPCODE(60) /* rts imp */
+	bc_imp(cpu, op); rts(cpu);
+	NEXT(6)
+OPCODE(61) /* adc indx */
+	bc_indx(cpu, op); adc(cpu);
+	NEXT(6)
+OPCODE(62) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(63) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(64) /* stz zp */
+	bc_zp(cpu, op); stz(cpu);
+	NEXT(3)
+OPCODE(65) /* adc zp */
+	bc_zp(cpu, op); adc(cpu);
+	NEXT(3)
+OPCODE(66) /* ror zp */
+	bc_zp(cpu, op); ror(cpu);
+	NEXT(5)
+OPCODE(67) /* rmb6 zp */
+	bc_zp(cpu, op); rmb6(cpu);
+	NEXT(5)
+OPCODE(68) /* pla imp */
+	bc_imp(cpu, op); pla(cpu);
+	NEXT(4)
+OPCODE(69) /* adc imm */
+	bc_imm(cpu, op); adc(cpu);
+	NEXT(2)
+OPCODE(6A) /* ror acc */
+	bc_acc(cpu, op); rora(cpu);
+	NEXT(2)
+OPCODE(6B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(6C) /* jmp ind */
+	bc_ind(cpu, op); jmp(cpu);
+	NEXT(5)
+OPCODE(6D) /* adc abso */
+	bc_abso(cpu, op); adc(cpu);
+	NEXT(4)
+OPCODE(6E) /* ror abso */
+	bc_abso(cpu, op); ror(cpu);
+	NEXT(6)
+OPCODE(6F) /* bbr6 zprel */
+	bc_zprel(cpu, op); bbr6(cpu);
+	NEXT(2)
+OPCODE(70) /* bvs rel */
+	bc_rel(cpu, op); bvs(cpu);
+	NEXT(2)
+OPCODE(71) /* adc indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); adc(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(72) /* adc ind0 */
+	bc_ind0(cpu, op); adc(cpu);
+	NEXT(5)
+OPCODE(73) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(74) /* stz zpx */
+	bc_zpx(cpu, op); stz(cpu);
+	NEXT(4)
+OPCODE(75) /* adc zpx */
+	bc_zpx(cpu, op); adc(cpu);
+	NEXT(4)
+OPCODE(76) /* ror zpx */
+	bc_zpx(cpu, op); ror(cpu);
+	NEXT(6)
+OPCODE(77) /* rmb7 zp */
+	bc_zp(cpu, op); rmb7(cpu);
+	NEXT(5)
+OPCODE(78) /* sei imp */
+	bc_imp(cpu, op); sei(cpu);
+	NEXT(2)
+OPCODE(79) /* adc absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); adc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7A) /* ply imp */
+	bc_imp(cpu, op); ply(cpu);
+	NEXT(4)
+OPCODE(7B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(7C) /* jmp ainx */
+	bc_ainx(cpu, op); jmp(cpu);
+	NEXT(6)
+OPCODE(7D) /* adc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); adc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7E) /* ror absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); ror(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7F) /* bbr7 zprel */
+	bc_zprel(cpu, op); bbr7(cpu);
+	NEXT(2)
+OPCODE(80) /* bra rel */
+	bc_rel(cpu, op); bra(cpu);
+	NEXT(3)
+OPCODE(81) /* sta indx */
+	bc_indx(cpu, op); sta(cpu);
+	NEXT(6)
+OPCODE(82) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(83) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(84) /* sty zp */
+	bc_zp(cpu, op); sty(cpu);
+	NEXT(3)
+OPCODE(85) /* sta zp */
+	bc_zp(cpu, op); sta(cpu);
+	NEXT(3)
+OPCODE(86) /* stx zp */
+	bc_zp(cpu, op); stx(cpu);
+	NEXT(3)
+OPCODE(87) /* smb0 zp */
+	bc_zp(cpu, op); smb0(cpu);
+	NEXT(5)
+OPCODE(88) /* dey imp */
+	bc_imp(cpu, op); dey(cpu);
+	NEXT(2)
+OPCODE(89) /* bit imm */
+	bc_imm(cpu, op); bit(cpu);
+	NEXT(2)
+OPCODE(8A) /* txa imp */
+	bc_imp(cpu, op); txa(cpu);
+	NEXT(2)
+OPCODE(8B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(8C) /* sty abso */
+	bc_abso(cpu, op); sty(cpu);
+	NEXT(4)
+OPCODE(8D) /* sta abso */
+	bc_abso(cpu, op); sta(cpu);
+	NEXT(4)
+OPCODE(8E) /* stx abso */
+	bc_abso(cpu, op); stx(cpu);
+	NEXT(4)
+OPCODE(8F) /* bbs0 zprel */
+	bc_zprel(cpu, op); bbs0(cpu);
+	NEXT(2)
+OPCODE(90) /* bcc rel */
+	bc_rel(cpu, op); bcc(cpu);
+	NEXT(2)
+OPCODE(91) /* sta indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); sta(cpu);
+	NEXT(6 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(92) /* sta ind0 */
+	bc_ind0(cpu, op); sta(cpu);
+	NEXT(5)
+OPCODE(93) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(94) /* sty zpx */
+	bc_zpx(cpu, op); sty(cpu);
+	NEXT(4)
+OPCODE(95) /* sta zpx */
+	bc_zpx(cpu, op); sta(cpu);
+	NEXT(4)
+OPCODE(96) /* stx zpy */
+	bc_zpy(cpu, op); stx(cpu);
+	NEXT(4)
+OPCODE(97) /* smb1 zp */
+	bc_zp(cpu, op); smb1(cpu);
+	NEXT(5)
+OPCODE(98) /* tya imp */
+	bc_imp(cpu, op); tya(cpu);
+	NEXT(2)
+OPCODE(99) /* sta absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); sta(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9A) /* txs imp */
+	bc_imp(cpu, op); txs(cpu);
+	NEXT(2)
+OPCODE(9B) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(9C) /* stz abso */
+	bc_abso(cpu, op); stz(cpu);
+	NEXT(4)
+OPCODE(9D) /* sta absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); sta(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9E) /* stz absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); stz(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9F) /* bbs1 zprel */
+	bc_zprel(cpu, op); bbs1(cpu);
+	NEXT(2)
+OPCODE(A0) /* ldy imm */
+	bc_imm(cpu, op); ldy(cpu);
+	NEXT(2)
+OPCODE(A1) /* lda indx */
+	bc_indx(cpu, op); lda(cpu);
+	NEXT(6)
+OPCODE(A2) /* ldx imm */
+	bc_imm(cpu, op); ldx(cpu);
+	NEXT(2)
+OPCODE(A3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(A4) /* ldy zp */
+	bc_zp(cpu, op); ldy(cpu);
+	NEXT(3)
+OPCODE(A5) /* lda zp */
+	bc_zp(cpu, op); lda(cpu);
+	NEXT(3)
+OPCODE(A6) /* ldx zp */
+	bc_zp(cpu, op); ldx(cpu);
+	NEXT(3)
+OPCODE(A7) /* smb2 zp */
+	bc_zp(cpu, op); smb2(cpu);
+	NEXT(5)
+OPCODE(A8) /* tay imp */
+	bc_imp(cpu, op); tay(cpu);
+	NEXT(2)
+OPCODE(A9) /* lda imm */
+	bc_imm(cpu, op); lda(cpu);
+	NEXT(2)
+OPCODE(AA) /* tax imp */
+	bc_imp(cpu, op); tax(cpu);
+	NEXT(2)
+OPCODE(AB) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(AC) /* ldy abso */
+	bc_abso(cpu, op); ldy(cpu);
+	NEXT(4)
+OPCODE(AD) /* lda abso */
+	bc_abso(cpu, op); lda(cpu);
+	NEXT(4)
+OPCODE(AE) /* ldx abso */
+	bc_abso(cpu, op); ldx(cpu);
+	NEXT(4)
+OPCODE(AF) /* bbs2 zprel */
+	bc_zprel(cpu, op); bbs2(cpu);
+	NEXT(2)
+OPCODE(B0) /* bcs rel */
+	bc_rel(cpu, op); bcs(cpu);
+	NEXT(2)
+OPCODE(B1) /* lda indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); lda(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(B2) /* lda ind0 */
+	bc_ind0(cpu, op); lda(cpu);
+	NEXT(5)
+OPCODE(B3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(B4) /* ldy zpx */
+	bc_zpx(cpu, op); ldy(cpu);
+	NEXT(4)
+OPCODE(B5) /* lda zpx */
+	bc_zpx(cpu, op); lda(cpu);
+	NEXT(4)
+OPCODE(B6) /* ldx zpy */
+	bc_zpy(cpu, op); ldx(cpu);
+	NEXT(4)
+OPCODE(B7) /* smb3 zp */
+	bc_zp(cpu, op); smb3(cpu);
+	NEXT(5)
+OPCODE(B8) /* clv imp */
+	bc_imp(cpu, op); clv(cpu);
+	NEXT(2)
+OPCODE(B9) /* lda absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); lda(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BA) /* tsx imp */
+	bc_imp(cpu, op); tsx(cpu);
+	NEXT(2)
+OPCODE(BB) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(BC) /* ldy absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); ldy(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BD) /* lda absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); lda(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BE) /* ldx absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); ldx(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BF) /* bbs3 zprel */
+	bc_zprel(cpu, op); bbs3(cpu);
+	NEXT(2)
+OPCODE(C0) /* cpy imm */
+	bc_imm(cpu, op); cpy(cpu);
+	NEXT(2)
+OPCODE(C1) /* cmp indx */
+	bc_indx(cpu, op); cmp(cpu);
+	NEXT(6)
+OPCODE(C2) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(C3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(C4) /* cpy zp */
+	bc_zp(cpu, op); cpy(cpu);
+	NEXT(3)
+OPCODE(C5) /* cmp zp */
+	bc_zp(cpu, op); cmp(cpu);
+	NEXT(3)
+OPCODE(C6) /* dec zp */
+	bc_zp(cpu, op); dec(cpu);
+	NEXT(5)
+OPCODE(C7) /* smb4 zp */
+	bc_zp(cpu, op); smb4(cpu);
+	NEXT(5)
+OPCODE(C8) /* iny imp */
+	bc_imp(cpu, op); iny(cpu);
+	NEXT(2)
+OPCODE(C9) /* cmp imm */
+	bc_imm(cpu, op); cmp(cpu);
+	NEXT(2)
+OPCODE(CA) /* dex imp */
+	bc_imp(cpu, op); dex(cpu);
+	NEXT(2)
+OPCODE(CB) /* wai imp */
+	bc_imp(cpu, op); wai(cpu);
+	NEXT(3)
+OPCODE(CC) /* cpy abso */
+	bc_abso(cpu, op); cpy(cpu);
+	NEXT(4)
+OPCODE(CD) /* cmp abso */
+	bc_abso(cpu, op); cmp(cpu);
+	NEXT(4)
+OPCODE(CE) /* dec abso */
+	bc_abso(cpu, op); dec(cpu);
+	NEXT(6)
+OPCODE(CF) /* bbs4 zprel */
+	bc_zprel(cpu, op); bbs4(cpu);
+	NEXT(2)
+OPCODE(D0) /* bne rel */
+	bc_rel(cpu, op); bne(cpu);
+	NEXT(2)
+OPCODE(D1) /* cmp indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); cmp(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(D2) /* cmp ind0 */
+	bc_ind0(cpu, op); cmp(cpu);
+	NEXT(5)
+OPCODE(D3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(D4) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(D5) /* cmp zpx */
+	bc_zpx(cpu, op); cmp(cpu);
+	NEXT(4)
+OPCODE(D6) /* dec zpx */
+	bc_zpx(cpu, op); dec(cpu);
+	NEXT(6)
+OPCODE(D7) /* smb5 zp */
+	bc_zp(cpu, op); smb5(cpu);
+	NEXT(5)
+OPCODE(D8) /* cld imp */
+	bc_imp(cpu, op); cld(cpu);
+	NEXT(2)
+OPCODE(D9) /* cmp absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); cmp(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DA) /* phx imp */
+	bc_imp(cpu, op); phx(cpu);
+	NEXT(3)
+OPCODE(DB) /* dbg imp */
+	bc_imp(cpu, op); dbg(cpu);
+	NEXT(1)
+OPCODE(DC) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(DD) /* cmp absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); cmp(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DE) /* dec absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); dec(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DF) /* bbs5 zprel */
+	bc_zprel(cpu, op); bbs5(cpu);
+	NEXT(2)
+OPCODE(E0) /* cpx imm */
+	bc_imm(cpu, op); cpx(cpu);
+	NEXT(2)
+OPCODE(E1) /* sbc indx */
+	bc_indx(cpu, op); sbc(cpu);
+	NEXT(6)
+OPCODE(E2) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(E3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(E4) /* cpx zp */
+	bc_zp(cpu, op); cpx(cpu);
+	NEXT(3)
+OPCODE(E5) /* sbc zp */
+	bc_zp(cpu, op); sbc(cpu);
+	NEXT(3)
+OPCODE(E6) /* inc zp */
+	bc_zp(cpu, op); inc(cpu);
+	NEXT(5)
+OPCODE(E7) /* smb6 zp */
+	bc_zp(cpu, op); smb6(cpu);
+	NEXT(5)
+OPCODE(E8) /* inx imp */
+	bc_imp(cpu, op); inx(cpu);
+	NEXT(2)
+OPCODE(E9) /* sbc imm */
+	bc_imm(cpu, op); sbc(cpu);
+	NEXT(2)
+OPCODE(EA) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(EB) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(EC) /* cpx abso */
+	bc_abso(cpu, op); cpx(cpu);
+	NEXT(4)
+OPCODE(ED) /* sbc abso */
+	bc_abso(cpu, op); sbc(cpu);
+	NEXT(4)
+OPCODE(EE) /* inc abso */
+	bc_abso(cpu, op); inc(cpu);
+	NEXT(6)
+OPCODE(EF) /* bbs6 zprel */
+	bc_zprel(cpu, op); bbs6(cpu);
+	NEXT(2)
+OPCODE(F0) /* beq rel */
+	bc_rel(cpu, op); beq(cpu);
+	NEXT(2)
+OPCODE(F1) /* sbc indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_indy(cpu, op); sbc(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(F2) /* sbc ind0 */
+	bc_ind0(cpu, op); sbc(cpu);
+	NEXT(5)
+OPCODE(F3) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(F4) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(F5) /* sbc zpx */
+	bc_zpx(cpu, op); sbc(cpu);
+	NEXT(4)
+OPCODE(F6) /* inc zpx */
+	bc_zpx(cpu, op); inc(cpu);
+	NEXT(6)
+OPCODE(F7) /* smb7 zp */
+	bc_zp(cpu, op); smb7(cpu);
+	NEXT(5)
+OPCODE(F8) /* sed imp */
+	bc_imp(cpu, op); sed(cpu);
+	NEXT(2)
+OPCODE(F9) /* sbc absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absy(cpu, op); sbc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FA) /* plx imp */
+	bc_imp(cpu, op); plx(cpu);
+	NEXT(4)
+OPCODE(FB) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(FC) /* nop imp */
+	bc_imp(cpu, op); nop(cpu);
+	NEXT(2)
+OPCODE(FD) /* sbc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); sbc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FE) /* inc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; bc_absx(cpu, op); inc(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FF) /* bbs7 zprel */
+	bc_zprel(cpu, op); bbs7(cpu);
+	NEXT(2)
+DISPATCH_END
@@ -0,0 +1,380 @@
+/* Generated by buildtables.py */
+
+enum {
+	BM_abso,
+	BM_absx,
+	BM_absy,
+	BM_acc,
+	BM_ainx,
+	BM_imm,
+	BM_imp,
+	BM_ind,
+	BM_ind0,
+	BM_indx,
+	BM_indy,
+	BM_rel,
+	BM_zp,
+	BM_zprel,
+	BM_zpx,
+	BM_zpy
+};
+
+enum {
+	BA_adc,
+	BA_and,
+	BA_asl,
+	BA_bbr0,
+	BA_bbr1,
+	BA_bbr2,
+	BA_bbr3,
+	BA_bbr4,
+	BA_bbr5,
+	BA_bbr6,
+	BA_bbr7,
+	BA_bbs0,
+	BA_bbs1,
+	BA_bbs2,
+	BA_bbs3,
+	BA_bbs4,
+	BA_bbs5,
+	BA_bbs6,
+	BA_bbs7,
+	BA_bcc,
+	BA_bcs,
+	BA_beq,
+	BA_bit,
+	BA_bmi,
+	BA_bne,
+	BA_bpl,
+	BA_bra,
+	BA_brk,
+	BA_bvc,
+	BA_bvs,
+	BA_clc,
+	BA_cld,
+	BA_cli,
+	BA_clv,
+	BA_cmp,
+	BA_cpx,
+	BA_cpy,
+	BA_dbg,
+	BA_dec,
+	BA_dex,
+	BA_dey,
+	BA_eor,
+	BA_inc,
+	BA_inx,
+	BA_iny,
+	BA_jmp,
+	BA_jsr,
+	BA_lda,
+	BA_ldx,
+	BA_ldy,
+	BA_lsr,
+	BA_nop,
+	BA_ora,
+	BA_pha,
+	BA_php,
+	BA_phx,
+	BA_phy,
+	BA_pla,
+	BA_plp,
+	BA_plx,
+	BA_ply,
+	BA_rmb0,
+	BA_rmb1,
+	BA_rmb2,
+	BA_rmb3,
+	BA_rmb4,
+	BA_rmb5,
+	BA_rmb6,
+	BA_rmb7,
+	BA_rol,
+	BA_ror,
+	BA_rti,
+	BA_rts,
+	BA_sbc,
+	BA_sec,
+	BA_sed,
+	BA_sei,
+	BA_smb0,
+	BA_smb1,
+	BA_smb2,
+	BA_smb3,
+	BA_smb4,
+	BA_smb5,
+	BA_smb6,
+	BA_smb7,
+	BA_sta,
+	BA_stx,
+	BA_sty,
+	BA_stz,
+	BA_tax,
+	BA_tay,
+	BA_trb,
+	BA_tsb,
+	BA_tsx,
+	BA_txa,
+	BA_txs,
+	BA_tya,
+	BA_wai
+};
+
+static const blockinfo blocktable[256] = {
+	/* $00 */ { 1, 1, 7, BM_imp, BA_brk },
+	/* $01 */ { 2, 0, 6, BM_indx, BA_ora },
+	/* $02 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $03 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $04 */ { 2, 0, 5, BM_zp, BA_tsb },
+	/* $05 */ { 2, 0, 3, BM_zp, BA_ora },
+	/* $06 */ { 2, 0, 5, BM_zp, BA_asl },
+	/* $07 */ { 2, 0, 5, BM_zp, BA_rmb0 },
+	/* $08 */ { 1, 0, 3, BM_imp, BA_php },
+	/* $09 */ { 2, 0, 2, BM_imm, BA_ora },
+	/* $0A */ { 1, 0, 2, BM_acc, BA_asl },
+	/* $0B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $0C */ { 3, 0, 6, BM_abso, BA_tsb },
+	/* $0D */ { 3, 0, 4, BM_abso, BA_ora },
+	/* $0E */ { 3, 0, 6, BM_abso, BA_asl },
+	/* $0F */ { 3, 0, 2, BM_zprel, BA_bbr0 },
+	/* $10 */ { 2, 0, 2, BM_rel, BA_bpl },
+	/* $11 */ { 2, 0, 5, BM_indy, BA_ora },
+	/* $12 */ { 2, 0, 5, BM_ind0, BA_ora },
+	/* $13 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $14 */ { 2, 0, 5, BM_zp, BA_trb },
+	/* $15 */ { 2, 0, 4, BM_zpx, BA_ora },
+	/* $16 */ { 2, 0, 6, BM_zpx, BA_asl },
+	/* $17 */ { 2, 0, 5, BM_zp, BA_rmb1 },
+	/* $18 */ { 1, 0, 2, BM_imp, BA_clc },
+	/* $19 */ { 3, 0, 4, BM_absy, BA_ora },
+	/* $1A */ { 1, 0, 2, BM_acc, BA_inc },
+	/* $1B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $1C */ { 3, 0, 6, BM_abso, BA_trb },
+	/* $1D */ { 3, 0, 4, BM_absx, BA_ora },
+	/* $1E */ { 3, 0, 7, BM_absx, BA_asl },
+	/* $1F */ { 3, 0, 2, BM_zprel, BA_bbr1 },
+	/* $20 */ { 3, 1, 6, BM_abso, BA_jsr },
+	/* $21 */ { 2, 0, 6, BM_indx, BA_and },
+	/* $22 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $23 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $24 */ { 2, 0, 3, BM_zp, BA_bit },
+	/* $25 */ { 2, 0, 3, BM_zp, BA_and },
+	/* $26 */ { 2, 0, 5, BM_zp, BA_rol },
+	/* $27 */ { 2, 0, 5, BM_zp, BA_rmb2 },
+	/* $28 */ { 1, 0, 4, BM_imp, BA_plp },
+	/* $29 */ { 2, 0, 2, BM_imm, BA_and },
+	/* $2A */ { 1, 0, 2, BM_acc, BA_rol },
+	/* $2B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $2C */ { 3, 0, 4, BM_abso, BA_bit },
+	/* $2D */ { 3, 0, 4, BM_abso, BA_and },
+	/* $2E */ { 3, 0, 6, BM_abso, BA_rol },
+	/* $2F */ { 3, 0, 2, BM_zprel, BA_bbr2 },
+	/* $30 */ { 2, 0, 2, BM_rel, BA_bmi },
+	/* $31 */ { 2, 0, 5, BM_indy, BA_and },
+	/* $32 */ { 2, 0, 5, BM_ind0, BA_and },
+	/* $33 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $34 */ { 2, 0, 4, BM_zpx, BA_bit },
+	/* $35 */ { 2, 0, 4, BM_zpx, BA_and },
+	/* $36 */ { 2, 0, 6, BM_zpx, BA_rol },
+	/* $37 */ { 2, 0, 5, BM_zp, BA_rmb3 },
+	/* $38 */ { 1, 0, 2, BM_imp, BA_sec },
+	/* $39 */ { 3, 0, 4, BM_absy, BA_and },
+	/* $3A */ { 1, 0, 2, BM_acc, BA_dec },
+	/* $3B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $3C */ { 3, 0, 4, BM_absx, BA_bit },
+	/* $3D */ { 3, 0, 4, BM_absx, BA_and },
+	/* $3E */ { 3, 0, 7, BM_absx, BA_rol },
+	/* $3F */ { 3, 0, 2, BM_zprel, BA_bbr3 },
+	/* $40 */ { 1, 1, 6, BM_imp, BA_rti },
+	/* $41 */ { 2, 0, 6, BM_indx, BA_eor },
+	/* $42 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $43 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $44 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $45 */ { 2, 0, 3, BM_zp, BA_eor },
+	/* $46 */ { 2, 0, 5, BM_zp, BA_lsr },
+	/* $47 */ { 2, 0, 5, BM_zp, BA_rmb4 },
+	/* $48 */ { 1, 0, 3, BM_imp, BA_pha },
+	/* $49 */ { 2, 0, 2, BM_imm, BA_eor },
+	/* $4A */ { 1, 0, 2, BM_acc, BA_lsr },
+	/* $4B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $4C */ { 3, 1, 3, BM_abso, BA_jmp },
+	/* $4D */ { 3, 0, 4, BM_abso, BA_eor },
+	/* $4E */ { 3, 0, 6, BM_abso, BA_lsr },
+	/* $4F */ { 3, 0, 2, BM_zprel, BA_bbr4 },
+	/* $50 */ { 2, 0, 2, BM_rel, BA_bvc },
+	/* $51 */ { 2, 0, 5, BM_indy, BA_eor },
+	/* $52 */ { 2, 0, 5, BM_ind0, BA_eor },
+	/* $53 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $54 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $55 */ { 2, 0, 4, BM_zpx, BA_eor },
+	/* $56 */ { 2, 0, 6, BM_zpx, BA_lsr },
+	/* $57 */ { 2, 0, 5, BM_zp, BA_rmb5 },
+	/* $58 */ { 1, 0, 2, BM_imp, BA_cli },
+	/* $59 */ { 3, 0, 4, BM_absy, BA_eor },
+	/* $5A */ { 1, 0, 3, BM_imp, BA_phy },
+	/* $5B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $5C */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $5D */ { 3, 0, 4, BM_absx, BA_eor },
+	/* $5E */ { 3, 0, 7, BM_absx, BA_lsr },
+	/* $5F */ { 3, 0, 2, BM_zprel, BA_bbr5 },
+	/* $60 */ { 1, 1, 6, BM_imp, BA_rts },
+	/* $61 */ { 2, 0, 6, BM_indx, BA_adc },
+	/* $62 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $63 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $64 */ { 2, 0, 3, BM_zp, BA_stz },
+	/* $65 */ { 2, 0, 3, BM_zp, BA_adc },
+	/* $66 */ { 2, 0, 5, BM_zp, BA_ror },
+	/* $67 */ { 2, 0, 5, BM_zp, BA_rmb6 },
+	/* $68 */ { 1, 0, 4, BM_imp, BA_pla },
+	/* $69 */ { 2, 0, 2, BM_imm, BA_adc },
+	/* $6A */ { 1, 0, 2, BM_acc, BA_ror },
+	/* $6B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $6C */ { 3, 1, 5, BM_ind, BA_jmp },
+	/* $6D */ { 3, 0, 4, BM_abso, BA_adc },
+	/* $6E */ { 3, 0, 6, BM_abso, BA_ror },
+	/* $6F */ { 3, 0, 2, BM_zprel, BA_bbr6 },
+	/* $70 */ { 2, 0, 2, BM_rel, BA_bvs },
+	/* $71 */ { 2, 0, 5, BM_indy, BA_adc },
+	/* $72 */ { 2, 0, 5, BM_ind0, BA_adc },
+	/* $73 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $74 */ { 2, 0, 4, BM_zpx, BA_stz },
+	/* $75 */ { 2, 0, 4, BM_zpx, BA_adc },
+	/* $76 */ { 2, 0, 6, BM_zpx, BA_ror },
+	/* $77 */ { 2, 0, 5, BM_zp, BA_rmb7 },
+	/* $78 */ { 1, 0, 2, BM_imp, BA_sei },
+	/* $79 */ { 3, 0, 4, BM_absy, BA_adc },
+	/* $7A */ { 1, 0, 4, BM_imp, BA_ply },
+	/* $7B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $7C */ { 3, 1, 6, BM_ainx, BA_jmp },
+	/* $7D */ { 3, 0, 4, BM_absx, BA_adc },
+	/* $7E */ { 3, 0, 7, BM_absx, BA_ror },
+	/* $7F */ { 3, 0, 2, BM_zprel, BA_bbr7 },
+	/* $80 */ { 2, 1, 3, BM_rel, BA_bra },
+	/* $81 */ { 2, 0, 6, BM_indx, BA_sta },
+	/* $82 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $83 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $84 */ { 2, 0, 3, BM_zp, BA_sty },
+	/* $85 */ { 2, 0, 3, BM_zp, BA_sta },
+	/* $86 */ { 2, 0, 3, BM_zp, BA_stx },
+	/* $87 */ { 2, 0, 5, BM_zp, BA_smb0 },
+	/* $88 */ { 1, 0, 2, BM_imp, BA_dey },
+	/* $89 */ { 2, 0, 2, BM_imm, BA_bit },
+	/* $8A */ { 1, 0, 2, BM_imp, BA_txa },
+	/* $8B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $8C */ { 3, 0, 4, BM_abso, BA_sty },
+	/* $8D */ { 3, 0, 4, BM_abso, BA_sta },
+	/* $8E */ { 3, 0, 4, BM_abso, BA_stx },
+	/* $8F */ { 3, 0, 2, BM_zprel, BA_bbs0 },
+	/* $90 */ { 2, 0, 2, BM_rel, BA_bcc },
+	/* $91 */ { 2, 0, 6, BM_indy, BA_sta },
+	/* $92 */ { 2, 0, 5, BM_ind0, BA_sta },
+	/* $93 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $94 */ { 2, 0, 4, BM_zpx, BA_sty },
+	/* $95 */ { 2, 0, 4, BM_zpx, BA_sta },
+	/* $96 */ { 2, 0, 4, BM_zpy, BA_stx },
+	/* $97 */ { 2, 0, 5, BM_zp, BA_smb1 },
+	/* $98 */ { 1, 0, 2, BM_imp, BA_tya },
+	/* $99 */ { 3, 0, 5, BM_absy, BA_sta },
+	/* $9A */ { 1, 0, 2, BM_imp, BA_txs },
+	/* $9B */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $9C */ { 3, 0, 4, BM_abso, BA_stz },
+	/* $9D */ { 3, 0, 5, BM_absx, BA_sta },
+	/* $9E */ { 3, 0, 5, BM_absx, BA_stz },
+	/* $9F */ { 3, 0, 2, BM_zprel, BA_bbs1 },
+	/* $A0 */ { 2, 0, 2, BM_imm, BA_ldy },
+	/* $A1 */ { 2, 0, 6, BM_indx, BA_lda },
+	/* $A2 */ { 2, 0, 2, BM_imm, BA_ldx },
+	/* $A3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $A4 */ { 2, 0, 3, BM_zp, BA_ldy },
+	/* $A5 */ { 2, 0, 3, BM_zp, BA_lda },
+	/* $A6 */ { 2, 0, 3, BM_zp, BA_ldx },
+	/* $A7 */ { 2, 0, 5, BM_zp, BA_smb2 },
+	/* $A8 */ { 1, 0, 2, BM_imp, BA_tay },
+	/* $A9 */ { 2, 0, 2, BM_imm, BA_lda },
+	/* $AA */ { 1, 0, 2, BM_imp, BA_tax },
+	/* $AB */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $AC */ { 3, 0, 4, BM_abso, BA_ldy },
+	/* $AD */ { 3, 0, 4, BM_abso, BA_lda },
+	/* $AE */ { 3, 0, 4, BM_abso, BA_ldx },
+	/* $AF */ { 3, 0, 2, BM_zprel, BA_bbs2 },
+	/* $B0 */ { 2, 0, 2, BM_rel, BA_bcs },
+	/* $B1 */ { 2, 0, 5, BM_indy, BA_lda },
+	/* $B2 */ { 2, 0, 5, BM_ind0, BA_lda },
+	/* $B3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $B4 */ { 2, 0, 4, BM_zpx, BA_ldy },
+	/* $B5 */ { 2, 0, 4, BM_zpx, BA_lda },
+	/* $B6 */ { 2, 0, 4, BM_zpy, BA_ldx },
+	/* $B7 */ { 2, 0, 5, BM_zp, BA_smb3 },
+	/* $B8 */ { 1, 0, 2, BM_imp, BA_clv },
+	/* $B9 */ { 3, 0, 4, BM_absy, BA_lda },
+	/* $BA */ { 1, 0, 2, BM_imp, BA_tsx },
+	/* $BB */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $BC */ { 3, 0, 4, BM_absx, BA_ldy },
+	/* $BD */ { 3, 0, 4, BM_absx, BA_lda },
+	/* $BE */ { 3, 0, 4, BM_absy, BA_ldx },
+	/* $BF */ { 3, 0, 2, BM_zprel, BA_bbs3 },
+	/* $C0 */ { 2, 0, 2, BM_imm, BA_cpy },
+	/* $C1 */ { 2, 0, 6, BM_indx, BA_cmp },
+	/* $C2 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $C3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $C4 */ { 2, 0, 3, BM_zp, BA_cpy },
+	/* $C5 */ { 2, 0, 3, BM_zp, BA_cmp },
+	/* $C6 */ { 2, 0, 5, BM_zp, BA_dec },
+	/* $C7 */ { 2, 0, 5, BM_zp, BA_smb4 },
+	/* $C8 */ { 1, 0, 2, BM_imp, BA_iny },
+	/* $C9 */ { 2, 0, 2, BM_imm, BA_cmp },
+	/* $CA */ { 1, 0, 2, BM_imp, BA_dex },
+	/* $CB */ { 1, 1, 3, BM_imp, BA_wai },
+	/* $CC */ { 3, 0, 4, BM_abso, BA_cpy },
+	/* $CD */ { 3, 0, 4, BM_abso, BA_cmp },
+	/* $CE */ { 3, 0, 6, BM_abso, BA_dec },
+	/* $CF */ { 3, 0, 2, BM_zprel, BA_bbs4 },
+	/* $D0 */ { 2, 0, 2, BM_rel, BA_bne },
+	/* $D1 */ { 2, 0, 5, BM_indy, BA_cmp },
+	/* $D2 */ { 2, 0, 5, BM_ind0, BA_cmp },
+	/* $D3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $D4 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $D5 */ { 2, 0, 4, BM_zpx, BA_cmp },
+	/* $D6 */ { 2, 0, 6, BM_zpx, BA_dec },
+	/* $D7 */ { 2, 0, 5, BM_zp, BA_smb5 },
+	/* $D8 */ { 1, 0, 2, BM_imp, BA_cld },
+	/* $D9 */ { 3, 0, 4, BM_absy, BA_cmp },
+	/* $DA */ { 1, 0, 3, BM_imp, BA_phx },
+	/* $DB */ { 1, 1, 1, BM_imp, BA_dbg },
+	/* $DC */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $DD */ { 3, 0, 4, BM_absx, BA_cmp },
+	/* $DE */ { 3, 0, 7, BM_absx, BA_dec },
+	/* $DF */ { 3, 0, 2, BM_zprel, BA_bbs5 },
+	/* $E0 */ { 2, 0, 2, BM_imm, BA_cpx },
+	/* $E1 */ { 2, 0, 6, BM_indx, BA_sbc },
+	/* $E2 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $E3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $E4 */ { 2, 0, 3, BM_zp, BA_cpx },
+	/* $E5 */ { 2, 0, 3, BM_zp, BA_sbc },
+	/* $E6 */ { 2, 0, 5, BM_zp, BA_inc },
+	/* $E7 */ { 2, 0, 5, BM_zp, BA_smb6 },
+	/* $E8 */ { 1, 0, 2, BM_imp, BA_inx },
+	/* $E9 */ { 2, 0, 2, BM_imm, BA_sbc },
+	/* $EA */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $EB */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $EC */ { 3, 0, 4, BM_abso, BA_cpx },
+	/* $ED */ { 3, 0, 4, BM_abso, BA_sbc },
+	/* $EE */ { 3, 0, 6, BM_abso, BA_inc },
+	/* $EF */ { 3, 0, 2, BM_zprel, BA_bbs6 },
+	/* $F0 */ { 2, 0, 2, BM_rel, BA_beq },
+	/* $F1 */ { 2, 0, 5, BM_indy, BA_sbc },
+	/* $F2 */ { 2, 0, 5, BM_ind0, BA_sbc },
+	/* $F3 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $F4 */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $F5 */ { 2, 0, 4, BM_zpx, BA_sbc },
+	/* $F6 */ { 2, 0, 6, BM_zpx, BA_inc },
+	/* $F7 */ { 2, 0, 5, BM_zp, BA_smb7 },
+	/* $F8 */ { 1, 0, 2, BM_imp, BA_sed },
+	/* $F9 */ { 3, 0, 4, BM_absy, BA_sbc },
+	/* $FA */ { 1, 0, 4, BM_imp, BA_plx },
+	/* $FB */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $FC */ { 1, 0, 2, BM_imp, BA_nop },
+	/* $FD */ { 3, 0, 4, BM_absx, BA_sbc },
+	/* $FE */ { 3, 0, 7, BM_absx, BA_inc },
+	/* $FF */ { 3, 0, 2, BM_zprel, BA_bbs7 }
+};
@@ -3,7 +3,8 @@
 #
 #		File:			buildtables.py
 #		Date:			3rd September 2019
-#		Purpose:		Creates files tables.h from the .opcodes descriptors
+#		Purpose:		Creates the fused interpreter dispatch.h from the .opcodes descriptors
+#						Creates the block cache decode table and dispatch.
 #						Creates disassembly include file.
 #		Author:			Paul Robson (paul@robson.org.uk)
 #		Formatted By: 	Jeries Abedrabbo (jabedrabbo@asaltech.com)
@@ -32,11 +33,33 @@ OPCODE_REGEX_STR = "^(?P<{actnCode}>\\w+)\\s+(?P<{addrMode}>\\w+)\\s+(?P<{mchnCy
 
 #####################################
 ########## HEADER CONSTANTS #########
-ADDR_MODE_HEADER = "static void (*addrtable[256])() = {"
-ACTN_CODE_HEADER = "static void (*optable[256])() = {"
-MCHN_CYCLES_HEADER = "static const uint32_t ticktable[256] = {"
+DISPATCH_TABLE_HEADER = "static const void *const dispatchtable[256] = {"
 MNEMONICS_DISASSEM_HEADER = "static const char *mnemonics[256] = {"
-TABLE_MAP = "/*{0:8}|  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |{0:5}*/\n"
+BLOCK_TABLE_HEADER = "static const blockinfo blocktable[256] = {"
+
+#####################################
+######### DISPATCH CONSTANTS ########
+# modes that can add a cycle when indexing crosses a page
+PENALTY_MODES = ["absx", "absy", "indy"]
+# suffix of the handler used when an action operates on the accumulator
+ACC_HANDLER_SUFFIX = "a"
+MODE_CALL = "{}(cpu);"
+
+#####################################
+######## BLOCK CACHE CONSTANTS ######
+# address modes work on pre-decoded operands in the block cache
+BLOCK_MODE_CALL = "bc_{}(cpu, op);"
+# instruction length in bytes for each address mode
+MODE_LENGTHS = {
+    "imp": 1, "acc": 1,
+    "imm": 2, "zp": 2, "zpx": 2, "zpy": 2, "rel": 2, "indx": 2, "indy": 2, "ind0": 2,
+    "abso": 3, "absx": 3, "absy": 3, "ind": 3, "ainx": 3, "zprel": 3
+}
+# actions after which execution never falls through to the next instruction
+BLOCK_END_ACTIONS = ["brk", "bra", "dbg", "jmp", "jsr", "rti", "rts", "wai"]
+# names of the address mode and action of each opcode, for the JIT
+BLOCK_MODE_ENUM = "BM_{}"
+BLOCK_ACTION_ENUM = "BA_{}"
 
 #####################################
 ######### OPCODE CONSTANTS ##########
@@ -48,8 +71,10 @@ TOTAL_NUMBER_OPCODES = 2 ** 8
 
 #####################################
 ############# FILENAMES #############
-TABLES_HEADER_FNAME = "tables.h"
+DISPATCH_HEADER_FNAME = "dispatch.h"
 MNEMONICS_DISASSEM_HEADER_FNAME = "mnemonics.h"
+BLOCK_TABLE_HEADER_FNAME = "blocktable.h"
+BLOCK_DISPATCH_HEADER_FNAME = "blockdispatch.h"
 OPCODES_6502_FNAME = "6502.opcodes"
 OPCODES_65c02_FNAME = "65c02.opcodes"
 
@@ -98,25 +123,67 @@ def fillNop():
 
 
 #######################################################################################################################
-###################################################  Output a table  ##################################################
+#########################################  Output the computed goto label table  ######################################
 #######################################################################################################################
-def generateTable(hFileName, header, element):
-    spacing = 5
-    hFileName.write("{}{}{}".format("\n", header, "\n"))
-    hFileName.write(TABLE_MAP.format("", ""))
+def generateDispatchTable(hFileName):
+    hFileName.write("\n#ifdef DISPATCH_COMPUTED_GOTO{}{}".format("\n", DISPATCH_TABLE_HEADER))
     for row in range(0, OPCODE_ROW_LEN):
-        elements = ",".join(
-            ["{0:>9}".format(opcodesList[opcodeItem][element])[-spacing:] for opcodeItem in
-             range(row * OPCODE_ROW_LEN, OPCODE_ROW_LEN * (row + 1))])
-
-        hFileName.write("/* {0:X} */ {3}  {1}{2} /* {0:X} */\n".format(
-            row,
-            elements,
-            " " if row == OPCODE_ROW_LEN - 1 else ",",
-            " " if element == ACTN_KEY_STR else "")
+        hFileName.write("\n\t/* {0:X} */".format(row))
+        for op in range(0, OPCODE_ROW_LEN):
+            hFileName.write(" &&op_{0:02X}{1}".format(row * OPCODE_ROW_LEN + op, "" if row == OPCODE_ROW_LEN-1 and op == OPCODE_ROW_LEN-1 else ","))
+    hFileName.write("\n};\n#endif\n")
+
+
+#######################################################################################################################
+#########################################  Output one specialized case per opcode  ####################################
+#######################################################################################################################
+def generateDispatch(hFileName, modeCall):
+    hFileName.write("\nDISPATCH_BEGIN\n")
+    for opInfo in opcodesList:
+        mode = opInfo[MODE_KEY_STR]
+        action = opInfo[ACTN_KEY_STR]
+        cycles = opInfo[CYCLES_KEY_STR]
+
+        body = []
+        if mode in PENALTY_MODES:
+            body.append("cpu->penaltyop = 0; cpu->penaltyaddr = 0;")
+            cycles = "{} + (cpu->penaltyop & cpu->penaltyaddr)".format(cycles)
+        body.append(modeCall.format(mode))
+        if mode == "acc":
+            action = action + ACC_HANDLER_SUFFIX
+        body.append("{}(cpu);".format(action))
+
+        hFileName.write("OPCODE({0:02X}) /* {1} {2} */\n\t{3}\n\tNEXT({4})\n".format(
+            opInfo[OPCODE_KEY_STR],
+            opInfo[ACTN_KEY_STR],
+            opInfo[MODE_KEY_STR],
+            " ".join(body),
+            cycles)
         )
-    hFileName.write("};\n")
+    hFileName.write("DISPATCH_END\n")
+
 
+#######################################################################################################################
+########################################  Output the block cache decode table  ########################################
+#######################################################################################################################
+def generateBlockTable(hFileName):
+    modes = sorted(set(opInfo[MODE_KEY_STR] for opInfo in opcodesList))
+    actions = sorted(set(opInfo[ACTN_KEY_STR] for opInfo in opcodesList))
+    hFileName.write("\nenum {{\n\t{}\n}};\n".format(",\n\t".join(BLOCK_MODE_ENUM.format(m) for m in modes)))
+    hFileName.write("\nenum {{\n\t{}\n}};\n".format(",\n\t".join(BLOCK_ACTION_ENUM.format(a) for a in actions)))
+
+    hFileName.write("\n{}\n".format(BLOCK_TABLE_HEADER))
+    for opInfo in opcodesList:
+        hFileName.write("\t/* ${0:02X} */ {{ {1}, {2}, {3}, {4}, {5} }}{6}\n".format(
+            opInfo[OPCODE_KEY_STR],
+            MODE_LENGTHS[opInfo[MODE_KEY_STR]],
+            1 if opInfo[ACTN_KEY_STR] in BLOCK_END_ACTIONS else 0,
+            opInfo[CYCLES_KEY_STR],
+            BLOCK_MODE_ENUM.format(opInfo[MODE_KEY_STR]),
+            BLOCK_ACTION_ENUM.format(opInfo[ACTN_KEY_STR]),
+            "" if opInfo[OPCODE_KEY_STR] == TOTAL_NUMBER_OPCODES-1 else ",")
+        )
+    hFileName.write("};\n")
 
 
 #######################################################################################################################
@@ -172,12 +239,22 @@ if __name__ == '__main__':
     # Fill opcodes list with NOP instructions
     fillNop()
 
-    # Create "TABLES_HEADER_FNAME" header file
-    with open(TABLES_HEADER_FNAME, "w") as output_h_file:
+    # Create "DISPATCH_HEADER_FNAME" header file
+    with open(DISPATCH_HEADER_FNAME, "w") as output_h_file:
+        output_h_file.write("/* Generated by buildtables.py */\n")
+        generateDispatchTable(output_h_file)
+        generateDispatch(output_h_file, MODE_CALL)
+
+    # Create "BLOCK_TABLE_HEADER_FNAME" header file
+    with open(BLOCK_TABLE_HEADER_FNAME, "w") as output_h_file:
+        output_h_file.write("/* Generated by buildtables.py */\n")
+        generateBlockTable(output_h_file)
+
+    # Create "BLOCK_DISPATCH_HEADER_FNAME" header file
+    with open(BLOCK_DISPATCH_HEADER_FNAME, "w") as output_h_file:
         output_h_file.write("/* Generated by buildtables.py */\n")
-        generateTable(output_h_file, ADDR_MODE_HEADER, MODE_KEY_STR)
-        generateTable(output_h_file, ACTN_CODE_HEADER, ACTN_KEY_STR)
-        generateTable(output_h_file, MCHN_CYCLES_HEADER, CYCLES_KEY_STR)
+        generateDispatchTable(output_h_file)
+        generateDispatch(output_h_file, BLOCK_MODE_CALL)
 
     # Create disassembly "MNEMONICS_DISASSEM_HEADER_FNAME" header file.
     mnemonics = [convertMnemonic(opcodesList[x]) for x in range(0, TOTAL_NUMBER_OPCODES)]
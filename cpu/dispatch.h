@@ -0,0 +1,793 @@
+/* Generated by buildtables.py */
+
+#ifdef DISPATCH_COMPUTED_GOTO
+static const void *const dispatchtable[256] = {
+	/* 0 */ &&op_00, &&op_01, &&op_02, &&op_03, &&op_04, &&op_05, &&op_06, &&op_07, &&op_08, &&op_09, &&op_0A, &&op_0B, &&op_0C, &&op_0D, &&op_0E, &&op_0F,
+	/* 1 */ &&op_10, &&op_11, &&op_12, &&op_13, &&op_14, &&op_15, &&op_16, &&op_17, &&op_18, &&op_19, &&op_1A, &&op_1B, &&op_1C, &&op_1D, &&op_1E, &&op_1F,
+	/* 2 */ &&op_20, &&op_21, &&op_22, &&op_23, &&op_24, &&op_25, &&op_26, &&op_27, &&op_28, &&op_29, &&op_2A, &&op_2B, &&op_2C, &&op_2D, &&op_2E, &&op_2F,
+	/* 3 */ &&op_30, &&op_31, &&op_32, &&op_33, &&op_34, &&op_35, &&op_36, &&op_37, &&op_38, &&op_39, &&op_3A, &&op_3B, &&op_3C, &&op_3D, &&op_3E, &&op_3F,
+	/* 4 */ &&op_40, &&op_41, &&op_42, &&op_43, &&op_44, &&op_45, &&op_46, &&op_47, &&op_48, &&op_49, &&op_4A, &&op_4B, &&op_4C, &&op_4D, &&op_4E, &&op_4F,
+	/* 5 */ &&op_50, &&op_51, &&op_52, &&op_53, &&op_54, &&op_55, &&op_56, &&op_57, &&op_58, &&op_59, &&op_5A, &&op_5B, &&op_5C, &&op_5D, &&op_5E, &&op_5F,
+	/* 6 */ &&op_60, &&op_61, &&op_62, &&op_63, &&op_64, &&op_65, &&op_66, &&op_67, &&op_68, &&op_69, &&op_6A, &&op_6B, &&op_6C, &&op_6D, &&op_6E, &&op_6F,
+	/* 7 */ &&op_70, &&op_71, &&op_72, &&op_73, &&op_74, &&op_75, &&op_76, &&op_77, &&op_78, &&op_79, &&op_7A, &&op_7B, &&op_7C, &&op_7D, &&op_7E, &&op_7F,
+	/* 8 */ &&op_80, &&op_81, &&op_82, &&op_83, &&op_84, &&op_85, &&op_86, &&op_87, &&op_88, &&op_89, &&op_8A, &&op_8B, &&op_8C, &&op_8D, &&op_8E, &&op_8F,
+	/* 9 */ &&op_90, &&op_91, &&op_92, &&op_93, &&op_94, &&op_95, &&op_96, &&op_97, &&op_98, &&op_99, &&op_9A, &&op_9B, &&op_9C, &&op_9D, &&op_9E, &&op_9F,
+	/* A */ &&op_A0, &&op_A1, &&op_A2, &&op_A3, &&op_A4, &&op_A5, &&op_A6, &&op_A7, &&op_A8, &&op_A9, &&op_AA, &&op_AB, &&op_AC, &&op_AD, &&op_AE, &&op_AF,
+	/* B */ &&op_B0, &&op_B1, &&op_B2, &&op_B3, &&op_B4, &&op_B5, &&op_B6, &&op_B7, &&op_B8, &&op_B9, &&op_BA, &&op_BB, &&op_BC, &&op_BD, &&op_BE, &&op_BF,
+	/* C */ &&op_C0, &&op_C1, &&op_C2, &&op_C3, &&op_C4, &&op_C5, &&op_C6, &&op_C7, &&op_C8, &&op_C9, &&op_CA, &&op_CB, &&op_CC, &&op_CD, &&op_CE, &&op_CF,
+	/* D */ &&op_D0, &&op_D1, &&op_D2, &&op_D3, &&op_D4, &&op_D5, &&op_D6, &&op_D7, &&op_D8, &&op_D9, &&op_DA, &&op_DB, &&op_DC, &&op_DD, &&op_DE, &&op_DF,
+	/* E */ &&op_E0, &&op_E1, &&op_E2, &&op_E3, &&op_E4, &&op_E5, &&op_E6, &&op_E7, &&op_E8, &&op_E9, &&op_EA, &&op_EB, &&op_EC, &&op_ED, &&op_EE, &&op_EF,
+	/* F */ &&op_F0, &&op_F1, &&op_F2, &&op_F3, &&op_F4, &&op_F5, &&op_F6, &&op_F7, &&op_F8, &&op_F9, &&op_FA, &&op_FB, &&op_FC, &&op_FD, &&op_FE, &&op_FF
+};
+#endif
+
+DISPATCH_BEGIN
+OPCODE(00) /* brk imp */
+	imp(cpu); brk(cpu);
+	NEXT(7)
+OPCODE(01) /* ora indx */
+	indx(cpu); ora(cpu);
+	NEXT(6)
+OPCODE(02) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(03) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(04) /* tsb zp */
+	zp(cpu); tsb(cpu);
+	NEXT(5)
+OPCODE(05) /* ora zp */
+	zp(cpu); ora(cpu);
+	NEXT(3)
+OPCODE(06) /* asl zp */
+	zp(cpu); asl(cpu);
+	NEXT(5)
+OPCODE(07) /* rmb0 zp */
+	zp(cpu); rmb0(cpu);
+	NEXT(5)
+OPCODE(08) /* php imp */
+	imp(cpu); php(cpu);
+	NEXT(3)
+OPCODE(09) /* ora imm */
+	imm(cpu); ora(cpu);
+	NEXT(2)
+OPCODE(0A) /* asl acc */
+	acc(cpu); asla(cpu);
+	NEXT(2)
+OPCODE(0B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(0C) /* tsb abso */
+	abso(cpu); tsb(cpu);
+	NEXT(6)
+OPCODE(0D) /* ora abso */
+	abso(cpu); ora(cpu);
+	NEXT(4)
+OPCODE(0E) /* asl abso */
+	abso(cpu); asl(cpu);
+	NEXT(6)
+OPCODE(0F) /* bbr0 zprel */
+	zprel(cpu); bbr0(cpu);
+	NEXT(2)
+OPCODE(10) /* bpl rel */
+	rel(cpu); bpl(cpu);
+	NEXT(2)
+OPCODE(11) /* ora indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); ora(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(12) /* ora ind0 */
+	ind0(cpu); ora(cpu);
+	NEXT(5)
+OPCODE(13) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(14) /* trb zp */
+	zp(cpu); trb(cpu);
+	NEXT(5)
+OPCODE(15) /* ora zpx */
+	zpx(cpu); ora(cpu);
+	NEXT(4)
+OPCODE(16) /* asl zpx */
+	zpx(cpu); asl(cpu);
+	NEXT(6)
+OPCODE(17) /* rmb1 zp */
+	zp(cpu); rmb1(cpu);
+	NEXT(5)
+OPCODE(18) /* clc imp */
+	imp(cpu); clc(cpu);
+	NEXT(2)
+OPCODE(19) /* ora absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); ora(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1A) /* inc acc */
+	acc(cpu); inca(cpu);
+	NEXT(2)
+OPCODE(1B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(1C) /* trb abso */
+	abso(cpu); trb(cpu);
+	NEXT(6)
+OPCODE(1D) /* ora absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); ora(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1E) /* asl absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); asl(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(1F) /* bbr1 zprel */
+	zprel(cpu); bbr1(cpu);
+	NEXT(2)
+OPCODE(20) /* jsr abso */
+	abso(cpu); jsr(cpu);
+	NEXT(6)
+OPCODE(21) /* and indx */
+	indx(cpu); and(cpu);
+	NEXT(6)
+OPCODE(22) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(23) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(24) /* bit zp */
+	zp(cpu); bit(cpu);
+	NEXT(3)
+OPCODE(25) /* and zp */
+	zp(cpu); and(cpu);
+	NEXT(3)
+OPCODE(26) /* rol zp */
+	zp(cpu); rol(cpu);
+	NEXT(5)
+OPCODE(27) /* rmb2 zp */
+	zp(cpu); rmb2(cpu);
+	NEXT(5)
+OPCODE(28) /* plp imp */
+	imp(cpu); plp(cpu);
+	NEXT(4)
+OPCODE(29) /* and imm */
+	imm(cpu); and(cpu);
+	NEXT(2)
+OPCODE(2A) /* rol acc */
+	acc(cpu); rola(cpu);
+	NEXT(2)
+OPCODE(2B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(2C) /* bit abso */
+	abso(cpu); bit(cpu);
+	NEXT(4)
+OPCODE(2D) /* and abso */
+	abso(cpu); and(cpu);
+	NEXT(4)
+OPCODE(2E) /* rol abso */
+	abso(cpu); rol(cpu);
+	NEXT(6)
+OPCODE(2F) /* bbr2 zprel */
+	zprel(cpu); bbr2(cpu);
+	NEXT(2)
+OPCODE(30) /* bmi rel */
+	rel(cpu); bmi(cpu);
+	NEXT(2)
+OPCODE(31) /* and indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); and(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(32) /* and ind0 */
+	ind0(cpu); and(cpu);
+	NEXT(5)
+OPCODE(33) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(34) /* bit zpx */
+	zpx(cpu); bit(cpu);
+	NEXT(4)
+OPCODE(35) /* and zpx */
+	zpx(cpu); and(cpu);
+	NEXT(4)
+OPCODE(36) /* rol zpx */
+	zpx(cpu); rol(cpu);
+	NEXT(6)
+OPCODE(37) /* rmb3 zp */
+	zp(cpu); rmb3(cpu);
+	NEXT(5)
+OPCODE(38) /* sec imp */
+	imp(cpu); sec(cpu);
+	NEXT(2)
+OPCODE(39) /* and absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); and(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3A) /* dec acc */
+	acc(cpu); deca(cpu);
+	NEXT(2)
+OPCODE(3B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(3C) /* bit absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); bit(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3D) /* and absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); and(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3E) /* rol absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); rol(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(3F) /* bbr3 zprel */
+	zprel(cpu); bbr3(cpu);
+	NEXT(2)
+OPCODE(40) /* rti imp */
+	imp(cpu); rti(cpu);
+	NEXT(6)
+OPCODE(41) /* eor indx */
+	indx(cpu); eor(cpu);
+	NEXT(6)
+OPCODE(42) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(43) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(44) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(45) /* eor zp */
+	zp(cpu); eor(cpu);
+	NEXT(3)
+OPCODE(46) /* lsr zp */
+	zp(cpu); lsr(cpu);
+	NEXT(5)
+OPCODE(47) /* rmb4 zp */
+	zp(cpu); rmb4(cpu);
+	NEXT(5)
+OPCODE(48) /* pha imp */
+	imp(cpu); pha(cpu);
+	NEXT(3)
+OPCODE(49) /* eor imm */
+	imm(cpu); eor(cpu);
+	NEXT(2)
+OPCODE(4A) /* lsr acc */
+	acc(cpu); lsra(cpu);
+	NEXT(2)
+OPCODE(4B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(4C) /* jmp abso */
+	abso(cpu); jmp(cpu);
+	NEXT(3)
+OPCODE(4D) /* eor abso */
+	abso(cpu); eor(cpu);
+	NEXT(4)
+OPCODE(4E) /* lsr abso */
+	abso(cpu); lsr(cpu);
+	NEXT(6)
+OPCODE(4F) /* bbr4 zprel */
+	zprel(cpu); bbr4(cpu);
+	NEXT(2)
+OPCODE(50) /* bvc rel */
+	rel(cpu); bvc(cpu);
+	NEXT(2)
+OPCODE(51) /* eor indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); eor(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(52) /* eor ind0 */
+	ind0(cpu); eor(cpu);
+	NEXT(5)
+OPCODE(53) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(54) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(55) /* eor zpx */
+	zpx(cpu); eor(cpu);
+	NEXT(4)
+OPCODE(56) /* lsr zpx */
+	zpx(cpu); lsr(cpu);
+	NEXT(6)
+OPCODE(57) /* rmb5 zp */
+	zp(cpu); rmb5(cpu);
+	NEXT(5)
+OPCODE(58) /* cli imp */
+	imp(cpu); cli(cpu);
+	NEXT(2)
+OPCODE(59) /* eor absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); eor(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5A) /* phy imp */
+	imp(cpu); phy(cpu);
+	NEXT(3)
+OPCODE(5B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(5C) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(5D) /* eor absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); eor(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5E) /* lsr absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); lsr(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(5F) /* bbr5 zprel */
+	zprel(cpu); bbr5(cpu);
+	NEXT(2)
+OPCODE(60) /* rts imp */
+	imp(cpu); rts(cpu);
+	NEXT(6)
+OPCODE(61) /* adc indx */
+	indx(cpu); adc(cpu);
+	NEXT(6)
+OPCODE(62) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(63) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(64) /* stz zp */
+	zp(cpu); stz(cpu);
+	NEXT(3)
+OPCODE(65) /* adc zp */
+	zp(cpu); adc(cpu);
+	NEXT(3)
+OPCODE(66) /* ror zp */
+	zp(cpu); ror(cpu);
+	NEXT(5)
+OPCODE(67) /* rmb6 zp */
+	zp(cpu); rmb6(cpu);
+	NEXT(5)
+OPCODE(68) /* pla imp */
+	imp(cpu); pla(cpu);
+	NEXT(4)
+OPCODE(69) /* adc imm */
+	imm(cpu); adc(cpu);
+	NEXT(2)
+OPCODE(6A) /* ror acc */
+	acc(cpu); rora(cpu);
+	NEXT(2)
+OPCODE(6B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(6C) /* jmp ind */
+	ind(cpu); jmp(cpu);
+	NEXT(5)
+OPCODE(6D) /* adc abso */
+	abso(cpu); adc(cpu);
+	NEXT(4)
+OPCODE(6E) /* ror abso */
+	abso(cpu); ror(cpu);
+	NEXT(6)
+OPCODE(6F) /* bbr6 zprel */
+	zprel(cpu); bbr6(cpu);
+	NEXT(2)
+OPCODE(70) /* bvs rel */
+	rel(cpu); bvs(cpu);
+	NEXT(2)
+OPCODE(71) /* adc indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); adc(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(72) /* adc ind0 */
+	ind0(cpu); adc(cpu);
+	NEXT(5)
+OPCODE(73) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(74) /* stz zpx */
+	zpx(cpu); stz(cpu);
+	NEXT(4)
+OPCODE(75) /* adc zpx */
+	zpx(cpu); adc(cpu);
+	NEXT(4)
+OPCODE(76) /* ror zpx */
+	zpx(cpu); ror(cpu);
+	NEXT(6)
+OPCODE(77) /* rmb7 zp */
+	zp(cpu); rmb7(cpu);
+	NEXT(5)
+OPCODE(78) /* sei imp */
+	imp(cpu); sei(cpu);
+	NEXT(2)
+OPCODE(79) /* adc absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); adc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7A) /* ply imp */
+	imp(cpu); ply(cpu);
+	NEXT(4)
+OPCODE(7B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(7C) /* jmp ainx */
+	ainx(cpu); jmp(cpu);
+	NEXT(6)
+OPCODE(7D) /* adc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); adc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7E) /* ror absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); ror(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(7F) /* bbr7 zprel */
+	zprel(cpu); bbr7(cpu);
+	NEXT(2)
+OPCODE(80) /* bra rel */
+	rel(cpu); bra(cpu);
+	NEXT(3)
+OPCODE(81) /* sta indx */
+	indx(cpu); sta(cpu);
+	NEXT(6)
+OPCODE(82) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(83) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(84) /* sty zp */
+	zp(cpu); sty(cpu);
+	NEXT(3)
+OPCODE(85) /* sta zp */
+	zp(cpu); sta(cpu);
+	NEXT(3)
+OPCODE(86) /* stx zp */
+	zp(cpu); stx(cpu);
+	NEXT(3)
+OPCODE(87) /* smb0 zp */
+	zp(cpu); smb0(cpu);
+	NEXT(5)
+OPCODE(88) /* dey imp */
+	imp(cpu); dey(cpu);
+	NEXT(2)
+OPCODE(89) /* bit imm */
+	imm(cpu); bit(cpu);
+	NEXT(2)
+OPCODE(8A) /* txa imp */
+	imp(cpu); txa(cpu);
+	NEXT(2)
+OPCODE(8B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(8C) /* sty abso */
+	abso(cpu); sty(cpu);
+	NEXT(4)
+OPCODE(8D) /* sta abso */
+	abso(cpu); sta(cpu);
+	NEXT(4)
+OPCODE(8E) /* stx abso */
+	abso(cpu); stx(cpu);
+	NEXT(4)
+OPCODE(8F) /* bbs0 zprel */
+	zprel(cpu); bbs0(cpu);
+	NEXT(2)
+OPCODE(90) /* bcc rel */
+	rel(cpu); bcc(cpu);
+	NEXT(2)
+OPCODE(91) /* sta indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); sta(cpu);
+	NEXT(6 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(92) /* sta ind0 */
+	ind0(cpu); sta(cpu);
+	NEXT(5)
+OPCODE(93) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(94) /* sty zpx */
+	zpx(cpu); sty(cpu);
+	NEXT(4)
+OPCODE(95) /* sta zpx */
+	zpx(cpu); sta(cpu);
+	NEXT(4)
+OPCODE(96) /* stx zpy */
+	zpy(cpu); stx(cpu);
+	NEXT(4)
+OPCODE(97) /* smb1 zp */
+	zp(cpu); smb1(cpu);
+	NEXT(5)
+OPCODE(98) /* tya imp */
+	imp(cpu); tya(cpu);
+	NEXT(2)
+OPCODE(99) /* sta absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); sta(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9A) /* txs imp */
+	imp(cpu); txs(cpu);
+	NEXT(2)
+OPCODE(9B) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(9C) /* stz abso */
+	abso(cpu); stz(cpu);
+	NEXT(4)
+OPCODE(9D) /* sta absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); sta(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9E) /* stz absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); stz(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(9F) /* bbs1 zprel */
+	zprel(cpu); bbs1(cpu);
+	NEXT(2)
+OPCODE(A0) /* ldy imm */
+	imm(cpu); ldy(cpu);
+	NEXT(2)
+OPCODE(A1) /* lda indx */
+	indx(cpu); lda(cpu);
+	NEXT(6)
+OPCODE(A2) /* ldx imm */
+	imm(cpu); ldx(cpu);
+	NEXT(2)
+OPCODE(A3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(A4) /* ldy zp */
+	zp(cpu); ldy(cpu);
+	NEXT(3)
+OPCODE(A5) /* lda zp */
+	zp(cpu); lda(cpu);
+	NEXT(3)
+OPCODE(A6) /* ldx zp */
+	zp(cpu); ldx(cpu);
+	NEXT(3)
+OPCODE(A7) /* smb2 zp */
+	zp(cpu); smb2(cpu);
+	NEXT(5)
+OPCODE(A8) /* tay imp */
+	imp(cpu); tay(cpu);
+	NEXT(2)
+OPCODE(A9) /* lda imm */
+	imm(cpu); lda(cpu);
+	NEXT(2)
+OPCODE(AA) /* tax imp */
+	imp(cpu); tax(cpu);
+	NEXT(2)
+OPCODE(AB) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(AC) /* ldy abso */
+	abso(cpu); ldy(cpu);
+	NEXT(4)
+OPCODE(AD) /* lda abso */
+	abso(cpu); lda(cpu);
+	NEXT(4)
+OPCODE(AE) /* ldx abso */
+	abso(cpu); ldx(cpu);
+	NEXT(4)
+OPCODE(AF) /* bbs2 zprel */
+	zprel(cpu); bbs2(cpu);
+	NEXT(2)
+OPCODE(B0) /* bcs rel */
+	rel(cpu); bcs(cpu);
+	NEXT(2)
+OPCODE(B1) /* lda indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); lda(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(B2) /* lda ind0 */
+	ind0(cpu); lda(cpu);
+	NEXT(5)
+OPCODE(B3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(B4) /* ldy zpx */
+	zpx(cpu); ldy(cpu);
+	NEXT(4)
+OPCODE(B5) /* lda zpx */
+	zpx(cpu); lda(cpu);
+	NEXT(4)
+OPCODE(B6) /* ldx zpy */
+	zpy(cpu); ldx(cpu);
+	NEXT(4)
+OPCODE(B7) /* smb3 zp */
+	zp(cpu); smb3(cpu);
+	NEXT(5)
+OPCODE(B8) /* clv imp */
+	imp(cpu); clv(cpu);
+	NEXT(2)
+OPCODE(B9) /* lda absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); lda(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BA) /* tsx imp */
+	imp(cpu); tsx(cpu);
+	NEXT(2)
+OPCODE(BB) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(BC) /* ldy absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); ldy(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BD) /* lda absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); lda(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BE) /* ldx absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); ldx(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(BF) /* bbs3 zprel */
+	zprel(cpu); bbs3(cpu);
+	NEXT(2)
+OPCODE(C0) /* cpy imm */
+	imm(cpu); cpy(cpu);
+	NEXT(2)
+OPCODE(C1) /* cmp indx */
+	indx(cpu); cmp(cpu);
+	NEXT(6)
+OPCODE(C2) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(C3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(C4) /* cpy zp */
+	zp(cpu); cpy(cpu);
+	NEXT(3)
+OPCODE(C5) /* cmp zp */
+	zp(cpu); cmp(cpu);
+	NEXT(3)
+OPCODE(C6) /* dec zp */
+	zp(cpu); dec(cpu);
+	NEXT(5)
+OPCODE(C7) /* smb4 zp */
+	zp(cpu); smb4(cpu);
+	NEXT(5)
+OPCODE(C8) /* iny imp */
+	imp(cpu); iny(cpu);
+	NEXT(2)
+OPCODE(C9) /* cmp imm */
+	imm(cpu); cmp(cpu);
+	NEXT(2)
+OPCODE(CA) /* dex imp */
+	imp(cpu); dex(cpu);
+	NEXT(2)
+OPCODE(CB) /* wai imp */
+	imp(cpu); wai(cpu);
+	NEXT(3)
+OPCODE(CC) /* cpy abso */
+	abso(cpu); cpy(cpu);
+	NEXT(4)
+OPCODE(CD) /* cmp abso */
+	abso(cpu); cmp(cpu);
+	NEXT(4)
+OPCODE(CE) /* dec abso */
+	abso(cpu); dec(cpu);
+	NEXT(6)
+OPCODE(CF) /* bbs4 zprel */
+	zprel(cpu); bbs4(cpu);
+	NEXT(2)
+OPCODE(D0) /* bne rel */
+	rel(cpu); bne(cpu);
+	NEXT(2)
+OPCODE(D1) /* cmp indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); cmp(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(D2) /* cmp ind0 */
+	ind0(cpu); cmp(cpu);
+	NEXT(5)
+OPCODE(D3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(D4) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(D5) /* cmp zpx */
+	zpx(cpu); cmp(cpu);
+	NEXT(4)
+OPCODE(D6) /* dec zpx */
+	zpx(cpu); dec(cpu);
+	NEXT(6)
+OPCODE(D7) /* smb5 zp */
+	zp(cpu); smb5(cpu);
+	NEXT(5)
+OPCODE(D8) /* cld imp */
+	imp(cpu); cld(cpu);
+	NEXT(2)
+OPCODE(D9) /* cmp absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); cmp(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DA) /* phx imp */
+	imp(cpu); phx(cpu);
+	NEXT(3)
+OPCODE(DB) /* dbg imp */
+	imp(cpu); dbg(cpu);
+	NEXT(1)
+OPCODE(DC) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(DD) /* cmp absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); cmp(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DE) /* dec absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); dec(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(DF) /* bbs5 zprel */
+	zprel(cpu); bbs5(cpu);
+	NEXT(2)
+OPCODE(E0) /* cpx imm */
+	imm(cpu); cpx(cpu);
+	NEXT(2)
+OPCODE(E1) /* sbc indx */
+	indx(cpu); sbc(cpu);
+	NEXT(6)
+OPCODE(E2) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(E3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(E4) /* cpx zp */
+	zp(cpu); cpx(cpu);
+	NEXT(3)
+OPCODE(E5) /* sbc zp */
+	zp(cpu); sbc(cpu);
+	NEXT(3)
+OPCODE(E6) /* inc zp */
+	zp(cpu); inc(cpu);
+	NEXT(5)
+OPCODE(E7) /* smb6 zp */
+	zp(cpu); smb6(cpu);
+	NEXT(5)
+OPCODE(E8) /* inx imp */
+	imp(cpu); inx(cpu);
+	NEXT(2)
+OPCODE(E9) /* sbc imm */
+	imm(cpu); sbc(cpu);
+	NEXT(2)
+OPCODE(EA) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(EB) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(EC) /* cpx abso */
+	abso(cpu); cpx(cpu);
+	NEXT(4)
+OPCODE(ED) /* sbc abso */
+	abso(cpu); sbc(cpu);
+	NEXT(4)
+OPCODE(EE) /* inc abso */
+	abso(cpu); inc(cpu);
+	NEXT(6)
+OPCODE(EF) /* bbs6 zprel */
+	zprel(cpu); bbs6(cpu);
+	NEXT(2)
+OPCODE(F0) /* beq rel */
+	rel(cpu); beq(cpu);
+	NEXT(2)
+OPCODE(F1) /* sbc indy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; indy(cpu); sbc(cpu);
+	NEXT(5 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(F2) /* sbc ind0 */
+	ind0(cpu); sbc(cpu);
+	NEXT(5)
+OPCODE(F3) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(F4) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(F5) /* sbc zpx */
+	zpx(cpu); sbc(cpu);
+	NEXT(4)
+OPCODE(F6) /* inc zpx */
+	zpx(cpu); inc(cpu);
+	NEXT(6)
+OPCODE(F7) /* smb7 zp */
+	zp(cpu); smb7(cpu);
+	NEXT(5)
+OPCODE(F8) /* sed imp */
+	imp(cpu); sed(cpu);
+	NEXT(2)
+OPCODE(F9) /* sbc absy */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absy(cpu); sbc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FA) /* plx imp */
+	imp(cpu); plx(cpu);
+	NEXT(4)
+OPCODE(FB) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(FC) /* nop imp */
+	imp(cpu); nop(cpu);
+	NEXT(2)
+OPCODE(FD) /* sbc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); sbc(cpu);
+	NEXT(4 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FE) /* inc absx */
+	cpu->penaltyop = 0; cpu->penaltyaddr = 0; absx(cpu); inc(cpu);
+	NEXT(7 + (cpu->penaltyop & cpu->penaltyaddr))
+OPCODE(FF) /* bbs7 zprel */
+	zprel(cpu); bbs7(cpu);
+	NEXT(2)
+DISPATCH_END
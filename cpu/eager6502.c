@@ -0,0 +1,27 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+// The CPU core once more, with N, Z, C and V updated on every instruction
+// and without the JIT, under names that end in _eager. Lockstep runs its
+// reference machine on it, so a mistake in the lazy flags of the core the
+// emulator runs shows up as a difference. Only the interpreter is used:
+// blockcache6502_eager stays 0.
+
+#define NO_LAZY_FLAGS
+#define NO_JIT
+
+#define reset6502 reset6502_eager
+#define step6502 step6502_eager
+#define exec6502 exec6502_eager
+#define irq6502 irq6502_eager
+#define nmi6502 nmi6502_eager
+#define yield6502 yield6502_eager
+#define hookexternal hookexternal_eager
+#define idleloop6502 idleloop6502_eager
+#define idleskip6502 idleskip6502_eager
+#define free6502 free6502_eager
+#define blockcache6502 blockcache6502_eager
+#define jit6502 jit6502_eager
+
+#include "fake6502.c"
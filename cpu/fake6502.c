@@ -80,6 +80,10 @@
  * void irq6502()                                    *
  *   - Trigger a hardware IRQ in the 6502 core.      *
  *                                                   *
+ * void yield6502()                                  *
+ *   - Make exec6502() return after the current      *
+ *     instruction.                                  *
+ *                                                   *
  * void nmi6502()                                    *
  *   - Trigger an NMI in the 6502 core.              *
  *                                                   *
@@ -102,9 +106,13 @@
  *                                                   *
  *****************************************************/
 
+#define _DEFAULT_SOURCE //for MAP_ANONYMOUS in jit.h
+
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "../debugger.h"
+#include "../machine.h"
 
 //6502 defines
 #define UNDOCUMENTED //when this is defined, undocumented opcodes are handled.
@@ -115,6 +123,11 @@
                      //CPU in the Nintendo Entertainment System does not
                      //support BCD operation.
 
+#ifndef NO_LAZY_FLAGS
+#define LAZY_FLAGS   //when this is defined, N, Z, C and V are only computed
+#endif               //when something reads them. status is current outside
+                     //of exec6502() and step6502().
+
 #define FLAG_CARRY     0x01
 #define FLAG_ZERO      0x02
 #define FLAG_INTERRUPT 0x04
@@ -127,20 +140,6 @@
 #define BASE_STACK     0x100
 
 
-//6502 CPU registers
-uint16_t pc;
-uint8_t sp, a, x, y, status;
-
-
-//helper variables
-uint32_t instructions = 0; //keep track of total instructions executed
-uint32_t clockticks6502 = 0, clockgoal6502 = 0;
-uint16_t oldpc, ea, reladdr, value, result;
-uint8_t opcode, oldstatus;
-
-uint8_t penaltyop, penaltyaddr;
-uint8_t waiting = 0;
-
 //externally supplied functions
 extern uint8_t read6502(uint16_t address);
 extern void write6502(uint16_t address, uint8_t value);
@@ -148,102 +147,202 @@ extern void write6502(uint16_t address, uint8_t value);
 #include "support.h"
 #include "modes.h"
 
-static void (*addrtable[256])();
-static void (*optable[256])();
-
-static uint16_t getvalue() {
-    if (addrtable[opcode] == acc) return((uint16_t)a);
-        else return((uint16_t)read6502(ea));
+static uint16_t getvalue(cpu6502_t *cpu) {
+    return((uint16_t)read6502(cpu->ea));
 }
 
-__attribute__((unused)) static uint16_t getvalue16() {
-    return((uint16_t)read6502(ea) | ((uint16_t)read6502(ea+1) << 8));
+__attribute__((unused)) static uint16_t getvalue16(cpu6502_t *cpu) {
+    return((uint16_t)read6502(cpu->ea) | ((uint16_t)read6502(cpu->ea+1) << 8));
 }
 
-static void putvalue(uint16_t saveval) {
-    if (addrtable[opcode] == acc) a = (uint8_t)(saveval & 0x00FF);
-        else write6502(ea, (saveval & 0x00FF));
+static void putvalue(cpu6502_t *cpu, uint16_t saveval) {
+    write6502(cpu->ea, (saveval & 0x00FF));
 }
 
 #include "instructions.h"
 #include "65c02.h"
-#include "tables.h"
 
 void nmi6502() {
-    push16(pc);
-    push8(status);
-    status |= FLAG_INTERRUPT;
-    pc = (uint16_t)read6502(0xFFFA) | ((uint16_t)read6502(0xFFFB) << 8);
-	waiting = 0;
+    cpu6502_t *cpu = &machine->cpu;
+    push16(cpu, cpu->pc);
+    push8(cpu, cpu->status);
+    cpu->status |= FLAG_INTERRUPT;
+    cpu->pc = (uint16_t)read6502(0xFFFA) | ((uint16_t)read6502(0xFFFB) << 8);
+	cpu->waiting = 0;
 }
 
 void irq6502() {
-    push16(pc);
-    push8(status & ~FLAG_BREAK);
-    status |= FLAG_INTERRUPT;
-    pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
-	waiting = 0;
+    cpu6502_t *cpu = &machine->cpu;
+    push16(cpu, cpu->pc);
+    push8(cpu, cpu->status & ~FLAG_BREAK);
+    cpu->status |= FLAG_INTERRUPT;
+    cpu->pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
+	cpu->waiting = 0;
+}
+
+//
+//          Fused interpreter
+//
+//          dispatch.h is generated by buildtables.py and holds one case per opcode
+//          with the addressing mode inlined, so there is no indirect call through
+//          an address mode or instruction table. With GCC/Clang the cases are
+//          threaded through a computed goto table instead of a switch.
+//
+#if defined(__GNUC__) && !defined(NO_COMPUTED_GOTO)
+#define DISPATCH_COMPUTED_GOTO
+#endif
+
+#define FETCH() \
+    cpu->lastpc = cpu->pc; \
+    cpu->opcode = read6502(cpu->pc++); \
+    cpu->status |= FLAG_CONSTANT
+
+#define RETIRE(cycles) \
+    cpu->clockticks6502 += (cycles); \
+    cpu->instructions++; \
+    if (cpu->callexternal) (*cpu->loopexternal)()
+
+#define DONE() ((int32_t)(cpu->clockticks6502 - cpu->clockgoal6502) >= 0 || cpu->waiting)
+
+// between instructions, the host also gets control back before a trap address
+#define STOP() (DONE() || memory_is_trap(cpu->pc))
+
+#ifdef DISPATCH_COMPUTED_GOTO
+#define DISPATCH_BEGIN FETCH(); goto *dispatchtable[cpu->opcode];
+#define OPCODE(n) op_##n:
+#define NEXT(cycles) RETIRE(cycles); if (STOP()) return; FETCH(); goto *dispatchtable[cpu->opcode];
+#define DISPATCH_END
+#else
+#define DISPATCH_BEGIN for (;;) { FETCH(); switch (cpu->opcode) {
+#define OPCODE(n) case 0x##n:
+#define NEXT(cycles) RETIRE(cycles); break;
+#define DISPATCH_END } if (STOP()) return; }
+#endif
+
+// runs instructions until clockgoal6502 is reached, the CPU starts waiting
+// or it gets to a trap address
+static void run6502(cpu6502_t *cpu) {
+    if (DONE()) return;
+
+#include "dispatch.h"
 }
 
-uint8_t callexternal = 0;
-void (*loopexternal)();
+#include "blockcache.h"
+#include "jit.h"
+#include "idle.h"
+
+// same as run6502, but executes pre-decoded blocks from the block cache;
+// a block is left when it branches, its memory is written or banks change.
+// Blocks end before trap addresses, so only the start of one can be a trap.
+#define BLOCKFETCH() \
+    cpu->lastpc = cpu->pc; \
+    cpu->pc = op->next; \
+    cpu->opcode = op->opcode; \
+    cpu->status |= FLAG_CONSTANT
+
+#define BLOCKDONE() (DONE() || cpu->pc != op->next || *code_epoch != epoch || op + 1 == end)
+
+#undef DISPATCH_BEGIN
+#undef NEXT
+#undef DISPATCH_END
+#ifdef DISPATCH_COMPUTED_GOTO
+#define DISPATCH_BEGIN BLOCKFETCH(); goto *dispatchtable[cpu->opcode];
+#define NEXT(cycles) RETIRE(cycles); if (BLOCKDONE()) goto blockdone; op++; BLOCKFETCH(); goto *dispatchtable[cpu->opcode];
+#define DISPATCH_END
+#else
+#define DISPATCH_BEGIN for (;;) { BLOCKFETCH(); switch (cpu->opcode) {
+#define NEXT(cycles) RETIRE(cycles); break;
+#define DISPATCH_END } if (BLOCKDONE()) goto blockdone; op++; }
+#endif
+
+static void runblocks6502(cpu6502_t *cpu) {
+    const uint32_t *code_epoch = &machine->memory.code_epoch;
+
+    if (!cpu->blockcache) {
+        cpu->blockcache = calloc(BLOCKCACHE_SIZE, sizeof(block));
+    }
+    if (DONE()) return;
+    do {
+        block *b = blocklookup(cpu, cpu->pc);
+        if (!b) {
+            // not cacheable, interpret a single instruction
+            uint32_t goal = cpu->clockgoal6502;
+            uint32_t step = cpu->clockgoal6502 = cpu->clockticks6502 + 1;
+            run6502(cpu);
+            if (cpu->clockgoal6502 == step) cpu->clockgoal6502 = goal;	// unless it yielded
+            continue;
+        }
+        if (jit6502 && jitrun(cpu, b)) continue;
+
+        uint32_t epoch = *code_epoch;
+        const blockop *op = b->ops;
+        const blockop *end = op + b->count;
+
+#include "blockdispatch.h"
+blockdone:
+        ;
+    } while (!STOP());
+}
 
 void exec6502(uint32_t tickcount) {
-	if (waiting) {
-		clockticks6502 += tickcount;
-		clockgoal6502 = clockticks6502;
+    cpu6502_t *cpu = &machine->cpu;
+
+	if (cpu->waiting) {
+		cpu->clockticks6502 += tickcount;
+		cpu->clockgoal6502 = cpu->clockticks6502;
 		return;
     }
 
-    clockgoal6502 += tickcount;
-   
-    while (clockticks6502 < clockgoal6502) {
-        opcode = read6502(pc++);
-        status |= FLAG_CONSTANT;
-
-        penaltyop = 0;
-        penaltyaddr = 0;
-
-        (*addrtable[opcode])();
-        (*optable[opcode])();
-        clockticks6502 += ticktable[opcode];
-        if (penaltyop && penaltyaddr) clockticks6502++;
-
-        instructions++;
+    cpu->clockgoal6502 += tickcount;
 
-        if (callexternal) (*loopexternal)();
-    }
+    loadflags();
+    if (blockcache6502) runblocks6502(cpu);
+    else run6502(cpu);
+    saveflags();
 }
 
 void step6502() {
-	if (waiting) {
-		++clockticks6502;
-		clockgoal6502 = clockticks6502;
+    cpu6502_t *cpu = &machine->cpu;
+
+	if (cpu->waiting) {
+		++cpu->clockticks6502;
+		cpu->clockgoal6502 = cpu->clockticks6502;
 		return;
 	}
 
-    opcode = read6502(pc++);
-    status |= FLAG_CONSTANT;
+    cpu->clockgoal6502 = cpu->clockticks6502 + 1;
 
-    penaltyop = 0;
-    penaltyaddr = 0;
+    loadflags();
+    if (blockcache6502) runblocks6502(cpu);
+    else run6502(cpu);
+    saveflags();
 
-    (*addrtable[opcode])();
-    (*optable[opcode])();
-    clockticks6502 += ticktable[opcode];
-    if (penaltyop && penaltyaddr) clockticks6502++;
-    clockgoal6502 = clockticks6502;
+    cpu->clockgoal6502 = cpu->clockticks6502;
+}
 
-    instructions++;
+// called from device code, e.g. when an I/O access raised the IRQ line
+void yield6502() {
+    cpu6502_t *cpu = &machine->cpu;
 
-    if (callexternal) (*loopexternal)();
+    cpu->clockgoal6502 = cpu->clockticks6502;
 }
 
 void hookexternal(void *funcptr) {
+    cpu6502_t *cpu = &machine->cpu;
+
     if (funcptr != (void *)NULL) {
-        loopexternal = funcptr;
-        callexternal = 1;
-    } else callexternal = 0;
+        cpu->loopexternal = funcptr;
+        cpu->callexternal = 1;
+    } else cpu->callexternal = 0;
+}
+
+// releases what the block cache, JIT and idle loop detector allocated
+void free6502(cpu6502_t *cpu) {
+    free(cpu->blockcache);
+    jitfree(cpu);
+    free(cpu->idleloop);
+    cpu->blockcache = NULL;
+    cpu->idleloop = NULL;
 }
 
 //  Fixes from http://6502.org/tutorials/65c02opcodes.html
@@ -7,10 +7,48 @@
 
 #include <stdint.h>
 
+typedef struct {
+	// registers
+	uint16_t pc;
+	uint8_t sp, a, x, y, status;
+
+	// N, Z, C and V while they are evaluated lazily (see support.h)
+	uint8_t lazyn, lazyz, lazyc, lazyv;
+
+	uint32_t instructions; // total instructions executed
+	uint32_t clockticks6502, clockgoal6502;
+	uint16_t oldpc, ea, reladdr, value, result;
+	uint8_t opcode, oldstatus;
+	uint8_t penaltyop, penaltyaddr;
+	uint8_t waiting;
+	uint16_t lastpc; // where the last instruction run started
+
+	uint8_t callexternal;
+	void (*loopexternal)();
+
+	// block cache, JIT and idle loop state, allocated on first use
+	struct block *blockcache;
+	uint8_t *jitbuffer, *jitptr;
+	uint8_t jitfailed; // no executable memory, the blocks are interpreted
+	struct idleloop *idleloop;
+} cpu6502_t;
+
+// these work on the CPU of the current machine
 extern void reset6502();
 extern void step6502();
 extern void exec6502(uint32_t tickcount);
 extern void irq6502();
-extern uint32_t clockticks6502;
+extern void yield6502();
+extern uint32_t idleloop6502(uint16_t from);
+extern void idleskip6502(uint32_t iterations);
+
+extern void free6502(cpu6502_t *cpu);
+
+extern uint8_t blockcache6502;
+extern uint8_t jit6502;
+
+// the same core with eager flags and no caches, for lockstep (eager6502.c)
+extern void step6502_eager();
+extern void irq6502_eager();
 
 #endif
@@ -0,0 +1,136 @@
+// *******************************************************************************************
+// *******************************************************************************************
+//
+//		File:		idle.h
+//		Purpose:	Detection of idle polling loops.
+//
+//		A loop qualifies if its body, from the target of a backward branch or jump up to
+//		that branch, doesn't write memory or use the stack and only reads immediates, zero
+//		page or absolute addresses outside the I/O page. If the CPU gets back to the top of
+//		such a loop after running the body once, with the same registers as last time, the
+//		next iteration will do exactly the same, and so will every one after it until an
+//		interrupt (or the host) changes something.
+//
+// *******************************************************************************************
+// *******************************************************************************************
+
+#define IDLE_MAX_BODY 64			// longest loop body considered, in bytes
+
+struct idleloop {
+    uint16_t top;					// target of the backward branch
+    uint16_t bottom;				// the branch itself
+    uint8_t ok;						// the body qualifies
+    uint8_t count;					// instructions in the body
+    uint8_t a, x, y, sp, status;	// registers at the top of the last iteration
+    uint32_t period;				// cycles per iteration, once verified
+    uint32_t clock;					// clockticks6502 at the top of the last iteration
+    uint32_t instructions;
+};
+
+// is the instruction at address harmless to repeat?
+static int idlesafe(uint16_t address, const blockinfo *info, int last) {
+    uint16_t operand = (uint16_t)read6502(address + 1) | ((uint16_t)read6502(address + 2) << 8);
+
+    switch (info->action) {
+        case BA_adc: case BA_and: case BA_bit: case BA_cmp: case BA_cpx: case BA_cpy:
+        case BA_eor: case BA_lda: case BA_ldx: case BA_ldy: case BA_ora: case BA_sbc:
+        case BA_clc: case BA_cld: case BA_cli: case BA_clv: case BA_sec: case BA_sed: case BA_sei:
+        case BA_tax: case BA_tay: case BA_tsx: case BA_txa: case BA_txs: case BA_tya:
+        case BA_inx: case BA_iny: case BA_dex: case BA_dey: case BA_nop:
+        case BA_bcc: case BA_bcs: case BA_beq: case BA_bmi: case BA_bne: case BA_bpl:
+        case BA_bvc: case BA_bvs:
+        case BA_bbr0: case BA_bbr1: case BA_bbr2: case BA_bbr3:
+        case BA_bbr4: case BA_bbr5: case BA_bbr6: case BA_bbr7:
+        case BA_bbs0: case BA_bbs1: case BA_bbs2: case BA_bbs3:
+        case BA_bbs4: case BA_bbs5: case BA_bbs6: case BA_bbs7:
+            break;
+        case BA_asl: case BA_lsr: case BA_rol: case BA_ror: case BA_inc: case BA_dec:
+            if (info->mode != BM_acc) return 0;
+            break;
+        case BA_bra:
+        case BA_jmp:
+            if (!last) return 0;	// would never get to the bottom
+            break;
+        default:
+            return 0;
+    }
+
+    switch (info->mode) {
+        case BM_imp: case BM_acc: case BM_imm: case BM_rel:
+        case BM_zp: case BM_zpx: case BM_zpy: case BM_zprel:
+            return 1;
+        case BM_abso:
+            return info->action == BA_jmp || (operand >> 8) != 0x9F;
+        case BM_absx:
+        case BM_absy:
+            return (operand >> 8) != 0x9F && ((uint16_t)(operand + 0xFF) >> 8) != 0x9F;
+        default:
+            return 0;				// the pointer could lead anywhere
+    }
+}
+
+static void idleanalyze(struct idleloop *idleloop, uint16_t top, uint16_t bottom) {
+    idleloop->top = top;
+    idleloop->bottom = bottom;
+    idleloop->ok = 0;
+    idleloop->count = 0;
+
+    // don't touch I/O registers while decoding
+    if ((uint16_t)(bottom - top) > IDLE_MAX_BODY || (top <= 0x9FFF && bottom + 2 >= 0x9F00)) return;
+
+    uint16_t address = top;
+    for (;;) {
+        const blockinfo *info = &blocktable[read6502(address)];
+        int last = address == bottom;
+        if (!idlesafe(address, info, last)) return;
+        idleloop->count++;
+        if (last) break;
+        address += info->length;
+        if ((uint16_t)(address - top) > (uint16_t)(bottom - top)) return;	// stepped over the bottom
+    }
+    idleloop->ok = 1;
+}
+
+// Called after the instruction at from has taken the CPU backwards to pc. Returns the
+// number of cycles per iteration if pc is the top of an idle loop, 0 otherwise.
+uint32_t idleloop6502(uint16_t from) {
+    cpu6502_t *cpu = &machine->cpu;
+    struct idleloop *idleloop = cpu->idleloop;
+    uint32_t period = 0;
+
+    if (!idleloop) {
+        idleloop = cpu->idleloop = calloc(1, sizeof(struct idleloop));
+    }
+    if (idleloop->top != cpu->pc || idleloop->bottom != from) {
+        idleanalyze(idleloop, cpu->pc, from);
+    } else if (idleloop->ok &&
+               cpu->instructions - idleloop->instructions == idleloop->count &&
+               cpu->a == idleloop->a && cpu->x == idleloop->x && cpu->y == idleloop->y &&
+               cpu->sp == idleloop->sp && cpu->status == idleloop->status) {
+        period = cpu->clockticks6502 - idleloop->clock;
+    }
+    idleloop->period = period;
+
+    idleloop->a = cpu->a;
+    idleloop->x = cpu->x;
+    idleloop->y = cpu->y;
+    idleloop->sp = cpu->sp;
+    idleloop->status = cpu->status;
+    idleloop->clock = cpu->clockticks6502;
+    idleloop->instructions = cpu->instructions;
+    return period;
+}
+
+// advances the clock over further iterations of the idle loop the CPU is at the top of
+void idleskip6502(uint32_t iterations) {
+    cpu6502_t *cpu = &machine->cpu;
+    struct idleloop *idleloop = cpu->idleloop;
+    uint32_t cycles = iterations * idleloop->period;
+    uint32_t count = iterations * idleloop->count;
+
+    cpu->clockticks6502 += cycles;
+    cpu->clockgoal6502 = cpu->clockticks6502;
+    cpu->instructions += count;
+    idleloop->clock += cycles;
+    idleloop->instructions += count;
+}
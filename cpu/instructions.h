@@ -14,14 +14,14 @@
 //
 //          instruction handler functions
 //
-static void adc() {
-    penaltyop = 1;
+static void adc(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
     #ifndef NES_CPU
-    if (status & FLAG_DECIMAL) {
+    if (cpu->status & FLAG_DECIMAL) {
         uint16_t tmp, tmp2;
-        value = getvalue();
-        tmp = ((uint16_t)a & 0x0F) + (value & 0x0F) + (uint16_t)(status & FLAG_CARRY);
-        tmp2 = ((uint16_t)a & 0xF0) + (value & 0xF0);
+        cpu->value = getvalue(cpu);
+        tmp = ((uint16_t)cpu->a & 0x0F) + (cpu->value & 0x0F) + (uint16_t)getcarry();
+        tmp2 = ((uint16_t)cpu->a & 0xF0) + (cpu->value & 0xF0);
         if (tmp > 0x09) {
             tmp2 += 0x10;
             tmp += 0x06;
@@ -34,474 +34,522 @@ static void adc() {
         } else {
             clearcarry();
         }
-        result = (tmp & 0x0F) | (tmp2 & 0xF0);
+        cpu->result = (tmp & 0x0F) | (tmp2 & 0xF0);
 
-        zerocalc(result);                /* 65C02 change, Decimal Arithmetic sets NZV */
-        signcalc(result);
+        zerocalc(cpu->result);                /* 65C02 change, Decimal Arithmetic sets NZV */
+        signcalc(cpu->result);
 
-        clockticks6502++;
+        cpu->clockticks6502++;
     } else {
     #endif
-        value = getvalue();
-        result = (uint16_t)a + value + (uint16_t)(status & FLAG_CARRY);
+        cpu->value = getvalue(cpu);
+        cpu->result = (uint16_t)cpu->a + cpu->value + (uint16_t)getcarry();
 
-        carrycalc(result);
-        zerocalc(result);
-        overflowcalc(result, a, value);
-        signcalc(result);
+        carrycalc(cpu->result);
+        zerocalc(cpu->result);
+        overflowcalc(cpu->result, cpu->a, cpu->value);
+        signcalc(cpu->result);
     #ifndef NES_CPU
     }
     #endif
 
-    saveaccum(result);
+    saveaccum(cpu->result);
 }
 
-static void and() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a & value;
+static void and(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->a & cpu->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    saveaccum(result);
+    saveaccum(cpu->result);
 }
 
-static void asl() {
-    value = getvalue();
-    result = value << 1;
+static void asl(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = cpu->value << 1;
 
-    carrycalc(result);
-    zerocalc(result);
-    signcalc(result);
+    carrycalc(cpu->result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    putvalue(cpu, cpu->result);
 }
 
-static void bcc() {
-    if ((status & FLAG_CARRY) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void asla(cpu6502_t *cpu) {
+    cpu->value = (uint16_t)cpu->a;
+    cpu->result = cpu->value << 1;
+
+    carrycalc(cpu->result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
+
+    saveaccum(cpu->result);
+}
+
+static void bcc(cpu6502_t *cpu) {
+    if (!getcarry()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void bcs() {
-    if ((status & FLAG_CARRY) == FLAG_CARRY) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bcs(cpu6502_t *cpu) {
+    if (getcarry()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void beq() {
-    if ((status & FLAG_ZERO) == FLAG_ZERO) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void beq(cpu6502_t *cpu) {
+    if (testzero()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void bit() {
-    value = getvalue();
-    result = (uint16_t)a & value;
+static void bit(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->a & cpu->value;
 
-    zerocalc(result);
-    status = (status & 0x3F) | (uint8_t)(value & 0xC0);
+    zerocalc(cpu->result);
+    setnv(cpu->value);
 }
 
-static void bmi() {
-    if ((status & FLAG_SIGN) == FLAG_SIGN) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bmi(cpu6502_t *cpu) {
+    if (testsign()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void bne() {
-    if ((status & FLAG_ZERO) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bne(cpu6502_t *cpu) {
+    if (!testzero()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void bpl() {
-    if ((status & FLAG_SIGN) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bpl(cpu6502_t *cpu) {
+    if (!testsign()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void brk() {
-    pc++;
+static void brk(cpu6502_t *cpu) {
+    cpu->pc++;
 
 
-    push16(pc); //push next instruction address onto stack
-    push8(status | FLAG_BREAK); //push CPU status to stack
+    push16(cpu, cpu->pc); //push next instruction address onto stack
+    push8(cpu, getstatus() | FLAG_BREAK); //push CPU status to stack
     setinterrupt(); //set interrupt flag
     cleardecimal();       // clear decimal flag (65C02 change)
-    pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
+    cpu->pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
 }
 
-static void bvc() {
-    if ((status & FLAG_OVERFLOW) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bvc(cpu6502_t *cpu) {
+    if (!testoverflow()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void bvs() {
-    if ((status & FLAG_OVERFLOW) == FLAG_OVERFLOW) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bvs(cpu6502_t *cpu) {
+    if (testoverflow()) {
+        cpu->oldpc = cpu->pc;
+        cpu->pc += cpu->reladdr;
+        if ((cpu->oldpc & 0xFF00) != (cpu->pc & 0xFF00)) cpu->clockticks6502 += 2; //check if jump crossed a page boundary
+            else cpu->clockticks6502++;
     }
 }
 
-static void clc() {
+static void clc(cpu6502_t *cpu) {
     clearcarry();
 }
 
-static void cld() {
+static void cld(cpu6502_t *cpu) {
     cleardecimal();
 }
 
-static void cli() {
+static void cli(cpu6502_t *cpu) {
     clearinterrupt();
 }
 
-static void clv() {
+static void clv(cpu6502_t *cpu) {
     clearoverflow();
 }
 
-static void cmp() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a - value;
+static void cmp(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->a - cpu->value;
 
-    if (a >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (cpu->a >= (uint8_t)(cpu->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (a == (uint8_t)(value & 0x00FF)) setzero();
+    if (cpu->a == (uint8_t)(cpu->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(cpu->result);
 }
 
-static void cpx() {
-    value = getvalue();
-    result = (uint16_t)x - value;
+static void cpx(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->x - cpu->value;
 
-    if (x >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (cpu->x >= (uint8_t)(cpu->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (x == (uint8_t)(value & 0x00FF)) setzero();
+    if (cpu->x == (uint8_t)(cpu->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(cpu->result);
 }
 
-static void cpy() {
-    value = getvalue();
-    result = (uint16_t)y - value;
+static void cpy(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->y - cpu->value;
 
-    if (y >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (cpu->y >= (uint8_t)(cpu->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (y == (uint8_t)(value & 0x00FF)) setzero();
+    if (cpu->y == (uint8_t)(cpu->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(cpu->result);
 }
 
-static void dec() {
-    value = getvalue();
-    result = value - 1;
+static void dec(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = cpu->value - 1;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    putvalue(cpu, cpu->result);
 }
 
-static void dex() {
-    x--;
+static void dex(cpu6502_t *cpu) {
+    cpu->x--;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void dey() {
-    y--;
+static void dey(cpu6502_t *cpu) {
+    cpu->y--;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(cpu->y);
+    signcalc(cpu->y);
 }
 
-static void eor() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a ^ value;
+static void eor(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->a ^ cpu->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    saveaccum(result);
+    saveaccum(cpu->result);
 }
 
-static void inc() {
-    value = getvalue();
-    result = value + 1;
+static void inc(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = cpu->value + 1;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    putvalue(cpu, cpu->result);
 }
 
-static void inx() {
-    x++;
+static void inx(cpu6502_t *cpu) {
+    cpu->x++;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void iny() {
-    y++;
+static void iny(cpu6502_t *cpu) {
+    cpu->y++;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(cpu->y);
+    signcalc(cpu->y);
 }
 
-static void jmp() {
-    pc = ea;
+static void jmp(cpu6502_t *cpu) {
+    cpu->pc = cpu->ea;
 }
 
-static void jsr() {
-    push16(pc - 1);
-    pc = ea;
+static void jsr(cpu6502_t *cpu) {
+    push16(cpu, cpu->pc - 1);
+    cpu->pc = cpu->ea;
 }
 
-static void lda() {
-    penaltyop = 1;
-    value = getvalue();
-    a = (uint8_t)(value & 0x00FF);
+static void lda(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->a = (uint8_t)(cpu->value & 0x00FF);
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
 }
 
-static void ldx() {
-    penaltyop = 1;
-    value = getvalue();
-    x = (uint8_t)(value & 0x00FF);
+static void ldx(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->x = (uint8_t)(cpu->value & 0x00FF);
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void ldy() {
-    penaltyop = 1;
-    value = getvalue();
-    y = (uint8_t)(value & 0x00FF);
+static void ldy(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->y = (uint8_t)(cpu->value & 0x00FF);
+
+    zerocalc(cpu->y);
+    signcalc(cpu->y);
+}
+
+static void lsr(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = cpu->value >> 1;
+
+    if (cpu->value & 1) setcarry();
+        else clearcarry();
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    zerocalc(y);
-    signcalc(y);
+    putvalue(cpu, cpu->result);
 }
 
-static void lsr() {
-    value = getvalue();
-    result = value >> 1;
+static void lsra(cpu6502_t *cpu) {
+    cpu->value = (uint16_t)cpu->a;
+    cpu->result = cpu->value >> 1;
 
-    if (value & 1) setcarry();
+    if (cpu->value & 1) setcarry();
         else clearcarry();
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    saveaccum(cpu->result);
 }
 
-static void nop() {
-    switch (opcode) {
+static void nop(cpu6502_t *cpu) {
+    switch (cpu->opcode) {
         case 0x1C:
         case 0x3C:
         case 0x5C:
         case 0x7C:
         case 0xDC:
         case 0xFC:
-            penaltyop = 1;
+            cpu->penaltyop = 1;
             break;
     }
 }
 
-static void ora() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a | value;
+static void ora(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
+    cpu->value = getvalue(cpu);
+    cpu->result = (uint16_t)cpu->a | cpu->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    saveaccum(result);
+    saveaccum(cpu->result);
 }
 
-static void pha() {
-    push8(a);
+static void pha(cpu6502_t *cpu) {
+    push8(cpu, cpu->a);
 }
 
-static void php() {
-    push8(status | FLAG_BREAK);
+static void php(cpu6502_t *cpu) {
+    push8(cpu, getstatus() | FLAG_BREAK);
 }
 
-static void pla() {
-    a = pull8();
+static void pla(cpu6502_t *cpu) {
+    cpu->a = pull8(cpu);
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
 }
 
-static void plp() {
-    status = pull8() | FLAG_CONSTANT;
+static void plp(cpu6502_t *cpu) {
+    cpu->status = pull8(cpu) | FLAG_CONSTANT;
+    loadflags();
 }
 
-static void rol() {
-    value = getvalue();
-    result = (value << 1) | (status & FLAG_CARRY);
+static void rol(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = (cpu->value << 1) | getcarry();
 
-    carrycalc(result);
-    zerocalc(result);
-    signcalc(result);
+    carrycalc(cpu->result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
+
+    putvalue(cpu, cpu->result);
+}
+
+static void rola(cpu6502_t *cpu) {
+    cpu->value = (uint16_t)cpu->a;
+    cpu->result = (cpu->value << 1) | getcarry();
+
+    carrycalc(cpu->result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
+
+    saveaccum(cpu->result);
+}
+
+static void ror(cpu6502_t *cpu) {
+    cpu->value = getvalue(cpu);
+    cpu->result = (cpu->value >> 1) | (getcarry() << 7);
+
+    if (cpu->value & 1) setcarry();
+        else clearcarry();
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    putvalue(cpu, cpu->result);
 }
 
-static void ror() {
-    value = getvalue();
-    result = (value >> 1) | ((status & FLAG_CARRY) << 7);
+static void rora(cpu6502_t *cpu) {
+    cpu->value = (uint16_t)cpu->a;
+    cpu->result = (cpu->value >> 1) | (getcarry() << 7);
 
-    if (value & 1) setcarry();
+    if (cpu->value & 1) setcarry();
         else clearcarry();
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(cpu->result);
+    signcalc(cpu->result);
 
-    putvalue(result);
+    saveaccum(cpu->result);
 }
 
-static void rti() {
-    status = pull8();
-    value = pull16();
-    pc = value;
+static void rti(cpu6502_t *cpu) {
+    cpu->status = pull8(cpu);
+    loadflags();
+    cpu->value = pull16(cpu);
+    cpu->pc = cpu->value;
 }
 
-static void rts() {
-    value = pull16();
-    pc = value + 1;
+static void rts(cpu6502_t *cpu) {
+    cpu->value = pull16(cpu);
+    cpu->pc = cpu->value + 1;
 }
 
-static void sbc() {
-    penaltyop = 1;
+static void sbc(cpu6502_t *cpu) {
+    cpu->penaltyop = 1;
 
     #ifndef NES_CPU
-    if (status & FLAG_DECIMAL) {
-        value = getvalue();
-        result = (uint16_t)a - (value & 0x0f) + (status & FLAG_CARRY) - 1;
-        if ((result & 0x0f) > (a & 0x0f)) {
-            result -= 6;
+    if (cpu->status & FLAG_DECIMAL) {
+        cpu->value = getvalue(cpu);
+        cpu->result = (uint16_t)cpu->a - (cpu->value & 0x0f) + getcarry() - 1;
+        if ((cpu->result & 0x0f) > (cpu->a & 0x0f)) {
+            cpu->result -= 6;
         }
-        result -= (value & 0xf0);
-        if ((result & 0xfff0) > ((uint16_t)a & 0xf0)) {
-            result -= 0x60;
+        cpu->result -= (cpu->value & 0xf0);
+        if ((cpu->result & 0xfff0) > ((uint16_t)cpu->a & 0xf0)) {
+            cpu->result -= 0x60;
         }
-        if (result <= (uint16_t)a) {
+        if (cpu->result <= (uint16_t)cpu->a) {
             setcarry();
         } else {
             clearcarry();
         }
 
-        zerocalc(result);                /* 65C02 change, Decimal Arithmetic sets NZV */
-        signcalc(result);
+        zerocalc(cpu->result);                /* 65C02 change, Decimal Arithmetic sets NZV */
+        signcalc(cpu->result);
 
-        clockticks6502++;
+        cpu->clockticks6502++;
     } else {
     #endif
-        value = getvalue() ^ 0x00FF;
-        result = (uint16_t)a + value + (uint16_t)(status & FLAG_CARRY);
+        cpu->value = getvalue(cpu) ^ 0x00FF;
+        cpu->result = (uint16_t)cpu->a + cpu->value + (uint16_t)getcarry();
 
-        carrycalc(result);
-        zerocalc(result);
-        overflowcalc(result, a, value);
-        signcalc(result);
+        carrycalc(cpu->result);
+        zerocalc(cpu->result);
+        overflowcalc(cpu->result, cpu->a, cpu->value);
+        signcalc(cpu->result);
     #ifndef NES_CPU
     }
     #endif
 
-    saveaccum(result);
+    saveaccum(cpu->result);
 }
 
-static void sec() {
+static void sec(cpu6502_t *cpu) {
     setcarry();
 }
 
-static void sed() {
+static void sed(cpu6502_t *cpu) {
     setdecimal();
 }
 
-static void sei() {
+static void sei(cpu6502_t *cpu) {
     setinterrupt();
 }
 
-static void sta() {
-    putvalue(a);
+static void sta(cpu6502_t *cpu) {
+    putvalue(cpu, cpu->a);
 }
 
-static void stx() {
-    putvalue(x);
+static void stx(cpu6502_t *cpu) {
+    putvalue(cpu, cpu->x);
 }
 
-static void sty() {
-    putvalue(y);
+static void sty(cpu6502_t *cpu) {
+    putvalue(cpu, cpu->y);
 }
 
-static void tax() {
-    x = a;
+static void tax(cpu6502_t *cpu) {
+    cpu->x = cpu->a;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void tay() {
-    y = a;
+static void tay(cpu6502_t *cpu) {
+    cpu->y = cpu->a;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(cpu->y);
+    signcalc(cpu->y);
 }
 
-static void tsx() {
-    x = sp;
+static void tsx(cpu6502_t *cpu) {
+    cpu->x = cpu->sp;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(cpu->x);
+    signcalc(cpu->x);
 }
 
-static void txa() {
-    a = x;
+static void txa(cpu6502_t *cpu) {
+    cpu->a = cpu->x;
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
 }
 
-static void txs() {
-    sp = x;
+static void txs(cpu6502_t *cpu) {
+    cpu->sp = cpu->x;
 }
 
-static void tya() {
-    a = y;
+static void tya(cpu6502_t *cpu) {
+    cpu->a = cpu->y;
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(cpu->a);
+    signcalc(cpu->a);
 }
@@ -0,0 +1,999 @@
+// *******************************************************************************************
+// *******************************************************************************************
+//
+//		File:		jit.h
+//		Purpose:	x86-64 translation of hot blocks from the block cache.
+//
+//		A block that has run JIT_THRESHOLD times through the block cache interpreter is
+//		translated to native code, up to its first instruction that isn't handled here.
+//		The native code keeps A, X, Y, the status register and clockticks6502 in host
+//		registers. RAM and ROM are accessed through the memory system's page table
+//		inline; pages without a host pointer (I/O, RAM holding cached code) go through
+//		read6502()/write6502(), so devices, banking and write tracking behave exactly as
+//		in the interpreter. It retires the same cycle counts per instruction and leaves
+//		when clockgoal6502 is reached, when a branch is taken (other than back to the
+//		start of the block) and when a write changes the memory map or cached code.
+//		The cycle counter is stored before every call into the memory system and the
+//		goal reloaded after it, so devices see the right clock and can yield6502().
+//
+// *******************************************************************************************
+// *******************************************************************************************
+
+uint8_t jit6502 = 0;
+
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(NO_JIT)
+
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef JIT_THRESHOLD
+#define JIT_THRESHOLD   32					// interpreted runs before a block is translated
+#endif
+#define JIT_BUFFER_SIZE (8 * 1024 * 1024)
+#define JIT_BLOCK_MAX   8192				// worst case size of one translated block
+#define JIT_MAX_EXITS   (BLOCK_MAX_OPS * 3)
+
+// where code is being emitted, in the buffer of the CPU being compiled for
+static THREAD_LOCAL uint8_t *jitptr;
+
+// host registers
+enum { EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+#define REG_A       EBX
+#define REG_X       R12
+#define REG_Y       R13
+#define REG_STATUS  R14
+#define REG_CLOCK   R15
+#define REG_GOAL    EBP
+
+// stack frame slots
+#define SLOT_EPOCH  0
+#define SLOT_EA     4
+#define SLOT_LO     8
+#define SLOT_PENALTY 12
+
+// ALU r/m32, r32 opcodes
+#define X_ADD  0x01
+#define X_OR   0x09
+#define X_AND  0x21
+#define X_SUB  0x29
+#define X_XOR  0x31
+#define X_MOV  0x89
+
+// group 1 extensions for ALU r/m32, imm
+#define G_ADD  0
+#define G_OR   1
+#define G_AND  4
+#define G_SUB  5
+#define G_XOR  6
+
+// shift extensions
+#define S_SHL  4
+#define S_SHR  5
+
+// condition codes
+#define CC_AE  0x3
+#define CC_E   0x4
+#define CC_NE  0x5
+#define CC_S   0x8
+#define CC_NS  0x9
+
+// *******************************************************************************************
+//
+//										Emitter
+//
+// *******************************************************************************************
+
+static void emit8(uint8_t v) {
+    *jitptr++ = v;
+}
+
+static void emit16(uint16_t v) {
+    memcpy(jitptr, &v, 2);
+    jitptr += 2;
+}
+
+static void emit32(uint32_t v) {
+    memcpy(jitptr, &v, 4);
+    jitptr += 4;
+}
+
+static void emit64(uint64_t v) {
+    memcpy(jitptr, &v, 8);
+    jitptr += 8;
+}
+
+// REX prefix for a reg/rm pair; byte accesses to SPL..DIL always need one
+static void emitrex(int reg, int rm, int bytereg) {
+    uint8_t rex = 0x40 | ((reg & 8) >> 1) | ((rm & 8) >> 3);
+    if (rex != 0x40 || (bytereg >= 4 && bytereg < 8)) emit8(rex);
+}
+
+static void emitmodrm(int mod, int reg, int rm) {
+    emit8((mod << 6) | ((reg & 7) << 3) | (rm & 7));
+}
+
+// op dst, src
+static void emit_rr(uint8_t op, int dst, int src) {
+    emitrex(src, dst, -1);
+    emit8(op);
+    emitmodrm(3, src, dst);
+}
+
+// op dst, imm
+static void emit_ri(int ext, int dst, int32_t imm) {
+    emitrex(0, dst, -1);
+    if (imm >= -128 && imm <= 127) {
+        emit8(0x83);
+        emitmodrm(3, ext, dst);
+        emit8(imm);
+    } else {
+        emit8(0x81);
+        emitmodrm(3, ext, dst);
+        emit32(imm);
+    }
+}
+
+// mov dst, imm
+static void emit_movi(int dst, uint32_t imm) {
+    emitrex(0, dst, -1);
+    emit8(0xB8 + (dst & 7));
+    emit32(imm);
+}
+
+// shl/shr dst, n
+static void emit_shift(int ext, int dst, int n) {
+    emitrex(0, dst, -1);
+    emit8(0xC1);
+    emitmodrm(3, ext, dst);
+    emit8(n);
+}
+
+// test dst, imm
+static void emit_testi(int dst, uint32_t imm) {
+    emitrex(0, dst, -1);
+    emit8(0xF7);
+    emitmodrm(3, 0, dst);
+    emit32(imm);
+}
+
+// movzx dst, src8
+static void emit_movzx8(int dst, int src) {
+    emitrex(dst, src, src);
+    emit8(0x0F);
+    emit8(0xB6);
+    emitmodrm(3, dst, src);
+}
+
+// setcc dst8
+static void emit_setcc(int cc, int dst) {
+    emitrex(0, dst, dst);
+    emit8(0x0F);
+    emit8(0x90 | cc);
+    emitmodrm(3, 0, dst);
+}
+
+// mov rax, imm64
+static void emit_movrax(const void *p) {
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((uint64_t)(uintptr_t)p);
+}
+
+// mov rdi, imm64, the first argument of a call
+static void emit_movrdi(const void *p) {
+    emit8(0x48);
+    emit8(0xBF);
+    emit64((uint64_t)(uintptr_t)p);
+}
+
+// movzx dst, byte [p]
+static void emit_load8(int dst, const void *p) {
+    emit_movrax(p);
+    emitrex(dst, EAX, -1);
+    emit8(0x0F);
+    emit8(0xB6);
+    emitmodrm(0, dst, EAX);
+}
+
+// mov byte [p], src8
+static void emit_store8(const void *p, int src) {
+    emit_movrax(p);
+    emitrex(src, EAX, src);
+    emit8(0x88);
+    emitmodrm(0, src, EAX);
+}
+
+// mov word [p], imm16
+static void emit_store16i(const void *p, uint16_t imm) {
+    emit_movrax(p);
+    emit8(0x66);
+    emit8(0xC7);
+    emitmodrm(0, 0, EAX);
+    emit16(imm);
+}
+
+// mov dst, dword [p]
+static void emit_load32(int dst, const void *p) {
+    emit_movrax(p);
+    emitrex(dst, EAX, -1);
+    emit8(0x8B);
+    emitmodrm(0, dst, EAX);
+}
+
+// mov dword [p], src
+static void emit_store32(const void *p, int src) {
+    emit_movrax(p);
+    emitrex(src, EAX, -1);
+    emit8(0x89);
+    emitmodrm(0, src, EAX);
+}
+
+// mov dst, dword [rsp + slot]
+static void emit_loadslot(int dst, int slot) {
+    emitrex(dst, ESP, -1);
+    emit8(0x8B);
+    emitmodrm(1, dst, ESP);
+    emit8(0x24);
+    emit8(slot);
+}
+
+// mov dword [rsp + slot], src
+static void emit_storeslot(int slot, int src) {
+    emitrex(src, ESP, -1);
+    emit8(0x89);
+    emitmodrm(1, src, ESP);
+    emit8(0x24);
+    emit8(slot);
+}
+
+static void emit_call(const void *fn) {
+    emit_movrax(fn);
+    emit8(0xFF);							// call rax
+    emit8(0xD0);
+}
+
+// jcc/jmp rel32, returns the displacement to patch
+static uint8_t *emit_jcc(int cc) {
+    emit8(0x0F);
+    emit8(0x80 | cc);
+    emit32(0);
+    return jitptr - 4;
+}
+
+static uint8_t *emit_jmp() {
+    emit8(0xE9);
+    emit32(0);
+    return jitptr - 4;
+}
+
+static void patch(uint8_t *at, const uint8_t *target) {
+    int32_t rel = (int32_t)(target - (at + 4));
+    memcpy(at, &rel, 4);
+}
+
+// *******************************************************************************************
+//
+//									6502 building blocks
+//
+// *******************************************************************************************
+
+// a pending exit to the interpreter: pc to continue at, instructions retired and
+// extra cycles of a taken branch
+typedef struct {
+    uint8_t *from;
+    uint16_t pc;
+    uint8_t count;
+    uint8_t cycles;
+    uint8_t loop;		// control transfer that may jump back to the start of the block
+} jitexit;
+
+static THREAD_LOCAL jitexit jitexits[JIT_MAX_EXITS];
+static THREAD_LOCAL int jitexitcount;
+
+// jumps to the common exit with the pc already in edx
+static THREAD_LOCAL uint8_t *jitdynamic[JIT_MAX_EXITS + BLOCK_MAX_OPS];
+static THREAD_LOCAL int jitdynamiccount;
+
+// leaves to a known pc; cc < 0 for an unconditional exit
+static void exit_to(int cc, uint16_t pc, int count, int cycles) {
+    jitexit *e = &jitexits[jitexitcount++];
+    e->from = cc < 0 ? emit_jmp() : emit_jcc(cc);
+    e->pc = pc;
+    e->count = count;
+    e->cycles = cycles;
+    e->loop = 0;
+}
+
+// leaves to a known pc through a branch or jump
+static void exit_branch(int cc, uint16_t pc, int count, int cycles) {
+    exit_to(cc, pc, count, cycles);
+    jitexits[jitexitcount - 1].loop = 1;
+}
+
+// where the i-th instruction of the block starts
+static uint16_t opaddress(const block *b, int i) {
+    return i ? b->ops[i - 1].next : b->pc;
+}
+
+// leaves to the pc in edx
+static void exit_dynamic(cpu6502_t *cpu, block *b, int count) {
+    emit_store16i(&cpu->lastpc, opaddress(b, count - 1));
+    emit_movi(ECX, count);
+    jitdynamic[jitdynamiccount++] = emit_jmp();
+}
+
+// N and Z from an 8 bit value
+static void emit_nz(int reg) {
+    int scratch = reg == ECX ? EDX : ECX;
+    emit_ri(G_AND, REG_STATUS, (uint8_t)~(FLAG_SIGN | FLAG_ZERO));
+    emit_rr(X_MOV, scratch, reg);
+    emit_ri(G_AND, scratch, FLAG_SIGN);
+    emit_rr(X_OR, REG_STATUS, scratch);
+    emit_rr(0x85, reg, reg);				// test reg, reg
+    emit8(0x75);							// jnz +4
+    emit8(4);
+    emit_ri(G_OR, REG_STATUS, FLAG_ZERO);
+}
+
+// C from bit 8 of a 9 bit value
+static void emit_carry8(int reg, int scratch) {
+    emit_rr(X_MOV, scratch, reg);
+    emit_shift(S_SHR, scratch, 8);
+    emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_CARRY);
+    emit_rr(X_OR, REG_STATUS, scratch);
+}
+
+// C from bit 0
+static void emit_carry0(int reg, int scratch) {
+    emit_rr(X_MOV, scratch, reg);
+    emit_ri(G_AND, scratch, 1);
+    emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_CARRY);
+    emit_rr(X_OR, REG_STATUS, scratch);
+}
+
+// rcx = page table entry for the address in edi, jumps to the returned
+// displacement if the page has no host memory
+static uint8_t *emit_pagelookup(uint8_t **table) {
+    emit_rr(X_MOV, EAX, EDI);
+    emit_shift(S_SHR, EAX, 8);
+    emit8(0x48);							// mov rcx, imm64
+    emit8(0xB9);
+    emit64((uint64_t)(uintptr_t)table);
+    emit8(0x48);							// mov rcx, [rcx + rax * 8]
+    emit8(0x8B);
+    emit8(0x0C);
+    emit8(0xC1);
+    emit8(0x48);							// test rcx, rcx
+    emit8(0x85);
+    emit8(0xC9);
+    uint8_t *slow = emit_jcc(CC_E);
+    emit_rr(X_MOV, EDX, EDI);
+    emit_ri(G_AND, EDX, 0xFF);
+    return slow;
+}
+
+// eax = read6502(edi), RAM and ROM are read from the page table inline.
+// Devices see the current clock and may yield6502().
+static void emit_read() {
+    uint8_t *slow = emit_pagelookup(machine->memory.read_page);
+    emit8(0x0F);							// movzx eax, byte [rcx + rdx]
+    emit8(0xB6);
+    emit8(0x04);
+    emit8(0x11);
+    uint8_t *done = emit_jmp();
+    patch(slow, jitptr);
+    emit_store32(&machine->cpu.clockticks6502, REG_CLOCK);
+    emit_call(read6502);
+    emit_movzx8(ECX, EAX);
+    emit_load32(REG_GOAL, &machine->cpu.clockgoal6502);
+    emit_rr(X_MOV, EAX, ECX);
+    patch(done, jitptr);
+}
+
+// write6502(edi, esi), pages without a write pointer (I/O, watched code)
+// go through write6502() itself
+static void emit_write() {
+    uint8_t *slow = emit_pagelookup(machine->memory.write_page);
+    emit8(0x40);							// mov [rcx + rdx], sil
+    emit8(0x88);
+    emit8(0x34);
+    emit8(0x11);
+    uint8_t *done = emit_jmp();
+    patch(slow, jitptr);
+    emit_store32(&machine->cpu.clockticks6502, REG_CLOCK);
+    emit_call(write6502);
+    emit_load32(REG_GOAL, &machine->cpu.clockgoal6502);
+    patch(done, jitptr);
+}
+
+// eax = word at the zero page pointer in edi
+static void emit_readzpword() {
+    emit_storeslot(SLOT_EA, EDI);
+    emit_read();
+    emit_storeslot(SLOT_LO, EAX);
+    emit_loadslot(EDI, SLOT_EA);
+    emit_ri(G_ADD, EDI, 1);
+    emit_ri(G_AND, EDI, 0xFF);
+    emit_read();
+    emit_shift(S_SHL, EAX, 8);
+    emit_loadslot(ECX, SLOT_LO);
+    emit_rr(X_OR, EAX, ECX);
+}
+
+// eax = word at edi
+static void emit_readword() {
+    emit_storeslot(SLOT_EA, EDI);
+    emit_read();
+    emit_storeslot(SLOT_LO, EAX);
+    emit_loadslot(EDI, SLOT_EA);
+    emit_ri(G_ADD, EDI, 1);
+    emit_ri(G_AND, EDI, 0xFFFF);
+    emit_read();
+    emit_shift(S_SHL, EAX, 8);
+    emit_loadslot(ECX, SLOT_LO);
+    emit_rr(X_OR, EAX, ECX);
+}
+
+// the penalty slot = 1 if base + index crosses a page; the clock only
+// takes it after the access, like with the interpreter
+static void emit_penalty(uint16_t base, int index) {
+    emit_rr(X_MOV, EAX, index);
+    emit_ri(G_ADD, EAX, base & 0xFF);
+    emit_shift(S_SHR, EAX, 8);
+    emit_storeslot(SLOT_PENALTY, EAX);
+}
+
+// effective address into edi; returns 0 for modes without one
+static int emit_ea(const blockinfo *info, const blockop *op, int penalty) {
+    switch (info->mode) {
+        case BM_zp:
+        case BM_abso:
+            emit_movi(EDI, op->operand);
+            return 1;
+        case BM_zpx:
+        case BM_zpy:
+            emit_rr(X_MOV, EDI, info->mode == BM_zpx ? REG_X : REG_Y);
+            emit_ri(G_ADD, EDI, op->operand);
+            emit_ri(G_AND, EDI, 0xFF);
+            return 1;
+        case BM_absx:
+        case BM_absy:
+            if (penalty) emit_penalty(op->operand, info->mode == BM_absx ? REG_X : REG_Y);
+            emit_rr(X_MOV, EDI, info->mode == BM_absx ? REG_X : REG_Y);
+            emit_ri(G_ADD, EDI, op->operand);
+            emit_ri(G_AND, EDI, 0xFFFF);
+            return 1;
+        case BM_indx:
+            emit_rr(X_MOV, EDI, REG_X);
+            emit_ri(G_ADD, EDI, op->operand);
+            emit_ri(G_AND, EDI, 0xFF);
+            emit_readzpword();
+            emit_rr(X_MOV, EDI, EAX);
+            return 1;
+        case BM_indy:
+            emit_movi(EDI, op->operand);
+            emit_readzpword();
+            if (penalty) {
+                emit_rr(X_MOV, EDI, EAX);
+                emit_ri(G_AND, EAX, 0xFF);
+                emit_rr(X_ADD, EAX, REG_Y);
+                emit_shift(S_SHR, EAX, 8);
+                emit_storeslot(SLOT_PENALTY, EAX);
+                emit_rr(X_MOV, EAX, EDI);
+            }
+            emit_rr(X_MOV, EDI, EAX);
+            emit_rr(X_ADD, EDI, REG_Y);
+            emit_ri(G_AND, EDI, 0xFFFF);
+            return 1;
+        case BM_ind0:
+            emit_movi(EDI, op->operand);
+            emit_readzpword();
+            emit_rr(X_MOV, EDI, EAX);
+            return 1;
+        case BM_ind:
+            emit_movi(EDI, op->operand);
+            emit_readword();
+            emit_rr(X_MOV, EDI, EAX);
+            return 1;
+        case BM_ainx:
+            emit_rr(X_MOV, EDI, REG_X);
+            emit_ri(G_ADD, EDI, op->operand);
+            emit_ri(G_AND, EDI, 0xFFFF);
+            emit_readword();
+            emit_rr(X_MOV, EDI, EAX);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// operand value into eax
+static void emit_operand(const blockinfo *info, const blockop *op, int penalty) {
+    if (info->mode == BM_imm) {
+        emit_movi(EAX, op->operand & 0xFF);
+    } else {
+        emit_ea(info, op, penalty);
+        emit_read();
+        if (penalty) {
+            emit_loadslot(ECX, SLOT_PENALTY);
+            emit_rr(X_ADD, REG_CLOCK, ECX);
+        }
+    }
+}
+
+// eax = a + eax + C with flags, into a
+static void emit_adc() {
+    emit_rr(X_MOV, ECX, REG_STATUS);
+    emit_ri(G_AND, ECX, FLAG_CARRY);
+    emit_rr(X_ADD, ECX, EAX);
+    emit_rr(X_ADD, ECX, REG_A);
+    emit_rr(X_MOV, EDX, ECX);				// V = (result ^ a) & (result ^ value) & 0x80
+    emit_rr(X_XOR, EDX, REG_A);
+    emit_rr(X_MOV, ESI, ECX);
+    emit_rr(X_XOR, ESI, EAX);
+    emit_rr(X_AND, EDX, ESI);
+    emit_ri(G_AND, EDX, 0x80);
+    emit_shift(S_SHR, EDX, 1);
+    emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_OVERFLOW);
+    emit_rr(X_OR, REG_STATUS, EDX);
+    emit_carry8(ECX, EDX);
+    emit_movzx8(REG_A, ECX);
+    emit_nz(REG_A);
+}
+
+// shift/rotate eax with flags
+static void emit_shiftop(int action) {
+    switch (action) {
+        case BA_asl:
+            emit_shift(S_SHL, EAX, 1);
+            emit_carry8(EAX, ECX);
+            break;
+        case BA_rol:
+            emit_shift(S_SHL, EAX, 1);
+            emit_rr(X_MOV, ECX, REG_STATUS);
+            emit_ri(G_AND, ECX, FLAG_CARRY);
+            emit_rr(X_OR, EAX, ECX);
+            emit_carry8(EAX, ECX);
+            break;
+        case BA_lsr:
+            emit_carry0(EAX, ECX);
+            emit_shift(S_SHR, EAX, 1);
+            break;
+        case BA_ror:
+            emit_rr(X_MOV, EDX, REG_STATUS);
+            emit_ri(G_AND, EDX, FLAG_CARRY);
+            emit_shift(S_SHL, EDX, 7);
+            emit_carry0(EAX, ECX);
+            emit_shift(S_SHR, EAX, 1);
+            emit_rr(X_OR, EAX, EDX);
+            break;
+        case BA_inc:
+            emit_ri(G_ADD, EAX, 1);
+            break;
+        case BA_dec:
+            emit_ri(G_SUB, EAX, 1);
+            break;
+    }
+    emit_ri(G_AND, EAX, 0xFF);
+    emit_nz(EAX);
+}
+
+static int regof(int action) {
+    switch (action) {
+        case BA_ldx: case BA_stx: case BA_cpx: case BA_phx: case BA_plx: case BA_inx: case BA_dex:
+            return REG_X;
+        case BA_ldy: case BA_sty: case BA_cpy: case BA_phy: case BA_ply: case BA_iny: case BA_dey:
+            return REG_Y;
+        default:
+            return REG_A;
+    }
+}
+
+// taken-branch condition as the x86 condition of "test status, flag"
+static int branchcond(int action, uint8_t *flag) {
+    switch (action) {
+        case BA_bcc: *flag = FLAG_CARRY; return CC_E;
+        case BA_bcs: *flag = FLAG_CARRY; return CC_NE;
+        case BA_bne: *flag = FLAG_ZERO; return CC_E;
+        case BA_beq: *flag = FLAG_ZERO; return CC_NE;
+        case BA_bpl: *flag = FLAG_SIGN; return CC_E;
+        case BA_bmi: *flag = FLAG_SIGN; return CC_NE;
+        case BA_bvc: *flag = FLAG_OVERFLOW; return CC_E;
+        case BA_bvs: *flag = FLAG_OVERFLOW; return CC_NE;
+        default: return -1;
+    }
+}
+
+// *******************************************************************************************
+//
+//										Translation
+//
+// *******************************************************************************************
+
+enum {
+    JIT_UNSUPPORTED,	// not translated, the native code stops in front of it
+    JIT_NEXT,			// falls through to the next instruction
+    JIT_WRITES,			// falls through, but may have changed the memory map
+    JIT_RETIRED,		// falls through with its cycles already counted
+    JIT_EXITED			// left the native code itself
+};
+
+// emits the i-th instruction of the block
+static int jitop(cpu6502_t *cpu, block *b, int i) {
+    const blockop *op = &b->ops[i];
+    const blockinfo *info = &blocktable[op->opcode];
+    int action = info->action;
+    int penalty = info->mode == BM_absx || info->mode == BM_absy || info->mode == BM_indy;
+    int count = i + 1;
+    uint8_t flag = 0;
+    int cc;
+
+    switch (action) {
+        case BA_lda: case BA_ldx: case BA_ldy:
+            emit_operand(info, op, penalty);
+            emit_rr(X_MOV, regof(action), EAX);
+            emit_nz(regof(action));
+            break;
+
+        case BA_and: case BA_ora: case BA_eor:
+            emit_operand(info, op, penalty);
+            emit_rr(action == BA_and ? X_AND : action == BA_ora ? X_OR : X_XOR, REG_A, EAX);
+            emit_nz(REG_A);
+            break;
+
+        case BA_adc: case BA_sbc:
+            emit_operand(info, op, penalty);
+            if (action == BA_sbc) emit_ri(G_XOR, EAX, 0xFF);
+            emit_adc();
+            b->binary = 1;
+            break;
+
+        case BA_cmp: case BA_cpx: case BA_cpy:
+            emit_operand(info, op, penalty && action == BA_cmp);
+            emit_rr(X_MOV, ECX, regof(action));
+            emit_rr(X_SUB, ECX, EAX);
+            emit_setcc(CC_AE, EDX);
+            emit_movzx8(EDX, EDX);
+            emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_CARRY);
+            emit_rr(X_OR, REG_STATUS, EDX);
+            emit_movzx8(ECX, ECX);
+            emit_nz(ECX);
+            break;
+
+        case BA_bit:
+            emit_operand(info, op, 0);
+            emit_rr(X_MOV, ECX, EAX);
+            emit_rr(X_AND, ECX, REG_A);
+            emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_ZERO);
+            emit_rr(0x85, ECX, ECX);
+            emit8(0x75);
+            emit8(4);
+            emit_ri(G_OR, REG_STATUS, FLAG_ZERO);
+            emit_ri(G_AND, REG_STATUS, 0x3F);
+            emit_ri(G_AND, EAX, 0xC0);
+            emit_rr(X_OR, REG_STATUS, EAX);
+            break;
+
+        case BA_sta: case BA_stx: case BA_sty: case BA_stz:
+            emit_ea(info, op, 0);
+            if (action == BA_stz) emit_rr(X_XOR, ESI, ESI);
+            else emit_rr(X_MOV, ESI, regof(action));
+            emit_write();
+            return JIT_WRITES;
+
+        case BA_asl: case BA_lsr: case BA_rol: case BA_ror: case BA_inc: case BA_dec:
+            if (info->mode == BM_acc) {
+                emit_rr(X_MOV, EAX, REG_A);
+                emit_shiftop(action);
+                emit_rr(X_MOV, REG_A, EAX);
+                break;
+            }
+            emit_ea(info, op, 0);
+            emit_storeslot(SLOT_EA, EDI);
+            emit_read();
+            emit_shiftop(action);
+            emit_rr(X_MOV, ESI, EAX);
+            emit_loadslot(EDI, SLOT_EA);
+            emit_write();
+            return JIT_WRITES;
+
+        case BA_inx: case BA_iny:
+            emit_ri(G_ADD, regof(action), 1);
+            emit_ri(G_AND, regof(action), 0xFF);
+            emit_nz(regof(action));
+            break;
+
+        case BA_dex: case BA_dey:
+            emit_ri(G_SUB, regof(action), 1);
+            emit_ri(G_AND, regof(action), 0xFF);
+            emit_nz(regof(action));
+            break;
+
+        case BA_tax: case BA_tay: case BA_txa: case BA_tya: {
+            int dst = action == BA_tax ? REG_X : action == BA_tay ? REG_Y : REG_A;
+            int src = action == BA_txa ? REG_X : action == BA_tya ? REG_Y : REG_A;
+            emit_rr(X_MOV, dst, src);
+            emit_nz(dst);
+            break;
+        }
+
+        case BA_tsx:
+            emit_load8(REG_X, &cpu->sp);
+            emit_nz(REG_X);
+            break;
+
+        case BA_txs:
+            emit_store8(&cpu->sp, REG_X);
+            break;
+
+        case BA_clc: emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_CARRY); break;
+        case BA_sec: emit_ri(G_OR, REG_STATUS, FLAG_CARRY); break;
+        case BA_cli: emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_INTERRUPT); break;
+        case BA_sei: emit_ri(G_OR, REG_STATUS, FLAG_INTERRUPT); break;
+        case BA_clv: emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_OVERFLOW); break;
+        case BA_cld: emit_ri(G_AND, REG_STATUS, (uint8_t)~FLAG_DECIMAL); break;
+
+        case BA_nop:
+            break;
+
+        case BA_pha: case BA_phx: case BA_phy: case BA_php:
+            if (action == BA_php) {
+                emit_rr(X_MOV, ESI, REG_STATUS);
+                emit_ri(G_OR, ESI, FLAG_BREAK);
+            } else {
+                emit_rr(X_MOV, ESI, regof(action));
+            }
+            emit_movrdi(cpu);
+            emit_call(push8);
+            return JIT_WRITES;
+
+        case BA_pla: case BA_plx: case BA_ply:
+            emit_movrdi(cpu);
+            emit_call(pull8);
+            emit_movzx8(regof(action), EAX);
+            emit_nz(regof(action));
+            break;
+
+        case BA_bcc: case BA_bcs: case BA_bne: case BA_beq:
+        case BA_bpl: case BA_bmi: case BA_bvc: case BA_bvs:
+        case BA_bra: {
+            uint16_t target = op->next + (uint16_t)(int8_t)op->operand;
+            int extra = (op->next & 0xFF00) != (target & 0xFF00) ? 2 : 1;
+            emit_ri(G_ADD, REG_CLOCK, info->cycles);
+            if (action == BA_bra) {
+                exit_branch(-1, target, count, extra);
+                return JIT_EXITED;
+            }
+            cc = branchcond(action, &flag);
+            emit_testi(REG_STATUS, flag);
+            exit_branch(cc, target, count, extra);
+            return JIT_RETIRED;
+        }
+
+        case BA_jmp:
+            if (info->mode == BM_abso) {
+                emit_ri(G_ADD, REG_CLOCK, info->cycles);
+                exit_branch(-1, op->operand, count, 0);
+                return JIT_EXITED;
+            }
+            emit_ea(info, op, 0);
+            emit_rr(X_MOV, EDX, EDI);
+            emit_ri(G_ADD, REG_CLOCK, info->cycles);
+            exit_dynamic(cpu, b, count);
+            return JIT_EXITED;
+
+        case BA_jsr:
+            emit_movi(ESI, (uint16_t)(op->next - 1));
+            emit_movrdi(cpu);
+            emit_call(push16);
+            emit_ri(G_ADD, REG_CLOCK, info->cycles);
+            exit_to(-1, op->operand, count, 0);
+            return JIT_EXITED;
+
+        case BA_rts:
+            emit_movrdi(cpu);
+            emit_call(pull16);
+            emit8(0x0F);					// movzx edx, ax
+            emit8(0xB7);
+            emitmodrm(3, EDX, EAX);
+            emit_ri(G_ADD, EDX, 1);
+            emit_ri(G_AND, EDX, 0xFFFF);
+            emit_ri(G_ADD, REG_CLOCK, info->cycles);
+            exit_dynamic(cpu, b, count);
+            return JIT_EXITED;
+
+        default:
+            return JIT_UNSUPPORTED;
+    }
+    return JIT_NEXT;
+}
+
+static void jitflush(cpu6502_t *cpu) {
+    for (int i = 0; i < BLOCKCACHE_SIZE; i++) {
+        cpu->blockcache[i].native = NULL;
+        cpu->blockcache[i].hits = 0;
+    }
+    cpu->jitptr = cpu->jitbuffer;
+}
+
+static void jitfree(cpu6502_t *cpu) {
+    if (cpu->jitbuffer) {
+        munmap(cpu->jitbuffer, JIT_BUFFER_SIZE);
+    }
+    cpu->jitbuffer = cpu->jitptr = NULL;
+}
+
+// the code refers to the registers of cpu and the page tables of the current machine
+static void jitcompile(cpu6502_t *cpu, block *b) {
+    if (cpu->jitfailed) {
+        b->nojit = 1;
+        return;
+    }
+    if (!cpu->jitbuffer) {
+        cpu->jitbuffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (cpu->jitbuffer == MAP_FAILED) {
+            // only for this machine; the others may still get their buffers
+            printf("JIT: can't allocate executable memory, using the block cache.\n");
+            cpu->jitbuffer = NULL;
+            cpu->jitfailed = 1;
+            b->nojit = 1;
+            return;
+        }
+        cpu->jitptr = cpu->jitbuffer;
+    }
+    if (cpu->jitptr + JIT_BLOCK_MAX > cpu->jitbuffer + JIT_BUFFER_SIZE) {
+        jitflush(cpu);
+    }
+    jitptr = cpu->jitptr;
+
+    uint8_t *start = jitptr;
+    jitexitcount = 0;
+    jitdynamiccount = 0;
+    b->binary = 0;
+
+    // prologue: callee-saved registers hold the 6502 state across calls
+    emit8(0x53);							// push rbx
+    emit8(0x55);							// push rbp
+    emit8(0x41); emit8(0x54);				// push r12
+    emit8(0x41); emit8(0x55);				// push r13
+    emit8(0x41); emit8(0x56);				// push r14
+    emit8(0x41); emit8(0x57);				// push r15
+    emit8(0x48); emit8(0x83); emit8(0xEC); emit8(0x18);	// sub rsp, 24
+    emit_load8(REG_A, &cpu->a);
+    emit_load8(REG_X, &cpu->x);
+    emit_load8(REG_Y, &cpu->y);
+    emit_load8(REG_STATUS, &cpu->status);
+    emit_ri(G_OR, REG_STATUS, FLAG_CONSTANT);
+    emit_load32(REG_CLOCK, &cpu->clockticks6502);
+    emit_load32(REG_GOAL, &cpu->clockgoal6502);
+    emit_load32(EAX, &machine->memory.code_epoch);
+    emit_storeslot(SLOT_EPOCH, EAX);
+
+    uint8_t *body = jitptr;
+    uint16_t address = b->pc;
+    int exited = 0;
+    int i;
+    for (i = 0; i < b->count && !exited; i++) {
+        const blockop *op = &b->ops[i];
+        uint8_t *mark = jitptr;
+        int result = jitop(cpu, b, i);
+
+        if (result == JIT_UNSUPPORTED) {
+            jitptr = mark;
+            break;
+        }
+        if (result == JIT_EXITED) {
+            exited = 1;
+            continue;
+        }
+        if (result != JIT_RETIRED) {
+            emit_ri(G_ADD, REG_CLOCK, blocktable[op->opcode].cycles);
+        }
+        if (result == JIT_WRITES) {
+            emit_load32(EAX, &machine->memory.code_epoch);
+            emitrex(EAX, ESP, -1);			// cmp eax, [rsp + SLOT_EPOCH]
+            emit8(0x3B);
+            emitmodrm(1, EAX, ESP);
+            emit8(0x24);
+            emit8(SLOT_EPOCH);
+            exit_to(CC_NE, op->next, i + 1, 0);
+        }
+        if (i + 1 < b->count) {
+            emit_rr(X_MOV, EAX, REG_CLOCK);	// DONE(): (int32_t)(clock - goal) >= 0
+            emit_rr(X_SUB, EAX, REG_GOAL);
+            exit_to(CC_NS, op->next, i + 1, 0);
+        }
+        address = op->next;
+    }
+
+    if (i == 0) {
+        b->nojit = 1;
+        return;
+    }
+
+    // ran off the end of the translated instructions
+    if (!exited) {
+        exit_to(-1, address, i, 0);
+    }
+
+    // exit stubs: extra cycles, then the pc in edx and the instruction count in
+    // ecx; lastpc is the last instruction retired
+    for (int e = 0; e < jitexitcount; e++) {
+        patch(jitexits[e].from, jitptr);
+        if (jitexits[e].cycles) emit_ri(G_ADD, REG_CLOCK, jitexits[e].cycles);
+        if (jitexits[e].loop && jitexits[e].pc == b->pc && !memory_is_trap(b->pc)) {
+            // loop back into the block unless the goal has been reached
+            emit_movrax(&cpu->instructions);	// add [instructions], count
+            emit8(0x83);
+            emitmodrm(0, 0, EAX);
+            emit8(jitexits[e].count);
+            emit_rr(X_MOV, EAX, REG_CLOCK);
+            emit_rr(X_SUB, EAX, REG_GOAL);
+            patch(emit_jcc(CC_S), body);
+            emit_movi(EDX, jitexits[e].pc);
+            emit_movi(ECX, 0);
+        } else {
+            emit_movi(EDX, jitexits[e].pc);
+            emit_movi(ECX, jitexits[e].count);
+        }
+        emit_store16i(&cpu->lastpc, opaddress(b, jitexits[e].count - 1));
+        jitdynamic[jitdynamiccount++] = emit_jmp();
+    }
+
+    // common exit
+    for (int d = 0; d < jitdynamiccount; d++) {
+        patch(jitdynamic[d], jitptr);
+    }
+    emit_movrax(&cpu->pc);					// mov [pc], dx
+    emit8(0x66);
+    emit8(0x89);
+    emitmodrm(0, EDX, EAX);
+    emit_movrax(&cpu->instructions);		// add [instructions], ecx
+    emit8(0x01);
+    emitmodrm(0, ECX, EAX);
+    emit_store8(&cpu->a, REG_A);
+    emit_store8(&cpu->x, REG_X);
+    emit_store8(&cpu->y, REG_Y);
+    emit_store8(&cpu->status, REG_STATUS);
+    emit_store32(&cpu->clockticks6502, REG_CLOCK);
+    emit8(0x48); emit8(0x83); emit8(0xC4); emit8(0x18);	// add rsp, 24
+    emit8(0x41); emit8(0x5F);				// pop r15
+    emit8(0x41); emit8(0x5E);				// pop r14
+    emit8(0x41); emit8(0x5D);				// pop r13
+    emit8(0x41); emit8(0x5C);				// pop r12
+    emit8(0x5D);							// pop rbp
+    emit8(0x5B);							// pop rbx
+    emit8(0xC3);							// ret
+
+    b->native = (void (*)())start;
+    cpu->jitptr = jitptr;
+}
+
+// runs the block natively if it is hot and translatable; returns 0 if the
+// interpreter has to run it instead
+static int jitrun(cpu6502_t *cpu, block *b) {
+    if (cpu->callexternal) return 0;
+    if (!b->native) {
+        if (b->nojit || ++b->hits < JIT_THRESHOLD) return 0;
+        jitcompile(cpu, b);
+        if (!b->native) return 0;
+    }
+    if (b->binary && (cpu->status & FLAG_DECIMAL)) return 0;
+
+    saveflags();							// native code keeps the flags in status
+    b->native();
+    loadflags();
+    return 1;
+}
+
+#else
+
+static int jitrun(cpu6502_t *cpu, block *b) {
+    return 0;
+}
+
+static void jitfree(cpu6502_t *cpu) {
+}
+
+#endif
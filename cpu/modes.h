@@ -12,99 +12,99 @@
 //                      A 6502 has a bug whereby if you jmp ($12FF) it reads the address from
 //                      $12FF and $1200. This has been fixed in the 65C02. 
 //                      
-static void imp() { //implied
+static void imp(cpu6502_t *cpu) { //implied
 }
 
-static void acc() { //accumulator
+static void acc(cpu6502_t *cpu) { //accumulator
 }
 
-static void imm() { //immediate
-    ea = pc++;
+static void imm(cpu6502_t *cpu) { //immediate
+    cpu->ea = cpu->pc++;
 }
 
-static void zp() { //zero-page
-    ea = (uint16_t)read6502((uint16_t)pc++);
+static void zp(cpu6502_t *cpu) { //zero-page
+    cpu->ea = (uint16_t)read6502((uint16_t)cpu->pc++);
 }
 
-static void zpx() { //zero-page,X
-    ea = ((uint16_t)read6502((uint16_t)pc++) + (uint16_t)x) & 0xFF; //zero-page wraparound
+static void zpx(cpu6502_t *cpu) { //zero-page,X
+    cpu->ea = ((uint16_t)read6502((uint16_t)cpu->pc++) + (uint16_t)cpu->x) & 0xFF; //zero-page wraparound
 }
 
-static void zpy() { //zero-page,Y
-    ea = ((uint16_t)read6502((uint16_t)pc++) + (uint16_t)y) & 0xFF; //zero-page wraparound
+static void zpy(cpu6502_t *cpu) { //zero-page,Y
+    cpu->ea = ((uint16_t)read6502((uint16_t)cpu->pc++) + (uint16_t)cpu->y) & 0xFF; //zero-page wraparound
 }
 
-static void rel() { //relative for branch ops (8-bit immediate value, sign-extended)
-    reladdr = (uint16_t)read6502(pc++);
-    if (reladdr & 0x80) reladdr |= 0xFF00;
+static void rel(cpu6502_t *cpu) { //relative for branch ops (8-bit immediate value, sign-extended)
+    cpu->reladdr = (uint16_t)read6502(cpu->pc++);
+    if (cpu->reladdr & 0x80) cpu->reladdr |= 0xFF00;
 }
 
-static void abso() { //absolute
-    ea = (uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8);
-    pc += 2;
+static void abso(cpu6502_t *cpu) { //absolute
+    cpu->ea = (uint16_t)read6502(cpu->pc) | ((uint16_t)read6502(cpu->pc+1) << 8);
+    cpu->pc += 2;
 }
 
-static void absx() { //absolute,X
+static void absx(cpu6502_t *cpu) { //absolute,X
     uint16_t startpage;
-    ea = ((uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8));
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)x;
+    cpu->ea = ((uint16_t)read6502(cpu->pc) | ((uint16_t)read6502(cpu->pc+1) << 8));
+    startpage = cpu->ea & 0xFF00;
+    cpu->ea += (uint16_t)cpu->x;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (cpu->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        cpu->penaltyaddr = 1;
     }
 
-    pc += 2;
+    cpu->pc += 2;
 }
 
-static void absy() { //absolute,Y
+static void absy(cpu6502_t *cpu) { //absolute,Y
     uint16_t startpage;
-    ea = ((uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8));
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)y;
+    cpu->ea = ((uint16_t)read6502(cpu->pc) | ((uint16_t)read6502(cpu->pc+1) << 8));
+    startpage = cpu->ea & 0xFF00;
+    cpu->ea += (uint16_t)cpu->y;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (cpu->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        cpu->penaltyaddr = 1;
     }
 
-    pc += 2;
+    cpu->pc += 2;
 }
 
-static void ind() { //indirect
+static void ind(cpu6502_t *cpu) { //indirect
     uint16_t eahelp, eahelp2;
-    eahelp = (uint16_t)read6502(pc) | (uint16_t)((uint16_t)read6502(pc+1) << 8);
+    eahelp = (uint16_t)read6502(cpu->pc) | (uint16_t)((uint16_t)read6502(cpu->pc+1) << 8);
     //
     //      The 6502 page boundary wraparound bug does not occur on a 65C02.
     //
     //eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //replicate 6502 page-boundary wraparound bug
     eahelp2 = (eahelp+1) & 0xFFFF;
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    pc += 2;
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
+    cpu->pc += 2;
 }
 
-static void indx() { // (indirect,X)
+static void indx(cpu6502_t *cpu) { // (indirect,X)
     uint16_t eahelp;
-    eahelp = (uint16_t)(((uint16_t)read6502(pc++) + (uint16_t)x) & 0xFF); //zero-page wraparound for table pointer
-    ea = (uint16_t)read6502(eahelp & 0x00FF) | ((uint16_t)read6502((eahelp+1) & 0x00FF) << 8);
+    eahelp = (uint16_t)(((uint16_t)read6502(cpu->pc++) + (uint16_t)cpu->x) & 0xFF); //zero-page wraparound for table pointer
+    cpu->ea = (uint16_t)read6502(eahelp & 0x00FF) | ((uint16_t)read6502((eahelp+1) & 0x00FF) << 8);
 }
 
-static void indy() { // (indirect),Y
+static void indy(cpu6502_t *cpu) { // (indirect),Y
     uint16_t eahelp, eahelp2, startpage;
-    eahelp = (uint16_t)read6502(pc++);
+    eahelp = (uint16_t)read6502(cpu->pc++);
     eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //zero-page wraparound
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)y;
+    cpu->ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
+    startpage = cpu->ea & 0xFF00;
+    cpu->ea += (uint16_t)cpu->y;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (cpu->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        cpu->penaltyaddr = 1;
     }
 }
 
-static void zprel() { // zero-page, relative for branch ops (8-bit immediatel value, sign-extended)
-	ea = (uint16_t)read6502(pc);
-	reladdr = (uint16_t)read6502(pc+1);
-	if (reladdr & 0x80) reladdr |= 0xFF00;
+static void zprel(cpu6502_t *cpu) { // zero-page, relative for branch ops (8-bit immediatel value, sign-extended)
+	cpu->ea = (uint16_t)read6502(cpu->pc);
+	cpu->reladdr = (uint16_t)read6502(cpu->pc+1);
+	if (cpu->reladdr & 0x80) cpu->reladdr |= 0xFF00;
 
-	pc += 2;
+	cpu->pc += 2;
 }
\ No newline at end of file
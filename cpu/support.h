@@ -4,22 +4,24 @@
 
 */
 
-#define saveaccum(n) a = (uint8_t)((n) & 0x00FF)
+#define saveaccum(n) cpu->a = (uint8_t)((n) & 0x00FF)
 
 
+#ifndef LAZY_FLAGS
+
 //flag modifier macros
-#define setcarry() status |= FLAG_CARRY
-#define clearcarry() status &= (~FLAG_CARRY)
-#define setzero() status |= FLAG_ZERO
-#define clearzero() status &= (~FLAG_ZERO)
-#define setinterrupt() status |= FLAG_INTERRUPT
-#define clearinterrupt() status &= (~FLAG_INTERRUPT)
-#define setdecimal() status |= FLAG_DECIMAL
-#define cleardecimal() status &= (~FLAG_DECIMAL)
-#define setoverflow() status |= FLAG_OVERFLOW
-#define clearoverflow() status &= (~FLAG_OVERFLOW)
-#define setsign() status |= FLAG_SIGN
-#define clearsign() status &= (~FLAG_SIGN)
+#define setcarry() cpu->status |= FLAG_CARRY
+#define clearcarry() cpu->status &= (~FLAG_CARRY)
+#define setzero() cpu->status |= FLAG_ZERO
+#define clearzero() cpu->status &= (~FLAG_ZERO)
+#define setinterrupt() cpu->status |= FLAG_INTERRUPT
+#define clearinterrupt() cpu->status &= (~FLAG_INTERRUPT)
+#define setdecimal() cpu->status |= FLAG_DECIMAL
+#define cleardecimal() cpu->status &= (~FLAG_DECIMAL)
+#define setoverflow() cpu->status |= FLAG_OVERFLOW
+#define clearoverflow() cpu->status &= (~FLAG_OVERFLOW)
+#define setsign() cpu->status |= FLAG_SIGN
+#define clearsign() cpu->status &= (~FLAG_SIGN)
 
 
 //flag calculation macros
@@ -43,34 +45,104 @@
         else clearoverflow();\
 }
 
+
+//flag access macros
+#define getcarry() (cpu->status & FLAG_CARRY)
+#define testzero() (cpu->status & FLAG_ZERO)
+#define testsign() (cpu->status & FLAG_SIGN)
+#define testoverflow() (cpu->status & FLAG_OVERFLOW)
+#define setnv(n) cpu->status = (cpu->status & 0x3F) | (uint8_t)((n) & 0xC0)
+
+#define getstatus() (cpu->status)
+#define loadflags()
+#define saveflags()
+
+#else
+
+//N, Z, C and V are kept as the values that last set them and are only
+//assembled into the status byte when something reads it:
+//  lazyn - bit 7 is N
+//  lazyz - zero when Z is set
+//  lazyc - 0 or 1, the carry itself
+//  lazyv - bit 7 is V
+//status keeps the I, D, B and constant bits.
+
+//flag modifier macros
+#define setcarry() cpu->lazyc = 1
+#define clearcarry() cpu->lazyc = 0
+#define setzero() cpu->lazyz = 0
+#define clearzero() cpu->lazyz = 1
+#define setinterrupt() cpu->status |= FLAG_INTERRUPT
+#define clearinterrupt() cpu->status &= (~FLAG_INTERRUPT)
+#define setdecimal() cpu->status |= FLAG_DECIMAL
+#define cleardecimal() cpu->status &= (~FLAG_DECIMAL)
+#define setoverflow() cpu->lazyv = 0x80
+#define clearoverflow() cpu->lazyv = 0
+#define setsign() cpu->lazyn = 0x80
+#define clearsign() cpu->lazyn = 0
+
+
+//flag calculation macros
+#define zerocalc(n) cpu->lazyz = (uint8_t)(n)
+#define signcalc(n) cpu->lazyn = (uint8_t)(n)
+#define carrycalc(n) cpu->lazyc = (((n) & 0xFF00) != 0)
+#define overflowcalc(n, m, o) /* n = result, m = accumulator, o = memory */ \
+    cpu->lazyv = (uint8_t)(((n) ^ (uint16_t)(m)) & ((n) ^ (o)))
+
+
+//flag access macros
+#define getcarry() (cpu->lazyc)
+#define testzero() (!cpu->lazyz)
+#define testsign() (cpu->lazyn & 0x80)
+#define testoverflow() (cpu->lazyv & 0x80)
+#define setnv(n) { cpu->lazyn = (uint8_t)(n); cpu->lazyv = (uint8_t)((n) << 1); }
+
+//the status byte with N, Z, C and V filled in
+#define getstatus() ((cpu->status & 0x3C) | (cpu->lazyn & 0x80) | ((cpu->lazyv >> 1) & 0x40) | (cpu->lazyz ? 0 : FLAG_ZERO) | cpu->lazyc)
+
+//status -> lazy flags, after status has been replaced
+#define loadflags() {\
+    cpu->lazyn = cpu->status;\
+    cpu->lazyz = ~cpu->status & FLAG_ZERO;\
+    cpu->lazyc = cpu->status & FLAG_CARRY;\
+    cpu->lazyv = cpu->status << 1;\
+}
+
+//lazy flags -> status, before status is read from outside the core
+#define saveflags() cpu->status = getstatus()
+
+#endif
+
 //a few general functions used by various other functions
-void push16(uint16_t pushval) {
-    write6502(BASE_STACK + sp, (pushval >> 8) & 0xFF);
-    write6502(BASE_STACK + ((sp - 1) & 0xFF), pushval & 0xFF);
-    sp -= 2;
+static void push16(cpu6502_t *cpu, uint16_t pushval) {
+    write6502(BASE_STACK + cpu->sp, (pushval >> 8) & 0xFF);
+    write6502(BASE_STACK + ((cpu->sp - 1) & 0xFF), pushval & 0xFF);
+    cpu->sp -= 2;
 }
 
-void push8(uint8_t pushval) {
-    write6502(BASE_STACK + sp--, pushval);
+static void push8(cpu6502_t *cpu, uint8_t pushval) {
+    write6502(BASE_STACK + cpu->sp--, pushval);
 }
 
-uint16_t pull16() {
+static uint16_t pull16(cpu6502_t *cpu) {
     uint16_t temp16;
-    temp16 = read6502(BASE_STACK + ((sp + 1) & 0xFF)) | ((uint16_t)read6502(BASE_STACK + ((sp + 2) & 0xFF)) << 8);
-    sp += 2;
+    temp16 = read6502(BASE_STACK + ((cpu->sp + 1) & 0xFF)) | ((uint16_t)read6502(BASE_STACK + ((cpu->sp + 2) & 0xFF)) << 8);
+    cpu->sp += 2;
     return(temp16);
 }
 
-uint8_t pull8() {
-    return (read6502(BASE_STACK + ++sp));
+static uint8_t pull8(cpu6502_t *cpu) {
+    return (read6502(BASE_STACK + ++cpu->sp));
 }
 
 void reset6502() {
-    pc = (uint16_t)read6502(0xFFFC) | ((uint16_t)read6502(0xFFFD) << 8);
-    a = 0;
-    x = 0;
-    y = 0;
-    sp = 0xFD;
-    status |= FLAG_CONSTANT;
+    cpu6502_t *cpu = &machine->cpu;
+
+    cpu->pc = (uint16_t)read6502(0xFFFC) | ((uint16_t)read6502(0xFFFD) << 8);
+    cpu->a = 0;
+    cpu->x = 0;
+    cpu->y = 0;
+    cpu->sp = 0xFD;
+    cpu->status |= FLAG_CONSTANT;
 }
 
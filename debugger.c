@@ -17,9 +17,7 @@
 #include <SDL.h>
 #include "glue.h"
 #include "disasm.h"
-#include "memory.h"
-#include "video.h"
-#include "cpu/fake6502.h"
+#include "machine.h"
 #include "debugger.h"
 #include "rendertext.h"
 
@@ -141,22 +139,22 @@ SDL_Renderer *dbgRenderer; 										// Renderer passed in.
 int  DEBUGGetCurrentStatus(void) {
 
 	SDL_Event event;
-	if (currentPC < 0) currentPC = pc;							// Initialise current PC displayed.
+	if (currentPC < 0) currentPC = machine->cpu.pc;				// Initialise current PC displayed.
 
 	if (currentMode == DMODE_STEP) {							// Single step before
-		currentPC = pc;											// Update current PC
+		currentPC = machine->cpu.pc;							// Update current PC
 		currentMode = DMODE_STOP;								// So now stop, as we've done it.
 	}
 
-	if (pc == breakPoint || pc == stepBreakPoint) {				// Hit a breakpoint.
-		currentPC = pc;											// Update current PC
+	if (machine->cpu.pc == breakPoint || machine->cpu.pc == stepBreakPoint) {	// Hit a breakpoint.
+		currentPC = machine->cpu.pc;							// Update current PC
 		currentMode = DMODE_STOP;								// So now stop, as we've done it.
 		stepBreakPoint = -1;									// Clear step breakpoint.
 	}
 
 	if (SDL_GetKeyboardState(NULL)[DBGSCANKEY_BRK]) {			// Stop on break pressed.
 		currentMode = DMODE_STOP;
-		currentPC = pc; 										// Set the PC to what it is.
+		currentPC = machine->cpu.pc; 							// Set the PC to what it is.
 	}
 
 	if(currentPCBank<0 && currentPC >= 0xA000) {
@@ -225,7 +223,7 @@ void DEBUGSetBreakPoint(int newBreakPoint) {
 
 void DEBUGBreakToDebugger(void) {
 	currentMode = DMODE_STOP;
-	currentPC = pc;
+	currentPC = machine->cpu.pc;
 }
 
 // *******************************************************************************************
@@ -244,9 +242,9 @@ static void DEBUGHandleKeyEvent(SDL_Keycode key,int isShift) {
 			break;
 
 		case DBGKEY_STEPOVER:								// Step over (F10 by default)
-			opcode = real_read6502(pc, false, 0);							// What opcode is it ?
+			opcode = real_read6502(machine->cpu.pc, false, 0);				// What opcode is it ?
 			if (opcode == 0x20) { 							// Is it JSR ?
-				stepBreakPoint = pc + 3;					// Then break 3 on.
+				stepBreakPoint = machine->cpu.pc + 3;		// Then break 3 on.
 				currentMode = DMODE_RUN;					// And run.
 			} else {
 				currentMode = DMODE_STEP;					// Otherwise single step.
@@ -262,13 +260,13 @@ static void DEBUGHandleKeyEvent(SDL_Keycode key,int isShift) {
 			break;
 
 		case DBGKEY_HOME:									// F1 sets the display PC to the actual one.
-			currentPC = pc;
+			currentPC = machine->cpu.pc;
 			currentPCBank= currentPC < 0xC000 ? memory_get_ram_bank() : memory_get_rom_bank();
 			break;
 
 		case DBGKEY_RESET:									// F2 reset the 6502
 			reset6502();
-			currentPC = pc;
+			currentPC = machine->cpu.pc;
 			currentPCBank= -1;
 			break;
 
@@ -380,9 +378,9 @@ static void DEBUGExecCmd() {
 					if (addr >= 0xC000) {
 						// Nop.
 					} else if (addr >= 0xA000) {
-						RAM[0xa000 + (currentBank << 13) + addr - 0xa000] = number;
+						machine->memory.RAM[0xa000 + (currentBank << 13) + addr - 0xa000] = number;
 					} else {
-						RAM[addr] = number;
+						machine->memory.RAM[addr] = number;
 					}
 					if (incr) {
 						addr += incr;
@@ -392,6 +390,7 @@ static void DEBUGExecCmd() {
 					addr &= 0xFFFF;
 					--size;
 				} while (size > 0);
+				memory_invalidate_code();
 			} else {
 				addr &= 0x1FFFF;
 				do {
@@ -432,19 +431,19 @@ static void DEBUGExecCmd() {
 			sscanf(line, "%s %x", reg, &number);
 
 			if(!strcmp(reg, "pc")) {
-				pc= number & 0xFFFF;
+				machine->cpu.pc= number & 0xFFFF;
 			}
 			if(!strcmp(reg, "a")) {
-				a= number & 0x00FF;
+				machine->cpu.a= number & 0x00FF;
 			}
 			if(!strcmp(reg, "x")) {
-				x= number & 0x00FF;
+				machine->cpu.x= number & 0x00FF;
 			}
 			if(!strcmp(reg, "y")) {
-				y= number & 0x00FF;
+				machine->cpu.y= number & 0x00FF;
 			}
 			if(!strcmp(reg, "sp")) {
-				sp= number & 0x00FF;
+				machine->cpu.sp= number & 0x00FF;
 			}
 			break;
 
@@ -529,7 +528,7 @@ static void DEBUGRenderZeroPageRegisters(int y) {
 			if (oldRegChange[reg] != NULL)
 				DEBUGString(dbgRenderer, DBG_ZP_REG+9, y, oldRegChange[reg], col_data);
 
-			if (oldRegisterTicks != clockticks6502) {   // change detection only when the emulated CPU changes
+			if (oldRegisterTicks != machine->cpu.clockticks6502) {   // change detection only when the emulated CPU changes
 				oldRegChange[reg] = n != oldRegisters[reg] ? "*" : " ";
 				oldRegisters[reg]=n;
 			}
@@ -538,8 +537,8 @@ static void DEBUGRenderZeroPageRegisters(int y) {
 		y++;
 	}
 
-	if (oldRegisterTicks != clockticks6502) {
-		oldRegisterTicks = clockticks6502;
+	if (oldRegisterTicks != machine->cpu.clockticks6502) {
+		oldRegisterTicks = machine->cpu.clockticks6502;
 	}
 }
 
@@ -600,9 +599,9 @@ static void DEBUGRenderCode(int lines, int initialPC) {
 
 		DEBUGAddress(DBG_ASMX, y, currentPCBank, initialPC, col_label);
 
-		int size = disasm(initialPC, RAM, buffer, sizeof(buffer), true, currentPCBank);	// Disassemble code
+		int size = disasm(initialPC, machine->memory.RAM, buffer, sizeof(buffer), true, currentPCBank);	// Disassemble code
 		// Output assembly highlighting PC
-		DEBUGString(dbgRenderer, DBG_ASMX+8, y, buffer, initialPC == pc ? col_highlight : col_data);
+		DEBUGString(dbgRenderer, DBG_ASMX+8, y, buffer, initialPC == machine->cpu.pc ? col_highlight : col_data);
 		initialPC += size;										// Forward to next
 	}
 }
@@ -617,29 +616,30 @@ static char *labels[] = { "NV-BDIZC","","","A","X","Y","","BKA","BKO", "PC","SP"
 
 
 static int DEBUGRenderRegisters(void) {
+	cpu6502_t *cpu = &machine->cpu;
 	int n = 0,yc = 0;
 	while (labels[n] != NULL) {									// Labels
 		DEBUGString(dbgRenderer, DBG_LBLX,n,labels[n], col_label);n++;
 	}
 	yc++;
-	DEBUGNumber(DBG_LBLX, yc, (status >> 7) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+1, yc, (status >> 6) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+3, yc, (status >> 4) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+4, yc, (status >> 3) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+5, yc, (status >> 2) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+6, yc, (status >> 1) & 1, 1, col_data);
-	DEBUGNumber(DBG_LBLX+7, yc, (status >> 0) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX, yc, (cpu->status >> 7) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+1, yc, (cpu->status >> 6) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+3, yc, (cpu->status >> 4) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+4, yc, (cpu->status >> 3) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+5, yc, (cpu->status >> 2) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+6, yc, (cpu->status >> 1) & 1, 1, col_data);
+	DEBUGNumber(DBG_LBLX+7, yc, (cpu->status >> 0) & 1, 1, col_data);
 	yc+= 2;
 
-	DEBUGNumber(DBG_DATX, yc++, a, 2, col_data);
-	DEBUGNumber(DBG_DATX, yc++, x, 2, col_data);
-	DEBUGNumber(DBG_DATX, yc++, y, 2, col_data);
+	DEBUGNumber(DBG_DATX, yc++, cpu->a, 2, col_data);
+	DEBUGNumber(DBG_DATX, yc++, cpu->x, 2, col_data);
+	DEBUGNumber(DBG_DATX, yc++, cpu->y, 2, col_data);
 	yc++;
 
 	DEBUGNumber(DBG_DATX, yc++, memory_get_ram_bank(), 2, col_data);
 	DEBUGNumber(DBG_DATX, yc++, memory_get_rom_bank(), 2, col_data);
-	DEBUGNumber(DBG_DATX, yc++, pc, 4, col_data);
-	DEBUGNumber(DBG_DATX, yc++, sp|0x100, 4, col_data);
+	DEBUGNumber(DBG_DATX, yc++, cpu->pc, 4, col_data);
+	DEBUGNumber(DBG_DATX, yc++, cpu->sp|0x100, 4, col_data);
 	yc++;
 
 	DEBUGNumber(DBG_DATX, yc++, breakPoint & 0xFFFF, 4, col_data);
@@ -660,7 +660,7 @@ static int DEBUGRenderRegisters(void) {
 // *******************************************************************************************
 
 static void DEBUGRenderStack(int bytesCount) {
-	int data= (sp+1) | 0x100;
+	int data= (machine->cpu.sp+1) | 0x100;
 	int y= 0;
 	while (y < bytesCount) {
 		DEBUGNumber(DBG_STCK,y,data & 0xFFFF,4, col_label);
@@ -15,6 +15,10 @@
 #include <string.h>  // For memset on GCC
 
 #include "ym2151.h"
+#include "../../machine.h"
+
+// the chip of the current machine
+#define ym (machine->ym)
 
 
 #define YM_MONO 1
@@ -23,27 +27,10 @@
 #define YM_LEFT 0
 #define YM_RIGHT 1
 
-int YM_initalized;
-
-// Sample Frequency in use
-uint32_t YM_sample_freq;
-
-// How many channels to support (mono/stereo)
-uint8_t YM_channels;
-
-int YM_irq;
-
 void YM_clear_buffer();
 void YM_write_buffer(const uint8_t, uint32_t, int16_t);
 int16_t YM_read_buffer(const uint8_t, uint32_t);
 
-// Frames per second
-uint32_t YM_fps; 
-
-
-int YM_clock;        /*chip clock in Hz (passed from 2151intf.c)*/
-int YM_sampfreq;     /*sampling frequency in Hz (passed from 2151intf.c)*/
-
 void YM_init_tables();
 void YM_init_chip_tables();
  void YM_envelope_KONKOFF(YM2151Operator * op, int v);
@@ -58,91 +45,6 @@ void YM_ym2151_reset_chip();
  void YM_advance();
 
 
-signed int     chanout[8];
-signed int     m2,c1,c2;            /* Phase Modulation input for operators 2,3,4  */
-signed int     mem;                 /* one sample delay memory */
-
-YM2151Operator oper[32];            /* the 32 operators */
-
-uint32_t       pan[16];             /* channels output masks (0xffffffff = enable) */
-
-uint32_t       eg_cnt;              /* global envelope generator counter */
-uint32_t       eg_timer;            /* global envelope generator counter works at frequency = chipclock/64/3 */
-uint32_t       eg_timer_add;        /* step of eg_timer */
-uint32_t       eg_timer_overflow;   /* envelope generator timer overlfows every 3 samples (on real chip) */
-
-uint32_t       lfo_phase;           /* accumulated LFO phase (0 to 255) */
-uint32_t       lfo_timer;           /* LFO timer                        */
-uint32_t       lfo_timer_add;       /* step of lfo_timer                */
-uint32_t       lfo_overflow;        /* LFO generates new output when lfo_timer reaches this value */
-uint32_t       lfo_counter;         /* LFO phase increment counter      */
-uint32_t       lfo_counter_add;     /* step of lfo_counter              */
-uint8_t        lfo_wsel;            /* LFO waveform (0-saw, 1-square, 2-triangle, 3-random noise) */
-uint8_t        amd;                 /* LFO Amplitude Modulation Depth   */
-int8_t         pmd;                 /* LFO Phase Modulation Depth       */
-uint32_t       lfa;                 /* LFO current AM output            */
-int32_t        lfp;                 /* LFO current PM output            */
-
-uint8_t        test;                /* TEST register */
-uint8_t        ct;                  /* output control pins (bit1-CT2, bit0-CT1) */
-
-uint32_t       noise;               /* noise enable/period register (bit 7 - noise enable, bits 4-0 - noise period */
-uint32_t       noise_rng;           /* 17 bit noise shift register */
-uint32_t       noise_p;             /* current noise 'phase'*/
-uint32_t       noise_f;             /* current noise period */
-
-uint32_t       csm_req;             /* CSM  KEY ON / KEY OFF sequence request */
-
-uint32_t       irq_enable;          /* IRQ enable for timer B (bit 3) and timer A (bit 2); bit 7 - CSM mode (keyon to all slots, everytime timer A overflows) */
-static uint32_t       status;       /* chip status (BUSY, IRQ Flags) */
-uint8_t        connects[8];         /* channels connections */
-
-#ifdef USE_MAME_TIMERS
-/* ASG 980324 -- added for tracking timers */
-    emu_timer  *timer_A;
-    emu_timer  *timer_B;
-    attotime   timer_A_time[1024];  /* timer A times for MAME */
-    attotime   timer_B_time[256];   /* timer B times for MAME */
-    int        irqlinestate;
-#else
-    uint8_t    tim_A;               /* timer A enable (0-disabled) */
-    uint8_t    tim_B;               /* timer B enable (0-disabled) */
-    int32_t    tim_A_val;           /* current value of timer A */
-    int32_t    tim_B_val;           /* current value of timer B */
-    uint32_t   tim_A_tab[1024];     /* timer A deltas */
-    uint32_t   tim_B_tab[256];      /* timer B deltas */
-#endif
-uint32_t       timer_A_index;       /* timer A index */
-uint32_t       timer_B_index;       /* timer B index */
-uint32_t       timer_A_index_old;   /* timer A previous index */
-uint32_t       timer_B_index_old;   /* timer B previous index */
-
-/*  Frequency-deltas to get the closest frequency possible.
-*   There are 11 octaves because of DT2 (max 950 cents over base frequency)
-*   and LFO phase modulation (max 800 cents below AND over base frequency)
-*   Summary:   octave  explanation
-*              0       note code - LFO PM
-*              1       note code
-*              2       note code
-*              3       note code
-*              4       note code
-*              5       note code
-*              6       note code
-*              7       note code
-*              8       note code
-*              9       note code + DT2 + LFO PM
-*              10      note code + DT2 + LFO PM
-*/
-uint32_t       freq[11*768];        /* 11 octaves, 768 'cents' per octave */
-
-/*  Frequency deltas for DT1. These deltas alter operator frequency
-*   after it has been taken from frequency-deltas table.
-*/
-int32_t        dt1_freq[8*32];      /* 8 DT1 levels, 32 KC values */
-
-uint32_t       noise_tab[32];       /* 17bit Noise Generator periods */
-
-
 #define PI               3.14159265358979323846
 
 #define FREQ_SH          16  /* 16.16 fixed point (frequency calculations) */
@@ -452,8 +354,8 @@ static FILE *sample[9];
 
 void YM_Create(uint32_t clock)
 {
-    YM_initalized = 0;
-    YM_clock = clock;
+    ym.YM_initalized = 0;
+    ym.YM_clock = clock;
 }
 
 void YM_init_tables()
@@ -550,7 +452,7 @@ void YM_init_chip_tables()
     double scaler;
     double pom;
 
-    scaler = ( (double)YM_clock / 64.0 ) / ( (double)YM_sampfreq );
+    scaler = ( (double)ym.YM_clock / 64.0 ) / ( (double)ym.YM_sampfreq );
     /*logerror("scaler    = %20.15f\n", scaler);*/
 
     /* this loop calculates Hertz values for notes from c-0 to b-7 */
@@ -576,29 +478,29 @@ void YM_init_chip_tables()
 
 
         /* octave 2 - reference octave */
-        freq[ 768+2*768+i ] = ((int)(phaseinc*mult)) & 0xffffffc0; /* adjust to X.10 fixed point */
+        ym.freq[ 768+2*768+i ] = ((int)(phaseinc*mult)) & 0xffffffc0; /* adjust to X.10 fixed point */
         /* octave 0 and octave 1 */
         for (j=0; j<2; j++)
         {
-            freq[768 + j*768 + i] = (freq[ 768+2*768+i ] >> (2-j) ) & 0xffffffc0; /* adjust to X.10 fixed point */
+            ym.freq[768 + j*768 + i] = (ym.freq[ 768+2*768+i ] >> (2-j) ) & 0xffffffc0; /* adjust to X.10 fixed point */
         }
         /* octave 3 to 7 */
         for (j=3; j<8; j++)
         {
-            freq[768 + j*768 + i] = freq[ 768+2*768+i ] << (j-2);
+            ym.freq[768 + j*768 + i] = ym.freq[ 768+2*768+i ] << (j-2);
         }
 
     #if 0
-            pom = (double)freq[ 768+2*768+i ] / ((double)(1<<FREQ_SH));
+            pom = (double)ym.freq[ 768+2*768+i ] / ((double)(1<<FREQ_SH));
             pom = pom * (double)sampfreq / (double)SIN_LEN;
-            logerror("1freq[%4i][%08x]= real %20.15f Hz  emul %20.15f Hz\n", i, freq[ 768+2*768+i ], Hz, pom);
+            logerror("1freq[%4i][%08x]= real %20.15f Hz  emul %20.15f Hz\n", i, ym.freq[ 768+2*768+i ], Hz, pom);
     #endif
     }
 
     /* octave -1 (all equal to: oct 0, _KC_00_, _KF_00_) */
     for (i=0; i<768; i++)
     {
-        freq[ 0*768 + i ] = freq[1*768+0];
+        ym.freq[ 0*768 + i ] = ym.freq[1*768+0];
     }
 
     /* octave 8 and 9 (all equal to: oct 7, _KC_14_, _KF_63_) */
@@ -606,16 +508,16 @@ void YM_init_chip_tables()
     {
         for (i=0; i<768; i++)
         {
-            freq[768+ j*768 + i ] = freq[768 + 8*768 -1];
+            ym.freq[768+ j*768 + i ] = ym.freq[768 + 8*768 -1];
         }
     }
 
 #if 0
         for (i=0; i<11*768; i++)
         {
-            pom = (double)freq[i] / ((double)(1<<FREQ_SH));
+            pom = (double)ym.freq[i] / ((double)(1<<FREQ_SH));
             pom = pom * (double)sampfreq / (double)SIN_LEN;
-            logerror("freq[%4i][%08x]= emul %20.15f Hz\n", i, freq[i], pom);
+            logerror("freq[%4i][%08x]= emul %20.15f Hz\n", i, ym.freq[i], pom);
         }
 #endif
 
@@ -624,22 +526,22 @@ void YM_init_chip_tables()
     {
         for (i=0; i<32; i++)
         {
-            Hz = ( (double)dt1_tab[j*32+i] * ((double)YM_clock/64.0) ) / (double)(1<<20);
+            Hz = ( (double)dt1_tab[j*32+i] * ((double)ym.YM_clock/64.0) ) / (double)(1<<20);
 
             /*calculate phase increment*/
-            phaseinc = (Hz*SIN_LEN) / (double)YM_sampfreq;
+            phaseinc = (Hz*SIN_LEN) / (double)ym.YM_sampfreq;
 
             /*positive and negative values*/
-            dt1_freq[ (j+0)*32 + i ] = (int32_t) (phaseinc * mult);
-            dt1_freq[ (j+4)*32 + i ] = -dt1_freq[ (j+0)*32 + i ];
+            ym.dt1_freq[ (j+0)*32 + i ] = (int32_t) (phaseinc * mult);
+            ym.dt1_freq[ (j+4)*32 + i ] = -ym.dt1_freq[ (j+0)*32 + i ];
 
 #if 0
             {
                 int x = j*32 + i;
-                pom = (double)dt1_freq[x] / mult;
+                pom = (double)ym.dt1_freq[x] / mult;
                 pom = pom * (double)sampfreq / (double)SIN_LEN;
                 logerror("DT1(%03i)[%02i %02i][%08x]= real %19.15f Hz  emul %19.15f Hz\n",
-                         x, j, i, dt1_freq[x], Hz, pom);
+                         x, j, i, ym.dt1_freq[x], Hz, pom);
             }
 #endif
         }
@@ -653,36 +555,36 @@ void YM_init_chip_tables()
     {
         /* ASG 980324: changed to compute both tim_A_tab and timer_A_time */
         //pom= attotime::from_hz(clock) * (64 * (1024 - i));
-        pom= ( 64.0  *  (1024.0-i) / (double)YM_clock );
+        pom= ( 64.0  *  (1024.0-i) / (double)ym.YM_clock );
         #ifdef USE_MAME_TIMERS
             timer_A_time[i] = pom;
         #else
             //tim_A_tab[i] = pom.as_double() * (double)sampfreq * mult;  /* number of samples that timer period takes (fixed point) */
-            tim_A_tab[i] = (int)(pom * (double)YM_sampfreq * mult); 
+            ym.tim_A_tab[i] = (int)(pom * (double)ym.YM_sampfreq * mult); 
         #endif
     }
     for (i=0; i<256; i++)
     {
         /* ASG 980324: changed to compute both tim_B_tab and timer_B_time */
         //pom= attotime::from_hz(clock) * (1024 * (256 - i));
-        pom= ( 1024.0 * (256.0-i)  / (double)YM_clock );
+        pom= ( 1024.0 * (256.0-i)  / (double)ym.YM_clock );
         #ifdef USE_MAME_TIMERS
             timer_B_time[i] = pom;
         #else
             //tim_B_tab[i] = pom.as_double() * (double)sampfreq * mult;  /* number of samples that timer period takes (fixed point) */
-            tim_B_tab[i] = (int)(pom * (double)YM_sampfreq * mult); 
+            ym.tim_B_tab[i] = (int)(pom * (double)ym.YM_sampfreq * mult); 
         #endif
     }
 
     /* calculate noise periods table */
-    scaler = ( (double)YM_clock / 64.0 ) / ( (double)YM_sampfreq );
+    scaler = ( (double)ym.YM_clock / 64.0 ) / ( (double)ym.YM_sampfreq );
     for (i=0; i<32; i++)
     {
         j = (i!=31 ? i : 30);                /* rate 30 and 31 are the same */
         j = 32-j;
         j = (int) (65536.0 / (double)(j*32.0));    /* number of samples per one shift of the shift register */
         /*noise_tab[i] = j * 64;*/    /* number of chip clock cycles per one shift */
-        noise_tab[i] = (uint32_t) (j * 64 * scaler);
+        ym.noise_tab[i] = (uint32_t) (j * 64 * scaler);
         /*logerror("noise_tab[%02x]=%08x\n", i, noise_tab[i]);*/
     }
 }
@@ -693,7 +595,7 @@ void YM_init_chip_tables()
             (op)->phase = 0;            /* clear phase */       \
             (op)->state = EG_ATT;        /* KEY ON = attack */  \
             (op)->volume += (~(op)->volume *                    \
-                           (eg_inc[(op)->eg_sel_ar + ((eg_cnt>>(op)->eg_sh_ar)&7)])    \
+                           (eg_inc[(op)->eg_sel_ar + ((ym.eg_cnt>>(op)->eg_sh_ar)&7)])    \
                           ) >>4;                                \
             if ((op)->volume <= MIN_ATT_INDEX)                  \
             {                                                   \
@@ -785,24 +687,24 @@ static TIMER_CALLBACK( irqBoff_callback )
 static TIMER_CALLBACK( timer_callback_a )
 {
     YM2151 *chip = (YM2151 *)ptr;
-    timer_A->adjust(timer_A_time[ timer_A_index ]);
-    timer_A_index_old = timer_A_index;
-    if (irq_enable & 0x04)
+    timer_A->adjust(timer_A_time[ ym.timer_A_index ]);
+    ym.timer_A_index_old = ym.timer_A_index;
+    if (ym.irq_enable & 0x04)
     {
-        status |= 1;
+        ym.status |= 1;
         machine.scheduler().timer_set(attotime::zero, FUNC(irqAon_callback), 0, chip);
     }
-    if (irq_enable & 0x80)
-        csm_req = 2;        /* request KEY ON / KEY OFF sequence */
+    if (ym.irq_enable & 0x80)
+        ym.csm_req = 2;        /* request KEY ON / KEY OFF sequence */
 }
 static TIMER_CALLBACK( timer_callback_b )
 {
     YM2151 *chip = (YM2151 *)ptr;
-    timer_B->adjust(timer_B_time[ timer_B_index ]);
-    timer_B_index_old = timer_B_index;
-    if (irq_enable & 0x08)
+    timer_B->adjust(timer_B_time[ ym.timer_B_index ]);
+    ym.timer_B_index_old = ym.timer_B_index;
+    if (ym.irq_enable & 0x08)
     {
-        status |= 2;
+        ym.status |= 2;
         machine.scheduler().timer_set(attotime::zero, FUNC(irqBon_callback), 0, chip);
     }
 }
@@ -810,7 +712,7 @@ static TIMER_CALLBACK( timer_callback_b )
 static TIMER_CALLBACK( timer_callback_chip_busy )
 {
     YM2151 *chip = (YM2151 *)ptr;
-    status &= 0x7f;    /* reset busy flag */
+    ym.status &= 0x7f;    /* reset busy flag */
 }
 #endif
 #endif
@@ -828,47 +730,47 @@ void YM_set_connect(YM2151Operator *om1, int cha, int v)
     {
     case 0:
         /* M1---C1---MEM---M2---C2---OUT */
-        om1->connects = &c1;
-        oc1->connects = &mem;
-        om2->connects = &c2;
-        om1->mem_connect = &m2;
+        om1->connects = &ym.c1;
+        oc1->connects = &ym.mem;
+        om2->connects = &ym.c2;
+        om1->mem_connect = &ym.m2;
         break;
 
     case 1:
         /* M1------+-MEM---M2---C2---OUT */
         /*      C1-+                     */
-        om1->connects = &mem;
-        oc1->connects = &mem;
-        om2->connects = &c2;
-        om1->mem_connect = &m2;
+        om1->connects = &ym.mem;
+        oc1->connects = &ym.mem;
+        om2->connects = &ym.c2;
+        om1->mem_connect = &ym.m2;
         break;
 
     case 2:
         /* M1-----------------+-C2---OUT */
         /*      C1---MEM---M2-+          */
-        om1->connects = &c2;
-        oc1->connects = &mem;
-        om2->connects = &c2;
-        om1->mem_connect = &m2;
+        om1->connects = &ym.c2;
+        oc1->connects = &ym.mem;
+        om2->connects = &ym.c2;
+        om1->mem_connect = &ym.m2;
         break;
 
     case 3:
         /* M1---C1---MEM------+-C2---OUT */
         /*                 M2-+          */
-        om1->connects = &c1;
-        oc1->connects = &mem;
-        om2->connects = &c2;
-        om1->mem_connect = &c2;
+        om1->connects = &ym.c1;
+        oc1->connects = &ym.mem;
+        om2->connects = &ym.c2;
+        om1->mem_connect = &ym.c2;
         break;
 
     case 4:
         /* M1---C1-+-OUT */
         /* M2---C2-+     */
         /* MEM: not used */
-        om1->connects = &c1;
-        oc1->connects = &chanout[cha];
-        om2->connects = &c2;
-        om1->mem_connect = &mem;    /* store it anywhere where it will not be used */
+        om1->connects = &ym.c1;
+        oc1->connects = &ym.chanout[cha];
+        om2->connects = &ym.c2;
+        om1->mem_connect = &ym.mem;    /* store it anywhere where it will not be used */
         break;
 
     case 5:
@@ -876,9 +778,9 @@ void YM_set_connect(YM2151Operator *om1, int cha, int v)
         /* M1-+-MEM---M2-+-OUT */
         /*    +----C2----+     */
         om1->connects = 0;    /* special mark */
-        oc1->connects = &chanout[cha];
-        om2->connects = &chanout[cha];
-        om1->mem_connect = &m2;
+        oc1->connects = &ym.chanout[cha];
+        om2->connects = &ym.chanout[cha];
+        om1->mem_connect = &ym.m2;
         break;
 
     case 6:
@@ -886,10 +788,10 @@ void YM_set_connect(YM2151Operator *om1, int cha, int v)
         /*      M2-+-OUT */
         /*      C2-+     */
         /* MEM: not used */
-        om1->connects = &c1;
-        oc1->connects = &chanout[cha];
-        om2->connects = &chanout[cha];
-        om1->mem_connect = &mem;    /* store it anywhere where it will not be used */
+        om1->connects = &ym.c1;
+        oc1->connects = &ym.chanout[cha];
+        om2->connects = &ym.chanout[cha];
+        om1->mem_connect = &ym.mem;    /* store it anywhere where it will not be used */
         break;
 
     case 7:
@@ -898,10 +800,10 @@ void YM_set_connect(YM2151Operator *om1, int cha, int v)
         /* M2-+     */
         /* C2-+     */
         /* MEM: not used*/
-        om1->connects = &chanout[cha];
-        oc1->connects = &chanout[cha];
-        om2->connects = &chanout[cha];
-        om1->mem_connect = &mem;    /* store it anywhere where it will not be used */
+        om1->connects = &ym.chanout[cha];
+        oc1->connects = &ym.chanout[cha];
+        om2->connects = &ym.chanout[cha];
+        om1->mem_connect = &ym.mem;    /* store it anywhere where it will not be used */
         break;
     }
 }
@@ -1000,7 +902,7 @@ void YM_refresh_EG(YM2151Operator * op)
 /* write a register on YM2151 chip number 'n' */
 void YM_write_reg(int r, int v)
 {
-    YM2151Operator *op = &oper[ (r&0x07)*4+((r&0x18)>>3) ];
+    YM2151Operator *op = &ym.oper[ (r&0x07)*4+((r&0x18)>>3) ];
 
     /* adjust bus to 8 bits */
     r &= 0xff;
@@ -1008,9 +910,9 @@ void YM_write_reg(int r, int v)
 
 #if 0
     /* There is no info on what YM2151 really does when busy flag is set */
-    if ( status & 0x80 ) return;
+    if ( ym.status & 0x80 ) return;
     timer_set ( attotime::from_hz(clock) * 64, chip, 0, timer_callback_chip_busy);
-    status |= 0x80;    /* set busy flag for 64 chip clock cycles */
+    ym.status |= 0x80;    /* set busy flag for 64 chip clock cycles */
 #endif
 
     switch(r & 0xe0)
@@ -1018,43 +920,43 @@ void YM_write_reg(int r, int v)
     case 0x00:
         switch(r){
         case 0x01:    /* LFO reset(bit 1), Test Register (other bits) */
-            test = v;
-            if (v&2) lfo_phase = 0;
+            ym.test = v;
+            if (v&2) ym.lfo_phase = 0;
             break;
 
         case 0x08:
-            YM_envelope_KONKOFF(&oper[ (v&7)*4 ], v );
+            YM_envelope_KONKOFF(&ym.oper[ (v&7)*4 ], v );
             break;
 
         case 0x0f:    /* noise mode enable, noise period */
-            noise = v;
-            noise_f = noise_tab[ v & 0x1f ];
+            ym.noise = v;
+            ym.noise_f = ym.noise_tab[ v & 0x1f ];
             break;
 
         case 0x10:    /* timer A hi */
-            timer_A_index = (timer_A_index & 0x003) | (v<<2);
+            ym.timer_A_index = (ym.timer_A_index & 0x003) | (v<<2);
             break;
 
         case 0x11:    /* timer A low */
-            timer_A_index = (timer_A_index & 0x3fc) | (v & 3);
+            ym.timer_A_index = (ym.timer_A_index & 0x3fc) | (v & 3);
             break;
 
         case 0x12:    /* timer B */
-            timer_B_index = v;
+            ym.timer_B_index = v;
             break;
 
         case 0x14:    /* CSM, irq flag reset, irq enable, timer start/stop */
 
-            irq_enable = v;    /* bit 3-timer B, bit 2-timer A, bit 7 - CSM */
+            ym.irq_enable = v;    /* bit 3-timer B, bit 2-timer A, bit 7 - CSM */
 
             if (v&0x10)    /* reset timer A irq flag */
             {
 #ifdef USE_MAME_TIMERS
-                status &= ~1;
+                ym.status &= ~1;
                 device->machine().scheduler().timer_set(attotime::zero, FUNC(irqAoff_callback), 0, chip);
 #else
                 //int oldstate = status & 3;
-                status &= ~1;
+                ym.status &= ~1;
                 //if ((oldstate==1) && (irqhandler)) (*irqhandler)(device, 0);
 #endif
             }
@@ -1062,11 +964,11 @@ void YM_write_reg(int r, int v)
             if (v&0x20)    /* reset timer B irq flag */
             {
 #ifdef USE_MAME_TIMERS
-                status &= ~2;
+                ym.status &= ~2;
                 device->machine().scheduler().timer_set(attotime::zero, FUNC(irqBoff_callback), 0, chip);
 #else
                 //int oldstate = status & 3;
-                status &= ~2;
+                ym.status &= ~2;
                 //if ((oldstate==2) && (irqhandler)) (*irqhandler)(device, 0);
 #endif
             }
@@ -1078,14 +980,14 @@ void YM_write_reg(int r, int v)
                 /* start timer _only_ if it wasn't already started (it will reload time value next round) */
                     if (!timer_B->enable(1))
                     {
-                        timer_B->adjust(timer_B_time[ timer_B_index ]);
-                        timer_B_index_old = timer_B_index;
+                        timer_B->adjust(timer_B_time[ ym.timer_B_index ]);
+                        ym.timer_B_index_old = ym.timer_B_index;
                     }
                 #else
-                    if (!tim_B)
+                    if (!ym.tim_B)
                     {
-                        tim_B = 1;
-                        tim_B_val = tim_B_tab[ timer_B_index ];
+                        ym.tim_B = 1;
+                        ym.tim_B_val = ym.tim_B_tab[ ym.timer_B_index ];
                     }
                 #endif
             }
@@ -1095,7 +997,7 @@ void YM_write_reg(int r, int v)
                 /* ASG 980324: added a real timer */
                     timer_B->enable(0);
                 #else
-                    tim_B = 0;
+                    ym.tim_B = 0;
                 #endif
             }
 
@@ -1106,14 +1008,14 @@ void YM_write_reg(int r, int v)
                 /* start timer _only_ if it wasn't already started (it will reload time value next round) */
                     if (!timer_A->enable(1))
                     {
-                        timer_A->adjust(timer_A_time[ timer_A_index ]);
-                        timer_A_index_old = timer_A_index;
+                        timer_A->adjust(timer_A_time[ ym.timer_A_index ]);
+                        ym.timer_A_index_old = ym.timer_A_index;
                     }
                 #else
-                    if (!tim_A)
+                    if (!ym.tim_A)
                     {
-                        tim_A = 1;
-                        tim_A_val = tim_A_tab[ timer_A_index ];
+                        ym.tim_A = 1;
+                        ym.tim_A_val = ym.tim_A_tab[ ym.timer_A_index ];
                     }
                 #endif
             }
@@ -1123,28 +1025,28 @@ void YM_write_reg(int r, int v)
                 /* ASG 980324: added a real timer */
                     timer_A->enable(0);
                 #else
-                    tim_A = 0;
+                    ym.tim_A = 0;
                 #endif
             }
             break;
 
         case 0x18:    /* LFO frequency */
             {
-                lfo_overflow    = ( 1 << ((15-(v>>4))+3) ) * (1<<LFO_SH);
-                lfo_counter_add = 0x10 + (v & 0x0f);
+                ym.lfo_overflow    = ( 1 << ((15-(v>>4))+3) ) * (1<<LFO_SH);
+                ym.lfo_counter_add = 0x10 + (v & 0x0f);
             }
             break;
 
         case 0x19:    /* PMD (bit 7==1) or AMD (bit 7==0) */
             if (v&0x80)
-                pmd = v & 0x7f;
+                ym.pmd = v & 0x7f;
             else
-                amd = v & 0x7f;
+                ym.amd = v & 0x7f;
             break;
 
         case 0x1b:    /* CT2, CT1, LFO waveform */
-            ct = v >> 6;
-            lfo_wsel = v & 3;
+            ym.ct = v >> 6;
+            ym.lfo_wsel = v & 3;
             //if (porthandler) (*porthandler)(device, 0 , ct );
             break;
 
@@ -1155,14 +1057,14 @@ void YM_write_reg(int r, int v)
         break;
 
     case 0x20:
-        op = &oper[ (r&7) * 4 ];
+        op = &ym.oper[ (r&7) * 4 ];
         switch(r & 0x18)
         {
         case 0x00:    /* RL enable, Feedback, Connection */
             op->fb_shift = ((v>>3)&7) ? ((v>>3)&7)+6:0;
-            pan[ (r&7)*2    ] = (v & 0x40) ? ~0 : 0;
-            pan[ (r&7)*2 +1 ] = (v & 0x80) ? ~0 : 0;
-            connects[r&7] = v&7;
+            ym.pan[ (r&7)*2    ] = (v & 0x40) ? ~0 : 0;
+            ym.pan[ (r&7)*2 +1 ] = (v & 0x80) ? ~0 : 0;
+            ym.connects[r&7] = v&7;
             YM_set_connect(op, r&7, v&7);
             break;
 
@@ -1187,17 +1089,17 @@ void YM_write_reg(int r, int v)
 
                 kc = v>>2;
 
-                (op+0)->dt1 = dt1_freq[ (op+0)->dt1_i + kc ];
-                (op+0)->freq = ( (freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
+                (op+0)->dt1 = ym.dt1_freq[ (op+0)->dt1_i + kc ];
+                (op+0)->freq = ( (ym.freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
 
-                (op+1)->dt1 = dt1_freq[ (op+1)->dt1_i + kc ];
-                (op+1)->freq = ( (freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
+                (op+1)->dt1 = ym.dt1_freq[ (op+1)->dt1_i + kc ];
+                (op+1)->freq = ( (ym.freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
 
-                (op+2)->dt1 = dt1_freq[ (op+2)->dt1_i + kc ];
-                (op+2)->freq = ( (freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
+                (op+2)->dt1 = ym.dt1_freq[ (op+2)->dt1_i + kc ];
+                (op+2)->freq = ( (ym.freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
 
-                (op+3)->dt1 = dt1_freq[ (op+3)->dt1_i + kc ];
-                (op+3)->freq = ( (freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
+                (op+3)->dt1 = ym.dt1_freq[ (op+3)->dt1_i + kc ];
+                (op+3)->freq = ( (ym.freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
 
                 YM_refresh_EG( op );
             }
@@ -1217,10 +1119,10 @@ void YM_write_reg(int r, int v)
                 (op+2)->kc_i = kc_channel;
                 (op+3)->kc_i = kc_channel;
 
-                (op+0)->freq = ( (freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
-                (op+1)->freq = ( (freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
-                (op+2)->freq = ( (freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
-                (op+3)->freq = ( (freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
+                (op+0)->freq = ( (ym.freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
+                (op+1)->freq = ( (ym.freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
+                (op+2)->freq = ( (ym.freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
+                (op+3)->freq = ( (ym.freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
             }
             break;
 
@@ -1240,10 +1142,10 @@ void YM_write_reg(int r, int v)
             op->mul   = (v&0x0f) ? (v&0x0f)<<1: 1;
 
             if (olddt1_i != op->dt1_i)
-                op->dt1 = dt1_freq[ op->dt1_i + (op->kc>>2) ];
+                op->dt1 = ym.dt1_freq[ op->dt1_i + (op->kc>>2) ];
 
             if ( (olddt1_i != op->dt1_i) || (oldmul != op->mul) )
-                op->freq = ( (freq[ op->kc_i + op->dt2 ] + op->dt1) * op->mul ) >> 1;
+                op->freq = ( (ym.freq[ op->kc_i + op->dt2 ] + op->dt1) * op->mul ) >> 1;
         }
         break;
 
@@ -1297,7 +1199,7 @@ void YM_write_reg(int r, int v)
             uint32_t olddt2 = op->dt2;
             op->dt2 = dt2_tab[ v>>6 ];
             if (op->dt2 != olddt2)
-                op->freq = ( (freq[ op->kc_i + op->dt2 ] + op->dt1) * op->mul ) >> 1;
+                op->freq = ( (ym.freq[ op->kc_i + op->dt2 ] + op->dt1) * op->mul ) >> 1;
         }
         op->d2r = (v&0x1f) ? 32 + ((v&0x1f)<<1) : 0;
         op->eg_sh_d2r = eg_rate_shift [op->d2r + (op->kc>>op->ks) ];
@@ -1315,7 +1217,17 @@ void YM_write_reg(int r, int v)
 
 uint32_t YM_read_status()
 {
-    return status;
+    return ym.status;
+}
+
+/*
+*   The operators point into the chip for their connections. Re-point them
+*   after the chip state was copied in from elsewhere (a saved state).
+*/
+void YM_relocate()
+{
+    for (int ch = 0; ch < 8; ch++)
+        YM_set_connect(&ym.oper[ch * 4], ch, ym.connects[ch]);
 }
 
 /*
@@ -1327,23 +1239,34 @@ uint32_t YM_read_status()
 */
 void YM_init(int rate, int fps)
 {
-    YM_fps         = fps;
-    YM_sample_freq = rate;
-    YM_channels    = YM_STEREO;
+    ym.YM_fps         = fps;
+    ym.YM_sample_freq = rate;
+    ym.YM_channels    = YM_STEREO;
+
+    ym.YM_initalized = 1;
 
-    YM_initalized = 1;
+    ym.YM_sampfreq = rate;
 
-    YM_sampfreq = rate;
-    YM_init_tables();
+    /* the tables don't depend on the rate and are shared by all machines,
+       which may be created on different threads */
+    static SDL_SpinLock tables_lock;
+    static int tables_done = 0;
+    SDL_AtomicLock(&tables_lock);
+    if (!tables_done)
+    {
+        YM_init_tables();
+        tables_done = 1;
+    }
+    SDL_AtomicUnlock(&tables_lock);
 
-    YM_sampfreq = rate ? rate : 44100;    /* avoid division by 0 in init_chip_tables() */
+    ym.YM_sampfreq = rate ? rate : 44100;    /* avoid division by 0 in init_chip_tables() */
 
     YM_init_chip_tables();
 
-    lfo_timer_add = (uint32_t) ((1<<LFO_SH) * (YM_clock/64.0) / YM_sampfreq);
+    ym.lfo_timer_add = (uint32_t) ((1<<LFO_SH) * (ym.YM_clock/64.0) / ym.YM_sampfreq);
 
-    eg_timer_add  = (uint32_t) ((1<<EG_SH)  * (YM_clock/64.0) / YM_sampfreq);
-    eg_timer_overflow = ( 3 ) * (1<<EG_SH);
+    ym.eg_timer_add  = (uint32_t) ((1<<EG_SH)  * (ym.YM_clock/64.0) / ym.YM_sampfreq);
+    ym.eg_timer_overflow = ( 3 ) * (1<<EG_SH);
     
     /*logerror("YM2151[init] eg_timer_add=%8x eg_timer_overflow=%8x\n", PSG->eg_timer_add, PSG->eg_timer_overflow);*/
 
@@ -1352,8 +1275,8 @@ void YM_init(int rate, int fps)
     PSG->timer_A = device->machine().scheduler().timer_alloc(FUNC(timer_callback_a), PSG);
     PSG->timer_B = device->machine().scheduler().timer_alloc(FUNC(timer_callback_b), PSG);
 #else
-    tim_A      = 0;
-    tim_B      = 0;
+    ym.tim_A      = 0;
+    ym.tim_B      = 0;
 #endif
     YM_ym2151_reset_chip();
     /*logerror("YM2151[init] clock=%i sampfreq=%i\n", PSG->clock, PSG->sampfreq);*/
@@ -1373,57 +1296,57 @@ void YM_ym2151_reset_chip()
     /* initialize hardware registers */
     for (i=0; i<32; i++)
     {
-        memset(&oper[i],'\0',sizeof(YM2151Operator));
-        oper[i].volume = MAX_ATT_INDEX;
-            oper[i].kc_i = 768; /* min kc_i value */
+        memset(&ym.oper[i],'\0',sizeof(YM2151Operator));
+        ym.oper[i].volume = MAX_ATT_INDEX;
+            ym.oper[i].kc_i = 768; /* min kc_i value */
     }
 
-    chanout[0] = 0;
-    chanout[1] = 0;
-    chanout[2] = 0;
-    chanout[3] = 0;
-    chanout[4] = 0;
-    chanout[5] = 0;
-    chanout[6] = 0;
-    chanout[7] = 0;
-
-    eg_timer = 0;
-    eg_cnt   = 0;
-
-    lfo_timer  = 0;
-    lfo_counter= 0;
-    lfo_phase  = 0;
-    lfo_wsel   = 0;
-    pmd = 0;
-    amd = 0;
-    lfa = 0;
-    lfp = 0;
-
-    test= 0;
-
-    irq_enable = 0;
+    ym.chanout[0] = 0;
+    ym.chanout[1] = 0;
+    ym.chanout[2] = 0;
+    ym.chanout[3] = 0;
+    ym.chanout[4] = 0;
+    ym.chanout[5] = 0;
+    ym.chanout[6] = 0;
+    ym.chanout[7] = 0;
+
+    ym.eg_timer = 0;
+    ym.eg_cnt   = 0;
+
+    ym.lfo_timer  = 0;
+    ym.lfo_counter= 0;
+    ym.lfo_phase  = 0;
+    ym.lfo_wsel   = 0;
+    ym.pmd = 0;
+    ym.amd = 0;
+    ym.lfa = 0;
+    ym.lfp = 0;
+
+    ym.test= 0;
+
+    ym.irq_enable = 0;
 #ifdef USE_MAME_TIMERS
     /* ASG 980324 -- reset the timers before writing to the registers */
     timer_A->enable(0);
     timer_B->enable(0);
 #else
-    tim_A      = 0;
-    tim_B      = 0;
-    tim_A_val  = 0;
-    tim_B_val  = 0;
+    ym.tim_A      = 0;
+    ym.tim_B      = 0;
+    ym.tim_A_val  = 0;
+    ym.tim_B_val  = 0;
 #endif
-    timer_A_index = 0;
-    timer_B_index = 0;
-    timer_A_index_old = 0;
-    timer_B_index_old = 0;
+    ym.timer_A_index = 0;
+    ym.timer_B_index = 0;
+    ym.timer_A_index_old = 0;
+    ym.timer_B_index_old = 0;
 
-    noise     = 0;
-    noise_rng = 0;
-    noise_p   = 0;
-    noise_f   = noise_tab[0];
+    ym.noise     = 0;
+    ym.noise_rng = 0;
+    ym.noise_p   = 0;
+    ym.noise_f   = ym.noise_tab[0];
 
-    csm_req    = 0;
-    status    = 0;
+    ym.csm_req    = 0;
+    ym.status    = 0;
 
     YM_write_reg(0x1b, 0);    /* only because of CT1, CT2 output pins */
     YM_write_reg(0x18, 0);    /* set LFO frequency */
@@ -1470,13 +1393,13 @@ void YM_chan_calc(unsigned int chan)
     unsigned int env;
     uint32_t AM = 0;
 
-    m2 = c1 = c2 = mem = 0;
-    op = &oper[chan*4];    /* M1 */
+    ym.m2 = ym.c1 = ym.c2 = ym.mem = 0;
+    op = &ym.oper[chan*4];    /* M1 */
 
     *op->mem_connect = op->mem_value;    /* restore delayed sample (MEM) value to m2 or c2 */
 
     if (op->ams)
-        AM = lfa << (op->ams-1);
+        AM = ym.lfa << (op->ams-1);
     env = volume_calc(op);
     {
         int32_t out = op->fb_out_prev + op->fb_out_curr;
@@ -1484,7 +1407,7 @@ void YM_chan_calc(unsigned int chan)
 
         if (!op->connects)
             /* algorithm 5 */
-            mem = c1 = c2 = op->fb_out_prev;
+            ym.mem = ym.c1 = ym.c2 = op->fb_out_prev;
         else
             /* other algorithms */
             *op->connects = op->fb_out_prev;
@@ -1500,18 +1423,18 @@ void YM_chan_calc(unsigned int chan)
 
     env = volume_calc(op+1);    /* M2 */
     if (env < ENV_QUIET)
-        *(op+1)->connects += YM_op_calc(op+1, env, m2);
+        *(op+1)->connects += YM_op_calc(op+1, env, ym.m2);
 
     env = volume_calc(op+2);    /* C1 */
     if (env < ENV_QUIET)
-        *(op+2)->connects += YM_op_calc(op+2, env, c1);
+        *(op+2)->connects += YM_op_calc(op+2, env, ym.c1);
 
     env = volume_calc(op+3);    /* C2 */
     if (env < ENV_QUIET)
-        chanout[chan]    += YM_op_calc(op+3, env, c2);
+        ym.chanout[chan]    += YM_op_calc(op+3, env, ym.c2);
 
     /* M1 */
-    op->mem_value = mem;
+    op->mem_value = ym.mem;
 }
 
 void YM_chan7_calc()
@@ -1520,13 +1443,13 @@ void YM_chan7_calc()
     unsigned int env;
     uint32_t AM = 0;
 
-    m2 = c1 = c2 = mem = 0;
-    op = &oper[7*4];        /* M1 */
+    ym.m2 = ym.c1 = ym.c2 = ym.mem = 0;
+    op = &ym.oper[7*4];        /* M1 */
 
     *op->mem_connect = op->mem_value;    /* restore delayed sample (MEM) value to m2 or c2 */
 
     if (op->ams)
-        AM = lfa << (op->ams-1);
+        AM = ym.lfa << (op->ams-1);
     env = volume_calc(op);
     {
         int32_t out = op->fb_out_prev + op->fb_out_curr;
@@ -1534,7 +1457,7 @@ void YM_chan7_calc()
 
         if (!op->connects)
             /* algorithm 5 */
-            mem = c1 = c2 = op->fb_out_prev;
+            ym.mem = ym.c1 = ym.c2 = op->fb_out_prev;
         else
             /* other algorithms */
             *op->connects = op->fb_out_prev;
@@ -1550,29 +1473,29 @@ void YM_chan7_calc()
 
     env = volume_calc(op+1);    /* M2 */
     if (env < ENV_QUIET)
-        *(op+1)->connects += YM_op_calc(op+1, env, m2);
+        *(op+1)->connects += YM_op_calc(op+1, env, ym.m2);
 
     env = volume_calc(op+2);    /* C1 */
     if (env < ENV_QUIET)
-        *(op+2)->connects += YM_op_calc(op+2, env, c1);
+        *(op+2)->connects += YM_op_calc(op+2, env, ym.c1);
 
     env = volume_calc(op+3);    /* C2 */
-    if (noise & 0x80)
+    if (ym.noise & 0x80)
     {
         int32_t noiseout;
 
         noiseout = 0;
         if (env < 0x3ff)
             noiseout = (env ^ 0x3ff) * 2;    /* range of the YM2151 noise output is -2044 to 2040 */
-        chanout[7] += ((noise_rng&0x10000) ? noiseout: -noiseout); /* bit 16 -> output */
+        ym.chanout[7] += ((ym.noise_rng&0x10000) ? noiseout: -noiseout); /* bit 16 -> output */
     }
     else
     {
         if (env < ENV_QUIET)
-            chanout[7] += YM_op_calc(op+3, env, c2);
+            ym.chanout[7] += YM_op_calc(op+3, env, ym.c2);
     }
     /* M1 */
-    op->mem_value = mem;
+    op->mem_value = ym.mem;
 }
 
 /*
@@ -1784,26 +1707,26 @@ void YM_advance_eg()
     YM2151Operator *op;
     unsigned int i;
 
-    eg_timer += eg_timer_add;
+    ym.eg_timer += ym.eg_timer_add;
 
-    while (eg_timer >= eg_timer_overflow)
+    while (ym.eg_timer >= ym.eg_timer_overflow)
     {
-        eg_timer -= eg_timer_overflow;
+        ym.eg_timer -= ym.eg_timer_overflow;
 
-        eg_cnt++;
+        ym.eg_cnt++;
 
         /* envelope generator */
-        op = &oper[0];    /* CH 0 M1 */
+        op = &ym.oper[0];    /* CH 0 M1 */
         i = 32;
         do
         {
             switch(op->state)
             {
             case EG_ATT:    /* attack phase */
-                if ( !(eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
+                if ( !(ym.eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
                 {
                     op->volume += (~op->volume *
-                                   (eg_inc[op->eg_sel_ar + ((eg_cnt>>op->eg_sh_ar)&7)])
+                                   (eg_inc[op->eg_sel_ar + ((ym.eg_cnt>>op->eg_sh_ar)&7)])
                                   ) >>4;
 
                     if (op->volume <= MIN_ATT_INDEX)
@@ -1816,9 +1739,9 @@ void YM_advance_eg()
             break;
 
             case EG_DEC:    /* decay phase */
-                if ( !(eg_cnt & ((1<<op->eg_sh_d1r)-1) ) )
+                if ( !(ym.eg_cnt & ((1<<op->eg_sh_d1r)-1) ) )
                 {
-                    op->volume += eg_inc[op->eg_sel_d1r + ((eg_cnt>>op->eg_sh_d1r)&7)];
+                    op->volume += eg_inc[op->eg_sel_d1r + ((ym.eg_cnt>>op->eg_sh_d1r)&7)];
 
                     if ( op->volume >= (int32_t) op->d1l )
                         op->state = EG_SUS;
@@ -1827,9 +1750,9 @@ void YM_advance_eg()
             break;
 
             case EG_SUS:    /* sustain phase */
-                if ( !(eg_cnt & ((1<<op->eg_sh_d2r)-1) ) )
+                if ( !(ym.eg_cnt & ((1<<op->eg_sh_d2r)-1) ) )
                 {
-                    op->volume += eg_inc[op->eg_sel_d2r + ((eg_cnt>>op->eg_sh_d2r)&7)];
+                    op->volume += eg_inc[op->eg_sel_d2r + ((ym.eg_cnt>>op->eg_sh_d2r)&7)];
 
                     if ( op->volume >= MAX_ATT_INDEX )
                     {
@@ -1841,9 +1764,9 @@ void YM_advance_eg()
             break;
 
             case EG_REL:    /* release phase */
-                if ( !(eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
+                if ( !(ym.eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
                 {
-                    op->volume += eg_inc[op->eg_sel_rr + ((eg_cnt>>op->eg_sh_rr)&7)];
+                    op->volume += eg_inc[op->eg_sel_rr + ((ym.eg_cnt>>op->eg_sh_rr)&7)];
 
                     if ( op->volume >= MAX_ATT_INDEX )
                     {
@@ -1868,24 +1791,24 @@ void YM_advance()
     int a,p;
 
     /* LFO */
-    if (test&2)
-        lfo_phase = 0;
+    if (ym.test&2)
+        ym.lfo_phase = 0;
     else
     {
-        lfo_timer += lfo_timer_add;
-        if (lfo_timer >= lfo_overflow)
+        ym.lfo_timer += ym.lfo_timer_add;
+        if (ym.lfo_timer >= ym.lfo_overflow)
         {
-            lfo_timer   -= lfo_overflow;
-            lfo_counter += lfo_counter_add;
-            lfo_phase   += (lfo_counter>>4);
-            lfo_phase   &= 255;
-            lfo_counter &= 15;
+            ym.lfo_timer   -= ym.lfo_overflow;
+            ym.lfo_counter += ym.lfo_counter_add;
+            ym.lfo_phase   += (ym.lfo_counter>>4);
+            ym.lfo_phase   &= 255;
+            ym.lfo_counter &= 15;
         }
     }
 
-    i = lfo_phase;
+    i = ym.lfo_phase;
     /* calculate LFO AM and PM waveform value (all verified on real chip, except for noise algorithm which is impossible to analyse)*/
-    switch (lfo_wsel)
+    switch (ym.lfo_wsel)
     {
     case 0:
         /* saw */
@@ -1943,8 +1866,8 @@ void YM_advance()
         p = a-128;
         break;
     }
-    lfa = a * amd / 128;
-    lfp = p * pmd / 128;
+    ym.lfa = a * ym.amd / 128;
+    ym.lfp = p * ym.pmd / 128;
 
 
     /*  The Noise Generator of the YM2151 is 17-bit shift register.
@@ -1952,26 +1875,26 @@ void YM_advance()
     *   Output of the register is negated (bit0 XOR bit3).
     *   Simply use bit16 as the noise output.
     */
-    noise_p += noise_f;
-    i = (noise_p>>16);        /* number of events (shifts of the shift register) */
-    noise_p &= 0xffff;
+    ym.noise_p += ym.noise_f;
+    i = (ym.noise_p>>16);        /* number of events (shifts of the shift register) */
+    ym.noise_p &= 0xffff;
     while (i)
     {
         uint32_t j;
-        j = ( (noise_rng ^ (noise_rng>>3) ) & 1) ^ 1;
-        noise_rng = (j<<16) | (noise_rng>>1);
+        j = ( (ym.noise_rng ^ (ym.noise_rng>>3) ) & 1) ^ 1;
+        ym.noise_rng = (j<<16) | (ym.noise_rng>>1);
         i--;
     }
 
 
     /* phase generator */
-    op = &oper[0];    /* CH 0 M1 */
+    op = &ym.oper[0];    /* CH 0 M1 */
     i = 8;
     do
     {
         if (op->pms)    /* only when phase modulation from LFO is enabled for this channel */
         {
-            int32_t mod_ind = lfp;        /* -128..+127 (8bits signed) */
+            int32_t mod_ind = ym.lfp;        /* -128..+127 (8bits signed) */
             if (op->pms < 6)
                 mod_ind >>= (6 - op->pms);
             else
@@ -1980,10 +1903,10 @@ void YM_advance()
             if (mod_ind)
             {
                 uint32_t kc_channel =    op->kc_i + mod_ind;
-                (op+0)->phase += ( (freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
-                (op+1)->phase += ( (freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
-                (op+2)->phase += ( (freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
-                (op+3)->phase += ( (freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
+                (op+0)->phase += ( (ym.freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
+                (op+1)->phase += ( (ym.freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
+                (op+2)->phase += ( (ym.freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
+                (op+3)->phase += ( (ym.freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
             }
             else        /* phase modulation from LFO is equal to zero */
             {
@@ -2015,11 +1938,11 @@ void YM_advance()
     * the sound played is the same as after normal KEY ON.
     */
 
-    if (csm_req)            /* CSM KEYON/KEYOFF seqeunce request */
+    if (ym.csm_req)            /* CSM KEYON/KEYOFF seqeunce request */
     {
-        if (csm_req==2)    /* KEY ON */
+        if (ym.csm_req==2)    /* KEY ON */
         {
-            op = &oper[0];    /* CH 0 M1 */
+            op = &ym.oper[0];    /* CH 0 M1 */
             i = 32;
             do
             {
@@ -2027,11 +1950,11 @@ void YM_advance()
                 op++;
                 i--;
             }while (i);
-            csm_req = 1;
+            ym.csm_req = 1;
         }
         else                    /* KEY OFF */
         {
-            op = &oper[0];    /* CH 0 M1 */
+            op = &ym.oper[0];    /* CH 0 M1 */
             i = 32;
             do
             {
@@ -2039,7 +1962,7 @@ void YM_advance()
                 op++;
                 i--;
             }while (i);
-            csm_req = 0;
+            ym.csm_req = 0;
         }
     }
 }
@@ -2058,18 +1981,18 @@ void YM_stream_update(uint16_t* stream, int samples)
 #ifdef USE_MAME_TIMERS
         /* ASG 980324 - handled by real timers now */
 #else
-    if (tim_B)
+    if (ym.tim_B)
     {
-        tim_B_val -= ( samples << TIMER_SH );
-        if (tim_B_val<=0)
+        ym.tim_B_val -= ( samples << TIMER_SH );
+        if (ym.tim_B_val<=0)
         {
-            tim_B_val += tim_B_tab[ timer_B_index ];
-            if ( irq_enable & 0x08 )
+            ym.tim_B_val += ym.tim_B_tab[ ym.timer_B_index ];
+            if ( ym.irq_enable & 0x08 )
             {
-                int oldstate = status & 3;
-                status |= 2;
+                int oldstate = ym.status & 3;
+                ym.status |= 2;
                 //if ((!oldstate) && (irqhandler)) (*irqhandler)(device, 1);
-                if (oldstate==0) YM_irq = 1;
+                if (oldstate==0) ym.YM_irq = 1;
             }
         }
     }
@@ -2079,14 +2002,14 @@ void YM_stream_update(uint16_t* stream, int samples)
     {
         YM_advance_eg();
 
-        chanout[0] = 0;
-        chanout[1] = 0;
-        chanout[2] = 0;
-        chanout[3] = 0;
-        chanout[4] = 0;
-        chanout[5] = 0;
-        chanout[6] = 0;
-        chanout[7] = 0;
+        ym.chanout[0] = 0;
+        ym.chanout[1] = 0;
+        ym.chanout[2] = 0;
+        ym.chanout[3] = 0;
+        ym.chanout[4] = 0;
+        ym.chanout[5] = 0;
+        ym.chanout[6] = 0;
+        ym.chanout[7] = 0;
 
         YM_chan_calc(0);
         YM_chan_calc(1);
@@ -2097,22 +2020,22 @@ void YM_stream_update(uint16_t* stream, int samples)
         YM_chan_calc(6);
         YM_chan7_calc();
 
-        outl = chanout[0] & pan[0];
-        outr = chanout[0] & pan[1];
-        outl += (chanout[1] & pan[2]);
-        outr += (chanout[1] & pan[3]);
-        outl += (chanout[2] & pan[4]);
-        outr += (chanout[2] & pan[5]);
-        outl += (chanout[3] & pan[6]);
-        outr += (chanout[3] & pan[7]);
-        outl += (chanout[4] & pan[8]);
-        outr += (chanout[4] & pan[9]);
-        outl += (chanout[5] & pan[10]);
-        outr += (chanout[5] & pan[11]);
-        outl += (chanout[6] & pan[12]);
-        outr += (chanout[6] & pan[13]);
-        outl += (chanout[7] & pan[14]);
-        outr += (chanout[7] & pan[15]);
+        outl = ym.chanout[0] & ym.pan[0];
+        outr = ym.chanout[0] & ym.pan[1];
+        outl += (ym.chanout[1] & ym.pan[2]);
+        outr += (ym.chanout[1] & ym.pan[3]);
+        outl += (ym.chanout[2] & ym.pan[4]);
+        outr += (ym.chanout[2] & ym.pan[5]);
+        outl += (ym.chanout[3] & ym.pan[6]);
+        outr += (ym.chanout[3] & ym.pan[7]);
+        outl += (ym.chanout[4] & ym.pan[8]);
+        outr += (ym.chanout[4] & ym.pan[9]);
+        outl += (ym.chanout[5] & ym.pan[10]);
+        outr += (ym.chanout[5] & ym.pan[11]);
+        outl += (ym.chanout[6] & ym.pan[12]);
+        outr += (ym.chanout[6] & ym.pan[13]);
+        outl += (ym.chanout[7] & ym.pan[14]);
+        outr += (ym.chanout[7] & ym.pan[15]);
 
         outl >>= FINAL_SH;
         outr >>= FINAL_SH;
@@ -2128,21 +2051,21 @@ void YM_stream_update(uint16_t* stream, int samples)
         /* ASG 980324 - handled by real timers now */
 #else
         /* calculate timer A */
-        if (tim_A)
+        if (ym.tim_A)
         {
-            tim_A_val -= ( 1 << TIMER_SH );
-            if (tim_A_val <= 0)
+            ym.tim_A_val -= ( 1 << TIMER_SH );
+            if (ym.tim_A_val <= 0)
             {
-                tim_A_val += tim_A_tab[ timer_A_index ];
-                if (irq_enable & 0x04)
+                ym.tim_A_val += ym.tim_A_tab[ ym.timer_A_index ];
+                if (ym.irq_enable & 0x04)
                 {
-                    int oldstate = status & 3;
-                    status |= 1;
+                    int oldstate = ym.status & 3;
+                    ym.status |= 1;
                     //if ((!oldstate) && (irqhandler)) (*irqhandler)(device, 1);
-                    if (oldstate==0) YM_irq = 1;
+                    if (oldstate==0) ym.YM_irq = 1;
                 }
-                if (irq_enable & 0x80)
-                    csm_req = 2;    /* request KEY ON / KEY OFF sequence */
+                if (ym.irq_enable & 0x80)
+                    ym.csm_req = 2;    /* request KEY ON / KEY OFF sequence */
             }
         }
 #endif
@@ -0,0 +1,613 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef __APPLE__
+#define _XOPEN_SOURCE   700
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine.h"
+#include "forkserver.h"
+
+// The machine boots once. When BASIC first waits for input, the emulator
+// forks for every test; the child loads the test's PRG or BASIC program into
+// its copy of the booted machine and runs it. Everything the machine had when
+// it forked, ROM, RAM and VRAM included, is shared with the server
+// copy-on-write, so a test only costs a fork and the pages it writes.
+//
+// The tests come from requests on a Unix socket (-fork-server), or from a
+// directory (-batch). A request is one line: the path of the program,
+// optionally followed by a comma and the load address in hex like with -prg,
+// and optionally by a space and the number of seconds the test may run.
+//
+// Anything a test prints with -echo goes to the client, or into the batch
+// report, followed by a line with the result: EXIT if the program jumped to
+// $FFFF or TIMEOUT, then A, the PC (for EXIT, the address of the instruction
+// that jumped to $FFFF), the frames and cycles the test ran and a hash of
+// what was on the screen at the end.
+//
+// -maxframes 0 lets tests run until they exit. Paths in requests, and names
+// of the files in a -batch directory, can't contain spaces or commas.
+
+#define FRAMES_PER_SECOND 60
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+bool
+fork_server_init(const char *path, uint32_t max_frames)
+{
+	printf("-fork-server is not supported on this platform.\n");
+	return false;
+}
+
+bool
+fork_batch_init(const char *dir, int jobs, uint32_t max_frames, const char *report_path)
+{
+	printf("-batch is not supported on this platform.\n");
+	return false;
+}
+
+bool
+fork_server_active()
+{
+	return false;
+}
+
+bool
+fork_server_run(fork_request_t *request)
+{
+	return false;
+}
+
+bool
+fork_server_frame()
+{
+	return true;
+}
+
+void
+fork_server_exit(uint16_t from)
+{
+}
+
+void
+fork_server_report()
+{
+}
+
+#else
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// how a test went, for the batch report
+typedef struct {
+	char path[PATH_MAX];
+	char status[16]; // EXIT, TIMEOUT or ERROR if there was no result
+	unsigned a, pc;
+	uint32_t frames;
+	unsigned long long cycles;
+	unsigned long long screen;
+	double host_ms;
+	char *output;
+} test_result_t;
+
+static struct {
+	int fd;               // listening, in the server
+	uint32_t max_frames;  // default for the tests
+
+	// -batch
+	const char *dir;
+	int jobs;
+	const char *report_path;
+	int report_fd;        // the original stdout
+	test_result_t *tests;
+	int count;
+
+	// in the child
+	bool child;
+	uint32_t frames;
+	uint32_t test_max_frames;
+	bool timeout;
+	uint16_t exit_pc;     // the instruction that jumped to $FFFF
+	uint64_t cycles;
+	uint32_t last_clock;
+} server = { -1 };
+
+// Listens on a Unix socket at path, replacing whatever was there.
+bool
+fork_server_init(const char *path, uint32_t max_frames)
+{
+	struct sockaddr_un address;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		printf("The socket path %s is too long!\n", path);
+		return false;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	server.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server.fd < 0) {
+		perror("socket");
+		return false;
+	}
+	unlink(path);
+	if (bind(server.fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(server.fd, 16) < 0) {
+		perror(path);
+		close(server.fd);
+		server.fd = -1;
+		return false;
+	}
+	server.max_frames = max_frames;
+	return true;
+}
+
+static bool
+is_test(const char *name)
+{
+	size_t length = strlen(name);
+	if (length < 4 || name[length - 4] != '.') {
+		return false;
+	}
+	char extension[4];
+	for (int i = 0; i < 3; i++) {
+		extension[i] = tolower((unsigned char)name[length - 3 + i]);
+	}
+	extension[3] = 0;
+	return !strcmp(extension, "prg") || !strcmp(extension, "bas");
+}
+
+static int
+compare_tests(const void *a, const void *b)
+{
+	return strcmp(((const test_result_t *)a)->path, ((const test_result_t *)b)->path);
+}
+
+// Runs every .prg and .bas in dir, up to jobs (0: one per CPU) at a time, and
+// writes a report to report_path: CSV if it ends in .csv, JSON otherwise,
+// stdout if NULL.
+bool
+fork_batch_init(const char *dir, int jobs, uint32_t max_frames, const char *report_path)
+{
+	DIR *d = opendir(dir);
+	if (!d) {
+		printf("Cannot open %s!\n", dir);
+		return false;
+	}
+	int capacity = 0;
+	struct dirent *entry;
+	while ((entry = readdir(d))) {
+		if (!is_test(entry->d_name)) {
+			continue;
+		}
+		if (server.count == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			test_result_t *tests = realloc(server.tests, capacity * sizeof(test_result_t));
+			if (!tests) {
+				closedir(d);
+				printf("Not enough memory for the tests!\n");
+				return false;
+			}
+			server.tests = tests;
+		}
+		test_result_t *test = &server.tests[server.count];
+		memset(test, 0, sizeof(*test));
+		strcpy(test->status, "ERROR");
+		if (snprintf(test->path, sizeof(test->path), "%s/%s", dir, entry->d_name) >= sizeof(test->path)) {
+			continue;
+		}
+		server.count++;
+	}
+	closedir(d);
+	qsort(server.tests, server.count, sizeof(test_result_t), compare_tests);
+
+	server.dir = dir;
+	if (!jobs) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		jobs = cpus > 0 ? (int)cpus : 1;
+	}
+	server.jobs = jobs;
+	server.max_frames = max_frames;
+	server.report_path = report_path;
+
+	// what the machine prints while it boots isn't part of the report
+	fflush(stdout);
+	server.report_fd = dup(STDOUT_FILENO);
+	int null = open("/dev/null", O_WRONLY);
+	if (server.report_fd < 0 || null < 0) {
+		perror("dup");
+		return false;
+	}
+	dup2(null, STDOUT_FILENO);
+	close(null);
+	return true;
+}
+
+// whether the machine is to be forked for tests once it has booted
+bool
+fork_server_active()
+{
+	return server.fd >= 0 || server.dir;
+}
+
+// a request for the program at path with the default settings
+static bool
+default_request(const char *path, fork_request_t *request)
+{
+	if (!path[0] || strlen(path) >= sizeof(request->path)) {
+		return false;
+	}
+	strcpy(request->path, path);
+	request->bas = is_test(path) && tolower((unsigned char)path[strlen(path) - 3]) == 'b';
+	request->start = -1;
+	request->max_frames = server.max_frames;
+	return true;
+}
+
+// parses a request line, see above
+static bool
+parse_request(char *line, fork_request_t *request)
+{
+	int start = -1;
+	uint32_t max_frames = server.max_frames;
+	char *space = strchr(line, ' ');
+	if (space) {
+		uint32_t seconds = (uint32_t)strtoul(space + 1, NULL, 10);
+		if (seconds) {
+			max_frames = seconds * FRAMES_PER_SECOND;
+		}
+		*space = 0;
+	}
+	char *comma = strchr(line, ',');
+	if (comma) {
+		start = (uint16_t)strtol(comma + 1, NULL, 16);
+		*comma = 0;
+	}
+	if (!default_request(line, request)) {
+		return false;
+	}
+	request->start = start;
+	request->max_frames = max_frames;
+	return true;
+}
+
+// reads the request line from a client
+static bool
+read_request(int conn, fork_request_t *request)
+{
+	char line[PATH_MAX + 32];
+	size_t length = 0;
+	while (length < sizeof(line) - 1) {
+		ssize_t n = read(conn, &line[length], 1);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0 || line[length] == '\n') {
+			break;
+		}
+		length++;
+	}
+	line[length] = 0;
+	if (length && line[length - 1] == '\r') {
+		line[--length] = 0;
+	}
+	return parse_request(line, request);
+}
+
+// in the child, with stdout going where the test's output belongs
+static void
+start_test(const fork_request_t *request)
+{
+	server.child = true;
+	server.dir = NULL;
+	server.test_max_frames = request->max_frames;
+	server.last_clock = machine->cpu.clockticks6502;
+}
+
+// Serves test requests until the emulator is killed. Returns in the child
+// for every request, with stdout going to the client.
+static void
+serve()
+{
+	fork_request_t request;
+
+	// the children aren't waited for
+	signal(SIGCHLD, SIG_IGN);
+	fflush(stdout);
+
+	for (;;) {
+		int conn = accept(server.fd, NULL, NULL);
+		if (conn < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("accept");
+			exit(1);
+		}
+
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("fork");
+		} else if (pid == 0) {
+			close(server.fd);
+			server.fd = -1;
+			if (!read_request(conn, &request)) {
+				dprintf(conn, "Bad request!\n");
+				_exit(1);
+			}
+			dup2(conn, STDOUT_FILENO);
+			close(conn);
+			start_test(&request);
+			return;
+		}
+		close(conn);
+	}
+}
+
+static void
+write_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		unsigned char c = *s;
+		if (c == '"' || c == '\\') {
+			fprintf(f, "\\%c", c);
+		} else if (c == '\n') {
+			fprintf(f, "\\n");
+		} else if (c < 0x20) {
+			fprintf(f, "\\u%04x", c);
+		} else {
+			fputc(c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+static void
+write_csv_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"') {
+			fputc('"', f);
+		}
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void
+write_report()
+{
+	FILE *f = server.report_path ? fopen(server.report_path, "w") : fdopen(server.report_fd, "w");
+	if (!f) {
+		perror(server.report_path);
+		return;
+	}
+	size_t length = server.report_path ? strlen(server.report_path) : 0;
+	bool csv = length >= 4 && !strcmp(server.report_path + length - 4, ".csv");
+
+	if (csv) {
+		fprintf(f, "test,status,a,pc,frames,cycles,screen,host_ms,output\n");
+	} else {
+		fprintf(f, "[\n");
+	}
+	for (int i = 0; i < server.count; i++) {
+		const test_result_t *t = &server.tests[i];
+		const char *output = t->output ? t->output : "";
+		if (csv) {
+			write_csv_string(f, t->path);
+			fprintf(f, ",%s,%u,%u,%u,%llu,%016llx,%.3f,", t->status, t->a, t->pc, t->frames, t->cycles, t->screen, t->host_ms);
+			write_csv_string(f, output);
+			fprintf(f, "\n");
+		} else {
+			fprintf(f, "  {\"test\": ");
+			write_json_string(f, t->path);
+			fprintf(f, ", \"status\": \"%s\", \"a\": %u, \"pc\": %u, \"frames\": %u, \"cycles\": %llu, \"screen\": \"%016llx\", \"host_ms\": %.3f, \"output\": ",
+				t->status, t->a, t->pc, t->frames, t->cycles, t->screen, t->host_ms);
+			write_json_string(f, output);
+			fprintf(f, "}%s\n", i + 1 < server.count ? "," : "");
+		}
+	}
+	if (!csv) {
+		fprintf(f, "]\n");
+	}
+	fclose(f);
+}
+
+// Takes the output of a finished test apart: the last line is the result.
+static void
+collect(test_result_t *test, FILE *out)
+{
+	fseek(out, 0, SEEK_END);
+	long size = ftell(out);
+	rewind(out);
+	test->output = malloc(size + 1);
+	if (!test->output) {
+		return;
+	}
+	size = fread(test->output, 1, size, out);
+	test->output[size] = 0;
+
+	if (size && test->output[size - 1] == '\n') {
+		test->output[--size] = 0;
+		char *newline = strrchr(test->output, '\n');
+		if (newline && sscanf(newline + 1, "%15s a=$%x pc=$%x frames=%u cycles=%llu screen=%llx",
+				test->status, &test->a, &test->pc, &test->frames, &test->cycles, &test->screen) == 6) {
+			*newline = 0;
+		} else {
+			strcpy(test->status, "ERROR");
+			test->output[size] = '\n';
+		}
+	}
+}
+
+// Runs all tests of the batch, the given number at a time. Returns in the
+// child for every test, with stdout going to a file, and with false in the
+// server at the end.
+static bool
+run_batch(fork_request_t *request)
+{
+	typedef struct {
+		pid_t pid;
+		int test;
+		FILE *out;
+		uint64_t start;
+	} job_t;
+	job_t *jobs = calloc(server.jobs, sizeof(job_t));
+	if (!jobs) {
+		perror("calloc");
+		return false;
+	}
+
+	int next = 0;
+	int running = 0;
+	for (;;) {
+		for (int j = 0; j < server.jobs && next < server.count; j++) {
+			if (jobs[j].pid) {
+				continue;
+			}
+			test_result_t *test = &server.tests[next];
+			FILE *out = tmpfile();
+			if (!out) {
+				perror("tmpfile");
+				strcpy(test->status, "ERROR");
+				next++;
+				continue;
+			}
+			uint64_t start = SDL_GetPerformanceCounter();
+			fflush(stdout);
+			pid_t pid = fork();
+			if (pid < 0) {
+				perror("fork");
+				fclose(out);
+				break;
+			}
+			if (pid == 0) {
+				// the file names can contain spaces and commas
+				default_request(test->path, request);
+				dup2(fileno(out), STDOUT_FILENO);
+				fclose(out);
+				start_test(request);
+				return true;
+			}
+			jobs[j].pid = pid;
+			jobs[j].test = next++;
+			jobs[j].out = out;
+			jobs[j].start = start;
+			running++;
+		}
+		if (!running) {
+			break;
+		}
+
+		pid_t pid = waitpid(-1, NULL, 0);
+		if (pid < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("waitpid");
+			break;
+		}
+		for (int j = 0; j < server.jobs; j++) {
+			if (jobs[j].pid == pid) {
+				test_result_t *test = &server.tests[jobs[j].test];
+				uint64_t ticks = SDL_GetPerformanceCounter() - jobs[j].start;
+				test->host_ms = ticks * 1000.0 / SDL_GetPerformanceFrequency();
+				collect(test, jobs[j].out);
+				fclose(jobs[j].out);
+				jobs[j].pid = 0;
+				running--;
+			}
+		}
+	}
+	free(jobs);
+
+	write_report();
+	for (int i = 0; i < server.count; i++) {
+		free(server.tests[i].output);
+	}
+	free(server.tests);
+	server.tests = NULL;
+	server.dir = NULL;
+	return false;
+}
+
+// Called once the machine has booted. Returns true in a child that is to run
+// request, false when a batch is done.
+bool
+fork_server_run(fork_request_t *request)
+{
+	if (server.dir) {
+		return run_batch(request);
+	}
+	serve();
+	return true;
+}
+
+static void
+count_cycles()
+{
+	uint32_t now = machine->cpu.clockticks6502;
+	server.cycles += (uint32_t)(now - server.last_clock);
+	server.last_clock = now;
+}
+
+// Called at the end of every frame. Returns false once a test ran out of time.
+bool
+fork_server_frame()
+{
+	if (!server.child) {
+		return true;
+	}
+	count_cycles();
+	server.frames++;
+	server.timeout = server.frames == server.test_max_frames;
+	return !server.timeout;
+}
+
+static uint64_t
+screen_hash()
+{
+	video_render_screen();
+	const uint8_t *p = machine->video.framebuffer;
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = 0; i < sizeof(machine->video.framebuffer); i++) {
+		hash = (hash ^ p[i]) * 0x100000001b3;
+	}
+	return hash;
+}
+
+// The test jumped to $FFFF from the given address.
+void
+fork_server_exit(uint16_t from)
+{
+	server.exit_pc = from;
+}
+
+// Tells the client how the test ended.
+void
+fork_server_report()
+{
+	if (!server.child) {
+		return;
+	}
+	count_cycles();
+	printf("\n%s a=$%02X pc=$%04X frames=%u cycles=%llu screen=%016llx\n",
+		server.timeout ? "TIMEOUT" : "EXIT", machine->cpu.a, server.timeout ? machine->cpu.pc : server.exit_pc,
+		server.frames, (unsigned long long)server.cycles, (unsigned long long)screen_hash());
+	fflush(stdout);
+}
+
+#endif
@@ -0,0 +1,28 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _FORKSERVER_H_
+#define _FORKSERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+// a test to run in a copy of the booted machine
+typedef struct {
+	char path[PATH_MAX]; // of a PRG, or of a BASIC program in ASCII
+	bool bas;
+	int start;           // load address of a PRG, -1 for the one in the file
+	uint32_t max_frames; // until the test is stopped, 0 for no limit
+} fork_request_t;
+
+bool fork_server_init(const char *path, uint32_t max_frames);
+bool fork_batch_init(const char *dir, int jobs, uint32_t max_frames, const char *report_path);
+bool fork_server_active(void);
+bool fork_server_run(fork_request_t *request);
+bool fork_server_frame(void);
+void fork_server_exit(uint16_t from);
+void fork_server_report(void);
+
+#endif
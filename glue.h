@@ -42,11 +42,6 @@ typedef enum {
 	RECORD_GIF_ACTIVE
 } gif_recorder_state_t;
 
-extern uint8_t a, x, y, sp, status;
-extern uint16_t pc;
-extern uint8_t *RAM;
-extern uint8_t ROM[];
-
 extern uint16_t num_ram_banks;
 
 extern bool debugger_enabled;
@@ -58,6 +53,9 @@ extern gif_recorder_state_t record_gif;
 extern char *gif_path;
 extern uint8_t keymap;
 extern bool warp_mode;
+extern int warp_render_ratio;
+extern int warp_present_fps;
+extern bool headless;
 
 extern void machine_dump();
 extern void machine_reset();
@@ -5,6 +5,10 @@
 /**********************************************/
 
 #include "joystick.h"
+#include "machine.h"
+#include "replay.h"
+#include "runahead.h"
+#include "lockstep.h"
 
 
 enum joy_status joy1_mode = NONE;
@@ -13,14 +17,13 @@ enum joy_status joy2_mode = NONE;
 
 static SDL_GameController *joystick1 = NULL;
 static SDL_GameController *joystick2 = NULL;
-static bool old_clock = false;
-static bool writing = false;
-static uint16_t joystick1_state = 0;
-static uint16_t joystick2_state = 0;
-static uint8_t clock_count = 0;
 
-bool joystick_latch, joystick_clock;
-bool joystick1_data, joystick2_data;
+// the controller states used instead of the game controllers' on this
+// thread, NULL for those (for libx16emu)
+static THREAD_LOCAL const uint16_t *joystick_states;
+
+// controller ports of the current machine
+#define joy (machine->joystick)
 
 bool joystick_init()
 {
@@ -51,40 +54,40 @@ bool joystick_init()
 			}
 		}
 	}
-	writing = false;
+	joy.writing = false;
 	return true;
 }
 
 void joystick_step()
 {
-	if (!writing) { //if we are not already writing, check latch to
+	if (!joy.writing) { //if we are not already writing, check latch to
 		//see if we need to start
-		handle_latch(joystick_latch, joystick_clock);
+		handle_latch(joy.joystick_latch, joy.joystick_clock);
 		return;
 	}
 
 	//if we have started writing controller data and the latch has dropped,
 	// we need to start the next bit
-	if (!joystick_latch) {
+	if (!joy.joystick_latch) {
 		//check if clock has changed
-		if (joystick_clock != old_clock) {
-			if (old_clock) {
-				old_clock = joystick_clock;
+		if (joy.joystick_clock != joy.old_clock) {
+			if (joy.old_clock) {
+				joy.old_clock = joy.joystick_clock;
 			} else {  //only write next bit when the new clock is high
-				clock_count +=1;
-				old_clock = joystick_clock;
-				if (clock_count < 16) { // write out the next 15 bits
-					joystick1_data = (joy1_mode != NONE) ? (joystick1_state & 1) : 1;
-					joystick2_data = (joy2_mode != NONE) ? (joystick2_state & 1) : 1;
-					joystick1_state = joystick1_state >> 1;
-					joystick2_state = joystick2_state >> 1;
+				joy.clock_count +=1;
+				joy.old_clock = joy.joystick_clock;
+				if (joy.clock_count < 16) { // write out the next 15 bits
+					joy.joystick1_data = (joy1_mode != NONE) ? (joy.joystick1_state & 1) : 1;
+					joy.joystick2_data = (joy2_mode != NONE) ? (joy.joystick2_state & 1) : 1;
+					joy.joystick1_state = joy.joystick1_state >> 1;
+					joy.joystick2_state = joy.joystick2_state >> 1;
 				} else {
 					//Done writing controller data
 					//reset flag and set count to 0
-					writing = false;
-					clock_count = 0;
-					joystick1_data = (joy1_mode != NONE) ? 0 : 1;
-					joystick2_data = (joy2_mode != NONE) ? 0 : 1;
+					joy.writing = false;
+					joy.clock_count = 0;
+					joy.joystick1_data = (joy1_mode != NONE) ? 0 : 1;
+					joy.joystick2_data = (joy2_mode != NONE) ? 0 : 1;
 				}
 			}
 		}
@@ -97,18 +100,31 @@ void joystick_step()
 bool handle_latch(bool latch, bool clock)
 {
 	if (latch){
-		clock_count = 0;
+		joy.clock_count = 0;
 		//get the 16-representation to put to the VIA
-		joystick1_state = get_joystick_state(joystick1, joy1_mode);
-		joystick2_state = get_joystick_state(joystick2, joy2_mode);
+		if (joystick_states) {
+			joy.joystick1_state = joystick_states[0];
+			joy.joystick2_state = joystick_states[1];
+		} else {
+			joy.joystick1_state = get_joystick_state(joystick1, joy1_mode);
+			joy.joystick2_state = get_joystick_state(joystick2, joy2_mode);
+		}
+		if (lockstep_checking()) {
+			// the reference machine gets what the real one latched
+			lockstep_joystick(&joy.joystick1_state, &joy.joystick2_state);
+		} else {
+			replay_joystick(&joy.joystick1_state, &joy.joystick2_state);
+			runahead_joystick(joy.joystick1_state, joy.joystick2_state);
+			lockstep_joystick(&joy.joystick1_state, &joy.joystick2_state);
+		}
 		//set writing flag to true to signal we will start writing controller data
-		writing = true;
-		old_clock = clock;
+		joy.writing = true;
+		joy.old_clock = clock;
 		//preload the first bit onto VIA
-		joystick1_data = (joy1_mode != NONE) ? (joystick1_state & 1) : 1;
-		joystick2_data = (joy2_mode != NONE) ? (joystick2_state & 1) : 1;
-		joystick1_state = joystick1_state >> 1;
-		joystick2_state = joystick2_state >> 1;
+		joy.joystick1_data = (joy1_mode != NONE) ? (joy.joystick1_state & 1) : 1;
+		joy.joystick2_data = (joy2_mode != NONE) ? (joy.joystick2_state & 1) : 1;
+		joy.joystick1_state = joy.joystick1_state >> 1;
+		joy.joystick2_state = joy.joystick2_state >> 1;
 	}
 
 	return latch;
@@ -172,3 +188,10 @@ uint16_t get_joystick_state(SDL_GameController *control, enum joy_status mode)
 
 	return 0xFFFF;
 }
+
+// The machines run on this thread read the two states (as
+// get_joystick_state() returns them) instead of the game controllers.
+void joystick_set_states(const uint16_t *states)
+{
+	joystick_states = states;
+}
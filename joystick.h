@@ -22,8 +22,17 @@
 enum joy_status { NES=0, NONE=1, SNES=0xF };
 extern enum joy_status joy1_mode;
 extern enum joy_status joy2_mode;
-extern bool joystick_latch, joystick_clock;
-extern bool joystick1_data, joystick2_data;
+
+typedef struct {
+	bool joystick_latch, joystick_clock;
+	bool joystick1_data, joystick2_data;
+
+	bool old_clock;
+	bool writing;
+	uint16_t joystick1_state;
+	uint16_t joystick2_state;
+	uint8_t clock_count;
+} joystick_state_t;
 
 
 bool joystick_init(); //initialize SDL controllers
@@ -36,4 +45,6 @@ bool handle_latch(bool latch, bool clock);  //used internally to check when to
 					//Used to get the 16-bit data needed to send
 uint16_t get_joystick_state(SDL_GameController *control, enum joy_status mode);
 
+void joystick_set_states(const uint16_t *states); // instead of the controllers
+
 #endif
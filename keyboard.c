@@ -2,8 +2,11 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "glue.h"
+#include "machine.h"
 #include "ps2.h"
 #include "keyboard.h"
+#include "utf8.h"
+#include "rom_symbols.h"
 
 #define EXTENDED_FLAG 0x100
 #define ESC_IS_BREAK /* if enabled, Esc sends Break/Pause key instead of Esc */
@@ -262,4 +265,83 @@ handle_keyboard(bool down, SDL_Keycode sym, SDL_Scancode scancode)
 	}
 }
 
+uint8_t
+iso8859_15_from_unicode(uint32_t c)
+{
+	// line feed -> carriage return
+	if (c == '\n') {
+		return '\r';
+	}
+
+	// translate Unicode characters not part of Latin-1 but part of Latin-15
+	switch (c) {
+		case 0x20ac: // '€'
+			return 0xa4;
+		case 0x160: // 'Š'
+			return 0xa6;
+		case 0x161: // 'š'
+			return 0xa8;
+		case 0x17d: // 'Ž'
+			return 0xb4;
+		case 0x17e: // 'ž'
+			return 0xb8;
+		case 0x152: // 'Œ'
+			return 0xbc;
+		case 0x153: // 'œ'
+			return 0xbd;
+		case 0x178: // 'Ÿ'
+			return 0xbe;
+	}
+
+	// remove Unicode characters part of Latin-1 but not part of Latin-15
+	switch (c) {
+		case 0xa4: // '¤'
+		case 0xa6: // '¦'
+		case 0xa8: // '¨'
+		case 0xb4: // '´'
+		case 0xb8: // '¸'
+		case 0xbc: // '¼'
+		case 0xbd: // '½'
+		case 0xbe: // '¾'
+			return '?';
+	}
+
+	// all other Unicode characters are also unsupported
+	if (c >= 256) {
+		return '?';
+	}
+
+	// everything else is Latin-15 already
+	return c;
+}
+
+// Types text into the KERNAL's keyboard buffer, as much of it as fits. The
+// text is UTF-8 followed by at least three zero bytes; "\X" and two hex
+// digits type that PETSCII code. Returns the rest, or NULL once all of it
+// has been typed.
+char *
+keyboard_paste(char *text)
+{
+	uint8_t *RAM = machine->memory.RAM;
 
+	while (RAM[NDX] < 10) {
+		uint32_t c;
+		int e = 0;
+
+		if (text[0] == '\\' && text[1] == 'X' && text[2] && text[3]) {
+			uint8_t hi = strtol((char[]){text[2], 0}, NULL, 16);
+			uint8_t lo = strtol((char[]){text[3], 0}, NULL, 16);
+			c = hi << 4 | lo;
+			text += 4;
+		} else {
+			text = utf8_decode(text, &c, &e);
+			c = iso8859_15_from_unicode(c);
+		}
+		if (!c || e) {
+			return NULL;
+		}
+		RAM[KEYD + RAM[NDX]] = c;
+		RAM[NDX]++;
+	}
+	return text;
+}
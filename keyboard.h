@@ -1,2 +1,3 @@
 void handle_keyboard(bool down, SDL_Keycode sym, SDL_Scancode scancode);
-
+uint8_t iso8859_15_from_unicode(uint32_t c);
+char *keyboard_paste(char *text);
@@ -0,0 +1,475 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glue.h"
+#include "machine.h"
+#include "keyboard.h"
+#include "loadsave.h"
+#include "rom_symbols.h"
+#include "x16emu.h"
+
+// libx16emu.a is everything but main.c, with this file as the host. Every
+// call selects the caller's machine for the duration and points the devices'
+// host ends at it: the sound goes into its buffer, the controllers are read
+// from its button states, and the frames are composed even though there is
+// no window. The KERNAL hooks of the emulator proper (host LOAD/SAVE, -echo,
+// exiting through $FFFF) are not installed.
+
+// stereo frames buffered for x16emu_read_audio()
+#define AUDIO_FRAMES 16384
+
+struct x16emu {
+	machine_t *machine;
+	idle_state_t idle;
+	uint64_t clocks; // clockticks6502 wraps around
+	uint32_t last_clock;
+
+	bool render;
+	uint8_t indexed[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+	uint16_t joystick[2]; // as get_joystick_state() returns them
+	int mouse_buttons;
+
+	char *paste_text; // what x16emu_type() got
+	char *paste; // what is left of it to type, NULL if nothing
+
+	int16_t audio[AUDIO_FRAMES * 2];
+	size_t audio_start; // of the oldest frame
+	size_t audio_count;
+};
+
+// the options of the emulator, as the library runs the machines
+uint16_t num_ram_banks = 64; // 512 KB
+bool debugger_enabled = false;
+bool log_video = false;
+bool log_keyboard = false;
+echo_mode_t echo_mode = ECHO_MODE_NONE;
+bool save_on_exit = false;
+gif_recorder_state_t record_gif = RECORD_GIF_DISABLED;
+char *gif_path = NULL;
+uint8_t keymap = 0; // KERNAL's default: "ABC/X16"
+bool warp_mode = false;
+int warp_render_ratio = 64;
+int warp_present_fps = 60;
+bool headless = true;
+
+// the one the current call is for
+static THREAD_LOCAL x16emu_t *current;
+
+// all machines share it; it can't change once attached
+static char *sdcard_path;
+
+static void type_text(x16emu_t *emu, const char *text);
+
+// The window and the debugger ask for these; the library has neither.
+void
+machine_dump()
+{
+}
+
+void
+machine_toggle_warp()
+{
+	warp_mode = !warp_mode;
+}
+
+// Emulator registers and replays paste into the machine being run.
+void
+machine_paste(char *s)
+{
+	if (current && s) {
+		type_text(current, s);
+	}
+}
+
+static void
+audio_sink(const int16_t *samples, int frames, void *user)
+{
+	x16emu_t *emu = user;
+
+	for (int i = 0; i < frames; i++) {
+		if (emu->audio_count == AUDIO_FRAMES) {
+			// drop the oldest
+			emu->audio_start = (emu->audio_start + 1) % AUDIO_FRAMES;
+			emu->audio_count--;
+		}
+		size_t end = (emu->audio_start + emu->audio_count) % AUDIO_FRAMES;
+		emu->audio[end * 2] = samples[i * 2];
+		emu->audio[end * 2 + 1] = samples[i * 2 + 1];
+		emu->audio_count++;
+	}
+}
+
+// Makes emu the machine the emulator code on this thread works on. Returns
+// the one that was, for leave().
+static machine_t *
+enter(x16emu_t *emu)
+{
+	machine_t *old = machine;
+
+	machine_select(emu->machine);
+	current = emu;
+	audio_set_sink(audio_sink, emu);
+	joystick_set_states(emu->joystick);
+	video_set_offscreen(emu->render, emu->render ? emu->indexed : NULL);
+	return old;
+}
+
+static void
+leave(machine_t *old)
+{
+	video_set_offscreen(false, NULL);
+	joystick_set_states(NULL);
+	audio_set_sink(NULL, NULL);
+	current = NULL;
+	machine_select(old);
+}
+
+static void
+count_clocks(x16emu_t *emu)
+{
+	emu->clocks += (uint32_t)(machine->cpu.clockticks6502 - emu->last_clock);
+	emu->last_clock = machine->cpu.clockticks6502;
+}
+
+x16emu_t *
+x16emu_create()
+{
+	x16emu_t *emu = calloc(1, sizeof(x16emu_t));
+	if (!emu) {
+		return NULL;
+	}
+	machine_t *old = machine;
+	emu->machine = machine_create();
+	if (!emu->machine) {
+		machine_select(old);
+		free(emu);
+		return NULL;
+	}
+	emu->render = true;
+	emu->joystick[0] = 0xffff;
+	emu->joystick[1] = 0xffff;
+
+	enter(emu);
+	machine_reset();
+	emu->last_clock = machine->cpu.clockticks6502;
+	leave(old);
+	return emu;
+}
+
+void
+x16emu_destroy(x16emu_t *emu)
+{
+	if (!emu) {
+		return;
+	}
+	machine_destroy(emu->machine);
+	free(emu->paste_text);
+	free(emu);
+}
+
+bool
+x16emu_load_rom(x16emu_t *emu, const char *path)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "rb");
+	if (!f) {
+		return false;
+	}
+	machine_t *old = enter(emu);
+	memset(machine->memory.ROM, 0, ROM_SIZE);
+	SDL_RWread(f, machine->memory.ROM, 1, ROM_SIZE);
+	SDL_RWclose(f);
+	memory_invalidate_code();
+	leave(old);
+
+	x16emu_reset(emu);
+	return true;
+}
+
+// Puts a PRG file into RAM like -prg does.
+bool
+x16emu_load_prg(x16emu_t *emu, const char *path, int start)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "rb");
+	if (!f) {
+		return false;
+	}
+	machine_t *old = enter(emu);
+	bool loaded = load_prg(f, start, NULL, NULL);
+	if (loaded) {
+		emu->idle.period = 0;
+	}
+	leave(old);
+	return loaded;
+}
+
+// There is one SD card image for all machines; attaching another path once
+// one is open fails.
+bool
+x16emu_attach_sdcard(x16emu_t *emu, const char *path)
+{
+	static SDL_SpinLock attach_lock;
+
+	SDL_AtomicLock(&attach_lock);
+	if (!sdcard_file) {
+		sdcard_file = SDL_RWFromFile(path, "r+b");
+		if (!sdcard_file) {
+			SDL_AtomicUnlock(&attach_lock);
+			return false;
+		}
+		sdcard_path = malloc(strlen(path) + 1);
+		if (sdcard_path) {
+			strcpy(sdcard_path, path);
+		}
+	} else if (!sdcard_path || strcmp(path, sdcard_path)) {
+		SDL_AtomicUnlock(&attach_lock);
+		return false;
+	}
+	SDL_AtomicUnlock(&attach_lock);
+	machine_t *old = enter(emu);
+	sdcard_attach();
+	leave(old);
+	return true;
+}
+
+void
+x16emu_reset(x16emu_t *emu)
+{
+	machine_t *old = enter(emu);
+	machine_reset();
+	memset(&emu->idle, 0, sizeof(emu->idle));
+	emu->paste = NULL;
+	leave(old);
+}
+
+bool
+x16emu_save_state(x16emu_t *emu, const char *path)
+{
+	machine_t *old = enter(emu);
+	count_clocks(emu);
+	bool ok = machine_save_state(path);
+	leave(old);
+	return ok;
+}
+
+bool
+x16emu_load_state(x16emu_t *emu, const char *path)
+{
+	machine_t *old = enter(emu);
+	count_clocks(emu);
+	bool ok = machine_load_state(path);
+	emu->last_clock = machine->cpu.clockticks6502;
+	memset(&emu->idle, 0, sizeof(emu->idle));
+	emu->paste = NULL;
+	leave(old);
+	return ok;
+}
+
+// Runs one batch of up to cycles, typing what is left to paste whenever the
+// KERNAL has taken the last of it. Returns whether a frame was completed.
+static bool
+run(x16emu_t *emu, uint32_t cycles)
+{
+	if (emu->paste) {
+		// don't skip ahead while the KERNAL could take the next characters
+		emu->idle.period = 0;
+	}
+	bool new_frame = machine_run_batch(&emu->idle, cycles, false);
+	if (emu->paste && machine->memory.RAM[NDX] < 10) {
+		emu->paste = keyboard_paste(emu->paste);
+	}
+	return new_frame;
+}
+
+uint32_t
+x16emu_run_cycles(x16emu_t *emu, uint32_t cycles)
+{
+	machine_t *old = enter(emu);
+	uint32_t start = machine->cpu.clockticks6502;
+	uint32_t frames = 0;
+
+	// the host may have changed memory
+	emu->idle.period = 0;
+	for (;;) {
+		uint32_t done = machine->cpu.clockticks6502 - start;
+		if (done >= cycles) {
+			break;
+		}
+		if (run(emu, cycles - done)) {
+			frames++;
+		}
+	}
+	count_clocks(emu);
+	leave(old);
+	return frames;
+}
+
+uint32_t
+x16emu_run_frames(x16emu_t *emu, uint32_t frames)
+{
+	machine_t *old = enter(emu);
+	uint32_t done = 0;
+
+	emu->idle.period = 0;
+	while (done < frames) {
+		if (run(emu, UINT32_MAX)) {
+			done++;
+		}
+	}
+	count_clocks(emu);
+	leave(old);
+	return done;
+}
+
+void
+x16emu_get_cpu(x16emu_t *emu, x16emu_cpu_t *cpu)
+{
+	const cpu6502_t *c = &emu->machine->cpu;
+
+	cpu->pc = c->pc;
+	cpu->a = c->a;
+	cpu->x = c->x;
+	cpu->y = c->y;
+	cpu->sp = c->sp;
+	cpu->status = c->status;
+	cpu->waiting = c->waiting;
+	cpu->clocks = emu->clocks + (uint32_t)(c->clockticks6502 - emu->last_clock);
+}
+
+uint8_t
+x16emu_peek(x16emu_t *emu, uint16_t address, uint8_t bank)
+{
+	machine_t *old = enter(emu);
+	uint8_t value = real_read6502(address, true, bank);
+	leave(old);
+	return value;
+}
+
+void
+x16emu_poke(x16emu_t *emu, uint16_t address, uint8_t bank, uint8_t value)
+{
+	machine_t *old = enter(emu);
+	if (address >= 0xa000 && address < 0xc000) {
+		uint8_t ram_bank = memory_get_ram_bank();
+		memory_set_ram_bank(bank);
+		write6502(address, value);
+		memory_set_ram_bank(ram_bank);
+	} else {
+		write6502(address, value);
+	}
+	emu->idle.period = 0;
+	leave(old);
+}
+
+uint8_t
+x16emu_peek_vram(x16emu_t *emu, uint32_t address)
+{
+	machine_t *old = enter(emu);
+	uint8_t value = video_space_read(address & 0x1ffff);
+	leave(old);
+	return value;
+}
+
+void
+x16emu_poke_vram(x16emu_t *emu, uint32_t address, uint8_t value)
+{
+	machine_t *old = enter(emu);
+	video_space_write(address & 0x1ffff, value);
+	leave(old);
+}
+
+void
+x16emu_set_rendering(x16emu_t *emu, bool render)
+{
+	emu->render = render;
+}
+
+const uint32_t *
+x16emu_framebuffer_rgb(x16emu_t *emu)
+{
+	return (const uint32_t *)emu->machine->video.framebuffer;
+}
+
+const uint8_t *
+x16emu_framebuffer_indexed(x16emu_t *emu)
+{
+	return emu->indexed;
+}
+
+void
+x16emu_key(x16emu_t *emu, int scancode, bool down)
+{
+	machine_t *old = enter(emu);
+	handle_keyboard(down, 0, scancode);
+	leave(old);
+}
+
+// Replaces what was left to type.
+static void
+type_text(x16emu_t *emu, const char *text)
+{
+	size_t len = strlen(text);
+	// utf8_decode() may look at 3 bytes past the end
+	char *copy = calloc(1, len + 4);
+	if (!copy) {
+		return;
+	}
+	memcpy(copy, text, len);
+	free(emu->paste_text);
+	emu->paste_text = copy;
+	emu->paste = copy;
+}
+
+bool
+x16emu_type(x16emu_t *emu, const char *utf8)
+{
+	type_text(emu, utf8);
+	return emu->paste != NULL;
+}
+
+void
+x16emu_mouse(x16emu_t *emu, int dx, int dy, int buttons)
+{
+	machine_t *old = enter(emu);
+	if (dx || dy) {
+		mouse_move(dx, dy);
+	}
+	for (int i = 0; i < 3; i++) {
+		int mask = 1 << i;
+		if ((buttons & mask) && !(emu->mouse_buttons & mask)) {
+			mouse_button_down(i);
+		} else if (!(buttons & mask) && (emu->mouse_buttons & mask)) {
+			mouse_button_up(i);
+		}
+	}
+	emu->mouse_buttons = buttons;
+	leave(old);
+}
+
+void
+x16emu_joystick(x16emu_t *emu, int port, uint16_t buttons)
+{
+	if (port == 0 || port == 1) {
+		// the controllers send a 0 for a pressed button
+		emu->joystick[port] = ~buttons;
+	}
+}
+
+size_t
+x16emu_read_audio(x16emu_t *emu, int16_t *samples, size_t frames)
+{
+	size_t n = frames < emu->audio_count ? frames : emu->audio_count;
+
+	for (size_t i = 0; i < n; i++) {
+		size_t j = (emu->audio_start + i) % AUDIO_FRAMES;
+		samples[i * 2] = emu->audio[j * 2];
+		samples[i * 2 + 1] = emu->audio[j * 2 + 1];
+	}
+	emu->audio_start = (emu->audio_start + n) % AUDIO_FRAMES;
+	emu->audio_count -= n;
+	return n;
+}
@@ -10,9 +10,9 @@
 #include <unistd.h>
 #include <SDL.h>
 #include "glue.h"
-#include "memory.h"
-#include "video.h"
+#include "machine.h"
 #include "rom_symbols.h"
+#include "loadsave.h"
 
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #define MAX(a,b) (((a)>(b))?(a):(b))
@@ -117,27 +117,29 @@ create_directory_listing(uint8_t *data)
 void
 LOAD()
 {
+	cpu6502_t *cpu = &machine->cpu;
+	uint8_t *RAM = machine->memory.RAM;
 	char filename[41];
 	uint8_t len = MIN(RAM[FNLEN], sizeof(filename) - 1);
 	memcpy(filename, (char *)&RAM[RAM[FNADR] | RAM[FNADR + 1] << 8], len);
 	filename[len] = 0;
 
-	uint16_t override_start = (x | (y << 8));
+	uint16_t override_start = (cpu->x | (cpu->y << 8));
 
 	if (filename[0] == '$') {
 		uint16_t dir_len = create_directory_listing(RAM + override_start);
 		uint16_t end = override_start + dir_len;
-		x = end & 0xff;
-		y = end >> 8;
-		status &= 0xfe;
+		cpu->x = end & 0xff;
+		cpu->y = end >> 8;
+		cpu->status &= 0xfe;
 		RAM[STATUS] = 0;
-		a = 0;
+		cpu->a = 0;
 	} else {
 		SDL_RWops *f = SDL_RWFromFile(filename, "rb");
 		if (!f) {
-			a = 4; // FNF
-			RAM[STATUS] = a;
-			status |= 1;
+			cpu->a = 4; // FNF
+			RAM[STATUS] = cpu->a;
+			cpu->status |= 1;
 			return;
 		}
 		uint8_t start_lo = SDL_ReadU8(f);
@@ -151,11 +153,11 @@ LOAD()
 		}
 
 		size_t bytes_read = 0;
-		if(a > 1) {
+		if(cpu->a > 1) {
 			// Video RAM
 			video_write(0, start & 0xff);
 			video_write(1, start >> 8);
-			video_write(2, ((a - 2) & 0xf) | 0x10);
+			video_write(2, ((cpu->a - 2) & 0xf) | 0x10);
 			uint8_t buf[2048];
 			while(1) {
 				size_t n = SDL_RWread(f, buf, 1, sizeof buf);
@@ -186,37 +188,40 @@ LOAD()
 		}
 
 		SDL_RWclose(f);
+		memory_invalidate_code();
 
 		uint16_t end = start + bytes_read;
-		x = end & 0xff;
-		y = end >> 8;
-		status &= 0xfe;
+		cpu->x = end & 0xff;
+		cpu->y = end >> 8;
+		cpu->status &= 0xfe;
 		RAM[STATUS] = 0;
-		a = 0;
+		cpu->a = 0;
 	}
 }
 
 void
 SAVE()
 {
+	cpu6502_t *cpu = &machine->cpu;
+	uint8_t *RAM = machine->memory.RAM;
 	char filename[41];
 	uint8_t len = MIN(RAM[FNLEN], sizeof(filename) - 1);
 	memcpy(filename, (char *)&RAM[RAM[FNADR] | RAM[FNADR + 1] << 8], len);
 	filename[len] = 0;
 
-	uint16_t start = RAM[a] | RAM[a + 1] << 8;
-	uint16_t end = x | y << 8;
+	uint16_t start = RAM[cpu->a] | RAM[cpu->a + 1] << 8;
+	uint16_t end = cpu->x | cpu->y << 8;
 	if (end < start) {
-		status |= 1;
-		a = 0;
+		cpu->status |= 1;
+		cpu->a = 0;
 		return;
 	}
 
 	SDL_RWops *f = SDL_RWFromFile(filename, "wb");
 	if (!f) {
-		a = 4; // FNF
-		RAM[STATUS] = a;
-		status |= 1;
+		cpu->a = 4; // FNF
+		RAM[STATUS] = cpu->a;
+		cpu->status |= 1;
 		return;
 	}
 
@@ -226,8 +231,41 @@ SAVE()
 	SDL_RWwrite(f, RAM + start, 1, end - start);
 	SDL_RWclose(f);
 
-	status &= 0xfe;
+	cpu->status &= 0xfe;
 	RAM[STATUS] = 0;
-	a = 0;
+	cpu->a = 0;
 }
 
+// Puts a PRG file into RAM and closes it, at start or, for -1, at the
+// address in the file. One at $0801 is a BASIC program, so the variables
+// start after it. Used by -prg, the fork server, the control socket and
+// the library.
+bool
+load_prg(SDL_RWops *f, int start, uint16_t *start_out, uint16_t *end_out)
+{
+	uint8_t *RAM = machine->memory.RAM;
+	uint8_t start_lo = SDL_ReadU8(f);
+	uint8_t start_hi = SDL_ReadU8(f);
+	if (start < 0) {
+		start = start_hi << 8 | start_lo;
+	}
+	if (start > 0xffff) {
+		SDL_RWclose(f);
+		return false;
+	}
+	uint16_t end = start + SDL_RWread(f, RAM + start, 1, 65536 - start);
+	SDL_RWclose(f);
+	memory_invalidate_code();
+	if (start == 0x0801) {
+		// set start of variables
+		RAM[VARTAB] = end & 0xff;
+		RAM[VARTAB + 1] = end >> 8;
+	}
+	if (start_out) {
+		*start_out = start;
+	}
+	if (end_out) {
+		*end_out = end;
+	}
+	return true;
+}
@@ -5,7 +5,12 @@
 #ifndef _LOADSAVE_H_
 #define _LOADSAVE_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL.h>
+
 void LOAD();
 void SAVE();
+bool load_prg(SDL_RWops *f, int start, uint16_t *start_out, uint16_t *end_out);
 
 #endif
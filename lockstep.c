@@ -0,0 +1,328 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glue.h"
+#include "machine.h"
+#include "lockstep.h"
+#include "audio.h"
+#include "joystick.h"
+#include "ps2.h"
+#include "vera_spi.h"
+#include "video.h"
+
+// The block cache, the JIT, skipping idle loops and letting devices catch up
+// in bulk must not change what the machine does. Lockstep checks that they
+// don't: after every frame of the real machine, a second one runs the same
+// frame the way the emulator used to, one instruction at a time with every
+// device stepped a clock at a time after each, and the two are compared. At
+// the first difference, the emulator stops and saves both machines. The
+// reference runs on a copy of the CPU core built with NO_LAZY_FLAGS
+// (cpu/eager6502.c), so the lazy flags are checked as well.
+//
+// Only the real machine is heard and writes to the SD card, and only its
+// traps run. Whenever the host changes it (input, traps that do the work of
+// the KERNAL, pasting, rewinding), the frame isn't compared and the
+// reference starts over as a copy of the real machine.
+
+#define LOCKSTEP_REAL_PATH "lockstep-real.x16state"
+#define LOCKSTEP_REFERENCE_PATH "lockstep-reference.x16state"
+
+// controller latches per frame the reference gets replayed
+#define LOCKSTEP_LATCHES 16
+
+static struct {
+	int interval; // frames between comparisons, 0 if off
+	bool checking; // running the reference machine
+	bool valid; // the reference started the frame where the real one did
+	bool diverged;
+
+	machine_t *reference;
+	uint32_t frames; // run by both
+	uint32_t compared;
+
+	// the controllers as the real machine latched them this frame
+	uint16_t joystick[LOCKSTEP_LATCHES][2];
+	int latches;
+	int latch; // the next one the reference gets
+} lockstep;
+
+// Compares the machines every given number of frames.
+bool
+lockstep_init(int interval)
+{
+	machine_t *real = machine;
+
+	lockstep.interval = interval;
+	lockstep.reference = machine_create();
+	machine_select(real);
+	return lockstep.reference != NULL;
+}
+
+void
+lockstep_close()
+{
+	if (!lockstep.interval) {
+		return;
+	}
+	if (!lockstep.diverged) {
+		printf("Lockstep: %u frames run, %u compared, no differences.\n", lockstep.frames, lockstep.compared);
+	}
+	if (lockstep.reference) {
+		machine_destroy(lockstep.reference);
+		lockstep.reference = NULL;
+	}
+	lockstep.interval = 0;
+}
+
+bool
+lockstep_enabled()
+{
+	return lockstep.interval != 0;
+}
+
+// Runs one instruction the way the emulator did before it ran the CPU in
+// batches: afterwards, every device is stepped a clock at a time, audio
+// renders the clocks and a raised IRQ line is taken. The devices are
+// always up to date, so the syncs before I/O accesses have nothing to do.
+// Returns true if a frame was completed.
+static bool
+reference_step()
+{
+	cpu6502_t *cpu = &machine->cpu;
+	uint32_t start = cpu->clockticks6502;
+	bool new_frame = false;
+
+	step6502_eager();
+	uint32_t clocks = cpu->clockticks6502 - start;
+	for (uint32_t i = 0; i < clocks; i++) {
+		ps2_step(0, 1);
+		ps2_step(1, 1);
+		joystick_step();
+		vera_spi_step(1);
+		new_frame |= video_step(MHZ, 1);
+	}
+	audio_render(clocks);
+	for (int d = 0; d < NUM_DEVICES; d++) {
+		machine->device_clock[d] = cpu->clockticks6502;
+	}
+
+	if (video_get_irq_out() && !(cpu->status & 4)) {
+		irq6502_eager();
+	}
+	return new_frame;
+}
+
+// Runs the current machine up to the end of the next frame the reference
+// way, with none of the CPU's caches and without machine_run().
+static void
+run_reference()
+{
+	lockstep.checking = true;
+	lockstep.latch = 0;
+
+	while (!reference_step()) {
+	}
+	// the scheduler picks up from here if the machine is ever run normally
+	machine_sync();
+
+	lockstep.checking = false;
+}
+
+// index of the first byte that differs, or -1
+static long
+first_difference(const uint8_t *a, const uint8_t *b, size_t size)
+{
+	if (!memcmp(a, b, size)) {
+		return -1;
+	}
+	for (size_t i = 0; i < size; i++) {
+		if (a[i] != b[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void
+print_cpu(const char *name, const cpu6502_t *cpu)
+{
+	printf("  %-10s pc=$%04X a=$%02X x=$%02X y=$%02X sp=$%02X p=$%02X%s clock=%u\n",
+		name, cpu->pc, cpu->a, cpu->x, cpu->y, cpu->sp, cpu->status,
+		cpu->waiting ? " (WAI)" : "", cpu->clockticks6502);
+}
+
+// Prints what differs between the machines. Returns false if anything does.
+static bool
+compare(const machine_t *real, const machine_t *reference)
+{
+	const cpu6502_t *c1 = &real->cpu;
+	const cpu6502_t *c2 = &reference->cpu;
+	bool same = true;
+
+	if (c1->pc != c2->pc || c1->a != c2->a || c1->x != c2->x || c1->y != c2->y ||
+		c1->sp != c2->sp || c1->status != c2->status || c1->waiting != c2->waiting ||
+		c1->clockticks6502 != c2->clockticks6502) {
+		printf("Lockstep: the CPUs differ.\n");
+		same = false;
+	}
+
+	long ram = first_difference(real->memory.RAM, reference->memory.RAM, RAM_SIZE);
+	if (ram >= 0) {
+		if (ram < 0xa000) {
+			printf("Lockstep: RAM differs at $%04lX: $%02X, should be $%02X.\n",
+				ram, real->memory.RAM[ram], reference->memory.RAM[ram]);
+		} else {
+			printf("Lockstep: RAM differs at $%02lX:$%04lX: $%02X, should be $%02X.\n",
+				(ram - 0xa000) / 8192, 0xa000 + (ram - 0xa000) % 8192,
+				real->memory.RAM[ram], reference->memory.RAM[ram]);
+		}
+		same = false;
+	}
+
+	long vram = first_difference(real->video.video_ram, reference->video.video_ram, sizeof(real->video.video_ram));
+	if (vram >= 0) {
+		printf("Lockstep: VRAM differs at $%05lX: $%02X, should be $%02X.\n",
+			vram, real->video.video_ram[vram], reference->video.video_ram[vram]);
+		same = false;
+	}
+	if (memcmp(real->video.palette, reference->video.palette, sizeof(real->video.palette)) ||
+		memcmp(real->video.sprite_data, reference->video.sprite_data, sizeof(real->video.sprite_data)) ||
+		memcmp(real->video.reg_layer, reference->video.reg_layer, sizeof(real->video.reg_layer)) ||
+		memcmp(real->video.reg_composer, reference->video.reg_composer, sizeof(real->video.reg_composer)) ||
+		real->video.ien != reference->video.ien || real->video.isr != reference->video.isr) {
+		printf("Lockstep: the VERA registers differ.\n");
+		same = false;
+	}
+
+	const size_t line = SCREEN_WIDTH * 4;
+	long pixel = first_difference(real->video.framebuffer, reference->video.framebuffer, sizeof(real->video.framebuffer));
+	if (pixel >= 0) {
+		printf("Lockstep: scanline %ld differs from x=%ld.\n", pixel / line, pixel % line / 4);
+		same = false;
+	}
+
+	if (!same) {
+		print_cpu("real:", c1);
+		print_cpu("reference:", c2);
+	}
+	return same;
+}
+
+static void
+save(machine_t *m, const char *path)
+{
+	machine_t *current = machine;
+
+	machine_select(m);
+	if (!machine_save_state(path)) {
+		printf("Cannot save the machine state to %s!\n", path);
+	}
+	machine_select(current);
+}
+
+// Called at the end of every frame of the real machine. Runs the same frame
+// on the reference machine. Returns false once they differ.
+bool
+lockstep_frame()
+{
+	if (!lockstep.interval) {
+		return true;
+	}
+	if (!lockstep.valid || debugger_enabled) {
+		// the debugger may have changed anything
+		lockstep.valid = false;
+		return true;
+	}
+
+	machine_t *real = machine;
+	machine_select(lockstep.reference);
+	run_reference();
+	machine_select(real);
+
+	lockstep.frames++;
+	if (lockstep.frames % lockstep.interval) {
+		return true;
+	}
+	lockstep.compared++;
+	if (compare(real, lockstep.reference)) {
+		return true;
+	}
+
+	printf("Lockstep: the machines differ after %u frames.\n", lockstep.frames);
+	save(real, LOCKSTEP_REAL_PATH);
+	save(lockstep.reference, LOCKSTEP_REFERENCE_PATH);
+	printf("Saved the real machine to %s and the reference to %s.\n", LOCKSTEP_REAL_PATH, LOCKSTEP_REFERENCE_PATH);
+	lockstep.diverged = true;
+	return false;
+}
+
+// Called before the next frame starts. Makes the reference a copy of the real
+// machine again if the host changed it.
+void
+lockstep_sync()
+{
+	if (!lockstep.interval) {
+		return;
+	}
+	lockstep.latches = 0;
+	if (lockstep.valid) {
+		return;
+	}
+
+	machine_t *real = machine;
+	machine_select(lockstep.reference);
+	machine_restore(real, real->memory.RAM);
+	machine_select(real);
+	lockstep.valid = true;
+}
+
+// The host changed the real machine: the reference can't follow until the
+// next frame.
+void
+lockstep_invalidate()
+{
+	lockstep.valid = false;
+}
+
+// The machine latched the controllers. The reference gets the same states as
+// the real machine, even if the host's have changed in between.
+void
+lockstep_joystick(uint16_t *state1, uint16_t *state2)
+{
+	if (!lockstep.interval) {
+		return;
+	}
+	if (lockstep.checking) {
+		if (lockstep.latch < lockstep.latches) {
+			*state1 = lockstep.joystick[lockstep.latch][0];
+			*state2 = lockstep.joystick[lockstep.latch][1];
+			lockstep.latch++;
+		}
+		return;
+	}
+	if (lockstep.latches == LOCKSTEP_LATCHES) {
+		lockstep.valid = false;
+		return;
+	}
+	lockstep.joystick[lockstep.latches][0] = *state1;
+	lockstep.joystick[lockstep.latches][1] = *state2;
+	lockstep.latches++;
+}
+
+// Whether the reference machine is running; it mustn't be heard or leave
+// anything on the host.
+bool
+lockstep_checking()
+{
+	return lockstep.checking;
+}
+
+bool
+lockstep_diverged()
+{
+	return lockstep.diverged;
+}
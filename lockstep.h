@@ -0,0 +1,21 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _LOCKSTEP_H_
+#define _LOCKSTEP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool lockstep_init(int interval);
+void lockstep_close(void);
+bool lockstep_enabled(void);
+bool lockstep_frame(void);
+void lockstep_sync(void);
+void lockstep_invalidate(void);
+void lockstep_joystick(uint16_t *state1, uint16_t *state2);
+bool lockstep_checking(void);
+bool lockstep_diverged(void);
+
+#endif
@@ -0,0 +1,523 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "glue.h"
+#include "machine.h"
+#include "audio.h"
+
+THREAD_LOCAL machine_t *machine;
+
+bool skip_idle = true;
+
+// cycles fast-forwarded on this thread since the last speed log
+THREAD_LOCAL uint32_t wai_skipped_clocks;
+THREAD_LOCAL uint32_t loop_skipped_clocks;
+
+// Creates a machine with empty ROM and selects it. The caller loads the ROM
+// and resets the machine before running it.
+machine_t *
+machine_create()
+{
+	machine_t *m = calloc(1, sizeof(machine_t));
+	if (!m) {
+		return NULL;
+	}
+	machine_select(m);
+
+	// different every time, unless a saved state says otherwise
+	m->random = (uint32_t)time(NULL) | 1;
+
+	memory_init();
+	sdcard_init();
+
+	// 4 MHz clock
+	YM_Create(4000000);
+	YM_init(AUDIO_SAMPLERATE, 60);
+
+	machine_sync();
+
+	return m;
+}
+
+void
+machine_destroy(machine_t *m)
+{
+	machine_t *old = machine;
+
+	machine_select(m);
+	free6502(&m->cpu);
+	memory_free();
+	machine_select(old == m ? NULL : old);
+	free(m);
+}
+
+void
+machine_select(machine_t *m)
+{
+	machine = m;
+}
+
+// How each device catches up, and how many CPU clocks it is from doing
+// something the CPU can notice without accessing it: VERA renders and
+// raises its IRQs at the end of the scanline, audio drains the PCM FIFO
+// when it renders a buffer. PS/2, SPI and the joysticks only change what
+// the CPU reads from them, so they wait until it does.
+static void
+run_video(uint32_t clocks)
+{
+	if (video_step(MHZ, clocks)) {
+		machine->frame_done = true;
+	}
+}
+
+static uint32_t
+video_event()
+{
+	return video_cycles_to_line(MHZ);
+}
+
+static void
+run_audio(uint32_t clocks)
+{
+	audio_render(clocks);
+}
+
+static uint32_t
+audio_event()
+{
+	return audio_cycles_to_render();
+}
+
+static void
+run_ps2(uint32_t clocks)
+{
+	ps2_step(0, clocks);
+	ps2_step(1, clocks);
+}
+
+static void
+run_joystick(uint32_t clocks)
+{
+	// the controllers only react to changes of latch and clock
+	joystick_step();
+}
+
+static const struct {
+	void (*run)(uint32_t clocks);
+	uint32_t (*cycles_to_event)(void); // NULL if there are none
+} devices[NUM_DEVICES] = {
+	[DEVICE_VIDEO] = { run_video, video_event },
+	[DEVICE_AUDIO] = { run_audio, audio_event },
+	[DEVICE_PS2] = { run_ps2, NULL },
+	[DEVICE_SPI] = { vera_spi_step, NULL },
+	[DEVICE_JOYSTICK] = { run_joystick, NULL },
+};
+
+// Enters the clock at which a device next acts on its own and keeps the CPU
+// from running past the earliest one. Called after the device has caught up
+// and after writes that can move its event.
+void
+machine_schedule(device_t d)
+{
+	cpu6502_t *cpu = &machine->cpu;
+
+	if (!devices[d].cycles_to_event) {
+		return;
+	}
+	machine->event_clock[d] = machine->device_clock[d] + devices[d].cycles_to_event();
+
+	uint32_t next = machine->event_clock[d];
+	for (int i = 0; i < NUM_DEVICES; i++) {
+		if (devices[i].cycles_to_event && (int32_t)(machine->event_clock[i] - next) < 0) {
+			next = machine->event_clock[i];
+		}
+	}
+	machine->next_event = next;
+	if ((int32_t)(next - cpu->clockgoal6502) < 0) {
+		cpu->clockgoal6502 = next;
+	}
+}
+
+// CPU clocks until the next device event
+uint32_t
+machine_cycles_to_deadline()
+{
+	return machine->next_event - machine->cpu.clockticks6502;
+}
+
+// Runs a device up to the CPU clock. This happens before the CPU accesses
+// one of its registers and at the end of machine_run(), which never runs
+// past an event. The result is the same as stepping it along with every
+// instruction.
+void
+machine_sync_device(device_t d)
+{
+	uint32_t clocks = machine->cpu.clockticks6502 - machine->device_clock[d];
+	if (clocks) {
+		machine->device_clock[d] += clocks;
+		devices[d].run(clocks);
+	}
+	machine_schedule(d);
+}
+
+void
+machine_sync()
+{
+	for (int d = 0; d < NUM_DEVICES; d++) {
+		machine_sync_device(d);
+	}
+}
+
+// Runs the CPU for up to the given number of clocks and brings the devices
+// up to date. It stops early at the next device event, at a trap address
+// and when an I/O access raises the IRQ line; like the hardware, it finishes
+// the instruction it is in first. Returns true if a frame was completed.
+bool
+machine_run(uint32_t cycles)
+{
+	cpu6502_t *cpu = &machine->cpu;
+
+	// a single instruction can't be cut short anyway
+	if (cycles > 1) {
+		uint32_t deadline = machine_cycles_to_deadline();
+		if (cycles > deadline) {
+			cycles = deadline;
+		}
+	}
+	cpu->clockgoal6502 = cpu->clockticks6502;
+	exec6502(cycles);
+	machine_sync();
+
+	if (video_get_irq_out() && !(cpu->status & 4)) {
+		irq6502();
+	}
+
+	bool frame_done = machine->frame_done;
+	machine->frame_done = false;
+	return frame_done;
+}
+
+// looking for idle loops between batches
+#define IDLE_PROBE 16        // instructions single stepped each time
+#define IDLE_BACKOFF_MAX 64  // most batches to run in between while there are none
+
+// Runs a batch of instructions of at most the given number of clocks, a
+// single one or whole iterations of an idle loop. step runs single
+// instructions, for the debugger and tracing. Returns true if a frame was
+// completed.
+bool
+machine_run_batch(idle_state_t *idle, uint32_t cycles, bool step)
+{
+	cpu6502_t *cpu = &machine->cpu;
+	uint32_t old_clockticks6502 = cpu->clockticks6502;
+	uint16_t old_pc = cpu->pc;
+	bool stepped = false;
+	bool new_frame;
+
+	// an IRQ that is pending while masked has to be taken right after the
+	// instruction that unmasks it, and -noidle waits in WAI clock by clock
+	step |= video_get_irq_out() || (cpu->waiting && !skip_idle);
+
+	if (skip_idle && idle->period && cpu->pc == idle->pc && !step) {
+		// spinning in a loop that only an IRQ can end: nothing can raise
+		// one before the next deadline, so jump whole iterations up to it
+		uint32_t deadline = machine_cycles_to_deadline();
+		uint32_t iterations = (cycles < deadline ? cycles : deadline) / idle->period;
+		idleskip6502(iterations);
+		loop_skipped_clocks += iterations * idle->period;
+		new_frame = machine_run(0);
+		idle->period = 0;
+		idle->probe = IDLE_PROBE; // see whether it is still spinning
+		idle->branches = 0;
+	} else if (step || idle->probe) {
+		new_frame = machine_run(1);
+		stepped = true;
+	} else {
+		// run up to the next deadline, or for the clocks given; a WAI just
+		// moves the clock there
+		bool waiting = cpu->waiting;
+		new_frame = machine_run(cycles);
+		if (waiting) {
+			wai_skipped_clocks += cpu->clockticks6502 - old_clockticks6502;
+		}
+		if (skip_idle && !idle->wait) {
+			// single step a few instructions to look for an idle loop
+			idle->probe = IDLE_PROBE;
+			idle->branches = 0;
+		} else if (idle->wait) {
+			idle->wait--;
+		}
+	}
+
+	if (stepped && idle->probe) {
+		idle->probe--;
+		idle->pc = cpu->pc;
+		idle->period = 0;
+		if (cpu->pc <= old_pc && !cpu->waiting) {
+			idle->period = idleloop6502(old_pc);
+			idle->branches++;
+		}
+		if (idle->period) {
+			idle->probe = 0;
+			idle->backoff = 0;
+			idle->wait = 0;
+		} else if (!idle->probe || idle->branches == 2) {
+			// two backward branches are enough to verify a loop; look
+			// less often while there is none
+			idle->probe = 0;
+			idle->backoff = idle->backoff ? idle->backoff * 2 : 1;
+			if (idle->backoff > IDLE_BACKOFF_MAX) {
+				idle->backoff = IDLE_BACKOFF_MAX;
+			}
+			idle->wait = idle->backoff;
+		}
+	}
+
+	return new_frame;
+}
+
+void
+machine_reset()
+{
+	vera_spi_init();
+	via1_init();
+	via2_init();
+	video_reset();
+	reset6502();
+}
+
+// The machine's random numbers (for what isn't emulated yet) come from its
+// own xorshift generator, so they are part of its state.
+uint32_t
+machine_random()
+{
+	uint32_t x = machine->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	machine->random = x;
+	return x;
+}
+
+// A saved state is the machine struct as it is in memory, followed by the
+// RAM, so loading one is little more than reading it. That only works with
+// a build that lays the struct out the same way. The header carries a hash
+// of the layout, so a file from a build that moved fields around is
+// rejected even when the size didn't change. STATE_VERSION is for changes
+// the layout doesn't show, like a field that now means something else.
+#define STATE_MAGIC "X16STATE"
+#define STATE_VERSION 3
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t layout;
+	uint32_t machine_size;
+	uint32_t ram_size;
+} state_header_t;
+
+// What a state file depends on besides the RAM: its version and the layout
+// of the machine struct, down to the fields of the parts that change most.
+const void *
+machine_state_layout(size_t *size)
+{
+	static const uint32_t layout[] = {
+		STATE_VERSION, sizeof(machine_t),
+		offsetof(machine_t, memory), offsetof(machine_t, video), offsetof(machine_t, psg),
+		offsetof(machine_t, pcm), offsetof(machine_t, via), offsetof(machine_t, sdcard),
+		offsetof(machine_t, vera_spi), offsetof(machine_t, ps2), offsetof(machine_t, joystick),
+		offsetof(machine_t, ym), offsetof(machine_t, audio), offsetof(machine_t, device_clock),
+		offsetof(machine_t, random),
+		offsetof(cpu6502_t, pc), offsetof(cpu6502_t, status), offsetof(cpu6502_t, clockticks6502),
+		offsetof(cpu6502_t, waiting), offsetof(cpu6502_t, blockcache),
+		offsetof(memory_state_t, ram_bank), offsetof(memory_state_t, rom_bank),
+		offsetof(video_state_t, palette), offsetof(video_state_t, io_addr),
+		offsetof(video_state_t, scan_pos_x), offsetof(video_state_t, scan_pos_y),
+	};
+	*size = sizeof(layout);
+	return layout;
+}
+
+// FNV-1a of machine_state_layout()
+static uint32_t
+state_layout_hash()
+{
+	size_t size;
+	const uint8_t *p = machine_state_layout(&size);
+	uint32_t hash = 0x811c9dc5;
+	while (size--) {
+		hash = (hash ^ *p++) * 0x01000193;
+	}
+	return hash;
+}
+
+bool
+machine_write_state(SDL_RWops *f)
+{
+	state_header_t header;
+	memcpy(header.magic, STATE_MAGIC, sizeof(header.magic));
+	header.version = STATE_VERSION;
+	header.layout = state_layout_hash();
+	header.machine_size = sizeof(machine_t);
+	header.ram_size = RAM_SIZE;
+
+	return SDL_RWwrite(f, &header, sizeof(header), 1) == 1 &&
+		SDL_RWwrite(f, machine, sizeof(machine_t), 1) == 1 &&
+		SDL_RWwrite(f, machine->memory.RAM, RAM_SIZE, 1) == 1;
+}
+
+bool
+machine_save_state(const char *path)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "wb");
+	if (!f) {
+		return false;
+	}
+	bool ok = machine_write_state(f);
+	SDL_RWclose(f);
+	return ok;
+}
+
+// what belongs to a machine on the host rather than to its state
+typedef struct {
+	uint8_t *RAM;
+	uint8_t *code_watched;
+	uint32_t *code_generation;
+	uint8_t *ram_written;
+	cpu6502_t cpu;
+} host_fields_t;
+
+static void
+get_host_fields(host_fields_t *h, const machine_t *m)
+{
+	h->RAM = m->memory.RAM;
+	h->code_watched = m->memory.code_watched;
+	h->code_generation = m->memory.code_generation;
+	h->ram_written = m->memory.ram_written;
+	h->cpu = m->cpu;
+}
+
+static void
+set_host_fields(machine_t *m, const host_fields_t *h)
+{
+	m->memory.RAM = h->RAM;
+	m->memory.code_watched = h->code_watched;
+	m->memory.code_generation = h->code_generation;
+	m->memory.ram_written = h->ram_written;
+	m->cpu.callexternal = h->cpu.callexternal;
+	m->cpu.loopexternal = h->cpu.loopexternal;
+	m->cpu.blockcache = h->cpu.blockcache;
+	m->cpu.jitbuffer = h->cpu.jitbuffer;
+	m->cpu.jitptr = h->cpu.jitptr;
+	m->cpu.jitfailed = h->cpu.jitfailed;
+	m->cpu.idleloop = h->cpu.idleloop;
+}
+
+// Copies the state of another machine, and its RAM, into the current one.
+// What belongs to the current machine on the host is kept; the rest is
+// fixed up and the state derived from the code is dropped.
+void
+machine_restore(const machine_t *saved, const uint8_t *ram)
+{
+	machine_t *m = machine;
+	host_fields_t host;
+	get_host_fields(&host, m);
+
+	*m = *saved;
+	set_host_fields(m, &host);
+	memcpy(m->memory.RAM, ram, RAM_SIZE);
+
+	free6502(&m->cpu);
+	memory_restore();
+	YM_relocate();
+}
+
+// Copies a machine except for its ROM, which doesn't change, and its
+// framebuffer, which is output. The ROM comes before the framebuffer.
+static void
+copy_machine(machine_t *to, const machine_t *from)
+{
+	size_t rom = offsetof(machine_t, memory.ROM);
+	size_t rom_end = rom + sizeof(from->memory.ROM);
+	size_t fb = offsetof(machine_t, video.framebuffer);
+	size_t fb_end = fb + sizeof(from->video.framebuffer);
+
+	memcpy(to, from, rom);
+	memcpy((uint8_t *)to + rom_end, (const uint8_t *)from + rom_end, fb - rom_end);
+	memcpy((uint8_t *)to + fb_end, (const uint8_t *)from + fb_end, sizeof(machine_t) - fb_end);
+}
+
+// Saves the current machine in memory, for machine_rollback(). ram has to
+// hold RAM_SIZE bytes.
+void
+machine_snapshot(machine_t *to, uint8_t *ram)
+{
+	copy_machine(to, machine);
+	memcpy(ram, machine->memory.RAM, RAM_SIZE);
+}
+
+// Puts the current machine back the way machine_snapshot() saved it. Unlike
+// machine_restore(), this keeps the code decoded from RAM that is the same
+// in both, so going back and forth between states many times a second stays
+// cheap. The framebuffer keeps what was rendered last.
+void
+machine_rollback(const machine_t *saved, const uint8_t *ram)
+{
+	machine_t *m = machine;
+	host_fields_t host;
+	get_host_fields(&host, m);
+	uint32_t code_epoch = m->memory.code_epoch;
+
+	copy_machine(m, saved);
+	set_host_fields(m, &host);
+	m->memory.code_epoch = code_epoch;
+
+	// the loop the idle loop detector looked at last may not be there any more
+	free(m->cpu.idleloop);
+	m->cpu.idleloop = NULL;
+
+	memory_rollback(ram);
+}
+
+// Replaces the state of the current machine. On failure, the machine is
+// left as it was.
+bool
+machine_read_state(SDL_RWops *f)
+{
+	state_header_t header;
+	machine_t *saved = malloc(sizeof(machine_t));
+	uint8_t *ram = malloc(RAM_SIZE);
+	bool ok = saved && ram &&
+		SDL_RWread(f, &header, sizeof(header), 1) == 1 &&
+		!memcmp(header.magic, STATE_MAGIC, sizeof(header.magic)) &&
+		header.version == STATE_VERSION &&
+		header.layout == state_layout_hash() &&
+		header.machine_size == sizeof(machine_t) &&
+		header.ram_size == RAM_SIZE &&
+		SDL_RWread(f, saved, sizeof(machine_t), 1) == 1 &&
+		SDL_RWread(f, ram, RAM_SIZE, 1) == 1;
+
+	if (ok) {
+		machine_restore(saved, ram);
+	}
+	free(ram);
+	free(saved);
+	return ok;
+}
+
+bool
+machine_load_state(const char *path)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "rb");
+	if (!f) {
+		return false;
+	}
+	bool ok = machine_read_state(f);
+	SDL_RWclose(f);
+	return ok;
+}
@@ -0,0 +1,99 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include "cpu/fake6502.h"
+#include "memory.h"
+#include "video.h"
+#include "vera_psg.h"
+#include "vera_pcm.h"
+#include "via.h"
+#include "sdcard.h"
+#include "vera_spi.h"
+#include "ps2.h"
+#include "joystick.h"
+#include "ym2151.h"
+#include "audio.h"
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// the devices that run on the CPU clock; each one catches up on its own
+typedef enum {
+	DEVICE_VIDEO,
+	DEVICE_AUDIO,
+	DEVICE_PS2,
+	DEVICE_SPI,
+	DEVICE_JOYSTICK,
+	NUM_DEVICES
+} device_t;
+
+// Everything that makes up one emulated computer. Host state (window, audio
+// device, debugger, options) is not part of it and stays global.
+typedef struct machine {
+	cpu6502_t cpu;
+	memory_state_t memory;
+	video_state_t video;
+	psg_state_t psg;
+	pcm_state_t pcm;
+	via_state_t via;
+	sdcard_state_t sdcard;
+	vera_spi_state_t vera_spi;
+	ps2_state_t ps2;
+	joystick_state_t joystick;
+	YM2151Chip ym;
+	audio_state_t audio;
+
+	// device scheduler: the clockticks6502 every device has been run up to,
+	// when it next acts on its own, and the earliest of those
+	uint32_t device_clock[NUM_DEVICES];
+	uint32_t event_clock[NUM_DEVICES];
+	uint32_t next_event;
+	bool frame_done; // a frame was completed since machine_run() returned
+
+	uint32_t random; // state of machine_random()
+} machine_t;
+
+// looking for idle loops between batches of instructions
+typedef struct {
+	uint16_t pc;
+	uint32_t period; // cycles per iteration of the idle loop at pc
+	uint32_t probe; // instructions left to single step looking for one
+	uint32_t branches; // backward branches seen while doing so
+	uint32_t wait; // batches to run before looking again
+	uint32_t backoff; // what wait starts from after a miss
+} idle_state_t;
+
+// The machine the emulator code on this thread works on. Every thread can
+// run a machine of its own.
+extern THREAD_LOCAL machine_t *machine;
+extern bool skip_idle;
+extern THREAD_LOCAL uint32_t wai_skipped_clocks;
+extern THREAD_LOCAL uint32_t loop_skipped_clocks;
+
+machine_t *machine_create();
+void machine_destroy(machine_t *m);
+void machine_select(machine_t *m);
+void machine_schedule(device_t d);
+uint32_t machine_cycles_to_deadline(void);
+void machine_sync_device(device_t d);
+void machine_sync(void);
+bool machine_run(uint32_t cycles);
+bool machine_run_batch(idle_state_t *idle, uint32_t cycles, bool step);
+uint32_t machine_random(void);
+void machine_restore(const machine_t *saved, const uint8_t *ram);
+void machine_snapshot(machine_t *to, uint8_t *ram);
+void machine_rollback(const machine_t *saved, const uint8_t *ram);
+const void *machine_state_layout(size_t *size);
+bool machine_write_state(SDL_RWops *f);
+bool machine_read_state(SDL_RWops *f);
+bool machine_save_state(const char *path);
+bool machine_load_state(const char *path);
+
+#endif
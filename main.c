@@ -16,24 +16,24 @@
 #ifdef __MINGW32__
 #include <ctype.h>
 #endif
-#include "cpu/fake6502.h"
+#include "machine.h"
 #include "disasm.h"
-#include "memory.h"
-#include "video.h"
-#include "via.h"
-#include "ps2.h"
 #include "spi.h"
-#include "vera_spi.h"
-#include "sdcard.h"
 #include "loadsave.h"
 #include "glue.h"
 #include "debugger.h"
-#include "utf8.h"
 #include "joystick.h"
+#include "keyboard.h"
 #include "utf8_encode.h"
 #include "rom_symbols.h"
 #include "ym2151.h"
 #include "audio.h"
+#include "rewind.h"
+#include "replay.h"
+#include "runahead.h"
+#include "lockstep.h"
+#include "forkserver.h"
+#include "control.h"
 #include "version.h"
 
 #ifdef __EMSCRIPTEN__
@@ -43,6 +43,7 @@
 
 void *emulator_loop(void *param);
 void emscripten_main_loop(void);
+static int emulator_thread(void *param);
 
 // This must match the KERNAL's set!
 char *keymaps[] = {
@@ -79,6 +80,9 @@ bool dump_ram = true;
 bool dump_bank = true;
 bool dump_vram = false;
 bool warp_mode = false;
+int warp_render_ratio = 64; // render 1 in this many frames in warp mode, none if 0
+int warp_present_fps = 60;  // most frames shown per second in warp mode, all if 0
+bool headless = false;
 echo_mode_t echo_mode;
 bool save_on_exit = true;
 gif_recorder_state_t record_gif = RECORD_GIF_DISABLED;
@@ -87,10 +91,14 @@ uint8_t keymap = 0; // KERNAL's default
 int window_scale = 1;
 char *scale_quality = "best";
 
+bool pace_audio = false;
+
 int frames;
-int32_t sdlTicks_base;
-int32_t last_perf_update;
-int32_t perf_frame_count;
+uint64_t timing_base;        // performance counter at timing_init()
+uint64_t timing_clocks;      // CPU clocks run since then
+uint32_t timing_last_clock;  // clockticks6502 at the last frame
+int64_t last_perf_update;    // in microseconds
+uint64_t perf_clocks;
 char window_title[30];
 
 #ifdef TRACE
@@ -99,6 +107,11 @@ uint16_t trace_address = 0;
 #endif
 
 int instruction_counter;
+char boot_cache_path[PATH_MAX]; // snapshot to save at the first prompt, if not empty
+// what the KERNAL printed while booting, printed again by the runs that
+// resume from the snapshot
+static uint8_t boot_echo[4096];
+static size_t boot_echo_size;
 SDL_RWops *prg_file ;
 int prg_override_start = -1;
 bool run_after_load = false;
@@ -195,12 +208,12 @@ machine_dump()
 	}
 
 	if (dump_cpu) {
-		SDL_RWwrite(f, &a, sizeof(uint8_t), 1);
-		SDL_RWwrite(f, &x, sizeof(uint8_t), 1);
-		SDL_RWwrite(f, &y, sizeof(uint8_t), 1);
-		SDL_RWwrite(f, &sp, sizeof(uint8_t), 1);
-		SDL_RWwrite(f, &status, sizeof(uint8_t), 1);
-		SDL_RWwrite(f, &pc, sizeof(uint16_t), 1);
+		SDL_RWwrite(f, &machine->cpu.a, sizeof(uint8_t), 1);
+		SDL_RWwrite(f, &machine->cpu.x, sizeof(uint8_t), 1);
+		SDL_RWwrite(f, &machine->cpu.y, sizeof(uint8_t), 1);
+		SDL_RWwrite(f, &machine->cpu.sp, sizeof(uint8_t), 1);
+		SDL_RWwrite(f, &machine->cpu.status, sizeof(uint8_t), 1);
+		SDL_RWwrite(f, &machine->cpu.pc, sizeof(uint16_t), 1);
 	}
 	memory_save(f, dump_ram, dump_bank);
 
@@ -212,16 +225,6 @@ machine_dump()
 	printf("Dumped system to %s.\n", filename);
 }
 
-void
-machine_reset()
-{
-	vera_spi_init();
-	via1_init();
-	via2_init();
-	video_reset();
-	reset6502();
-}
-
 void
 machine_paste(char *s)
 {
@@ -234,24 +237,49 @@ machine_paste(char *s)
 void
 timing_init() {
 	frames = 0;
-	sdlTicks_base = SDL_GetTicks();
+	timing_base = SDL_GetPerformanceCounter();
+	timing_clocks = 0;
+	timing_last_clock = machine->cpu.clockticks6502;
 	last_perf_update = 0;
-	perf_frame_count = 0;
+	perf_clocks = 0;
+}
+
+// microseconds since timing_init()
+static int64_t
+timing_usec()
+{
+	uint64_t ticks = SDL_GetPerformanceCounter() - timing_base;
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	return ticks / freq * 1000000 + ticks % freq * 1000000 / freq;
 }
 
 void
 timing_update()
 {
 	frames++;
-	int32_t sdlTicks = SDL_GetTicks() - sdlTicks_base;
-	int32_t diff_time = 1000 * frames / 60 - sdlTicks;
-	if (!warp_mode && diff_time > 0) {
-		usleep(1000 * diff_time);
+
+	// emulated time follows the CPU clock, so a VGA frame takes 1/59.94 s
+	uint32_t frame_clocks = machine->cpu.clockticks6502 - timing_last_clock;
+	timing_last_clock += frame_clocks;
+	timing_clocks += frame_clocks;
+
+	int64_t usec = timing_usec();
+	int64_t ahead; // microseconds the emulation is ahead of the host
+	if (pace_audio) {
+		// the sound device plays at its own clock; keep its queue half
+		// full, so it neither runs dry nor builds up latency
+		ahead = audio_ahead_usec();
+	} else {
+		ahead = (int64_t)(timing_clocks / MHZ) - usec;
+	}
+	if (!warp_mode && ahead > 0) {
+		usleep(ahead);
 	}
 
-	if (sdlTicks - last_perf_update > 5000) {
-		int32_t frameCount = frames - perf_frame_count;
-		int perf = frameCount / 3;
+	if (usec - last_perf_update > 5000000) {
+		uint64_t emulated = (timing_clocks - perf_clocks) / MHZ;
+		int64_t elapsed = usec - last_perf_update;
+		int perf = (int)((emulated * 100 + elapsed / 2) / elapsed);
 
 		if (perf < 100 || warp_mode) {
 			sprintf(window_title, "Commander X16 (%d%%)", perf);
@@ -260,12 +288,17 @@ timing_update()
 			video_update_title("Commander X16");
 		}
 
-		perf_frame_count = frames;
-		last_perf_update = sdlTicks;
+		if (log_speed) {
+			rewind_log_stats(elapsed);
+			runahead_log_stats();
+		}
+
+		perf_clocks = timing_clocks;
+		last_perf_update = usec;
 	}
 
 	if (log_speed) {
-		float frames_behind = -((float)diff_time / 16.666666);
+		float frames_behind = frame_clocks ? -((float)ahead * MHZ / frame_clocks) : 0;
 		int load = (int)((1 + frames_behind) * 100);
 		printf("Load: %d%%\n", load > 100 ? 100 : load);
 
@@ -273,6 +306,12 @@ timing_update()
 			printf("Rendering is behind %d frames.\n", -(int)frames_behind);
 		} else {
 		}
+
+		if (wai_skipped_clocks || loop_skipped_clocks) {
+			printf("Skipped: %u cycles in WAI, %u in idle loops.\n", wai_skipped_clocks, loop_skipped_clocks);
+			wai_skipped_clocks = 0;
+			loop_skipped_clocks = 0;
+		}
 	}
 }
 
@@ -283,56 +322,6 @@ machine_toggle_warp()
 	timing_init();
 }
 
-uint8_t
-iso8859_15_from_unicode(uint32_t c)
-{
-	// line feed -> carriage return
-	if (c == '\n') {
-		return '\r';
-	}
-
-	// translate Unicode characters not part of Latin-1 but part of Latin-15
-	switch (c) {
-		case 0x20ac: // '€'
-			return 0xa4;
-		case 0x160: // 'Š'
-			return 0xa6;
-		case 0x161: // 'š'
-			return 0xa8;
-		case 0x17d: // 'Ž'
-			return 0xb4;
-		case 0x17e: // 'ž'
-			return 0xb8;
-		case 0x152: // 'Œ'
-			return 0xbc;
-		case 0x153: // 'œ'
-			return 0xbd;
-		case 0x178: // 'Ÿ'
-			return 0xbe;
-	}
-
-	// remove Unicode characters part of Latin-1 but not part of Latin-15
-	switch (c) {
-		case 0xa4: // '¤'
-		case 0xa6: // '¦'
-		case 0xa8: // '¨'
-		case 0xb4: // '´'
-		case 0xb8: // '¸'
-		case 0xbc: // '¼'
-		case 0xbd: // '½'
-		case 0xbe: // '¾'
-			return '?';
-	}
-
-	// all other Unicode characters are also unsupported
-	if (c >= 256) {
-		return '?';
-	}
-
-	// everything else is Latin-15 already
-	return c;
-}
-
 uint32_t
 unicode_from_iso8859_15(uint8_t c)
 {
@@ -377,6 +366,301 @@ is_kernal()
 			read6502(0xfff9) == 'T';
 }
 
+//
+// traps: host-side hooks on addresses the CPU is about to execute
+//
+
+static bool exit_requested = false;
+
+// the program jumped to $FFFF to quit the emulator
+static void
+trap_exit()
+{
+	fork_server_exit(machine->cpu.lastpc);
+	if (save_on_exit) {
+		machine_dump();
+	}
+	exit_requested = true;
+}
+
+static void
+echo_char(uint8_t c)
+{
+	if (echo_mode == ECHO_MODE_COOKED) {
+		if (c == 0x0d) {
+			printf("\n");
+		} else if (c == 0x0a) {
+			// skip
+		} else if (c < 0x20 || c >= 0x80) {
+			printf("\\X%02X", c);
+		} else {
+			printf("%c", c);
+		}
+	} else if (echo_mode == ECHO_MODE_ISO) {
+		if (c == 0x0d) {
+			printf("\n");
+		} else if (c == 0x0a) {
+			// skip
+		} else if (c < 0x20 || (c >= 0x80 && c < 0xa0)) {
+			printf("\\X%02X", c);
+		} else {
+			print_iso8859_15_char(c);
+		}
+	} else {
+		printf("%c", c);
+	}
+}
+
+// KERNAL CHROUT: echo the character to stdout
+static void
+trap_chrout()
+{
+	if ((echo_mode == ECHO_MODE_NONE && !boot_cache_path[0]) || !is_kernal()) {
+		return;
+	}
+	uint8_t c = machine->cpu.a;
+	// the snapshot keeps the boot output whether it is echoed now or not
+	if (boot_cache_path[0] && boot_echo_size < sizeof(boot_echo)) {
+		boot_echo[boot_echo_size++] = c;
+	}
+	if (echo_mode != ECHO_MODE_NONE) {
+		echo_char(c);
+		fflush(stdout);
+	}
+}
+
+//
+// boot snapshot: the machine at the first BASIC prompt, for runs that would
+// boot the same way
+//
+
+static uint64_t
+fnv1a(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+	while (size--) {
+		hash = (hash ^ *p++) * 0x100000001b3;
+	}
+	return hash;
+}
+
+// The name of the snapshot depends on the emulator that saved it, its
+// release and state layout, and on everything the KERNAL looks at while it
+// boots: the ROM, the amount of banked RAM and the keymap.
+static void
+boot_cache_name(const char *dir)
+{
+	size_t layout_size;
+	const void *layout = machine_state_layout(&layout_size);
+
+	uint64_t hash = 0xcbf29ce484222325;
+	hash = fnv1a(hash, VER, sizeof(VER));
+	hash = fnv1a(hash, layout, layout_size);
+	hash = fnv1a(hash, machine->memory.ROM, ROM_SIZE);
+	hash = fnv1a(hash, &num_ram_banks, sizeof(num_ram_banks));
+	hash = fnv1a(hash, &keymap, sizeof(keymap));
+	snprintf(boot_cache_path, sizeof(boot_cache_path), "%s/boot-%016llx.x16state", dir, (unsigned long long)hash);
+}
+
+// Several emulators can boot at the same time; none of them may see a
+// half-written snapshot. The boot output goes next to it, first, so that a
+// snapshot is never found without it.
+static void
+boot_cache_save()
+{
+	char echo_path[PATH_MAX + 8];
+	char temp_path[PATH_MAX + 24];
+	snprintf(echo_path, sizeof(echo_path), "%s.echo", boot_cache_path);
+	snprintf(temp_path, sizeof(temp_path), "%s.%d", echo_path, (int)getpid());
+	SDL_RWops *f = SDL_RWFromFile(temp_path, "wb");
+	bool ok = f && SDL_RWwrite(f, boot_echo, 1, boot_echo_size) == boot_echo_size;
+	if (f) {
+		SDL_RWclose(f);
+	}
+	if (!ok || rename(temp_path, echo_path)) {
+		printf("Cannot save the boot output to %s!\n", echo_path);
+		remove(temp_path);
+		return;
+	}
+
+	snprintf(temp_path, sizeof(temp_path), "%s.%d", boot_cache_path, (int)getpid());
+	if (!machine_save_state(temp_path) || rename(temp_path, boot_cache_path)) {
+		printf("Cannot save the boot snapshot to %s!\n", boot_cache_path);
+		remove(temp_path);
+	}
+}
+
+// prints the boot output of the snapshot the machine resumed from
+static void
+boot_cache_echo()
+{
+	char echo_path[PATH_MAX + 8];
+	snprintf(echo_path, sizeof(echo_path), "%s.echo", boot_cache_path);
+	SDL_RWops *f = SDL_RWFromFile(echo_path, "rb");
+	if (!f) {
+		return;
+	}
+	boot_echo_size = SDL_RWread(f, boot_echo, 1, sizeof(boot_echo));
+	SDL_RWclose(f);
+	for (size_t i = 0; i < boot_echo_size; i++) {
+		echo_char(boot_echo[i]);
+	}
+	fflush(stdout);
+}
+
+// reads a BASIC program in ASCII to be pasted once BASIC is ready
+static bool
+load_bas(const char *path)
+{
+	SDL_RWops *bas_file = SDL_RWFromFile(path, "r");
+	if (!bas_file) {
+		return false;
+	}
+	paste_text = paste_text_data;
+	size_t paste_size = SDL_RWread(bas_file, paste_text, 1, sizeof(paste_text_data) - 1);
+	if (run_after_load) {
+		strncpy(paste_text + paste_size, "\rRUN\r", sizeof(paste_text_data) - paste_size);
+	} else {
+		paste_text[paste_size] = 0;
+	}
+	SDL_RWclose(bas_file);
+	return true;
+}
+
+// KERNAL BASIN
+static void
+trap_basin()
+{
+	if (!is_kernal()) {
+		return;
+	}
+	// as soon as BASIC starts reading a line...
+	if (boot_cache_path[0]) {
+		// ...keep the booted machine for the next run, before anything is injected
+		boot_cache_save();
+		boot_cache_path[0] = 0;
+	}
+	if (fork_server_active()) {
+		// ...run the tests, each in a copy of the booted machine
+		fork_request_t request;
+		if (!fork_server_run(&request)) {
+			// the batch is done
+			exit_requested = true;
+			return;
+		}
+		// the tests share the directory and report their end themselves
+		save_on_exit = false;
+		run_after_load = true;
+		if (request.bas) {
+			if (!load_bas(request.path)) {
+				printf("Cannot open %s!\n", request.path);
+				exit(1);
+			}
+		} else {
+			prg_file = SDL_RWFromFile(request.path, "rb");
+			if (!prg_file) {
+				printf("Cannot open %s!\n", request.path);
+				exit(1);
+			}
+			prg_override_start = request.start;
+		}
+		timing_init();
+	}
+	if (prg_file) {
+		// ...inject the app into RAM
+		uint16_t start, end;
+		bool loaded = load_prg(prg_file, prg_override_start, &start, &end);
+		prg_file = NULL;
+		if (!loaded) {
+			printf("Cannot load the program!\n");
+			exit(1);
+		}
+		runahead_invalidate();
+		lockstep_invalidate();
+
+		if (run_after_load) {
+			if (start == 0x0801) {
+				paste_text = "RUN\r";
+			} else {
+				paste_text = paste_text_data;
+				snprintf(paste_text, sizeof(paste_text_data), "SYS$%04X\r", start);
+			}
+		}
+	}
+
+	if (paste_text) {
+		// ...paste BASIC code into the keyboard buffer
+		pasting_bas = true;
+	}
+}
+
+#ifdef LOAD_HYPERCALLS
+// KERNAL LOAD and SAVE on device 8 go to the host filesystem unless there is an SD card
+static bool
+hypercall_allowed()
+{
+	return is_kernal() && machine->memory.RAM[FA] == 8 && !sdcard_file;
+}
+
+// returns from the KERNAL call to the caller
+static void
+hypercall_return()
+{
+	cpu6502_t *cpu = &machine->cpu;
+	uint8_t *RAM = machine->memory.RAM;
+	cpu->pc = (RAM[0x100 + cpu->sp + 1] | (RAM[0x100 + cpu->sp + 2] << 8)) + 1;
+	cpu->sp += 2;
+}
+
+static void
+trap_load()
+{
+	if (hypercall_allowed()) {
+		LOAD();
+		hypercall_return();
+		runahead_invalidate();
+		lockstep_invalidate();
+	}
+}
+
+static void
+trap_save()
+{
+	if (hypercall_allowed()) {
+		SAVE();
+		hypercall_return();
+		runahead_invalidate();
+		lockstep_invalidate();
+	}
+}
+#endif
+
+#ifdef TRACE
+static void
+trap_trace()
+{
+	trace_mode = true;
+}
+#endif
+
+static void
+traps_init()
+{
+	// the jump table is in every ROM bank, the handlers check for the KERNAL
+	memory_add_trap(0xffff, MEMORY_ALL_BANKS, trap_exit);
+	memory_add_trap(0xffd2, MEMORY_ALL_BANKS, trap_chrout);
+	memory_add_trap(0xffcf, MEMORY_ALL_BANKS, trap_basin);
+#ifdef LOAD_HYPERCALLS
+	memory_add_trap(0xffd5, MEMORY_ALL_BANKS, trap_load);
+	memory_add_trap(0xffd8, MEMORY_ALL_BANKS, trap_save);
+#endif
+#ifdef TRACE
+	if (trace_address != 0) {
+		memory_add_trap(trace_address, MEMORY_ALL_BANKS, trap_trace);
+	}
+#endif
+}
+
 static void
 usage()
 {
@@ -393,6 +677,42 @@ usage()
 	printf("\tEnable a specific keyboard layout decode table.\n");
 	printf("-sdcard <sdcard.img>\n");
 	printf("\tSpecify SD card image (partition map + FAT32)\n");
+	printf("-loadstate <file>\n");
+	printf("\tStart from a saved machine state instead of booting.\n");
+	printf("-savestate <file>\n");
+	printf("\tSave the machine state when the emulator quits.\n");
+	printf("-record <file>\n");
+	printf("\tRecord the input to the machine, with the state it starts in.\n");
+	printf("-replay <file>\n");
+	printf("\tRun a recording, instead of the input from the host,\n");
+	printf("\tand quit at its end.\n");
+	printf("-rewind <seconds>\n");
+	printf("\tKeep the last seconds of the machine's state, to go back\n");
+	printf("\tin time while Ctrl+Backspace is held.\n");
+	printf("-runahead <frames>\n");
+	printf("\tShow the frame this many frames ahead of the machine, to\n");
+	printf("\thide the time input takes to get through to the program.\n");
+	printf("-fork-server <socket>\n");
+	printf("\tBoot once, then run a PRG or BAS file for every request on\n");
+	printf("\tthis Unix socket in a copy of the booted machine\n");
+	printf("\t(implies -headless).\n");
+	printf("-batch <directory>\n");
+	printf("\tBoot once, then run every .prg and .bas file in the directory\n");
+	printf("\tin a copy of the booted machine and write a report of how\n");
+	printf("\tthey ended (implies -headless, -warp and -echo).\n");
+	printf("-jobs <n>\n");
+	printf("\tRun this many tests of -batch at the same time\n");
+	printf("\t(default: one per CPU).\n");
+	printf("-maxframes <n>\n");
+	printf("\tStop tests of -batch and -fork-server after n frames\n");
+	printf("\t(default for -batch: 3600, one minute; 0 for no limit).\n");
+	printf("-report <file>\n");
+	printf("\tWrite the -batch report to a file instead of stdout, as CSV\n");
+	printf("\tif the name ends in .csv, otherwise as JSON.\n");
+	printf("-bootcache <directory>\n");
+	printf("\tStart from a snapshot of the machine at the BASIC prompt\n");
+	printf("\tin this directory instead of booting. If there is none for\n");
+	printf("\tthe ROM, -ram and -keymap, boot and save it.\n");
 	printf("-prg <app.prg>[,<load_addr>]\n");
 	printf("\tLoad application from the local disk into RAM\n");
 	printf("\t(.PRG file with 2 byte start address header)\n");
@@ -407,6 +727,31 @@ usage()
 	printf("\tLaunch GEOS at startup.\n");
 	printf("-warp\n");
 	printf("\tEnable warp mode, run emulator as fast as possible.\n");
+	printf("-warprender <n>\n");
+	printf("\tIn warp mode, render only 1 in n frames (default: 64).\n");
+	printf("\t0 renders nothing but the sprites, for their collision IRQ.\n");
+	printf("-warpfps <n>\n");
+	printf("\tIn warp mode, show at most n frames per second\n");
+	printf("\t(default: 60, 0 for no limit).\n");
+	printf("-headless\n");
+	printf("\tRun without a window or sound device. Output only goes to\n");
+	printf("\tfiles (-gif, -dump) and stdout (-echo).\n");
+	printf("-noidle\n");
+	printf("\tDon't fast-forward while the CPU waits in WAI or spins\n");
+	printf("\tin a polling loop.\n");
+	printf("-blockcache\n");
+	printf("\tExecute 6502 code from a cache of pre-decoded blocks.\n");
+	printf("-jit\n");
+	printf("\tTranslate hot blocks to native code (x86-64 only),\n");
+	printf("\timplies -blockcache.\n");
+	printf("-lockstep <frames>\n");
+	printf("\tRun every frame a second time on a reference machine without\n");
+	printf("\tthe fast paths, compare the two every n frames, and stop and\n");
+	printf("\tsave both at the first difference.\n");
+	printf("-control <socket>\n");
+	printf("\tLet a program on this Unix socket stop and run the machine,\n");
+	printf("\tread and write memory and registers, load PRGs, take\n");
+	printf("\tscreenshots and set breakpoints.\n");
 	printf("-echo [{iso|raw}]\n");
 	printf("\tPrint all KERNAL output to the host's stdout.\n");
 	printf("\tBy default, everything but printable ASCII characters get\n");
@@ -443,6 +788,9 @@ usage()
 	printf("\tSet the number of audio buffers used for playback. (default: 8)\n");
 	printf("\tIncreasing this will reduce stutter on slower computers,\n");
 	printf("\tbut will increase audio latency.\n");
+	printf("-pace {clock|audio}\n");
+	printf("\tRun in step with the host's clock (default) or with the\n");
+	printf("\tsound device, which keeps the audio latency low.\n");
 #ifdef TRACE
 	printf("-trace [<address>]\n");
 	printf("\tPrint instruction trace. Optionally, a trigger address\n");
@@ -474,6 +822,20 @@ main(int argc, char **argv)
 	char *prg_path = NULL;
 	char *bas_path = NULL;
 	char *sdcard_path = NULL;
+	char *loadstate_path = NULL;
+	char *savestate_path = NULL;
+	char *boot_cache_dir = NULL;
+	int rewind_seconds = 0;
+	int runahead_frames = 0;
+	int lockstep_interval = 0;
+	char *fork_server_path = NULL;
+	char *batch_dir = NULL;
+	char *control_path = NULL;
+	int batch_jobs = 0;
+	int max_frames = -1;
+	char *report_path = NULL;
+	char *record_path = NULL;
+	char *replay_path = NULL;
 	bool run_geos = false;
 	bool run_test = false;
 	int test_number = 0;
@@ -576,6 +938,129 @@ main(int argc, char **argv)
 			run_test = true;
 			argc--;
 			argv++;
+		} else if (!strcmp(argv[0], "-loadstate")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			loadstate_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-savestate")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			savestate_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-record")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			record_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-replay")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			replay_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-rewind")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			rewind_seconds = (int)strtol(argv[0], NULL, 10);
+			if (rewind_seconds < 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-runahead")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			runahead_frames = (int)strtol(argv[0], NULL, 10);
+			if (runahead_frames < 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-fork-server")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			fork_server_path = argv[0];
+			headless = true;
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-batch")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			batch_dir = argv[0];
+			headless = true;
+			warp_mode = true;
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-jobs")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			batch_jobs = (int)strtol(argv[0], NULL, 10);
+			if (batch_jobs < 1) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-maxframes")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			max_frames = (int)strtol(argv[0], NULL, 10);
+			if (max_frames < 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-report")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			report_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-bootcache")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			boot_cache_dir = argv[0];
+			argc--;
+			argv++;
 		} else if (!strcmp(argv[0], "-sdcard")) {
 			argc--;
 			argv++;
@@ -589,6 +1074,68 @@ main(int argc, char **argv)
 			argc--;
 			argv++;
 			warp_mode = true;
+		} else if (!strcmp(argv[0], "-warprender")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			warp_render_ratio = (int)strtol(argv[0], NULL, 10);
+			if (warp_render_ratio < 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-warpfps")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			warp_present_fps = (int)strtol(argv[0], NULL, 10);
+			if (warp_present_fps < 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-headless")) {
+			argc--;
+			argv++;
+			headless = true;
+		} else if (!strcmp(argv[0], "-noidle")) {
+			argc--;
+			argv++;
+			skip_idle = false;
+		} else if (!strcmp(argv[0], "-blockcache")) {
+			argc--;
+			argv++;
+			blockcache6502 = 1;
+		} else if (!strcmp(argv[0], "-jit")) {
+			argc--;
+			argv++;
+			blockcache6502 = 1;
+			jit6502 = 1;
+		} else if (!strcmp(argv[0], "-lockstep")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			lockstep_interval = (int)strtol(argv[0], NULL, 10);
+			if (lockstep_interval <= 0) {
+				usage();
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-control")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			control_path = argv[0];
+			argc--;
+			argv++;
 		} else if (!strcmp(argv[0], "-echo")) {
 			argc--;
 			argv++;
@@ -767,6 +1314,21 @@ main(int argc, char **argv)
 			audio_dev_name = argv[0];
 			argc--;
 			argv++;
+		} else if (!strcmp(argv[0], "-pace")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			if (!strcmp(argv[0], "audio")) {
+				pace_audio = true;
+			} else if (!strcmp(argv[0], "clock")) {
+				pace_audio = false;
+			} else {
+				usage();
+			}
+			argc--;
+			argv++;
 		} else if (!strcmp(argv[0], "-abufs")) {
 			argc--;
 			argv++;
@@ -786,12 +1348,57 @@ main(int argc, char **argv)
 		}
 	}
 
+	if (headless && debugger_enabled) {
+		printf("The debugger needs a window, it can't be used with -headless.\n");
+		exit(1);
+	}
+
+	// going back in time can't be recorded
+	if ((record_path && replay_path) || ((record_path || replay_path) && rewind_seconds)) {
+		printf("Only one of -record, -replay and -rewind can be used at a time.\n");
+		exit(1);
+	}
+
+	// every test brings its own program, and the children can't share files
+	if ((fork_server_path || batch_dir) && (prg_path || bas_path || sdcard_path || record_path || replay_path)) {
+		printf("-fork-server and -batch can't be used with -prg, -bas, -sdcard, -record or -replay.\n");
+		exit(1);
+	}
+	if (fork_server_path && batch_dir) {
+		printf("Only one of -fork-server and -batch can be used at a time.\n");
+		exit(1);
+	}
+	// the tests would all share the client
+	if (control_path && (fork_server_path || batch_dir)) {
+		printf("-control can't be used with -fork-server or -batch.\n");
+		exit(1);
+	}
+	if (batch_dir && echo_mode == ECHO_MODE_NONE) {
+		echo_mode = ECHO_MODE_COOKED;
+	}
+
+	// the frames run ahead would latch the controllers out of turn
+	if ((record_path || replay_path) && runahead_frames) {
+		printf("-runahead can't be used with -record or -replay.\n");
+		exit(1);
+	}
+	// the frames run ahead would latch the controllers for the reference
+	if (runahead_frames && lockstep_interval) {
+		printf("-runahead can't be used with -lockstep.\n");
+		exit(1);
+	}
+
+	if (!machine_create()) {
+		printf("Cannot create the machine!\n");
+		exit(1);
+	}
+
 	SDL_RWops *f = SDL_RWFromFile(rom_path, "rb");
 	if (!f) {
 		printf("Cannot open %s!\n", rom_path);
 		exit(1);
 	}
-	size_t rom_size = SDL_RWread(f, ROM, ROM_SIZE, 1);
+	size_t rom_size = SDL_RWread(f, machine->memory.ROM, ROM_SIZE, 1);
 	(void)rom_size;
 	SDL_RWclose(f);
 
@@ -819,20 +1426,9 @@ main(int argc, char **argv)
 		}
 	}
 
-	if (bas_path) {
-		SDL_RWops *bas_file = SDL_RWFromFile(bas_path, "r");
-		if (!bas_file) {
-			printf("Cannot open %s!\n", bas_path);
-			exit(1);
-		}
-		paste_text = paste_text_data;
-		size_t paste_size = SDL_RWread(bas_file, paste_text, 1, sizeof(paste_text_data) - 1);
-		if (run_after_load) {
-			strncpy(paste_text + paste_size, "\rRUN\r", sizeof(paste_text_data) - paste_size);
-		} else {
-			paste_text[paste_size] = 0;
-		}
-		SDL_RWclose(bas_file);
+	if (bas_path && !load_bas(bas_path)) {
+		printf("Cannot open %s!\n", bas_path);
+		exit(1);
 	}
 
 	if (run_geos) {
@@ -843,17 +1439,74 @@ main(int argc, char **argv)
 		snprintf(paste_text, sizeof(paste_text_data), "TEST %d\r", test_number);
 	}
 
-	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER | SDL_INIT_AUDIO);
-
-	audio_init(audio_dev_name, audio_buffers);
+	if (headless) {
+		// events only, for SDL_QUIT on Ctrl+C
+		SDL_Init(SDL_INIT_EVENTS);
+		// there is no sound device to follow
+		pace_audio = false;
+	} else {
+		SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER | SDL_INIT_AUDIO);
+		audio_init(audio_dev_name, audio_buffers);
+	}
 
-	memory_init();
 	video_init(window_scale, scale_quality);
 
 	joystick_init();
 
 	machine_reset();
 
+	if (loadstate_path && !machine_load_state(loadstate_path)) {
+		printf("Cannot load the machine state from %s!\n", loadstate_path);
+		exit(1);
+	}
+
+	// the KERNAL may read the SD card while booting
+	if (boot_cache_dir && !loadstate_path && !sdcard_path) {
+		boot_cache_name(boot_cache_dir);
+		if (machine_load_state(boot_cache_path)) {
+			if (echo_mode != ECHO_MODE_NONE) {
+				boot_cache_echo();
+			}
+			boot_cache_path[0] = 0;
+		}
+	}
+
+	if (record_path && !replay_record(record_path)) {
+		printf("Cannot record to %s!\n", record_path);
+		exit(1);
+	}
+	if (replay_path && !replay_open(replay_path)) {
+		printf("Cannot replay %s!\n", replay_path);
+		exit(1);
+	}
+
+	if (rewind_seconds && !rewind_init(rewind_seconds)) {
+		printf("Not enough memory to rewind %d seconds!\n", rewind_seconds);
+		exit(1);
+	}
+
+	if (runahead_frames && !runahead_init(runahead_frames)) {
+		printf("Not enough memory to run ahead!\n");
+		exit(1);
+	}
+
+	if (lockstep_interval && !lockstep_init(lockstep_interval)) {
+		printf("Cannot create the reference machine!\n");
+		exit(1);
+	}
+
+	if (fork_server_path && !fork_server_init(fork_server_path, max_frames > 0 ? max_frames : 0)) {
+		exit(1);
+	}
+	if (batch_dir && !fork_batch_init(batch_dir, batch_jobs, max_frames >= 0 ? max_frames : 3600, report_path)) {
+		exit(1);
+	}
+	if (control_path && !control_init(control_path)) {
+		exit(1);
+	}
+
+	traps_init();
+
 	timing_init();
 
 	instruction_counter = 0;
@@ -861,12 +1514,36 @@ main(int argc, char **argv)
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop(emscripten_main_loop, 0, 1);
 #else
-	emulator_loop(NULL);
+	if (video_threaded()) {
+		// the main thread owns the window, the machine runs on another one
+		SDL_Thread *thread = SDL_CreateThread(emulator_thread, "emulator", machine);
+		if (!thread) {
+			printf("Cannot create the emulator thread: %s\n", SDL_GetError());
+			exit(1);
+		}
+		video_present_loop();
+		SDL_WaitThread(thread, NULL);
+	} else {
+		emulator_loop(NULL);
+	}
 #endif
 
-	audio_close();
+	if (savestate_path && !machine_save_state(savestate_path)) {
+		printf("Cannot save the machine state to %s!\n", savestate_path);
+	}
+	fork_server_report();
+
+	replay_close();
+	rewind_close();
+	runahead_close();
+	lockstep_close();
+	control_close();
+	if (!headless) {
+		audio_close();
+	}
 	video_end();
 	SDL_Quit();
+	machine_destroy(machine);
 
 #ifdef PERFSTAT
 	for (int pc = 0xc000; pc < sizeof(stat)/sizeof(*stat); pc++) {
@@ -894,6 +1571,16 @@ main(int argc, char **argv)
 	}
 #endif
 
+	// -lockstep found a difference
+	return lockstep_diverged() ? 1 : 0;
+}
+
+static int
+emulator_thread(void *param)
+{
+	machine_select(param);
+	emulator_loop(NULL);
+	video_present_stop();
 	return 0;
 }
 
@@ -903,17 +1590,70 @@ emscripten_main_loop(void) {
 }
 
 
+// Runs a batch of instructions. Returns true if a frame was completed.
+static bool
+run_cpu(idle_state_t *idle)
+{
+	// the debugger and tracing look at every instruction
+	bool step = debugger_enabled;
+#ifdef TRACE
+	step |= trace_mode;
+#endif
+#ifdef PERFSTAT
+	step = true;
+#endif
+	step |= control_stepping();
+	if (pasting_bas) {
+		// don't skip ahead while the KERNAL could take the next characters
+		idle->period = 0;
+	}
+	return machine_run_batch(idle, UINT32_MAX, step);
+}
+
+// Runs the machine up to the end of the next frame, without traps or
+// pasting, for run-ahead.
+static void
+run_frame_ahead()
+{
+	idle_state_t idle = {0};
+	while (!run_cpu(&idle)) {
+	}
+}
+
 void*
 emulator_loop(void *param)
 {
+	cpu6502_t *cpu = &machine->cpu;
+	uint8_t *RAM = machine->memory.RAM;
+	idle_state_t idle = {0};
+
 	for (;;) {
 
 		if (debugger_enabled) {
 			int dbgCmd = DEBUGGetCurrentStatus();
-			if (dbgCmd > 0) continue;
+			if (dbgCmd > 0) {
+				idle.period = 0; // registers and memory may be edited
+				continue;
+			}
 			if (dbgCmd < 0) break;
 		}
 
+		if (memory_is_trap(cpu->pc)) {
+			memory_run_traps(cpu->pc);
+			if (exit_requested) {
+				break;
+			}
+		}
+
+		if (control_stopped()) {
+			// at a breakpoint, or the -control client stopped the machine
+			if (!control_serve()) {
+				break;
+			}
+			timing_init();
+			idle.period = 0; // registers and memory may be edited
+		}
+
 #ifdef PERFSTAT
 
 //		if (memory_get_rom_bank() == 3) {
@@ -922,23 +1662,20 @@ emulator_loop(void *param)
 		if (memory_get_rom_bank() == 3) {
 			static uint8_t old_sp;
 			static uint16_t base_pc;
-			if (sp < old_sp) {
-				base_pc = pc;
+			if (cpu->sp < old_sp) {
+				base_pc = cpu->pc;
 			}
-			old_sp = sp;
+			old_sp = cpu->sp;
 			stat[base_pc]++;
 		}
 #endif
 
 #ifdef TRACE
-		if (pc == trace_address && trace_address != 0) {
-			trace_mode = true;
-		}
 		if (trace_mode) {
 			//printf("\t\t\t\t");
 			printf("[%6d] ", instruction_counter);
 
-			char *label = label_for_address(pc);
+			char *label = label_for_address(cpu->pc);
 			int label_len = label ? strlen(label) : 0;
 			if (label) {
 				printf("%s", label);
@@ -946,11 +1683,11 @@ emulator_loop(void *param)
 			for (int i = 0; i < 20 - label_len; i++) {
 				printf(" ");
 			}
-			printf(" %02x:.,%04x ", memory_get_rom_bank(), pc);
+			printf(" %02x:.,%04x ", memory_get_rom_bank(), cpu->pc);
 			char disasm_line[15];
-			int len = disasm(pc, RAM, disasm_line, sizeof(disasm_line), false, 0);
+			int len = disasm(cpu->pc, RAM, disasm_line, sizeof(disasm_line), false, 0);
 			for (int i = 0; i < len; i++) {
-				printf("%02x ", read6502(pc + i));
+				printf("%02x ", read6502(cpu->pc + i));
 			}
 			for (int i = 0; i < 9 - 3 * len; i++) {
 				printf(" ");
@@ -960,9 +1697,9 @@ emulator_loop(void *param)
 				printf(" ");
 			}
 
-			printf("a=$%02x x=$%02x y=$%02x s=$%02x p=", a, x, y, sp);
+			printf("a=$%02x x=$%02x y=$%02x s=$%02x p=", cpu->a, cpu->x, cpu->y, cpu->sp);
 			for (int i = 7; i >= 0; i--) {
-				printf("%c", (status & (1 << i)) ? "czidb.vn"[i] : '-');
+				printf("%c", (cpu->status & (1 << i)) ? "czidb.vn"[i] : '-');
 			}
 
 #if 0
@@ -988,38 +1725,47 @@ emulator_loop(void *param)
 		}
 #endif
 
-#ifdef LOAD_HYPERCALLS
-		if ((pc == 0xffd5 || pc == 0xffd8) && is_kernal() && RAM[FA] == 8 && !sdcard_file) {
-			if (pc == 0xffd5) {
-				LOAD();
-			} else {
-				SAVE();
-			}
-			pc = (RAM[0x100 + sp + 1] | (RAM[0x100 + sp + 2] << 8)) + 1;
-			sp += 2;
-		}
-#endif
-
-		uint32_t old_clockticks6502 = clockticks6502;
-		step6502();
-		uint8_t clocks = clockticks6502 - old_clockticks6502;
-		bool new_frame = false;
-		for (uint8_t i = 0; i < clocks; i++) {
-			ps2_step(0);
-			ps2_step(1);
-			joystick_step();
-			vera_spi_step();
-			new_frame |= video_step(MHZ);
-		}
-		audio_render(clocks);
+		uint32_t old_instructions = cpu->instructions;
+		bool new_frame = run_cpu(&idle);
 
-		instruction_counter++;
+		instruction_counter += cpu->instructions - old_instructions;
 
 		if (new_frame) {
+			// the host may have changed memory
+			idle.period = 0;
+
+			runahead_frame(run_frame_ahead);
+
+			if (!lockstep_frame()) {
+				// a fast path went wrong
+				break;
+			}
+
 			if (!video_update()) {
 				break;
 			}
 
+			if (!replay_frame()) {
+				// the recording is over
+				break;
+			}
+
+			if (!fork_server_frame()) {
+				// the test ran out of time
+				break;
+			}
+
+			if (rewind_frame()) {
+				// the CPU clock went back
+				timing_init();
+				runahead_invalidate();
+				lockstep_invalidate();
+			}
+
+			control_frame();
+
+			lockstep_sync();
+
 			timing_update();
 #ifdef __EMSCRIPTEN__
 			// After completing a frame we yield back control to the browser to stay responsive
@@ -1027,114 +1773,20 @@ emulator_loop(void *param)
 #endif
 		}
 
-		if (video_get_irq_out()) {
-			if (!(status & 4)) {
-//				printf("IRQ!\n");
-				irq6502();
-			}
-		}
-
 #if 0
-		if (clockticks6502 >= 5 * MHZ * 1000 * 1000) {
+		if (cpu->clockticks6502 >= 5 * MHZ * 1000 * 1000) {
 			break;
 		}
 #endif
 
-		if (pc == 0xffff) {
-			if (save_on_exit) {
-				machine_dump();
-			}
-			break;
-		}
-
-		if (echo_mode != ECHO_MODE_NONE && pc == 0xffd2 && is_kernal()) {
-			uint8_t c = a;
-			if (echo_mode == ECHO_MODE_COOKED) {
-				if (c == 0x0d) {
-					printf("\n");
-				} else if (c == 0x0a) {
-					// skip
-				} else if (c < 0x20 || c >= 0x80) {
-					printf("\\X%02X", c);
-				} else {
-					printf("%c", c);
-				}
-			} else if (echo_mode == ECHO_MODE_ISO) {
-				if (c == 0x0d) {
-					printf("\n");
-				} else if (c == 0x0a) {
-					// skip
-				} else if (c < 0x20 || (c >= 0x80 && c < 0xa0)) {
-					printf("\\X%02X", c);
-				} else {
-					print_iso8859_15_char(c);
-				}
-			} else {
-				printf("%c", c);
-			}
-			fflush(stdout);
-		}
-
-		if (pc == 0xffcf && is_kernal()) {
-			// as soon as BASIC starts reading a line...
-			if (prg_file) {
-				// ...inject the app into RAM
-				uint8_t start_lo = SDL_ReadU8(prg_file);
-				uint8_t start_hi = SDL_ReadU8(prg_file);
-				uint16_t start;
-				if (prg_override_start >= 0) {
-					start = prg_override_start;
-				} else {
-					start = start_hi << 8 | start_lo;
-				}
-				uint16_t end = start + SDL_RWread(prg_file, RAM + start, 1, 65536-start);
-				SDL_RWclose(prg_file);
-				prg_file = NULL;
-				if (start == 0x0801) {
-					// set start of variables
-					RAM[VARTAB] = end & 0xff;
-					RAM[VARTAB + 1] = end >> 8;
-				}
-
-				if (run_after_load) {
-					if (start == 0x0801) {
-						paste_text = "RUN\r";
-					} else {
-						paste_text = paste_text_data;
-						snprintf(paste_text, sizeof(paste_text_data), "SYS$%04X\r", start);
-					}
-				}
-			}
-
-			if (paste_text) {
-				// ...paste BASIC code into the keyboard buffer
-				pasting_bas = true;
-			}
-		}
-
 #if 0 // enable this for slow pasting
 		if (!(instruction_counter % 100000))
 #endif
-		while (pasting_bas && RAM[NDX] < 10) {
-			uint32_t c;
-			int e = 0;
-
-			if (paste_text[0] == '\\' && paste_text[1] == 'X' && paste_text[2] && paste_text[3]) {
-				uint8_t hi = strtol((char[]){paste_text[2], 0}, NULL, 16);
-				uint8_t lo = strtol((char[]){paste_text[3], 0}, NULL, 16);
-				c = hi << 4 | lo;
-				paste_text += 4;
-			} else {
-				paste_text = utf8_decode(paste_text, &c, &e);
-				c = iso8859_15_from_unicode(c);
-			}
-			if (c && !e) {
-				RAM[KEYD + RAM[NDX]] = c;
-				RAM[NDX]++;
-			} else {
-				pasting_bas = false;
-				paste_text = NULL;
-			}
+		if (pasting_bas && RAM[NDX] < 10) {
+			paste_text = keyboard_paste(paste_text);
+			pasting_bas = paste_text != NULL;
+			runahead_invalidate();
+			lockstep_invalidate();
 		}
 	}
 
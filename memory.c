@@ -12,28 +12,316 @@
 #include "video.h"
 #include "ym2151.h"
 #include "ps2.h"
-#include "cpu/fake6502.h"
+#include "machine.h"
 
-uint8_t ram_bank;
-uint8_t rom_bank;
+#define DEVICE_EMULATOR (0x9fb0)
 
-uint8_t *RAM;
-uint8_t ROM[ROM_SIZE];
+#define IO_PAGE (0x9f00 >> 8)
 
-bool led_status;
+// memory of the current machine
+#define mem (machine->memory)
 
-#define DEVICE_EMULATOR (0x9fb0)
+// trap bitmap, laid out like RAM with all possible banks followed by ROM;
+// the traps are the same for all machines
+#define TRAP_ROM_BASE (0xa000 + NUM_MAX_RAM_BANKS * 8192)
+#define MAX_TRAPS 32
+
+static uint8_t trap_bits[(TRAP_ROM_BASE + ROM_SIZE) >> 3];
+
+static struct {
+	uint16_t address;
+	int bank;
+	memory_trap_t handler;
+} traps[MAX_TRAPS];
+static int trap_count;
+
+static void memory_map_banks();
+
+// points the pages at this machine's memory
+static void
+memory_map()
+{
+	for (int page = 0; page < 0xa0; page++) {
+		mem.read_page[page] = mem.write_page[page] = &mem.RAM[page << 8];
+	}
+	mem.read_page[IO_PAGE] = mem.write_page[IO_PAGE] = NULL;
+	for (int page = 0; page < 0xa0; page++) {
+		mem.trap_page[page] = &trap_bits[page << 5];
+	}
+	for (int page = 0xc0; page < 0x100; page++) {
+		mem.write_page[page] = mem.rom_write_sink;
+	}
+	memory_map_banks();
+}
 
 void
 memory_init()
 {
-	RAM = calloc(RAM_SIZE, sizeof(uint8_t));
+	mem.RAM = calloc(RAM_SIZE, sizeof(uint8_t));
+	mem.code_watched = calloc(RAM_SIZE >> 8, sizeof(uint8_t));
+	mem.code_generation = calloc(RAM_SIZE >> 8, sizeof(uint32_t));
+	memory_map();
+}
+
+// The machine's state was copied in from a saved state: the page pointers
+// are the ones of the machine that was saved, and any code that was
+// decoded is stale.
+void
+memory_restore()
+{
+	memset(mem.code_watched, 0, RAM_SIZE >> 8);
+	if (mem.ram_written) {
+		memset(mem.ram_written, 1, RAM_SIZE >> 8);
+	}
+	mem.code_epoch++;
+	memory_map();
+}
+
+// The machine's state was copied in from an earlier state of the same
+// machine, and this is its RAM: only the pages that differ are copied, so
+// the code decoded from the others stays valid.
+void
+memory_rollback(const uint8_t *ram)
+{
+	for (int host = 0; host < RAM_SIZE >> 8; host++) {
+		uint8_t *page = &mem.RAM[host << 8];
+		if (!memcmp(page, &ram[host << 8], 256)) {
+			continue;
+		}
+		memcpy(page, &ram[host << 8], 256);
+		if (mem.code_watched[host]) {
+			mem.code_watched[host] = 0;
+			mem.code_generation[host]++;
+		}
+		if (mem.ram_written) {
+			mem.ram_written[host] = 1;
+		}
+	}
+	for (int page = 0; page < 0xa0; page++) {
+		if (page != IO_PAGE) {
+			mem.write_page[page] = mem.code_watched[page] ? NULL : &mem.RAM[page << 8];
+		}
+	}
+	memory_map_banks();
+}
+
+void
+memory_free()
+{
+	free(mem.RAM);
+	free(mem.code_watched);
+	free(mem.code_generation);
+	free(mem.ram_written);
 }
 
 static uint8_t
 effective_ram_bank()
 {
-	return ram_bank % num_ram_banks;
+	return mem.ram_bank % num_ram_banks;
+}
+
+// whether writes to a RAM page can go straight to it
+static bool
+write_mapped(int host)
+{
+	return !mem.code_watched[host] && (!mem.ram_written || mem.ram_written[host]);
+}
+
+// points the $A000-$BFFF and $C000-$FFFF pages at the current banks
+static void
+memory_map_banks()
+{
+	if (!mem.RAM) {
+		return;
+	}
+	int host = (0xa000 + (effective_ram_bank() << 13)) >> 8;
+	for (int page = 0; page < 0x20; page++, host++) {
+		mem.read_page[0xa0 + page] = &mem.RAM[host << 8];
+		mem.write_page[0xa0 + page] = write_mapped(host) ? &mem.RAM[host << 8] : NULL;
+		mem.trap_page[0xa0 + page] = &trap_bits[host << 5];
+	}
+	uint8_t *rom = &mem.ROM[mem.rom_bank << 14];
+	const uint8_t *rom_traps = &trap_bits[(TRAP_ROM_BASE + (mem.rom_bank << 14)) >> 3];
+	for (int page = 0; page < 0x40; page++) {
+		mem.read_page[0xc0 + page] = &rom[page << 8];
+		mem.trap_page[0xc0 + page] = &rom_traps[page << 5];
+	}
+	mem.code_epoch++;
+}
+
+// index of the RAM page currently mapped at a CPU page below $C000
+static int
+ram_host_page(int page)
+{
+	if (page < 0xa0) {
+		return page;
+	}
+	return ((0xa000 + (effective_ram_bank() << 13)) >> 8) + page - 0xa0;
+}
+
+//
+// block cache support
+//
+// Returns a tag identifying the memory currently mapped at the page holding
+// address and its contents: it differs for every RAM/ROM bank and changes
+// whenever the page is written. Arms write tracking for RAM pages.
+// Returns 0 for pages that can't hold cached code.
+//
+uint64_t
+memory_code_tag(uint16_t address)
+{
+	int page = address >> 8;
+	if (page == IO_PAGE) {
+		return 0;
+	}
+	if (page >= 0xc0) {
+		// ROM is never written
+		return (1 << 15) | (mem.rom_bank << 6) | (page - 0xc0);
+	}
+	int host = ram_host_page(page);
+	if (!mem.code_watched[host]) {
+		mem.code_watched[host] = 1;
+		mem.write_page[page] = NULL;
+	}
+	return ((uint64_t)mem.code_generation[host] << 16) | (host + 1);
+}
+
+// first write to a page code was decoded from or whose writes are tracked
+static void
+watched_page_write(uint16_t address, uint8_t value)
+{
+	int page = address >> 8;
+	int host = ram_host_page(page);
+	if (mem.code_watched[host]) {
+		mem.code_watched[host] = 0;
+		mem.code_generation[host]++;
+	}
+	if (mem.ram_written) {
+		mem.ram_written[host] = 1;
+	}
+	mem.code_epoch++;
+	mem.write_page[page] = &mem.RAM[host << 8];
+	mem.RAM[(host << 8) | (address & 0xff)] = value;
+}
+
+//
+// traps
+//
+// position of address in bank in the trap bitmap; the bank is ignored below $A000
+static uint32_t
+trap_host(uint16_t address, int bank)
+{
+	if (address < 0xa000) {
+		return address;
+	} else if (address < 0xc000) {
+		return 0xa000 + (bank << 13) + address - 0xa000;
+	} else {
+		return TRAP_ROM_BASE + (bank << 14) + address - 0xc000;
+	}
+}
+
+static int
+trap_banks(uint16_t address)
+{
+	return address < 0xa000 ? 1 : address < 0xc000 ? NUM_MAX_RAM_BANKS : NUM_ROM_BANKS;
+}
+
+static void
+set_trap_bits(uint16_t address, int bank)
+{
+	for (int b = 0; b < trap_banks(address); b++) {
+		if (bank == MEMORY_ALL_BANKS || bank == b || address < 0xa000) {
+			uint32_t host = trap_host(address, b);
+			trap_bits[host >> 3] |= 1 << (host & 7);
+		}
+	}
+}
+
+// runs handler whenever the CPU is about to execute address with the given
+// RAM or ROM bank mapped (MEMORY_ALL_BANKS: with any of them); code the CPU
+// cached before runs past it until free6502() drops it
+bool
+memory_add_trap(uint16_t address, int bank, memory_trap_t handler)
+{
+	if (trap_count == MAX_TRAPS) {
+		return false;
+	}
+	if (bank != MEMORY_ALL_BANKS) {
+		bank %= trap_banks(address);
+	}
+	traps[trap_count].address = address;
+	traps[trap_count].bank = bank;
+	traps[trap_count].handler = handler;
+	trap_count++;
+
+	set_trap_bits(address, bank);
+	return true;
+}
+
+// removes the traps memory_add_trap() added with these arguments
+void
+memory_remove_trap(uint16_t address, int bank, memory_trap_t handler)
+{
+	if (bank != MEMORY_ALL_BANKS) {
+		bank %= trap_banks(address);
+	}
+	int count = 0;
+	for (int i = 0; i < trap_count; i++) {
+		if (traps[i].address != address || traps[i].bank != bank || traps[i].handler != handler) {
+			traps[count++] = traps[i];
+		}
+	}
+	trap_count = count;
+
+	memset(trap_bits, 0, sizeof(trap_bits));
+	for (int i = 0; i < trap_count; i++) {
+		set_trap_bits(traps[i].address, traps[i].bank);
+	}
+}
+
+// runs the handlers of the trap at address in the current banks
+void
+memory_run_traps(uint16_t address)
+{
+	int bank = address < 0xa000 ? 0 : address < 0xc000 ? effective_ram_bank() : mem.rom_bank;
+	for (int i = 0; i < trap_count; i++) {
+		if (traps[i].address == address && (traps[i].bank == MEMORY_ALL_BANKS || traps[i].bank == bank || address < 0xa000)) {
+			traps[i].handler();
+		}
+	}
+}
+
+// drops all cached code after RAM was modified behind write6502's back
+void
+memory_invalidate_code()
+{
+	for (int host = 0; host < RAM_SIZE >> 8; host++) {
+		if (mem.code_watched[host]) {
+			mem.code_watched[host] = 0;
+			mem.code_generation[host]++;
+		}
+	}
+	for (int page = 0; page < 0xa0; page++) {
+		if (page != IO_PAGE) {
+			mem.write_page[page] = &mem.RAM[page << 8];
+		}
+	}
+	if (mem.ram_written) {
+		memset(mem.ram_written, 1, RAM_SIZE >> 8);
+	}
+	memory_map_banks();
+}
+
+// Clears the list of written banked RAM pages, or starts keeping one. Writes
+// to the rest of RAM are not tracked; it is small enough to compare.
+void
+memory_track_writes()
+{
+	if (!mem.ram_written) {
+		mem.ram_written = malloc(RAM_SIZE >> 8);
+	}
+	memset(mem.ram_written, 0, RAM_SIZE >> 8);
+	memory_map_banks();
 }
 
 //
@@ -41,85 +329,131 @@ effective_ram_bank()
 //
 // if debugOn then reads memory only for debugger; no I/O, no side effects whatsoever
 
+// lets the devices behind an I/O address catch up before it is accessed
+static void
+io_sync(uint16_t address)
+{
+	if (address >= 0x9f20 && address < 0x9f40) {
+		machine_sync_device(DEVICE_VIDEO);
+		machine_sync_device(DEVICE_AUDIO);
+		if (address >= 0x9f3e) {
+			machine_sync_device(DEVICE_SPI);
+		}
+	} else if (address >= 0x9f70 && address < 0x9f80) {
+		machine_sync_device(DEVICE_PS2);
+		machine_sync_device(DEVICE_JOYSTICK);
+	} else if (address == 0x9fe0 || address == 0x9fe1) {
+		machine_sync_device(DEVICE_AUDIO);
+	}
+}
+
+static uint8_t
+io_read(uint16_t address, bool debugOn)
+{
+	if (!debugOn) {
+		io_sync(address);
+	}
+
+	if (address >= 0x9f00 && address < 0x9f20) {
+		// TODO: sound
+		return 0;
+	} else if (address >= 0x9f20 && address < 0x9f40) {
+		return video_read(address & 0x1f, debugOn);
+	} else if (address >= 0x9f40 && address < 0x9f60) {
+		// TODO: character LCD
+		return 0;
+	} else if (address >= 0x9f60 && address < 0x9f70) {
+		return via1_read(address & 0xf);
+	} else if (address >= 0x9f70 && address < 0x9f80) {
+		return via2_read(address & 0xf);
+	} else if (address >= 0x9f80 && address < 0x9fa0) {
+		// TODO: RTC
+		return 0;
+	} else if (address >= 0x9fa0 && address < 0x9fb0) {
+		// fake mouse
+		return mouse_read(address & 0x1f);
+	} else if (address >= 0x9fb0 && address < 0x9fc0) {
+		// emulator state
+		return emu_read(address & 0xf, debugOn);
+	} else {
+		return 0;
+	}
+}
+
+static void
+io_write(uint16_t address, uint8_t value)
+{
+	io_sync(address);
+
+	if (address >= 0x9f00 && address < 0x9f20) {
+		// TODO: sound
+	} else if (address >= 0x9f20 && address < 0x9f40) {
+		video_write(address & 0x1f, value);
+		machine_schedule(DEVICE_VIDEO); // the output mode sets the line length
+	} else if (address >= 0x9f40 && address < 0x9f60) {
+		// TODO: character LCD
+	} else if (address >= 0x9f60 && address < 0x9f70) {
+		via1_write(address & 0xf, value);
+	} else if (address >= 0x9f70 && address < 0x9f80) {
+		via2_write(address & 0xf, value);
+	} else if (address >= 0x9f80 && address < 0x9fa0) {
+		// TODO: RTC
+	} else if (address >= 0x9fb0 && address < 0x9fc0) {
+		// emulator state
+		emu_write(address & 0xf, value);
+	} else if (address == 0x9fe0) {
+		mem.ym_address = value;
+	} else if (address == 0x9fe1) {
+		YM_write_reg(mem.ym_address, value);
+	} else {
+		// future expansion
+	}
+
+	// e.g. enabling an IRQ that is pending or filling the PCM FIFO
+	if (video_get_irq_out()) {
+		yield6502();
+	}
+}
+
 uint8_t
 read6502(uint16_t address) {
-	return real_read6502(address, false, 0);
+	const uint8_t *page = mem.read_page[address >> 8];
+	if (page) {
+		return page[address & 0xff];
+	}
+	return io_read(address, false);
 }
 
 uint8_t
 real_read6502(uint16_t address, bool debugOn, uint8_t bank)
 {
+	if (!debugOn) {
+		return read6502(address);
+	}
+
 	if (address < 0x9f00) { // RAM
-		return RAM[address];
+		return mem.RAM[address];
 	} else if (address < 0xa000) { // I/O
-		if (address >= 0x9f00 && address < 0x9f20) {
-			// TODO: sound
-			return 0;
-		} else if (address >= 0x9f20 && address < 0x9f40) {
-			return video_read(address & 0x1f, debugOn);
-		} else if (address >= 0x9f40 && address < 0x9f60) {
-			// TODO: character LCD
-			return 0;
-		} else if (address >= 0x9f60 && address < 0x9f70) {
-			return via1_read(address & 0xf);
-		} else if (address >= 0x9f70 && address < 0x9f80) {
-			return via2_read(address & 0xf);
-		} else if (address >= 0x9f80 && address < 0x9fa0) {
-			// TODO: RTC
-			return 0;
-		} else if (address >= 0x9fa0 && address < 0x9fb0) {
-			// fake mouse
-			return mouse_read(address & 0x1f);
-		} else if (address >= 0x9fb0 && address < 0x9fc0) {
-			// emulator state
-			return emu_read(address & 0xf, debugOn);
-		} else {
-			return 0;
-		}
+		return io_read(address, debugOn);
 	} else if (address < 0xc000) { // banked RAM
-		int ramBank = debugOn ? bank % num_ram_banks : effective_ram_bank();
-		return	RAM[0xa000 + (ramBank << 13) + address - 0xa000];
-
-
+		int ramBank = bank % num_ram_banks;
+		return	mem.RAM[0xa000 + (ramBank << 13) + address - 0xa000];
 	} else { // banked ROM
-		int romBank = debugOn ? bank % NUM_ROM_BANKS : rom_bank;
-		return ROM[(romBank << 14) + address - 0xc000];
+		int romBank = bank % NUM_ROM_BANKS;
+		return mem.ROM[(romBank << 14) + address - 0xc000];
 	}
 }
 
 void
 write6502(uint16_t address, uint8_t value)
 {
-	static uint8_t lastAudioAdr = 0;
-	if (address < 0x9f00) { // RAM
-		RAM[address] = value;
-	} else if (address < 0xa000) { // I/O
-		if (address >= 0x9f00 && address < 0x9f20) {
-			// TODO: sound
-		} else if (address >= 0x9f20 && address < 0x9f40) {
-			video_write(address & 0x1f, value);
-		} else if (address >= 0x9f40 && address < 0x9f60) {
-			// TODO: character LCD
-		} else if (address >= 0x9f60 && address < 0x9f70) {
-			via1_write(address & 0xf, value);
-		} else if (address >= 0x9f70 && address < 0x9f80) {
-			via2_write(address & 0xf, value);
-		} else if (address >= 0x9f80 && address < 0x9fa0) {
-			// TODO: RTC
-		} else if (address >= 0x9fb0 && address < 0x9fc0) {
-			// emulator state
-			emu_write(address & 0xf, value);
-		} else if (address == 0x9fe0) {
-			lastAudioAdr = value;
-		} else if (address == 0x9fe1) {
-			YM_write_reg(lastAudioAdr, value);
-		} else {
-			// future expansion
-		}
-	} else if (address < 0xc000) { // banked RAM
-		RAM[0xa000 + (effective_ram_bank() << 13) + address - 0xa000] = value;
-	} else { // ROM
-		// ignore
+	uint8_t *page = mem.write_page[address >> 8];
+	if (page) {
+		page[address & 0xff] = value;
+	} else if ((address >> 8) == IO_PAGE) {
+		io_write(address, value);
+	} else {
+		watched_page_write(address, value);
 	}
 }
 
@@ -131,10 +465,10 @@ void
 memory_save(SDL_RWops *f, bool dump_ram, bool dump_bank)
 {
 	if (dump_ram) {
-		SDL_RWwrite(f, &RAM[0], sizeof(uint8_t), 0xa000);
+		SDL_RWwrite(f, &mem.RAM[0], sizeof(uint8_t), 0xa000);
 	}
 	if (dump_bank) {
-		SDL_RWwrite(f, &RAM[0xa000], sizeof(uint8_t), (num_ram_banks * 8192));
+		SDL_RWwrite(f, &mem.RAM[0xa000], sizeof(uint8_t), (num_ram_banks * 8192));
 	}
 }
 
@@ -146,25 +480,27 @@ memory_save(SDL_RWops *f, bool dump_ram, bool dump_bank)
 void
 memory_set_ram_bank(uint8_t bank)
 {
-	ram_bank = bank & (NUM_MAX_RAM_BANKS - 1);
+	mem.ram_bank = bank & (NUM_MAX_RAM_BANKS - 1);
+	memory_map_banks();
 }
 
 uint8_t
 memory_get_ram_bank()
 {
-	return ram_bank;
+	return mem.ram_bank;
 }
 
 void
 memory_set_rom_bank(uint8_t bank)
 {
-	rom_bank = bank & (NUM_ROM_BANKS - 1);;
+	mem.rom_bank = bank & (NUM_ROM_BANKS - 1);
+	memory_map_banks();
 }
 
 uint8_t
 memory_get_rom_bank()
 {
-	return rom_bank;
+	return mem.rom_bank;
 }
 
 // Control the GIF recorder
@@ -206,7 +542,7 @@ emu_write(uint8_t reg, uint8_t value)
 		case 3: echo_mode = value; break;
 		case 4: save_on_exit = v; break;
 		case 5: emu_recorder_set((gif_recorder_command_t) value); break;
-		case 15: led_status = v; break;
+		case 15: mem.led_status = v; break;
 		default: printf("WARN: Invalid register %x\n", DEVICE_EMULATOR + reg);
 	}
 }
@@ -228,13 +564,13 @@ emu_read(uint8_t reg, bool debugOn)
 		return record_gif;
 
 	} else if (reg == 8) {
-		return (clockticks6502 >> 0) & 0xff;
+		return (machine->cpu.clockticks6502 >> 0) & 0xff;
 	} else if (reg == 9) {
-		return (clockticks6502 >> 8) & 0xff;
+		return (machine->cpu.clockticks6502 >> 8) & 0xff;
 	} else if (reg == 10) {
-		return (clockticks6502 >> 16) & 0xff;
+		return (machine->cpu.clockticks6502 >> 16) & 0xff;
 	} else if (reg == 11) {
-		return (clockticks6502 >> 24) & 0xff;
+		return (machine->cpu.clockticks6502 >> 24) & 0xff;
 
 	} else if (reg == 13) {
 		return keymap;
@@ -9,13 +9,72 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <SDL.h>
+#include "glue.h"
 
-extern bool led_status;
+typedef struct {
+	uint8_t ram_bank;
+	uint8_t rom_bank;
+
+	uint8_t *RAM;
+	uint8_t ROM[ROM_SIZE];
+
+	bool led_status;
+
+	// host pointers for every 256 byte page of the 6502 address space;
+	// NULL means the page has to go through the slow path. The JIT reads
+	// these directly.
+	uint8_t *read_page[256];
+	uint8_t *write_page[256];
+
+	// writes to ROM are directed here and discarded
+	uint8_t rom_write_sink[256];
+
+	// block cache write tracking, per 256 byte page of RAM: pages that code has
+	// been decoded from are not write-mapped, so the first write to them takes
+	// the slow path and bumps the page's generation
+	uint8_t *code_watched;
+	uint32_t *code_generation;
+
+	// changes whenever the mapping changes or a code page is written
+	uint32_t code_epoch;
+
+	// rewind write tracking, per 256 byte page of RAM, NULL if off: banked
+	// RAM pages written since memory_track_writes(). Until then, they are
+	// not write-mapped either.
+	uint8_t *ram_written;
+
+	// the part of the trap bitmap covering what is mapped at every page
+	const uint8_t *trap_page[256];
+
+	uint8_t ym_address;
+} memory_state_t;
+
+// Traps are host-side hooks run when the CPU is about to execute an address.
+// Every address of every RAM and ROM bank has a bit in the trap bitmap, so
+// checking for one costs a single bit test.
+#define MEMORY_ALL_BANKS (-1)
+
+typedef void (*memory_trap_t)(void);
+
+#define memory_is_trap(address) \
+	(machine->memory.trap_page[(address) >> 8][((address) & 0xff) >> 3] & (1 << ((address) & 7)))
 
 uint8_t read6502(uint16_t address);
 uint8_t real_read6502(uint16_t address, bool debugOn, uint8_t bank);
+void write6502(uint16_t address, uint8_t value);
 
 void memory_init();
+void memory_free();
+void memory_restore();
+void memory_rollback(const uint8_t *ram);
+
+uint64_t memory_code_tag(uint16_t address);
+void memory_invalidate_code();
+void memory_track_writes();
+
+bool memory_add_trap(uint16_t address, int bank, memory_trap_t handler);
+void memory_remove_trap(uint16_t address, int bank, memory_trap_t handler);
+void memory_run_traps(uint16_t address);
 
 void memory_save(SDL_RWops *f, bool dump_ram, bool dump_bank);
 
@@ -6,6 +6,7 @@
 #define _PS2_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define PS2_DATA_MASK 1
 #define PS2_CLK_MASK 2
@@ -17,11 +18,36 @@ typedef struct {
 	int data_in;
 } ps2_port_t;
 
-extern ps2_port_t ps2_port[2];
+#define PS2_BUFFER_SIZE 32
+
+typedef struct {
+	struct {
+		bool sending;
+		bool has_byte;
+		uint8_t current_byte;
+		int bit_index;
+		int data_bits;
+		int send_state;
+		struct
+		{
+			uint8_t data[PS2_BUFFER_SIZE];
+			uint8_t read;
+			uint8_t write;
+		} buffer;
+	} state[2];
+
+	ps2_port_t port[2];
+
+	// fake mouse
+	uint8_t buttons;
+	int16_t mouse_diff_x;
+	int16_t mouse_diff_y;
+} ps2_state_t;
 
 bool ps2_buffer_can_fit(int i, int n);
 void ps2_buffer_add(int i, uint8_t byte);
-void ps2_step(int i);
+void ps2_step(int i, uint32_t clocks);
+bool ps2_is_idle(int i);
 
 // fake mouse
 void mouse_button_down(int num);
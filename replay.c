@@ -0,0 +1,285 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glue.h"
+#include "machine.h"
+#include "keyboard.h"
+#include "joystick.h"
+#include "ps2.h"
+#include "sdcard.h"
+#include "replay.h"
+#include "runahead.h"
+#include "lockstep.h"
+
+// A recording is the state of the machine when it started, followed by all
+// input from the host with the CPU clock at which it reached the machine.
+// Everything else the machine does follows from these (its random numbers
+// are part of its state), so a replay goes exactly the same way, at any
+// speed. Files the machine reads from the host, like the SD card image, have
+// to be the same, though.
+
+#define REPLAY_MAGIC "X16INPUT"
+#define REPLAY_VERSION 1
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t joy1_mode;
+	uint32_t joy2_mode;
+} replay_header_t;
+
+typedef struct {
+	uint64_t clock; // CPU clocks since the recording started
+	uint32_t type;
+	int32_t a;
+	int32_t b;
+	uint32_t length; // of the text that follows
+} input_record_t;
+
+static struct {
+	SDL_RWops *file;
+	bool recording;
+	bool replaying;
+
+	uint64_t clock;
+	uint32_t last_clock; // clockticks6502 when clock was last updated
+
+	bool has_next;
+	input_record_t next;
+	char *next_text;
+
+	uint16_t joystick[2]; // as of the last INPUT_JOYSTICK
+} replay;
+
+// clockticks6502 wraps after a few minutes, the clock of the recording doesn't;
+// it is updated at least once per frame
+static uint64_t
+replay_clock()
+{
+	uint32_t now = machine->cpu.clockticks6502;
+	replay.clock += (uint32_t)(now - replay.last_clock);
+	replay.last_clock = now;
+	return replay.clock;
+}
+
+static bool
+write_header()
+{
+	replay_header_t header;
+	memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+	header.version = REPLAY_VERSION;
+	header.joy1_mode = joy1_mode;
+	header.joy2_mode = joy2_mode;
+	return SDL_RWwrite(replay.file, &header, sizeof(header), 1) == 1 &&
+		machine_write_state(replay.file);
+}
+
+static bool
+read_header()
+{
+	replay_header_t header;
+	if (SDL_RWread(replay.file, &header, sizeof(header), 1) != 1 ||
+		memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) ||
+		header.version != REPLAY_VERSION ||
+		!machine_read_state(replay.file)) {
+		return false;
+	}
+	joy1_mode = header.joy1_mode;
+	joy2_mode = header.joy2_mode;
+	return true;
+}
+
+// Starts recording the input from now on.
+bool
+replay_record(const char *path)
+{
+	replay.file = SDL_RWFromFile(path, "wb");
+	if (!replay.file) {
+		return false;
+	}
+	if (!write_header()) {
+		SDL_RWclose(replay.file);
+		replay.file = NULL;
+		return false;
+	}
+	replay.recording = true;
+	replay.last_clock = machine->cpu.clockticks6502;
+	return true;
+}
+
+static void
+write_record(input_type_t type, int a, int b, const char *text)
+{
+	input_record_t record;
+	record.clock = replay_clock();
+	record.type = type;
+	record.a = a;
+	record.b = b;
+	record.length = text ? strlen(text) : 0;
+	SDL_RWwrite(replay.file, &record, sizeof(record), 1);
+	if (record.length) {
+		SDL_RWwrite(replay.file, text, record.length, 1);
+	}
+}
+
+static void
+read_record()
+{
+	replay.has_next = SDL_RWread(replay.file, &replay.next, sizeof(replay.next), 1) == 1;
+	replay.next_text = NULL;
+	if (replay.has_next && replay.next.length) {
+		// the paste buffer keeps pointing to it
+		replay.next_text = malloc(replay.next.length + 1);
+		if (!replay.next_text || SDL_RWread(replay.file, replay.next_text, replay.next.length, 1) != 1) {
+			free(replay.next_text);
+			replay.next_text = NULL;
+			replay.has_next = false;
+			return;
+		}
+		replay.next_text[replay.next.length] = 0;
+	}
+}
+
+// Restores the machine the way it was when the recording started and feeds
+// it the recorded input instead of the host's.
+bool
+replay_open(const char *path)
+{
+	replay.file = SDL_RWFromFile(path, "rb");
+	if (!replay.file) {
+		return false;
+	}
+	if (!read_header()) {
+		SDL_RWclose(replay.file);
+		replay.file = NULL;
+		return false;
+	}
+	replay.replaying = true;
+	replay.last_clock = machine->cpu.clockticks6502;
+	read_record();
+	return true;
+}
+
+void
+replay_close()
+{
+	if (replay.recording) {
+		write_record(INPUT_END, 0, 0, NULL);
+	}
+	if (replay.file) {
+		SDL_RWclose(replay.file);
+	}
+	free(replay.next_text);
+	memset(&replay, 0, sizeof(replay));
+}
+
+static void
+apply(input_type_t type, int a, int b, const char *text)
+{
+	switch (type) {
+		case INPUT_KEY_DOWN:
+			handle_keyboard(true, 0, a);
+			break;
+		case INPUT_KEY_UP:
+			handle_keyboard(false, 0, a);
+			break;
+		case INPUT_MOUSE_DOWN:
+			mouse_button_down(a);
+			break;
+		case INPUT_MOUSE_UP:
+			mouse_button_up(a);
+			break;
+		case INPUT_MOUSE_MOVE:
+			mouse_move(a, b);
+			break;
+		case INPUT_JOYSTICK:
+			replay.joystick[0] = a;
+			replay.joystick[1] = b;
+			break;
+		case INPUT_PASTE:
+			machine_paste(text);
+			break;
+		case INPUT_RESET:
+			machine_reset();
+			break;
+		case INPUT_SDCARD_ATTACH:
+			sdcard_attach();
+			break;
+		case INPUT_SDCARD_DETACH:
+			sdcard_detach();
+			break;
+		case INPUT_END:
+			break;
+	}
+}
+
+// Applies the recorded input the machine has reached. Returns false at the
+// end of the recording.
+static bool
+replay_due()
+{
+	uint64_t clock = replay_clock();
+	while (replay.has_next && replay.next.clock <= clock) {
+		if (replay.next.type == INPUT_END) {
+			return false;
+		}
+		apply(replay.next.type, replay.next.a, replay.next.b, replay.next_text);
+		read_record();
+		lockstep_invalidate();
+	}
+	return replay.has_next;
+}
+
+// Input from the host goes through here. It is recorded, or ignored while
+// replaying.
+void
+replay_input(input_type_t type, int a, int b, const char *text)
+{
+	if (replay.replaying) {
+		return;
+	}
+	if (replay.recording) {
+		write_record(type, a, b, text);
+	}
+	apply(type, a, b, text);
+	runahead_invalidate();
+	lockstep_invalidate();
+}
+
+// The controllers are read when the machine latches them, in the middle of
+// a frame. Changes their states to the recorded ones while replaying.
+void
+replay_joystick(uint16_t *state1, uint16_t *state2)
+{
+	if (replay.replaying) {
+		// the rest of the input only reaches the machine between frames
+		uint64_t clock = replay_clock();
+		while (replay.has_next && replay.next.type == INPUT_JOYSTICK && replay.next.clock <= clock) {
+			apply(INPUT_JOYSTICK, replay.next.a, replay.next.b, NULL);
+			read_record();
+		}
+		*state1 = replay.joystick[0];
+		*state2 = replay.joystick[1];
+	} else if (replay.recording && (*state1 != replay.joystick[0] || *state2 != replay.joystick[1])) {
+		write_record(INPUT_JOYSTICK, *state1, *state2, NULL);
+		replay.joystick[0] = *state1;
+		replay.joystick[1] = *state2;
+	}
+}
+
+// Called at the end of every frame. Returns false once a replay is over.
+bool
+replay_frame()
+{
+	if (replay.recording) {
+		replay_clock();
+	}
+	if (!replay.replaying) {
+		return true;
+	}
+	return replay_due();
+}
@@ -0,0 +1,33 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// input from the host that changes the machine
+typedef enum {
+	INPUT_KEY_DOWN,      // a: SDL scancode
+	INPUT_KEY_UP,        // a: SDL scancode
+	INPUT_MOUSE_DOWN,    // a: button
+	INPUT_MOUSE_UP,      // a: button
+	INPUT_MOUSE_MOVE,    // a, b: distance
+	INPUT_JOYSTICK,      // a, b: state of the controllers
+	INPUT_PASTE,         // text
+	INPUT_RESET,
+	INPUT_SDCARD_ATTACH,
+	INPUT_SDCARD_DETACH,
+	INPUT_END,           // the recording stopped
+} input_type_t;
+
+bool replay_record(const char *path);
+bool replay_open(const char *path);
+void replay_close(void);
+void replay_input(input_type_t type, int a, int b, const char *text);
+void replay_joystick(uint16_t *state1, uint16_t *state2);
+bool replay_frame(void);
+
+#endif
@@ -0,0 +1,285 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glue.h"
+#include "machine.h"
+#include "rewind.h"
+
+// The machine is saved at the end of every frame: the 256 byte chunks of the
+// machine struct and of RAM that changed since the frame before. Banked RAM
+// can be large, so only the pages the CPU wrote to are compared; the rest is
+// small enough to compare every time. Every KEYFRAME_INTERVAL frames, all
+// chunks that aren't zero are saved, so no frame needs more than that many
+// others to be restored.
+//
+// Going back restores the frame before the newest one and lets the machine
+// run a frame from there, which renders the frame that was the newest.
+
+#define CHUNK_SIZE 256
+#define KEYFRAME_INTERVAL 60
+#define FRAMES_PER_SECOND 60
+
+typedef struct {
+	uint8_t *data; // chunk number (uint32_t) and content, for every chunk
+	uint32_t size;
+	bool keyframe;
+} saved_frame_t;
+
+static struct {
+	saved_frame_t *frames; // ring buffer, oldest at first
+	int capacity;
+	int first;
+	int count;
+	int since_keyframe; // frames saved since the newest keyframe, including it
+	bool active;
+
+	// the machine as of the newest frame, which the next one is compared to;
+	// its chunks are numbered through the struct, then through RAM
+	machine_t *shadow;
+	uint8_t *shadow_ram;
+	uint32_t machine_chunks;
+	uint32_t chunks;
+	uint8_t *tracked; // per chunk of the struct: false if it is never saved
+
+	uint8_t *buffer; // the frame being saved
+	uint32_t buffer_size;
+
+	uint64_t bytes; // saved since the last stats
+	uint64_t held;  // in the ring buffer
+} history;
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Chunks entirely inside the given part of the struct are never saved. The
+// ROM doesn't change, the page pointers are rebuilt when a frame is restored
+// and the framebuffer is rendered again.
+static void
+untrack(size_t offset, size_t size)
+{
+	for (size_t c = (offset + CHUNK_SIZE - 1) / CHUNK_SIZE; (c + 1) * CHUNK_SIZE <= offset + size; c++) {
+		history.tracked[c] = false;
+	}
+}
+
+// address and length of a chunk of machine m with RAM ram
+static uint8_t *
+chunk(machine_t *m, uint8_t *ram, uint32_t index, uint32_t *length)
+{
+	if (index < history.machine_chunks) {
+		size_t offset = (size_t)index * CHUNK_SIZE;
+		*length = MIN(CHUNK_SIZE, sizeof(machine_t) - offset);
+		return (uint8_t *)m + offset;
+	}
+	*length = CHUNK_SIZE;
+	return ram + (size_t)(index - history.machine_chunks) * CHUNK_SIZE;
+}
+
+static bool
+is_zero(const uint8_t *data, uint32_t length)
+{
+	while (length--) {
+		if (*data++) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Keeps the current machine's state for the last seconds of emulated time.
+bool
+rewind_init(int seconds)
+{
+	history.capacity = seconds * FRAMES_PER_SECOND;
+	history.machine_chunks = (sizeof(machine_t) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	history.chunks = history.machine_chunks + RAM_SIZE / CHUNK_SIZE;
+	history.frames = calloc(history.capacity, sizeof(saved_frame_t));
+	history.shadow = malloc(sizeof(machine_t));
+	history.shadow_ram = malloc(RAM_SIZE);
+	history.tracked = malloc(history.machine_chunks);
+	history.buffer = malloc((size_t)history.chunks * (sizeof(uint32_t) + CHUNK_SIZE));
+	if (!history.frames || !history.shadow || !history.shadow_ram || !history.tracked || !history.buffer) {
+		rewind_close();
+		return false;
+	}
+
+	memset(history.tracked, true, history.machine_chunks);
+	untrack(offsetof(machine_t, memory.ROM), sizeof(machine->memory.ROM));
+	untrack(offsetof(machine_t, memory.read_page), sizeof(machine->memory.read_page));
+	untrack(offsetof(machine_t, memory.write_page), sizeof(machine->memory.write_page));
+	untrack(offsetof(machine_t, memory.trap_page), sizeof(machine->memory.trap_page));
+	untrack(offsetof(machine_t, video.framebuffer), sizeof(machine->video.framebuffer));
+
+	*history.shadow = *machine;
+	memcpy(history.shadow_ram, machine->memory.RAM, RAM_SIZE);
+	memory_track_writes();
+	return true;
+}
+
+static void
+drop_frame(int i)
+{
+	saved_frame_t *frame = &history.frames[i % history.capacity];
+	history.held -= frame->size;
+	free(frame->data);
+	frame->data = NULL;
+	frame->size = 0;
+}
+
+void
+rewind_close()
+{
+	if (history.frames) {
+		while (history.count) {
+			drop_frame(history.first + --history.count);
+		}
+	}
+	free(history.frames);
+	free(history.shadow);
+	free(history.shadow_ram);
+	free(history.tracked);
+	free(history.buffer);
+	memset(&history, 0, sizeof(history));
+}
+
+// Saves the chunks that changed since the newest frame, or all that aren't
+// zero, and brings the shadow up to date.
+static void
+save_frame()
+{
+	if (history.count == history.capacity) {
+		// the oldest frame goes, and the ones that can't be restored without it
+		do {
+			drop_frame(history.first++);
+			history.count--;
+		} while (history.count && !history.frames[history.first % history.capacity].keyframe);
+		history.first %= history.capacity;
+	}
+
+	machine_t *m = machine;
+	const uint8_t *written = m->memory.ram_written;
+	uint32_t banked = history.machine_chunks + (0xa000 / CHUNK_SIZE);
+	bool keyframe = !history.count || history.since_keyframe >= KEYFRAME_INTERVAL;
+
+	history.buffer_size = 0;
+	for (uint32_t i = 0; i < history.chunks; i++) {
+		if (i < history.machine_chunks && !history.tracked[i]) {
+			continue;
+		}
+		uint32_t length;
+		uint8_t *live = chunk(m, m->memory.RAM, i, &length);
+		uint8_t *old = chunk(history.shadow, history.shadow_ram, i, &length);
+		bool changed = false;
+		if (i < banked || !written || written[i - history.machine_chunks]) {
+			changed = memcmp(live, old, length) != 0;
+			if (changed) {
+				memcpy(old, live, length);
+			}
+		}
+		if (keyframe ? !is_zero(live, length) : changed) {
+			uint8_t *p = history.buffer + history.buffer_size;
+			memcpy(p, &i, sizeof(i));
+			memcpy(p + sizeof(i), live, length);
+			history.buffer_size += sizeof(i) + length;
+		}
+	}
+	memory_track_writes();
+
+	saved_frame_t *frame = &history.frames[(history.first + history.count) % history.capacity];
+	frame->data = history.buffer_size ? malloc(history.buffer_size) : NULL;
+	if (history.buffer_size && !frame->data) {
+		// start over with a keyframe
+		while (history.count) {
+			drop_frame(history.first + --history.count);
+		}
+		return;
+	}
+	if (frame->data) {
+		memcpy(frame->data, history.buffer, history.buffer_size);
+	}
+	frame->size = history.buffer_size;
+	frame->keyframe = keyframe;
+	history.count++;
+	history.since_keyframe = keyframe ? 1 : history.since_keyframe + 1;
+	history.bytes += frame->size;
+	history.held += frame->size;
+}
+
+// Drops the newest frame and restores the one before it.
+static void
+restore_previous_frame()
+{
+	if (history.count > 1) {
+		drop_frame(history.first + --history.count);
+	}
+
+	int newest = history.first + history.count - 1;
+	int keyframe = newest;
+	while (!history.frames[keyframe % history.capacity].keyframe) {
+		keyframe--;
+	}
+
+	for (uint32_t i = 0; i < history.chunks; i++) {
+		if (i >= history.machine_chunks || history.tracked[i]) {
+			uint32_t length;
+			uint8_t *data = chunk(history.shadow, history.shadow_ram, i, &length);
+			memset(data, 0, length);
+		}
+	}
+	for (int f = keyframe; f <= newest; f++) {
+		const saved_frame_t *frame = &history.frames[f % history.capacity];
+		const uint8_t *p = frame->data;
+		while (p < frame->data + frame->size) {
+			uint32_t i, length;
+			memcpy(&i, p, sizeof(i));
+			uint8_t *data = chunk(history.shadow, history.shadow_ram, i, &length);
+			memcpy(data, p + sizeof(i), length);
+			p += sizeof(i) + length;
+		}
+	}
+	history.since_keyframe = newest - keyframe + 1;
+
+	machine_restore(history.shadow, history.shadow_ram);
+	memory_track_writes();
+}
+
+// Called at the end of every frame. Returns true if the machine went back
+// in time.
+bool
+rewind_frame()
+{
+	if (!history.capacity) {
+		return false;
+	}
+	if (history.active && history.count) {
+		restore_previous_frame();
+		return true;
+	}
+	save_frame();
+	return false;
+}
+
+// The machine goes back one frame per frame while active.
+void
+rewind_set_active(bool active)
+{
+	history.active = active;
+}
+
+void
+rewind_log_stats(int64_t usec)
+{
+	if (!history.capacity || usec <= 0) {
+		return;
+	}
+	printf("Rewind: %d KB/s saved, %.1f s held in %d KB.\n",
+		(int)(history.bytes * 1000000 / usec / 1024),
+		(float)history.count / FRAMES_PER_SECOND,
+		(int)(history.held / 1024));
+	history.bytes = 0;
+}
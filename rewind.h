@@ -0,0 +1,17 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool rewind_init(int seconds);
+void rewind_close(void);
+bool rewind_frame(void);
+void rewind_set_active(bool active);
+void rewind_log_stats(int64_t usec);
+
+#endif
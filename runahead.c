@@ -0,0 +1,176 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "glue.h"
+#include "machine.h"
+#include "runahead.h"
+
+// Keyboard, mouse and controller input takes a frame or more to make it
+// through the PS/2 and SNES protocols and the KERNAL before a program shows
+// a reaction. Run-ahead hides that: at the end of every frame, the machine is
+// saved, runs the next frames without being heard or seen, except for the
+// picture of the last one, and then goes back to where it was. The host
+// shows that picture, and the input it takes goes to the real machine.
+//
+// As long as the host doesn't touch the real machine, it does exactly what
+// the frames run ahead did, so the machine that ran ahead is kept and only
+// needs to run one more frame every time. Input, traps and the like make it
+// start over from the real machine. Whatever happens ahead is thrown away:
+// it can only change what is shown, never the real machine.
+
+static struct {
+	int frames; // how far ahead the frame that is shown is
+	bool speculating; // running a frame that is thrown away
+	bool composing; // ... whose picture is shown
+	bool valid; // the machine ahead still follows from the real one
+
+	machine_t *real;
+	uint8_t *real_ram;
+	machine_t *ahead;
+	uint8_t *ahead_ram;
+
+	uint16_t joystick[2]; // as the machine latched them last
+
+	// since the last stats
+	uint64_t ticks;
+	uint64_t max_ticks;
+	uint32_t count;
+	uint32_t restarts;
+} runahead;
+
+// Shows the frame that is the given number of frames ahead of the current
+// machine.
+bool
+runahead_init(int frames)
+{
+	runahead.frames = frames;
+	runahead.real = malloc(sizeof(machine_t));
+	runahead.real_ram = malloc(RAM_SIZE);
+	runahead.ahead = malloc(sizeof(machine_t));
+	runahead.ahead_ram = malloc(RAM_SIZE);
+	if (!runahead.real || !runahead.real_ram || !runahead.ahead || !runahead.ahead_ram) {
+		runahead_close();
+		return false;
+	}
+	return true;
+}
+
+void
+runahead_close()
+{
+	free(runahead.real);
+	free(runahead.real_ram);
+	free(runahead.ahead);
+	free(runahead.ahead_ram);
+	memset(&runahead, 0, sizeof(runahead));
+}
+
+// nobody is waiting for a frame in the debugger or in warp mode
+static bool
+paused()
+{
+	return debugger_enabled || warp_mode;
+}
+
+// Called at the end of every frame, before it is shown. run_frame runs the
+// current machine up to the end of the next frame, without traps.
+void
+runahead_frame(void (*run_frame)(void))
+{
+	if (!runahead.frames) {
+		return;
+	}
+	if (paused()) {
+		runahead.valid = false;
+		return;
+	}
+
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	machine_snapshot(runahead.real, runahead.real_ram);
+	int frames = 1;
+	if (runahead.valid) {
+		machine_rollback(runahead.ahead, runahead.ahead_ram);
+	} else {
+		frames = runahead.frames;
+		runahead.restarts++;
+	}
+
+	runahead.valid = true;
+	runahead.speculating = true;
+	for (int i = 0; i < frames; i++) {
+		runahead.composing = i == frames - 1;
+		run_frame();
+	}
+	runahead.speculating = false;
+	runahead.composing = false;
+
+	machine_snapshot(runahead.ahead, runahead.ahead_ram);
+	machine_rollback(runahead.real, runahead.real_ram);
+
+	uint64_t ticks = SDL_GetPerformanceCounter() - start;
+	runahead.ticks += ticks;
+	if (ticks > runahead.max_ticks) {
+		runahead.max_ticks = ticks;
+	}
+	runahead.count++;
+}
+
+// The host changed the real machine: the next frame starts over from it.
+void
+runahead_invalidate()
+{
+	runahead.valid = false;
+}
+
+// The machine latched the controllers. If they changed, the frames ahead of
+// the real machine saw other ones than it will.
+void
+runahead_joystick(uint16_t state1, uint16_t state2)
+{
+	if (state1 != runahead.joystick[0] || state2 != runahead.joystick[1]) {
+		runahead.joystick[0] = state1;
+		runahead.joystick[1] = state2;
+		runahead.valid = false;
+	}
+}
+
+// Whether the frame being run is thrown away; it mustn't be heard or leave
+// anything on the host.
+bool
+runahead_speculating()
+{
+	return runahead.speculating;
+}
+
+// Whether the frame being run is the one that is shown.
+bool
+runahead_composing()
+{
+	if (!runahead.frames || paused()) {
+		return true;
+	}
+	return runahead.composing;
+}
+
+void
+runahead_log_stats()
+{
+	if (!runahead.frames || !runahead.count) {
+		return;
+	}
+	double freq = SDL_GetPerformanceFrequency() / 1000.0;
+	printf("Run-ahead: %.2f ms per frame, at most %.2f ms; %u of %u frames started over.\n",
+		runahead.ticks / freq / runahead.count,
+		runahead.max_ticks / freq,
+		runahead.restarts, runahead.count);
+	runahead.ticks = 0;
+	runahead.max_ticks = 0;
+	runahead.count = 0;
+	runahead.restarts = 0;
+}
@@ -0,0 +1,20 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _RUNAHEAD_H_
+#define _RUNAHEAD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool runahead_init(int frames);
+void runahead_close(void);
+void runahead_frame(void (*run_frame)(void));
+void runahead_invalidate(void);
+void runahead_joystick(uint16_t state1, uint16_t state2);
+bool runahead_speculating(void);
+bool runahead_composing(void);
+void runahead_log_stats(void);
+
+#endif
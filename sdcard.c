@@ -5,7 +5,11 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include "sdcard.h"
+#include "machine.h"
+#include "runahead.h"
+#include "lockstep.h"
 
 //#define VERBOSE 1
 
@@ -35,71 +39,71 @@ enum {
 };
 
 SDL_RWops *sdcard_file = NULL;
-bool sdcard_attached = false;
+// machines on different threads seek and transfer in the image one at a time
+static SDL_SpinLock sdcard_lock;
+// SD card interface of the current machine
+#define sd (machine->sdcard)
 
-static uint8_t rxbuf[3 + 512];
-static int rxbuf_idx;
-static uint32_t lba;
-static uint8_t last_cmd;
-static bool is_acmd = false;
-static bool is_idle = true;
-static bool is_initialized = false;
-
-static const uint8_t *response = NULL;
-static int response_length = 0;
-static int response_counter = 0;
-
-static bool selected = false;
+void
+sdcard_init()
+{
+	sd.is_idle = true;
+}
 
 void
 sdcard_attach()
 {
-	if (!sdcard_attached && sdcard_file) {
+	if (!sd.attached && sdcard_file) {
 		printf("SD card attached.\n");
-		sdcard_attached = true;
-		is_initialized = false;
+		sd.attached = true;
+		sd.is_initialized = false;
 	}
 }
 
 void
 sdcard_detach()
 {
-	if (sdcard_attached) {
+	if (sd.attached) {
 		printf("SD card detached.\n");
-		sdcard_attached = false;
+		sd.attached = false;
 	}
 }
 
 void
 sdcard_select(bool select)
 {
-	selected = select;
-	rxbuf_idx = 0;
+	sd.selected = select;
+	sd.rxbuf_idx = 0;
 #if defined(VERBOSE) && VERBOSE >= 2
 	printf("*** SD card select: %u\n", select);
 #endif
 }
 
+// responses are copied into the machine, so they are part of its state
+static void
+set_response(const uint8_t *data, int length)
+{
+	memcpy(sd.response, data, length);
+	sd.response_length = length;
+	sd.has_response = true;
+}
+
 static void
 set_response_r1(void)
 {
-	static uint8_t r1;
-	r1 = is_idle ? 1 : 0;
-	response = &r1;
-	response_length = 1;
+	uint8_t r1 = sd.is_idle ? 1 : 0;
+	set_response(&r1, 1);
 }
 
 static void
 set_response_r2(void)
 {
-	if (is_initialized) {
+	if (sd.is_initialized) {
 		static const uint8_t r2[] = {0x00, 0x00};
-		response = r2;
-		response_length = sizeof(r2);
+		set_response(r2, sizeof(r2));
 	} else {
 		static const uint8_t r2[] = {0x1F, 0xFF};
-		response = r2;
-		response_length = sizeof(r2);
+		set_response(r2, sizeof(r2));
 	}
 }
 
@@ -107,65 +111,63 @@ static void
 set_response_r3(void)
 {
 	static const uint8_t r3[] = {0xC0, 0xFF, 0x80, 0x00};
-	response = r3;
-	response_length = sizeof(r3);
+	set_response(r3, sizeof(r3));
 }
 
 static void
 set_response_r7(void)
 {
 	static const uint8_t r7[] = {1, 0x00, 0x00, 0x01, 0xAA};
-	response = r7;
-	response_length = sizeof(r7);
+	set_response(r7, sizeof(r7));
 }
 
 uint8_t
 sdcard_handle(uint8_t inbyte)
 {
-	if (!selected || sdcard_file == NULL) {
+	if (!sd.selected || sdcard_file == NULL) {
 		return 0xFF;
 	}
 	// printf("sdcard_handle: %02X\n", inbyte);
 
 	uint8_t outbyte = 0xFF;
 
-	if (rxbuf_idx == 0 && inbyte == 0xFF) {
+	if (sd.rxbuf_idx == 0 && inbyte == 0xFF) {
 		// send response data
-		if (response) {
-			outbyte = response[response_counter++];
-			if (response_counter == response_length) {
-				response = NULL;
+		if (sd.has_response) {
+			outbyte = sd.response[sd.response_counter++];
+			if (sd.response_counter == sd.response_length) {
+				sd.has_response = false;
 			}
 		}
 
 	} else {
-		rxbuf[rxbuf_idx++] = inbyte;
+		sd.rxbuf[sd.rxbuf_idx++] = inbyte;
 
-		if ((rxbuf[0] & 0xC0) == 0x40 && rxbuf_idx == 6) {
-			rxbuf_idx = 0;
+		if ((sd.rxbuf[0] & 0xC0) == 0x40 && sd.rxbuf_idx == 6) {
+			sd.rxbuf_idx = 0;
 
 			// Check for start-bit + transmission bit
-			if ((rxbuf[0] & 0xC0) != 0x40) {
-				response = NULL;
+			if ((sd.rxbuf[0] & 0xC0) != 0x40) {
+				sd.has_response = false;
 				return 0xFF;
 			}
-			rxbuf[0] &= 0x3F;
+			sd.rxbuf[0] &= 0x3F;
 
 			// Use upper command bit to indicate this is an ACMD
-			if (is_acmd) {
-				rxbuf[0] |= 0x80;
-				is_acmd = false;
+			if (sd.is_acmd) {
+				sd.rxbuf[0] |= 0x80;
+				sd.is_acmd = false;
 			}
 
-			last_cmd = rxbuf[0];
+			sd.last_cmd = sd.rxbuf[0];
 
 #if defined(VERBOSE) && VERBOSE >= 2
-			printf("*** SD %sCMD%d -> Response:", (rxbuf[0] & 0x80) ? "A" : "", rxbuf[0] & 0x3F);
+			printf("*** SD %sCMD%d -> Response:", (sd.rxbuf[0] & 0x80) ? "A" : "", sd.rxbuf[0] & 0x3F);
 #endif
-			switch (rxbuf[0]) {
+			switch (sd.rxbuf[0]) {
 				case CMD0: {
 					// GO_IDLE_STATE: Resets the SD Memory Card
-					is_idle = true;
+					sd.is_idle = true;
 					set_response_r1();
 					break;
 				}
@@ -178,8 +180,8 @@ sdcard_handle(uint8_t inbyte)
 
 				case ACMD41: {
 					// SD_SEND_OP_COND: Sends host capacity support information and activated the card's initialization process
-					is_idle = false;
-					is_initialized = true;
+					sd.is_idle = false;
+					sd.is_initialized = true;
 					set_response_r1();
 					break;
 				}
@@ -196,34 +198,35 @@ sdcard_handle(uint8_t inbyte)
 				}
 				case CMD17: {
 					// READ_SINGLE_BLOCK
-					uint32_t lba = (rxbuf[1] << 24) | (rxbuf[2] << 16) | (rxbuf[3] << 8) | rxbuf[4];
-					static uint8_t read_block_response[2 + 512 + 2];
-					read_block_response[0] = 0;
-					read_block_response[1] = 0xFE;
+					uint32_t lba = (sd.rxbuf[1] << 24) | (sd.rxbuf[2] << 16) | (sd.rxbuf[3] << 8) | sd.rxbuf[4];
+					sd.response[0] = 0;
+					sd.response[1] = 0xFE;
 #ifdef VERBOSE
 					printf("*** SD Reading LBA %d\n", lba);
 #endif
+					SDL_AtomicLock(&sdcard_lock);
 					SDL_RWseek(sdcard_file, lba * 512, SEEK_SET);
-					int bytes_read = SDL_RWread(sdcard_file, &read_block_response[2], 1, 512);
+					int bytes_read = SDL_RWread(sdcard_file, &sd.response[2], 1, 512);
+					SDL_AtomicUnlock(&sdcard_lock);
 					if (bytes_read != 512) {
 						printf("Warning: short read!\n");
 					}
 
-					response = read_block_response;
-					response_length = 2 + 512 + 2;
+					sd.response_length = 2 + 512 + 2;
+					sd.has_response = true;
 					break;
 				}
 
 				case CMD24: {
 					// WRITE_BLOCK
-					lba = (rxbuf[1] << 24) | (rxbuf[2] << 16) | (rxbuf[3] << 8) | rxbuf[4];
+					sd.lba = (sd.rxbuf[1] << 24) | (sd.rxbuf[2] << 16) | (sd.rxbuf[3] << 8) | sd.rxbuf[4];
 					set_response_r1();
 					break;
 				}
 
 				case CMD55: {
 					// APP_CMD: Next command is an application specific command
-					is_acmd = true;
+					sd.is_acmd = true;
 					set_response_r1();
 					break;
 				}
@@ -239,26 +242,34 @@ sdcard_handle(uint8_t inbyte)
 					break;
 				}
 			}
-			response_counter = 0;
+			sd.response_counter = 0;
 
 #if defined(VERBOSE) && VERBOSE >= 2
-			for (int i = 0; i < (response_length < 16 ? response_length : 16); i++) {
-				printf(" %02X", response[i]);
+			for (int i = 0; i < (sd.response_length < 16 ? sd.response_length : 16); i++) {
+				printf(" %02X", sd.response[i]);
 			}
 			printf("\n");
 #endif
 
-		} else if (rxbuf_idx == 515) {
-			rxbuf_idx = 0;
+		} else if (sd.rxbuf_idx == 515) {
+			sd.rxbuf_idx = 0;
 			// Check for 'start block' byte
-			if (last_cmd == CMD24 && rxbuf[0] == 0xFE) {
+			if (sd.last_cmd == CMD24 && sd.rxbuf[0] == 0xFE) {
 #ifdef VERBOSE
-				printf("*** SD Writing LBA %d\n", lba);
+				printf("*** SD Writing LBA %d\n", sd.lba);
 #endif
-				SDL_RWseek(sdcard_file, lba * 512, SEEK_SET);
-				int bytes_written = SDL_RWwrite(sdcard_file, rxbuf + 1, 1, 512);
-				if (bytes_written != 512) {
-					printf("Warning: short write!\n");
+				// only the real machine writes to the image
+				if (!runahead_speculating() && !lockstep_checking()) {
+					SDL_AtomicLock(&sdcard_lock);
+					SDL_RWseek(sdcard_file, sd.lba * 512, SEEK_SET);
+					int bytes_written = SDL_RWwrite(sdcard_file, sd.rxbuf + 1, 1, 512);
+					SDL_AtomicUnlock(&sdcard_lock);
+					if (bytes_written != 512) {
+						printf("Warning: short write!\n");
+					}
+					// the frames run ahead read what was there before
+					runahead_invalidate();
+					lockstep_invalidate();
 				}
 			}
 		}
@@ -7,8 +7,29 @@
 #include <stdbool.h>
 #include <SDL.h>
 
+typedef struct {
+	bool attached;
+
+	uint8_t rxbuf[3 + 512];
+	int rxbuf_idx;
+	uint32_t lba;
+	uint8_t last_cmd;
+	bool is_acmd;
+	bool is_idle;
+	bool is_initialized;
+
+	bool has_response;
+	int response_length;
+	int response_counter;
+	uint8_t response[2 + 512 + 2];
+
+	bool selected;
+} sdcard_state_t;
+
+// the image is shared by all machines
 extern SDL_RWops *sdcard_file;
-extern bool sdcard_attached;
+
+void sdcard_init();
 
 void sdcard_attach();
 void sdcard_detach();
@@ -0,0 +1,125 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# A small two-pass 65C02 assembler for the test ROMs, using the opcode
+# tables the CPU core is generated from.
+
+import os
+
+CPU_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'cpu')
+
+OPCODES = {}
+for name in ('6502.opcodes', '65c02.opcodes'):
+    for line in open(os.path.join(CPU_DIR, name)):
+        line = line.split(';')[0].strip()
+        if line:
+            mnemonic, mode, cycles, opcode = line.split()
+            OPCODES[(mnemonic, mode)] = int(opcode[1:], 16)
+
+LENGTH = {
+    'imp': 1, 'acc': 1, 'imm': 2, 'zp': 2, 'zpx': 2, 'zpy': 2, 'rel': 2, 'indx': 2, 'indy': 2,
+    'ind0': 2, 'abso': 3, 'absx': 3, 'absy': 3, 'ind': 3, 'ainx': 3, 'zprel': 3,
+}
+
+# where the test ROMs print and end, see image()
+CHROUT = 0xffd2
+EXIT = 0xffff
+
+
+class Asm:
+    """Code at org. Operands are numbers or labels; A('lda', 'imm', 1)."""
+
+    def __init__(self, org=0xc000):
+        self.org = org
+        self.items = []
+        self.labels = {}
+
+    def __call__(self, mnemonic, mode='imp', operand=None, target=None):
+        assert (mnemonic, mode) in OPCODES, (mnemonic, mode)
+        self.items.append(('op', mnemonic, mode, operand, target))
+
+    def label(self, name):
+        self.items.append(('label', name))
+
+    def byte(self, *values):
+        self.items.append(('bytes', list(values)))
+
+    def word(self, value):
+        self.items.append(('word', value))
+
+    def value(self, operand, final):
+        if isinstance(operand, str):
+            return self.labels[operand] if final else 0
+        return operand or 0
+
+    def assemble(self):
+        for final in (False, True):
+            pc = self.org
+            code = bytearray()
+            for item in self.items:
+                if item[0] == 'label':
+                    self.labels[item[1]] = pc
+                    continue
+                if item[0] == 'bytes':
+                    data = bytes(item[1])
+                elif item[0] == 'word':
+                    v = self.value(item[1], final)
+                    data = bytes([v & 0xff, v >> 8])
+                else:
+                    _, mnemonic, mode, operand, target = item
+                    v = self.value(operand, final)
+                    data = bytearray([OPCODES[(mnemonic, mode)]])
+                    if mode == 'rel':
+                        offset = v - (pc + 2) if final else 0
+                        assert -128 <= offset < 128, (mnemonic, operand)
+                        data.append(offset & 0xff)
+                    elif mode == 'zprel':
+                        offset = self.value(target, final) - (pc + 3) if final else 0
+                        assert -128 <= offset < 128, (mnemonic, target)
+                        data += bytes([v & 0xff, offset & 0xff])
+                    elif LENGTH[mode] == 2:
+                        data.append(v & 0xff)
+                    elif LENGTH[mode] == 3:
+                        data += bytes([v & 0xff, (v >> 8) & 0xff])
+                code += data
+                pc += len(data)
+        return bytes(code)
+
+    def print_hex(self):
+        """PRHEX: prints A as two hex digits."""
+        self.label('PRHEX')
+        self('pha')
+        for i in range(4):
+            self('lsr', 'acc')
+        self('jsr', 'abso', 'NIBBLE')
+        self('pla')
+        self('and', 'imm', 0x0f)
+        self.label('NIBBLE')
+        self('cmp', 'imm', 10)
+        self('bcc', 'rel', 'DIGIT')
+        self('adc', 'imm', 6)
+        self.label('DIGIT')
+        self('adc', 'imm', 0x30)
+        self('jsr', 'abso', CHROUT)
+        self('rts')
+
+
+def image(asm, reset='RESET', irq='IRQ', nmi='NMI', fill=0xea):
+    """The code in every ROM bank, with the vectors, an RTS at $FFD2 and
+    $FFCF and the KERNAL's signature, so -echo prints what goes to $FFD2.
+    The program ends by jumping to $FFFF."""
+    code = asm.assemble()
+    assert len(code) < 0x3f00, len(code)
+    rom = bytearray([fill]) * (8 * 16384)
+    for bank in range(8):
+        base = bank * 16384
+        rom[base:base + len(code)] = code
+        rom[base + 0x3fd2] = 0x60
+        rom[base + 0x3fcf] = 0x60
+        rom[base + 0x3ff6:base + 0x3ffa] = b'MIST'
+        for vector, name in ((0x3ffa, nmi), (0x3ffc, reset), (0x3ffe, irq)):
+            v = asm.labels[name]
+            rom[base + vector] = v & 0xff
+            rom[base + vector + 1] = v >> 8
+    return bytes(rom)
@@ -0,0 +1,130 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Times the CPU cores on two loops that keep the CPU busy with the VERA IRQs
+# off: a memory copy through (zp),Y and a CRC-16, which mostly updates and
+# tests flags. Prints how many emulated MHz every core runs at, the best of
+# a few runs, each minus the time the emulator takes to start and quit.
+# With several emulators, e.g. builds with different options, they are
+# timed on the same loops.
+#
+#     python tests/bench.py [x16emu...]
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+sys.dont_write_bytecode = True
+
+from asm import Asm, CHROUT, EXIT, image
+
+MODES = [
+    [],
+    ['-blockcache'],
+    ['-jit'],
+]
+
+RUNS = 5
+SRC, DST, COUNT, CRC = 0x10, 0x12, 0x14, 0x16
+ROUNDS = 0x0400  # times each loop runs
+
+
+def program(body):
+    """Runs body ROUNDS times and prints the emulator's cycle counter."""
+    A = Asm()
+    A.label('RESET')
+    A('sei'); A('cld'); A('ldx', 'imm', 0xff); A('txs')
+    A('lda', 'imm', ROUNDS & 0xff); A('sta', 'zp', COUNT); A('lda', 'imm', ROUNDS >> 8); A('sta', 'zp', COUNT + 1)
+    A.label('ROUND')
+    body(A)
+    A('lda', 'zp', COUNT); A('bne', 'rel', 'dec1'); A('dec', 'zp', COUNT + 1)
+    A.label('dec1'); A('dec', 'zp', COUNT)
+    A('lda', 'zp', COUNT); A('ora', 'zp', COUNT + 1); A('beq', 'rel', 'done'); A('jmp', 'abso', 'ROUND')
+    A.label('done')
+    for r in (0x9fbb, 0x9fba, 0x9fb9, 0x9fb8):
+        A('lda', 'abso', r); A('jsr', 'abso', 'PRHEX')
+    A('lda', 'imm', 13); A('jsr', 'abso', CHROUT)
+    A('jmp', 'abso', EXIT)
+    A.print_hex()
+    A.label('IRQ'); A.label('NMI'); A('rti')
+    return image(A)
+
+
+def copy(A):
+    """$1000-$2FFF to $3000-$4FFF"""
+    A('lda', 'imm', 0); A('sta', 'zp', SRC); A('sta', 'zp', DST)
+    A('lda', 'imm', 0x10); A('sta', 'zp', SRC + 1); A('lda', 'imm', 0x30); A('sta', 'zp', DST + 1)
+    A('ldx', 'imm', 32); A('ldy', 'imm', 0)
+    A.label('copy')
+    A('lda', 'indy', SRC); A('sta', 'indy', DST); A('iny'); A('bne', 'rel', 'copy')
+    A('inc', 'zp', SRC + 1); A('inc', 'zp', DST + 1); A('dex'); A('bne', 'rel', 'copy')
+
+
+def crc(A):
+    """CRC-16/XMODEM of $1000-$13FF"""
+    A('lda', 'imm', 0); A('sta', 'zp', SRC); A('sta', 'zp', CRC); A('sta', 'zp', CRC + 1)
+    A('lda', 'imm', 0x10); A('sta', 'zp', SRC + 1)
+    A('ldy', 'imm', 0)
+    A.label('byte')
+    A('lda', 'indy', SRC); A('eor', 'zp', CRC + 1); A('sta', 'zp', CRC + 1)
+    A('ldx', 'imm', 8)
+    A.label('bit')
+    A('asl', 'zp', CRC); A('rol', 'zp', CRC + 1); A('bcc', 'rel', 'next')
+    A('lda', 'zp', CRC + 1); A('eor', 'imm', 0x10); A('sta', 'zp', CRC + 1)
+    A('lda', 'zp', CRC); A('eor', 'imm', 0x21); A('sta', 'zp', CRC)
+    A.label('next')
+    A('dex'); A('bne', 'rel', 'bit')
+    A('iny'); A('bne', 'rel', 'byte')
+    A('inc', 'zp', SRC + 1); A('lda', 'zp', SRC + 1); A('cmp', 'imm', 0x14); A('bne', 'rel', 'byte')
+
+
+LOOPS = [('copy', copy), ('crc', crc)]
+
+
+def idle(A):
+    pass
+
+
+def run(emulator, rom, mode, directory):
+    """Seconds the run took and the cycles the program printed."""
+    start = time.perf_counter()
+    result = subprocess.run([emulator, '-rom', rom, '-headless', '-warp', '-echo'] + mode,
+                            cwd=directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    seconds = time.perf_counter() - start
+    for line in result.stdout.decode('latin-1').splitlines():
+        line = line.strip()
+        if len(line) == 8:
+            return seconds, int(line, 16)
+    sys.exit('%s %s: no cycle count' % (emulator, ' '.join(mode)))
+
+
+def best(emulator, rom, mode, directory):
+    return min(run(emulator, rom, mode, directory) for i in range(RUNS))
+
+
+def main():
+    emulators = [os.path.abspath(e) for e in sys.argv[1:]] or [os.path.abspath('x16emu')]
+    with tempfile.TemporaryDirectory() as directory:
+        roms = {}
+        for name, body in LOOPS + [('idle', idle)]:
+            roms[name] = os.path.join(directory, name + '.bin')
+            with open(roms[name], 'wb') as f:
+                f.write(program(body))
+        for emulator in emulators:
+            if len(emulators) > 1:
+                print(emulator)
+            for mode in MODES:
+                overhead, _ = best(emulator, roms['idle'], mode, directory)
+                results = []
+                for name, body in LOOPS:
+                    seconds, cycles = best(emulator, roms[name], mode, directory)
+                    results.append('%s %7.1f MHz' % (name, cycles / max(seconds - overhead, 1e-3) / 1e6))
+                print('%-12s %s' % (' '.join(mode) or 'interpreter', '   '.join(results)))
+
+
+if __name__ == '__main__':
+    main()
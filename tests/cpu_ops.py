@@ -0,0 +1,139 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Runs pseudo-random operands through every kind of instruction the block
+# cache and the JIT translate, including decimal mode, page crossing,
+# self-modifying code, banked RAM and a loop that jumps back into its own
+# block, while the VSYNC IRQ samples the registers and the return address,
+# and WAI waits for it. Prints a checksum of the results, the number of
+# IRQs and the clock from the emulator's cycle counter registers.
+
+from asm import Asm, CHROUT, EXIT, image
+
+CK, SEED, OP1, OP2, PTR, IRQS, COUNT, TMP = 0x10, 0x20, 0x30, 0x31, 0x40, 0x50, 0x52, 0x60
+LOOPS = 8
+
+OUTPUT = 'F2BBF05959 00B5422B'
+
+
+def rom():
+    A = Asm()
+    A.label('RESET')
+    A('sei'); A('cld'); A('ldx', 'imm', 0xff); A('txs')
+    A('lda', 'imm', 0)
+    for z in (CK, CK + 1, CK + 2, CK + 3, IRQS, COUNT, COUNT + 1):
+        A('sta', 'zp', z)
+    A('lda', 'imm', 0x5a); A('sta', 'zp', SEED); A('lda', 'imm', 0xc3); A('sta', 'zp', SEED + 1)
+    A('ldx', 'imm', 0)
+    A.label('copy'); A('lda', 'absx', 'SMC'); A('sta', 'absx', 0x0400); A('inx'); A('cpx', 'imm', 16); A('bne', 'rel', 'copy')
+    A('lda', 'imm', 1); A('sta', 'abso', 0x9f26)
+    A('cli')
+    A.label('MAIN')
+    A('jsr', 'abso', 'BODY')
+    A('inc', 'zp', COUNT); A('bne', 'rel', 'MAIN')
+    A('lda', 'zp', IRQS)
+    A.label('poll'); A('cmp', 'zp', IRQS); A('beq', 'rel', 'poll')
+    A('wai')
+    A('inc', 'zp', COUNT + 1); A('lda', 'zp', COUNT + 1); A('cmp', 'imm', LOOPS); A('bne', 'rel', 'MAIN')
+    A('sei')
+    for z in (CK, CK + 1, CK + 2, CK + 3, IRQS):
+        A('lda', 'zp', z); A('jsr', 'abso', 'PRHEX')
+    A('lda', 'imm', 0x20); A('jsr', 'abso', CHROUT)
+    for r in (0x9fbb, 0x9fba, 0x9fb9, 0x9fb8):
+        A('lda', 'abso', r); A('jsr', 'abso', 'PRHEX')
+    A('lda', 'imm', 13); A('jsr', 'abso', CHROUT)
+    A('jmp', 'abso', EXIT)
+    A.print_hex()
+
+    A.label('RNG')
+    A('lda', 'zp', SEED); A('asl', 'acc'); A('rol', 'zp', SEED + 1); A('bcc', 'rel', 'rng1'); A('eor', 'imm', 0x2d)
+    A.label('rng1'); A('sta', 'zp', SEED); A('eor', 'zp', SEED + 1); A('rts')
+
+    # mixes A, then the flags, into the checksum
+    A.label('MIXF'); A('php'); A('jsr', 'abso', 'MIX'); A('pla'); A('jsr', 'abso', 'MIX'); A('rts')
+    A.label('MIX')
+    A('eor', 'zp', CK); A('sta', 'zp', CK); A('clc'); A('adc', 'zp', CK + 1); A('sta', 'zp', CK + 1); A('rol', 'zp', CK + 2)
+    A('lda', 'zp', CK + 2); A('adc', 'zp', CK + 3); A('sta', 'zp', CK + 3)
+    A('lda', 'zp', CK); A('asl', 'acc'); A('adc', 'imm', 0); A('sta', 'zp', CK); A('rts')
+
+    A.label('BODY')
+    A('jsr', 'abso', 'RNG'); A('sta', 'zp', OP1); A('jsr', 'abso', 'RNG'); A('sta', 'zp', OP2)
+    # binary
+    A('lda', 'zp', OP1); A('lsr', 'acc'); A('lda', 'zp', OP1); A('adc', 'zp', OP2); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP2); A('lsr', 'acc'); A('lda', 'zp', OP1); A('sbc', 'zp', OP2); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP1); A('clc'); A('adc', 'imm', 0x7f); A('bvc', 'rel', 'nv'); A('inc', 'zp', CK + 3)
+    A.label('nv'); A('bcc', 'rel', 'nc'); A('inc', 'zp', CK + 2)
+    A.label('nc'); A('bmi', 'rel', 'nm'); A('inc', 'zp', CK + 1)
+    A.label('nm'); A('bne', 'rel', 'nz'); A('inc', 'zp', CK)
+    A.label('nz')
+    # decimal
+    A('sed'); A('lda', 'zp', OP1); A('lsr', 'acc'); A('lda', 'zp', OP1); A('adc', 'zp', OP2); A('php'); A('cld')
+    A('jsr', 'abso', 'MIX'); A('pla'); A('jsr', 'abso', 'MIX')
+    A('sed'); A('lda', 'zp', OP2); A('lsr', 'acc'); A('lda', 'zp', OP1); A('sbc', 'zp', OP2); A('php'); A('cld')
+    A('jsr', 'abso', 'MIX'); A('pla'); A('jsr', 'abso', 'MIX')
+    # compares and BIT
+    A('lda', 'zp', OP1); A('cmp', 'zp', OP2); A('jsr', 'abso', 'MIXF')
+    A('ldx', 'zp', OP1); A('cpx', 'zp', OP2); A('txa'); A('jsr', 'abso', 'MIXF')
+    A('ldy', 'zp', OP2); A('cpy', 'zp', OP1); A('tya'); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP1); A('bit', 'zp', OP2); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP1); A('bit', 'imm', 0xc1); A('jsr', 'abso', 'MIXF')
+    # indexed read-modify-write, crossing pages
+    A('ldx', 'zp', OP1); A('lda', 'zp', OP2); A('sta', 'absx', 0x02f0)
+    A('asl', 'absx', 0x02f0); A('rol', 'absx', 0x02f0); A('lda', 'absx', 0x02f0); A('jsr', 'abso', 'MIXF')
+    A('ldx', 'zp', OP1); A('lsr', 'absx', 0x02f0); A('ror', 'absx', 0x02f0); A('inc', 'absx', 0x02f0)
+    A('lda', 'absx', 0x02f0); A('jsr', 'abso', 'MIXF')
+    A('ldy', 'zp', OP2); A('lda', 'absy', 0x02f0); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP1); A('asl', 'acc'); A('rol', 'acc'); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP2); A('lsr', 'acc'); A('ror', 'acc'); A('inc', 'acc'); A('dec', 'acc'); A('jsr', 'abso', 'MIXF')
+    # indirect
+    A('lda', 'imm', 0xf0); A('sta', 'zp', PTR); A('lda', 'imm', 0x02); A('sta', 'zp', PTR + 1)
+    A('ldy', 'zp', OP2); A('lda', 'indy', PTR); A('jsr', 'abso', 'MIXF')
+    A('ldx', 'imm', 0); A('lda', 'indx', PTR); A('jsr', 'abso', 'MIX')
+    A('lda', 'ind0', PTR); A('jsr', 'abso', 'MIX')
+    A('ldy', 'zp', OP1); A('lda', 'zp', OP2); A('sta', 'indy', PTR)
+    # bit instructions of the 65C02
+    A('lda', 'zp', OP1); A('sta', 'zp', TMP); A('lda', 'zp', OP2); A('tsb', 'zp', TMP); A('jsr', 'abso', 'MIXF')
+    A('lda', 'zp', OP1); A('trb', 'zp', TMP); A('lda', 'zp', TMP); A('jsr', 'abso', 'MIX')
+    A('smb3', 'zp', TMP); A('rmb5', 'zp', TMP); A('lda', 'zp', TMP); A('jsr', 'abso', 'MIX')
+    A('bbr0', 'zprel', TMP, 'bb1'); A('inc', 'zp', CK)
+    A.label('bb1'); A('bbs7', 'zprel', TMP, 'bb2'); A('inc', 'zp', CK + 1)
+    A.label('bb2')
+    # self-modifying code
+    A('lda', 'zp', OP1); A('sta', 'abso', 0x0401); A('lda', 'zp', OP2); A('lsr', 'acc'); A('jsr', 'abso', 0x0400)
+    A('jsr', 'abso', 'MIXF')
+    # indirect jumps
+    A('lda', 'zp', OP1); A('and', 'imm', 2); A('tax'); A('jmp', 'ainx', 'JUMPS')
+    A.label('j0'); A('lda', 'imm', 0x11); A('jmp', 'ind', 'VECTOR')
+    A.label('j1'); A('lda', 'imm', 0x22); A('jmp', 'ind', 'VECTOR')
+    A.label('jb'); A('jsr', 'abso', 'MIX')
+    # banked RAM
+    A('lda', 'zp', OP1); A('and', 'imm', 7); A('sta', 'abso', 0x9f61); A('lda', 'zp', OP2); A('sta', 'abso', 0xa123)
+    A('lda', 'zp', OP1); A('and', 'imm', 7); A('eor', 'imm', 1); A('sta', 'abso', 0x9f61)
+    A('lda', 'abso', 0xa123); A('jsr', 'abso', 'MIX')
+    A('lda', 'abso', 0x9f61); A('jsr', 'abso', 'MIX')
+    # stack
+    A('ldx', 'zp', OP1); A('ldy', 'zp', OP2); A('phx'); A('phy'); A('plx'); A('ply')
+    A('txa'); A('jsr', 'abso', 'MIX'); A('tya'); A('jsr', 'abso', 'MIX')
+    A('lda', 'zp', OP1); A('pha'); A('plp'); A('php'); A('pla'); A('cld'); A('cli'); A('jsr', 'abso', 'MIX')
+    # a block that loops back to itself
+    A('ldx', 'zp', OP1); A('ldy', 'imm', 0)
+    A.label('loop'); A('lda', 'absx', 0x0200); A('sta', 'absy', 0x0300); A('iny'); A('dex'); A('bne', 'rel', 'loop')
+    A('lda', 'abso', 0x0310); A('jsr', 'abso', 'MIX')
+    A('rts')
+
+    A.label('JUMPS'); A.word('j0'); A.word('j1')
+    A.label('VECTOR'); A.word('jb')
+    # copied to $0400: lda #xx; sta $0406; adc #00; rts
+    A.label('SMC'); A.byte(0xa9, 0x00, 0x8d, 0x06, 0x04, 0x69, 0x00, 0x60)
+
+    A.label('IRQ')
+    A('pha'); A('phx')
+    A('lda', 'abso', 0x9f27); A('and', 'imm', 1); A('beq', 'rel', 'irq1'); A('sta', 'abso', 0x9f27)
+    A('inc', 'zp', IRQS); A('lda', 'zp', COUNT); A('eor', 'zp', CK + 3); A('sta', 'zp', CK + 3)
+    A('tsx'); A('lda', 'absx', 0x0104); A('eor', 'zp', CK + 2); A('sta', 'zp', CK + 2)  # return address
+    A('lda', 'absx', 0x0103); A('eor', 'zp', CK + 1); A('sta', 'zp', CK + 1)  # flags
+    A.label('irq1')
+    A('plx'); A('pla'); A('rti')
+    A.label('NMI'); A('rti')
+    return image(A)
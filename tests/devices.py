@@ -0,0 +1,78 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Keeps VERA, the PSG, PCM and the YM2151 busy for 200 frames: fills VRAM,
+# moves sprites, plays a note and a stream of PCM samples and changes them
+# every frame, counting the frames in the VSYNC IRQ. The CPU sleeps in an
+# idle loop in between. Prints a letter every eight frames.
+
+from asm import Asm, CHROUT, EXIT, image
+
+FRAMES, LAST, COUNT = 0x20, 0x21, 0x22
+
+OUTPUT = 'H@H@H@H@H@H@H@H@H@H@H@H@H'
+
+
+def vera_address(A, address, increment):
+    A('lda', 'imm', address & 0xff); A('sta', 'abso', 0x9f20)
+    A('lda', 'imm', (address >> 8) & 0xff); A('sta', 'abso', 0x9f21)
+    A('lda', 'imm', increment << 4 | address >> 16); A('sta', 'abso', 0x9f22)
+
+
+def rom():
+    A = Asm()
+    A.label('RESET')
+    A('sei'); A('ldx', 'imm', 0xff); A('txs')
+    A('lda', 'imm', 0); A('sta', 'abso', 0x9f25)
+    A('lda', 'imm', 0); A('sta', 'abso', 0x9f20); A('sta', 'abso', 0x9f21)
+    A('lda', 'imm', 0x10); A('sta', 'abso', 0x9f22)
+    A('ldx', 'imm', 0)
+    A.label('fill'); A('txa'); A('sta', 'abso', 0x9f23); A('inx'); A('bne', 'rel', 'fill')
+    # two sprites
+    vera_address(A, 0x1fc00, 1)
+    for v in (0x00, 0x00, 0x10, 0x00, 0x10, 0x00, 0x0c, 0x50,
+              0x00, 0x00, 0x14, 0x00, 0x14, 0x00, 0x0c, 0x50):
+        A('lda', 'imm', v); A('sta', 'abso', 0x9f23)
+    A('lda', 'imm', 0x71); A('sta', 'abso', 0x9f29)  # sprites, layers, VGA
+    A('lda', 'imm', 0x60); A('sta', 'abso', 0x9f2d)
+    A('lda', 'imm', 0x05); A('sta', 'abso', 0x9f26)  # VSYNC and sprite collision IRQs
+    # PSG voice 0
+    vera_address(A, 0x1f9c0, 1)
+    for v in (0x00, 0x10, 0xff, 0x3f):
+        A('lda', 'imm', v); A('sta', 'abso', 0x9f23)
+    # YM2151 note on channel 0
+    for r, v in ((0x20, 0xc7), (0x28, 0x4a), (0x60, 0x10), (0x80, 0x1f), (0xe0, 0x0f),
+                 (0x08, 0x78), (0x0f, 0x85), (0x18, 0x40), (0x1b, 0x02)):
+        A('lda', 'imm', r); A('sta', 'abso', 0x9fe0); A('lda', 'imm', v); A('sta', 'abso', 0x9fe1)
+    # PCM
+    A('lda', 'imm', 0x0f); A('sta', 'abso', 0x9f3b); A('lda', 'imm', 0x20); A('sta', 'abso', 0x9f3c)
+    A('ldx', 'imm', 0)
+    A.label('pcm'); A('txa'); A('sta', 'abso', 0x9f3d); A('inx'); A('bne', 'rel', 'pcm')
+    A('lda', 'imm', 0); A('sta', 'zp', FRAMES); A('sta', 'zp', LAST); A('sta', 'zp', COUNT)
+    A('cli'); A('jsr', 'abso', 0xffcf)
+
+    A.label('MAIN')
+    A('lda', 'zp', FRAMES); A('cmp', 'zp', LAST); A('beq', 'rel', 'MAIN')
+    A('sta', 'zp', LAST)
+    A('inc', 'zp', COUNT)
+    A('lda', 'zp', COUNT); A('and', 'imm', 7); A('bne', 'rel', 'quiet')
+    A('lda', 'zp', FRAMES); A('and', 'imm', 0x0f); A('ora', 'imm', 0x40); A('jsr', 'abso', CHROUT)
+    A.label('quiet')
+    A('lda', 'imm', 0x28); A('sta', 'abso', 0x9fe0); A('lda', 'zp', FRAMES); A('sta', 'abso', 0x9fe1)
+    A('lda', 'imm', 0x08); A('sta', 'abso', 0x9fe0); A('lda', 'zp', FRAMES); A('and', 'imm', 1); A('beq', 'rel', 'off')
+    A('lda', 'imm', 0x78)
+    A.label('off'); A('sta', 'abso', 0x9fe1)
+    vera_address(A, 0x1fc02, 0)
+    A('lda', 'zp', FRAMES); A('sta', 'abso', 0x9f23)
+    A('ldx', 'imm', 0x40)
+    A.label('pcm2'); A('txa'); A('eor', 'zp', FRAMES); A('sta', 'abso', 0x9f3d); A('dex'); A('bne', 'rel', 'pcm2')
+    A('lda', 'zp', FRAMES); A('cmp', 'imm', 200); A('bne', 'rel', 'MAIN')
+    A('lda', 'imm', 13); A('jsr', 'abso', CHROUT)
+    A('jmp', 'abso', EXIT)
+
+    A.label('IRQ')
+    A('pha'); A('lda', 'abso', 0x9f27); A('sta', 'abso', 0x9f27); A('and', 'imm', 1); A('beq', 'rel', 'irq1')
+    A('inc', 'zp', FRAMES)
+    A.label('irq1'); A('pla'); A('rti')
+    return image(A, nmi='IRQ', fill=0xff)
@@ -0,0 +1,59 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Measures 600 VGA frames with the emulator's cycle counter: the VSYNC IRQ
+# wakes the CPU from WAI and reads the counter right away, so the reads
+# are a fixed number of cycles after the end of the frame. A frame is 525
+# lines of 800 pixels at 25.175 MHz, the CPU runs at 8 MHz, so 600 of them
+# take 80079443.9 cycles; the frames in between have to add up to that
+# within a cycle.
+
+from asm import Asm, CHROUT, EXIT, image
+
+FRAMES = 600
+CYCLES = FRAMES * 525 * 800 * 8000 / 25175
+
+NOW, START, COUNT = 0x10, 0x14, 0x18
+
+OUTPUT = '%08X' % round(CYCLES)
+
+
+def rom():
+    A = Asm()
+    A.label('RESET')
+    A('sei'); A('cld'); A('ldx', 'imm', 0xff); A('txs')
+    A('lda', 'imm', 0); A('sta', 'zp', COUNT); A('sta', 'zp', COUNT + 1)
+    A('lda', 'imm', 1); A('sta', 'abso', 0x9f26)  # VSYNC IRQ
+    A('cli')
+    A.label('WAIT')
+    A('wai')
+    A('lda', 'zp', COUNT + 1); A('bne', 'rel', 'later')
+    A('lda', 'zp', COUNT); A('cmp', 'imm', 1); A('bne', 'rel', 'WAIT')
+    for i in range(4):
+        A('lda', 'zp', NOW + i); A('sta', 'zp', START + i)
+    A('jmp', 'abso', 'WAIT')
+    A.label('later')
+    A('cmp', 'imm', (FRAMES + 1) >> 8); A('bne', 'rel', 'WAIT')
+    A('lda', 'zp', COUNT); A('cmp', 'imm', (FRAMES + 1) & 0xff); A('bne', 'rel', 'WAIT')
+    A('sei')
+    A('sec')
+    for i in range(4):
+        A('lda', 'zp', NOW + i); A('sbc', 'zp', START + i); A('sta', 'zp', NOW + i)
+    for i in reversed(range(4)):
+        A('lda', 'zp', NOW + i); A('jsr', 'abso', 'PRHEX')
+    A('lda', 'imm', 13); A('jsr', 'abso', CHROUT)
+    A('jmp', 'abso', EXIT)
+    A.print_hex()
+
+    A.label('IRQ')
+    A('pha')
+    for i in range(4):
+        A('lda', 'abso', 0x9fb8 + i); A('sta', 'zp', NOW + i)
+    A('lda', 'imm', 1); A('sta', 'abso', 0x9f27)
+    A('inc', 'zp', COUNT); A('bne', 'rel', 'irq1'); A('inc', 'zp', COUNT + 1)
+    A.label('irq1')
+    A('pla')
+    A.label('NMI')
+    A('rti')
+    return image(A)
@@ -0,0 +1,42 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Polls the VSYNC flag in ISR with LDA $9EF7,X, which crosses a page and
+# so takes an extra cycle, and counts the polls it takes for 250 frames,
+# starting a cycle later every frame. VERA has to see the access at the
+# clock the instruction started at in every CPU core, or the counts
+# differ.
+
+from asm import Asm, CHROUT, EXIT, image
+
+SUM, PHASE, FRAMES = 0x10, 0x14, 0x15
+
+OUTPUT = '7BE7'
+
+
+def rom():
+    A = Asm()
+    A.label('RESET')
+    A('sei'); A('cld'); A('ldx', 'imm', 0xff); A('txs')
+    A('lda', 'imm', 0)
+    for z in (SUM, SUM + 1, PHASE, FRAMES):
+        A('sta', 'zp', z)
+    A('lda', 'imm', 1); A('sta', 'abso', 0x9f26)  # VSYNC, not taken with I set
+    A('lda', 'imm', 1); A('sta', 'abso', 0x9f27)
+    A.label('MAIN')
+    A('ldx', 'imm', 0x30); A('ldy', 'imm', 0)
+    A.label('poll'); A('iny'); A('lda', 'absx', 0x9f27 - 0x30); A('and', 'imm', 1); A('beq', 'rel', 'poll')
+    A('sta', 'abso', 0x9f27)
+    A('tya'); A('clc'); A('adc', 'zp', SUM); A('sta', 'zp', SUM)
+    A('lda', 'zp', SUM + 1); A('rol', 'acc'); A('eor', 'zp', SUM); A('sta', 'zp', SUM + 1)
+    A('ldx', 'zp', PHASE)
+    A.label('delay'); A('dex'); A('bne', 'rel', 'delay')
+    A('inc', 'zp', PHASE)
+    A('inc', 'zp', FRAMES); A('lda', 'zp', FRAMES); A('cmp', 'imm', 250); A('bne', 'rel', 'MAIN')
+    A('lda', 'zp', SUM + 1); A('jsr', 'abso', 'PRHEX'); A('lda', 'zp', SUM); A('jsr', 'abso', 'PRHEX')
+    A('lda', 'imm', 13); A('jsr', 'abso', CHROUT)
+    A('jmp', 'abso', EXIT)
+    A.print_hex()
+    A.label('IRQ'); A.label('NMI'); A('rti')
+    return image(A)
@@ -0,0 +1,94 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+// ps2_step() skips the clocks a bit is held on the lines and stops once the
+// port is idle. This runs two machines through the same pseudo-random
+// sequence of bytes, host line changes and clock counts: one steps each
+// count at once, the other a clock at a time. After every step, the ports
+// have to be in the same state.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../machine.h"
+
+#define STEPS 200000
+
+THREAD_LOCAL machine_t *machine;
+
+static uint32_t seed = 0x2545f491;
+
+static uint32_t
+random32()
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static bool
+same_port(const ps2_state_t *a, const ps2_state_t *b, int i)
+{
+	return a->port[i].clk_out == b->port[i].clk_out &&
+		a->port[i].data_out == b->port[i].data_out &&
+		a->state[i].sending == b->state[i].sending &&
+		a->state[i].has_byte == b->state[i].has_byte &&
+		a->state[i].current_byte == b->state[i].current_byte &&
+		a->state[i].bit_index == b->state[i].bit_index &&
+		a->state[i].send_state == b->state[i].send_state &&
+		a->state[i].buffer.read == b->state[i].buffer.read &&
+		a->state[i].buffer.write == b->state[i].buffer.write;
+}
+
+int
+main()
+{
+	machine_t *bulk = calloc(1, sizeof(machine_t));
+	machine_t *single = calloc(1, sizeof(machine_t));
+	machine_t *both[2] = { bulk, single };
+	if (!bulk || !single) {
+		return 1;
+	}
+	for (int m = 0; m < 2; m++) {
+		for (int i = 0; i < 2; i++) {
+			both[m]->ps2.port[i].clk_in = 1;
+			both[m]->ps2.port[i].data_in = 1;
+		}
+	}
+
+	for (int step = 0; step < STEPS; step++) {
+		int i = random32() & 1;
+		uint32_t r = random32();
+
+		// mostly let the port send, sometimes inhibit it or pull the data line
+		int clk_in = (r & 15) != 0;
+		int data_in = (r & 0x70) != 0;
+		bool add = (r & 0x380) == 0;
+		uint8_t byte = r >> 10;
+		// from a single clock to a few bits
+		uint32_t clocks = (r >> 18) % 3 == 0 ? 1 + (r >> 20) % 8 : 1 + (r >> 20) % 2000;
+
+		for (int m = 0; m < 2; m++) {
+			machine = both[m];
+			machine->ps2.port[i].clk_in = clk_in;
+			machine->ps2.port[i].data_in = data_in;
+			if (add && ps2_buffer_can_fit(i, 1)) {
+				ps2_buffer_add(i, byte);
+			}
+		}
+		machine = bulk;
+		ps2_step(i, clocks);
+		machine = single;
+		for (uint32_t c = 0; c < clocks; c++) {
+			ps2_step(i, 1);
+		}
+
+		if (!same_port(&bulk->ps2, &single->ps2, i)) {
+			printf("FAIL ps2_step: port %d differs after step %d (%u clocks)\n", i, step, clocks);
+			return 1;
+		}
+	}
+	printf("ok   ps2_step\n");
+	return 0;
+}
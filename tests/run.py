@@ -0,0 +1,82 @@
+# Commander X16 Emulator
+# Copyright (c) 2019 Michael Steil
+# All rights reserved. License: 2-clause BSD
+#
+# Runs the test ROMs headless with every CPU core and with -lockstep, which
+# compares the fast paths against the reference machine every frame. Each
+# run has to print what the test expects, and every -lockstep run has to
+# end without a difference.
+#
+#     python tests/run.py [x16emu] [test...]
+
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+sys.dont_write_bytecode = True
+
+TESTS = ['cpu_ops', 'devices', 'frame_timing', 'isr_poll']
+
+MODES = [
+    [],
+    ['-blockcache'],
+    ['-jit'],
+    ['-lockstep', '1'],
+    ['-lockstep', '1', '-blockcache'],
+    ['-lockstep', '1', '-jit'],
+]
+
+TIMEOUT = 120  # seconds
+
+
+def run(emulator, rom, mode, directory):
+    """The ROM's output and the lockstep result, or None for either."""
+    try:
+        result = subprocess.run([emulator, '-rom', rom, '-headless', '-warp', '-echo'] + mode,
+                                cwd=directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                timeout=TIMEOUT)
+    except subprocess.TimeoutExpired:
+        return None, None
+    output = []
+    lockstep = None
+    for line in result.stdout.decode('latin-1').splitlines():
+        if line.startswith('Lockstep:'):
+            lockstep = line
+        elif not line.startswith('Dumped system'):
+            output.append(line.rstrip())
+    return '\n'.join(output).strip(), lockstep
+
+
+def main():
+    emulator = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else 'x16emu')
+    tests = sys.argv[2:] or TESTS
+    failed = 0
+    with tempfile.TemporaryDirectory() as directory:
+        for name in tests:
+            test = __import__(name)
+            rom = os.path.join(directory, name + '.bin')
+            with open(rom, 'wb') as f:
+                f.write(test.rom())
+            for mode in MODES:
+                output, lockstep = run(emulator, rom, mode, directory)
+                label = ' '.join([name] + mode)
+                if output is None:
+                    print('FAIL %s: timed out' % label)
+                    failed += 1
+                elif output != test.OUTPUT:
+                    print('FAIL %s: %r, expected %r' % (label, output, test.OUTPUT))
+                    failed += 1
+                elif '-lockstep' in mode and (not lockstep or 'no differences' not in lockstep):
+                    print('FAIL %s: %s' % (label, lockstep or 'no lockstep result'))
+                    failed += 1
+                else:
+                    print('ok   %s' % label)
+    if failed:
+        print('%d failed' % failed)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
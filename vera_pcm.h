@@ -7,6 +7,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+typedef struct {
+	uint8_t  fifo[4096 - 1]; // Actual hardware FIFO is 4kB, but you can only use 4095 bytes.
+	unsigned fifo_wridx;
+	unsigned fifo_rdidx;
+	unsigned fifo_cnt;
+
+	uint8_t ctrl;
+	uint8_t rate;
+
+	int16_t cur_l, cur_r;
+	uint8_t phase;
+} pcm_state_t;
+
 void    pcm_reset(void);
 void    pcm_write_ctrl(uint8_t val);
 uint8_t pcm_read_ctrl(void);
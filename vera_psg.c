@@ -3,6 +3,7 @@
 // All rights reserved. License: 2-clause BSD
 
 #include "vera_psg.h"
+#include "machine.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -15,25 +16,15 @@ enum waveform {
 	WF_NOISE,
 };
 
-struct channel {
-	uint16_t freq;
-	uint8_t  volume;
-	bool     left, right;
-	uint8_t  pw;
-	uint8_t  waveform;
-
-	unsigned phase;
-	uint8_t  noiseval;
-};
-
-static struct channel channels[16];
+// PSG of the current machine
+#define psg (machine->psg)
 
 static uint8_t volume_lut[64] = {0, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 6, 6, 7, 7, 7, 8, 8, 9, 9, 10, 11, 11, 12, 13, 14, 14, 15, 16, 17, 18, 19, 21, 22, 23, 25, 26, 28, 29, 31, 33, 35, 37, 39, 42, 44, 47, 50, 52, 56, 59, 63};
 
 void
 psg_reset(void)
 {
-	memset(channels, 0, sizeof(channels));
+	memset(psg.channels, 0, sizeof(psg.channels));
 }
 
 void
@@ -45,17 +36,17 @@ psg_writereg(uint8_t reg, uint8_t val)
 	int idx = reg & 3;
 
 	switch (idx) {
-		case 0: channels[ch].freq = (channels[ch].freq & 0xFF00) | val; break;
-		case 1: channels[ch].freq = (channels[ch].freq & 0x00FF) | (val << 8); break;
+		case 0: psg.channels[ch].freq = (psg.channels[ch].freq & 0xFF00) | val; break;
+		case 1: psg.channels[ch].freq = (psg.channels[ch].freq & 0x00FF) | (val << 8); break;
 		case 2: {
-			channels[ch].right  = (val & 0x80) != 0;
-			channels[ch].left   = (val & 0x40) != 0;
-			channels[ch].volume = volume_lut[val & 0x3F];
+			psg.channels[ch].right  = (val & 0x80) != 0;
+			psg.channels[ch].left   = (val & 0x40) != 0;
+			psg.channels[ch].volume = volume_lut[val & 0x3F];
 			break;
 		}
 		case 3: {
-			channels[ch].pw       = val & 0x3F;
-			channels[ch].waveform = val >> 6;
+			psg.channels[ch].pw       = val & 0x3F;
+			psg.channels[ch].waveform = val >> 6;
 			break;
 		}
 	}
@@ -68,11 +59,11 @@ render(int16_t *left, int16_t *right)
 	int r = 0;
 
 	for (int i = 0; i < 16; i++) {
-		struct channel *ch = &channels[i];
+		struct psg_channel *ch = &psg.channels[i];
 
 		unsigned new_phase = (ch->phase + ch->freq) & 0x1FFFF;
 		if ((ch->phase & 0x10000) != (new_phase & 0x10000)) {
-			ch->noiseval = rand() & 63;
+			ch->noiseval = machine_random() & 63;
 		}
 		ch->phase = new_phase;
 
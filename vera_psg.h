@@ -5,6 +5,22 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
+
+struct psg_channel {
+	uint16_t freq;
+	uint8_t  volume;
+	bool     left, right;
+	uint8_t  pw;
+	uint8_t  waveform;
+
+	unsigned phase;
+	uint8_t  noiseval;
+};
+
+typedef struct {
+	struct psg_channel channels[16];
+} psg_state_t;
 
 void psg_reset(void);
 void psg_writereg(uint8_t reg, uint8_t val);
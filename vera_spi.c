@@ -5,52 +5,59 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "sdcard.h"
+#include "machine.h"
 
-bool ss;
-bool busy;
-bool autotx;
-uint8_t sending_byte, received_byte;
-int outcounter;
+// SPI controller of the current machine
+#define spi (machine->vera_spi)
 
 void
 vera_spi_init()
 {
-	ss = false;
-	busy = false;
-	autotx = false;
-	received_byte = 0xff;
+	spi.ss = false;
+	spi.busy = false;
+	spi.autotx = false;
+	spi.received_byte = 0xff;
 }
 
+// a byte takes 8 clocks to shift
 void
-vera_spi_step()
+vera_spi_step(uint32_t clocks)
 {
-	if (busy) {
-		outcounter++;
-		if (outcounter == 8) {
-			busy = false;
-			if (sdcard_attached) {
-				received_byte = sdcard_handle(sending_byte);
+	if (spi.busy) {
+		if (clocks < 8 - spi.outcounter) {
+			spi.outcounter += clocks;
+		} else {
+			spi.outcounter = 8;
+			spi.busy = false;
+			if (machine->sdcard.attached) {
+				spi.received_byte = sdcard_handle(spi.sending_byte);
 			} else {
-				received_byte = 0xff;
+				spi.received_byte = 0xff;
 			}
 		}
 	}
 }
 
+bool
+vera_spi_is_busy()
+{
+	return spi.busy;
+}
+
 uint8_t
 vera_spi_read(uint8_t reg)
 {
 	switch (reg) {
 		case 0:
-			if (autotx && ss && !busy) {
+			if (spi.autotx && spi.ss && !spi.busy) {
 				// autotx mode will automatically send $FF after each read
-				sending_byte = 0xff;
-				busy = true;
-				outcounter = 0;
+				spi.sending_byte = 0xff;
+				spi.busy = true;
+				spi.outcounter = 0;
 			}
-			return received_byte;
+			return spi.received_byte;
 		case 1:
-			return busy << 7 | autotx << 3 | ss;
+			return spi.busy << 7 | spi.autotx << 3 | spi.ss;
 	}
 	return 0;
 }
@@ -60,20 +67,20 @@ vera_spi_write(uint8_t reg, uint8_t value)
 {
 	switch (reg) {
 		case 0:
-			if (ss && !busy) {
-				sending_byte = value;
-				busy = true;
-				outcounter = 0;
+			if (spi.ss && !spi.busy) {
+				spi.sending_byte = value;
+				spi.busy = true;
+				spi.outcounter = 0;
 			}
 			break;
 		case 1:
-			if (ss != (value & 1)) {
-				ss = value & 1;
-				if (ss) {
-					sdcard_select(ss);
+			if (spi.ss != (value & 1)) {
+				spi.ss = value & 1;
+				if (spi.ss) {
+					sdcard_select(spi.ss);
 				}
 			}
-			autotx = !!(value & 8);
+			spi.autotx = !!(value & 8);
 			break;
 	}
 }
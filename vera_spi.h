@@ -2,9 +2,24 @@
 // Copyright (c) 2019 Michael Steil
 // All rights reserved. License: 2-clause BSD
 
+#ifndef _VERA_SPI_H_
+#define _VERA_SPI_H_
+
 #include <inttypes.h>
+#include <stdbool.h>
+
+typedef struct {
+	bool ss;
+	bool busy;
+	bool autotx;
+	uint8_t sending_byte, received_byte;
+	int outcounter;
+} vera_spi_state_t;
 
 void vera_spi_init();
-void vera_spi_step();
+void vera_spi_step(uint32_t clocks);
+bool vera_spi_is_busy();
 uint8_t vera_spi_read(uint8_t address);
 void vera_spi_write(uint8_t address, uint8_t value);
+
+#endif
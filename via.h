@@ -7,6 +7,12 @@
 
 #include <stdint.h>
 
+typedef struct {
+	uint8_t via1registers[16];
+	uint8_t via2registers[16];
+	uint8_t via2pb_in;
+} via_state_t;
+
 void via1_init();
 uint8_t via1_read(uint8_t reg);
 void via1_write(uint8_t reg, uint8_t value);
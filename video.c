@@ -15,6 +15,12 @@
 #include "vera_pcm.h"
 #include "icon.h"
 #include "sdcard.h"
+#include "machine.h"
+#include "rewind.h"
+#include "replay.h"
+#include "runahead.h"
+#include "lockstep.h"
+#include "control.h"
 
 #include <limits.h>
 
@@ -40,12 +46,12 @@
 // VGA
 #define VGA_FRONT_PORCH_X 16
 #define VGA_FRONT_PORCH_Y 10
-#define VGA_PIXEL_FREQ 25.175
+#define VGA_PIXEL_FREQ 25175 /* kHz */
 
 // NTSC: 262.5 lines per frame, lower field first
 #define NTSC_FRONT_PORCH_X 80
 #define NTSC_FRONT_PORCH_Y 22
-#define NTSC_PIXEL_FREQ (15.750 * 800 / 1000)
+#define NTSC_PIXEL_FREQ (15750 * 800 / 1000)
 #define TITLE_SAFE_X 0.067
 #define TITLE_SAFE_Y 0.05
 
@@ -63,6 +69,9 @@
 #define RSHORTCUT_KEY SDL_SCANCODE_RCTRL
 #endif
 
+// VERA of the current machine
+#define vera (machine->video)
+
 // When rendering a layer line, we can amortize some of the cost by calculating multiple pixels at a time.
 #define LAYER_PIXELS_PER_ITERATION 8
 
@@ -71,39 +80,52 @@ static SDL_Window *window;
 static SDL_Renderer *renderer;
 static SDL_Texture *sdlTexture;
 static bool is_fullscreen = false;
+static THREAD_LOCAL bool frame_composed = false; // the framebuffer changed since the last video_update()
+static THREAD_LOCAL bool compose_all = false;    // for video_render_screen()
+
+// without a window: compose every frame on this thread, and where the palette
+// indices go too, if anywhere (for libx16emu)
+static THREAD_LOCAL bool compose_offscreen;
+static THREAD_LOCAL uint8_t *offscreen_indices;
+static uint64_t last_show;          // performance counter when a frame was last shown
+
+#define INPUT_QUEUE_SIZE 256 /* power of 2 */
+// releases of every key and mouse button, the request to quit and the end
+// of rewinding
+#define INPUT_PENDING_SIZE (SDL_NUM_SCANCODES + 8)
+
+// Unless the debugger needs the window, frames are shown by a thread of
+// their own, the main thread, while the machine runs on another one.
+static struct {
+	bool thread;
+
+	// Triple buffering: the emulation thread fills the back buffer, the
+	// newest complete frame waits in the middle one and the presentation
+	// thread shows the front one, so neither has to wait for the other.
+	uint8_t buffer[3][SCREEN_WIDTH * SCREEN_HEIGHT * 4];
+	bool gif[3]; // the frame goes into the GIF
+	bool show[3]; // the frame goes onto the screen
+	int back, middle, front;
+	bool fresh; // the middle buffer hasn't been shown yet
+	bool gif_failed;
+	bool stop;
+	char title[64];
+	bool title_changed;
+	SDL_mutex *lock;
+	SDL_cond *cond;
+
+	// input for the emulation thread; with one producer and one consumer
+	// the ring buffer needs no lock
+	SDL_Event input[INPUT_QUEUE_SIZE];
+	SDL_atomic_t input_head; // written by the presentation thread only
+	SDL_atomic_t input_tail; // written by the emulation thread only
+
+	// Presentation thread: events that mustn't get lost wait here while
+	// the queue is full, one of each kind.
+	SDL_Event pending[INPUT_PENDING_SIZE];
+	int pending_count;
+} present;
 
-static uint8_t video_ram[0x20000];
-static uint8_t palette[256 * 2];
-static uint8_t sprite_data[128][8];
-
-// I/O registers
-static uint32_t io_addr[2];
-static uint8_t io_rddata[2];
-static uint8_t io_inc[2];
-static uint8_t io_addrsel;
-static uint8_t io_dcsel;
-
-static uint8_t ien;
-static uint8_t isr;
-
-static uint16_t irq_line;
-
-static uint8_t reg_layer[2][7];
-static uint8_t reg_composer[8];
-
-static uint8_t layer_line[2][SCREEN_WIDTH];
-static uint8_t sprite_line_col[SCREEN_WIDTH];
-static uint8_t sprite_line_z[SCREEN_WIDTH];
-static uint8_t sprite_line_mask[SCREEN_WIDTH];
-static uint8_t sprite_line_collisions;
-static bool layer_line_enable[2];
-static bool sprite_line_enable;
-
-float scan_pos_x;
-uint16_t scan_pos_y;
-int frame_count = 0;
-
-static uint8_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT * 4];
 
 static GifWriter gif_writer;
 
@@ -120,48 +142,48 @@ void
 video_reset()
 {
 	// init I/O registers
-	memset(io_addr, 0, sizeof(io_addr));
-	memset(io_inc, 0, sizeof(io_inc));
-	io_addrsel = 0;
-	io_dcsel = 0;
-	io_rddata[0] = 0;
-	io_rddata[1] = 0;
+	memset(vera.io_addr, 0, sizeof(vera.io_addr));
+	memset(vera.io_inc, 0, sizeof(vera.io_inc));
+	vera.io_addrsel = 0;
+	vera.io_dcsel = 0;
+	vera.io_rddata[0] = 0;
+	vera.io_rddata[1] = 0;
 
-	ien = 0;
-	isr = 0;
-	irq_line = 0;
+	vera.ien = 0;
+	vera.isr = 0;
+	vera.irq_line = 0;
 
 	// init Layer registers
-	memset(reg_layer, 0, sizeof(reg_layer));
+	memset(vera.reg_layer, 0, sizeof(vera.reg_layer));
 
 	// init composer registers
-	memset(reg_composer, 0, sizeof(reg_composer));
-	reg_composer[1] = 128; // hscale = 1.0
-	reg_composer[2] = 128; // vscale = 1.0
-	reg_composer[5] = 640 >> 2;
-	reg_composer[7] = 480 >> 1;
+	memset(vera.reg_composer, 0, sizeof(vera.reg_composer));
+	vera.reg_composer[1] = 128; // hscale = 1.0
+	vera.reg_composer[2] = 128; // vscale = 1.0
+	vera.reg_composer[5] = 640 >> 2;
+	vera.reg_composer[7] = 480 >> 1;
 
 	// init sprite data
-	memset(sprite_data, 0, sizeof(sprite_data));
+	memset(vera.sprite_data, 0, sizeof(vera.sprite_data));
 
 	// copy palette
-	memcpy(palette, default_palette, sizeof(palette));
+	memcpy(vera.palette, default_palette, sizeof(vera.palette));
 	for (int i = 0; i < 256; i++) {
-		palette[i * 2 + 0] = default_palette[i] & 0xff;
-		palette[i * 2 + 1] = default_palette[i] >> 8;
+		vera.palette[i * 2 + 0] = default_palette[i] & 0xff;
+		vera.palette[i * 2 + 1] = default_palette[i] >> 8;
 	}
 
 	refresh_palette();
 
 	// fill video RAM with random data
 	for (int i = 0; i < 128 * 1024; i++) {
-		video_ram[i] = rand();
+		vera.video_ram[i] = machine_random();
 	}
 
-	sprite_line_collisions = 0;
+	vera.sprite_line_collisions = 0;
 
-	scan_pos_x = 0;
-	scan_pos_y = 0;
+	vera.scan_pos_x = 0;
+	vera.scan_pos_y = 0;
 
 	psg_reset();
 	pcm_reset();
@@ -179,6 +201,26 @@ video_init(int window_scale, char *quality)
 
 	video_reset();
 
+	if (record_gif != RECORD_GIF_DISABLED) {
+		if (!strcmp(gif_path+strlen(gif_path)-5, ",wait")) {
+			// wait for POKE
+			record_gif = RECORD_GIF_PAUSED;
+			// move the string terminator to remove the ",wait"
+			gif_path[strlen(gif_path)-5] = 0;
+		} else {
+			// start now
+			record_gif = RECORD_GIF_ACTIVE;
+		}
+		if (!GifBegin(&gif_writer, gif_path, SCREEN_WIDTH, SCREEN_HEIGHT, 1, 8, false)) {
+			record_gif = RECORD_GIF_DISABLED;
+		}
+	}
+
+	if (headless) {
+		// the framebuffer only goes into the GIF
+		return true;
+	}
+
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, quality);
 	SDL_CreateWindowAndRenderer(SCREEN_WIDTH * window_scale, SCREEN_HEIGHT * window_scale, window_flags, &window, &renderer);
 #ifndef __MORPHOS__
@@ -196,69 +238,24 @@ video_init(int window_scale, char *quality)
 
 	SDL_ShowCursor(SDL_DISABLE);
 
-	if (record_gif != RECORD_GIF_DISABLED) {
-		if (!strcmp(gif_path+strlen(gif_path)-5, ",wait")) {
-			// wait for POKE
-			record_gif = RECORD_GIF_PAUSED;
-			// move the string terminator to remove the ",wait"
-			gif_path[strlen(gif_path)-5] = 0;
-		} else {
-			// start now
-			record_gif = RECORD_GIF_ACTIVE;
-		}
-		if (!GifBegin(&gif_writer, gif_path, SCREEN_WIDTH, SCREEN_HEIGHT, 1, 8, false)) {
-			record_gif = RECORD_GIF_DISABLED;
-		}
-	}
-
 	if (debugger_enabled) {
 		DEBUGInitUI(renderer);
 	}
 
+#ifndef __EMSCRIPTEN__
+	if (!debugger_enabled) {
+		present.thread = true;
+		present.back = 0;
+		present.middle = 1;
+		present.front = 2;
+		present.lock = SDL_CreateMutex();
+		present.cond = SDL_CreateCond();
+	}
+#endif
+
 	return true;
 }
 
-struct video_layer_properties
-{
-	uint8_t color_depth;
-	uint32_t map_base;
-	uint32_t tile_base;
-
-	bool text_mode;
-	bool text_mode_256c;
-	bool tile_mode;
-	bool bitmap_mode;
-
-	uint16_t hscroll;
-	uint16_t vscroll;
-
-	uint8_t  mapw_log2;
-	uint8_t  maph_log2;
-	uint16_t tilew;
-	uint16_t tileh;
-	uint8_t  tilew_log2;
-	uint8_t  tileh_log2;
-
-	uint16_t mapw_max;
-	uint16_t maph_max;
-	uint16_t tilew_max;
-	uint16_t tileh_max;
-	uint16_t layerw_max;
-	uint16_t layerh_max;
-
-	uint8_t tile_size_log2;
-
-	int min_eff_x;
-	int max_eff_x;
-
-	uint8_t bits_per_pixel;
-	uint8_t first_color_pos;
-	uint8_t color_mask;
-	uint8_t color_fields_max;
-};
-
-struct video_layer_properties layer_properties[2];
-
 static int
 calc_layer_eff_x(const struct video_layer_properties *props, const int x)
 {
@@ -287,22 +284,22 @@ calc_layer_map_addr_base2(const struct video_layer_properties *props, const int
 static void
 refresh_layer_properties(const uint8_t layer)
 {
-	struct video_layer_properties* props = &layer_properties[layer];
+	struct video_layer_properties* props = &vera.layer_properties[layer];
 
 	uint16_t prev_layerw_max = props->layerw_max;
 	uint16_t prev_hscroll = props->hscroll;
 
-	props->color_depth    = reg_layer[layer][0] & 0x3;
-	props->map_base       = reg_layer[layer][1] << 9;
-	props->tile_base      = (reg_layer[layer][2] & 0xFC) << 9;
-	props->bitmap_mode    = (reg_layer[layer][0] & 0x4) != 0;
+	props->color_depth    = vera.reg_layer[layer][0] & 0x3;
+	props->map_base       = vera.reg_layer[layer][1] << 9;
+	props->tile_base      = (vera.reg_layer[layer][2] & 0xFC) << 9;
+	props->bitmap_mode    = (vera.reg_layer[layer][0] & 0x4) != 0;
 	props->text_mode      = (props->color_depth == 0) && !props->bitmap_mode;
-	props->text_mode_256c = (reg_layer[layer][0] & 8) != 0;
+	props->text_mode_256c = (vera.reg_layer[layer][0] & 8) != 0;
 	props->tile_mode      = !props->bitmap_mode && !props->text_mode;
 
 	if (!props->bitmap_mode) {
-		props->hscroll = reg_layer[layer][3] | (reg_layer[layer][4] & 0xf) << 8;
-		props->vscroll = reg_layer[layer][5] | (reg_layer[layer][6] & 0xf) << 8;
+		props->hscroll = vera.reg_layer[layer][3] | (vera.reg_layer[layer][4] & 0xf) << 8;
+		props->vscroll = vera.reg_layer[layer][5] | (vera.reg_layer[layer][6] & 0xf) << 8;
 	} else {
 		props->hscroll = 0;
 		props->vscroll = 0;
@@ -314,19 +311,19 @@ refresh_layer_properties(const uint8_t layer)
 	props->tileh = 0;
 
 	if (props->tile_mode || props->text_mode) {
-		props->mapw_log2 = 5 + ((reg_layer[layer][0] >> 4) & 3);
-		props->maph_log2 = 5 + ((reg_layer[layer][0] >> 6) & 3);
+		props->mapw_log2 = 5 + ((vera.reg_layer[layer][0] >> 4) & 3);
+		props->maph_log2 = 5 + ((vera.reg_layer[layer][0] >> 6) & 3);
 		mapw      = 1 << props->mapw_log2;
 		maph      = 1 << props->maph_log2;
 
 		// Scale the tiles or text characters according to TILEW and TILEH.
-		props->tilew_log2 = 3 + (reg_layer[layer][2] & 1);
-		props->tileh_log2 = 3 + ((reg_layer[layer][2] >> 1) & 1);
+		props->tilew_log2 = 3 + (vera.reg_layer[layer][2] & 1);
+		props->tileh_log2 = 3 + ((vera.reg_layer[layer][2] >> 1) & 1);
 		props->tilew      = 1 << props->tilew_log2;
 		props->tileh      = 1 << props->tileh_log2;
 	} else if (props->bitmap_mode) {
 		// bitmap mode is basically tiled mode with a single huge tile
-		props->tilew = (reg_layer[layer][2] & 1) ? 640 : 320;
+		props->tilew = (vera.reg_layer[layer][2] & 1) ? 640 : 320;
 		props->tileh = SCREEN_HEIGHT;
 	}
 
@@ -365,41 +362,18 @@ refresh_layer_properties(const uint8_t layer)
 	props->color_fields_max = (8 >> props->color_depth) - 1;
 }
 
-struct video_sprite_properties
-{
-	int8_t sprite_zdepth;
-	uint8_t sprite_collision_mask;
-
-	int16_t sprite_x;
-	int16_t sprite_y;
-	uint8_t sprite_width_log2;
-	uint8_t sprite_height_log2;
-	uint8_t sprite_width;
-	uint8_t sprite_height;
-
-	bool hflip;
-	bool vflip;
-
-	uint8_t color_mode;
-	uint32_t sprite_address;
-
-	uint16_t palette_offset;
-};
-
-struct video_sprite_properties sprite_properties[128];
-
 static void
 refresh_sprite_properties(const uint16_t sprite)
 {
-	struct video_sprite_properties* props = &sprite_properties[sprite];
+	struct video_sprite_properties* props = &vera.sprite_properties[sprite];
 
-	props->sprite_zdepth = (sprite_data[sprite][6] >> 2) & 3;
-	props->sprite_collision_mask = sprite_data[sprite][6] & 0xf0;
+	props->sprite_zdepth = (vera.sprite_data[sprite][6] >> 2) & 3;
+	props->sprite_collision_mask = vera.sprite_data[sprite][6] & 0xf0;
 
-	props->sprite_x = sprite_data[sprite][2] | (sprite_data[sprite][3] & 3) << 8;
-	props->sprite_y = sprite_data[sprite][4] | (sprite_data[sprite][5] & 3) << 8;
-	props->sprite_width_log2  = (((sprite_data[sprite][7] >> 4) & 3) + 3);
-	props->sprite_height_log2 = ((sprite_data[sprite][7] >> 6) + 3);
+	props->sprite_x = vera.sprite_data[sprite][2] | (vera.sprite_data[sprite][3] & 3) << 8;
+	props->sprite_y = vera.sprite_data[sprite][4] | (vera.sprite_data[sprite][5] & 3) << 8;
+	props->sprite_width_log2  = (((vera.sprite_data[sprite][7] >> 4) & 3) + 3);
+	props->sprite_height_log2 = ((vera.sprite_data[sprite][7] >> 6) + 3);
 	props->sprite_width       = 1 << props->sprite_width_log2;
 	props->sprite_height      = 1 << props->sprite_height_log2;
 
@@ -411,27 +385,19 @@ refresh_sprite_properties(const uint16_t sprite)
 		props->sprite_y -= 0x400;
 	}
 
-	props->hflip = sprite_data[sprite][6] & 1;
-	props->vflip = (sprite_data[sprite][6] >> 1) & 1;
+	props->hflip = vera.sprite_data[sprite][6] & 1;
+	props->vflip = (vera.sprite_data[sprite][6] >> 1) & 1;
 
-	props->color_mode     = (sprite_data[sprite][1] >> 7) & 1;
-	props->sprite_address = sprite_data[sprite][0] << 5 | (sprite_data[sprite][1] & 0xf) << 13;
+	props->color_mode     = (vera.sprite_data[sprite][1] >> 7) & 1;
+	props->sprite_address = vera.sprite_data[sprite][0] << 5 | (vera.sprite_data[sprite][1] & 0xf) << 13;
 
-	props->palette_offset = (sprite_data[sprite][7] & 0x0f) << 4;
+	props->palette_offset = (vera.sprite_data[sprite][7] & 0x0f) << 4;
 }
 
-struct video_palette
-{
-	uint32_t entries[256];
-	bool dirty;
-};
-
-struct video_palette video_palette;
-
 static void
 refresh_palette() {
-	const uint8_t out_mode = reg_composer[0] & 3;
-	const bool chroma_disable = (reg_composer[0] >> 2) & 1;
+	const uint8_t out_mode = vera.reg_composer[0] & 3;
+	const bool chroma_disable = (vera.reg_composer[0] >> 2) & 1;
 	for (int i = 0; i < 256; ++i) {
 		uint8_t r;
 		uint8_t g;
@@ -443,7 +409,7 @@ refresh_palette() {
 			g = 0;
 			b = 255;
 		} else {
-			uint16_t entry = palette[i * 2] | palette[i * 2 + 1] << 8;
+			uint16_t entry = vera.palette[i * 2] | vera.palette[i * 2 + 1] << 8;
 			r = ((entry >> 8) & 0xf) << 4 | ((entry >> 8) & 0xf);
 			g = ((entry >> 4) & 0xf) << 4 | ((entry >> 4) & 0xf);
 			b = (entry & 0xf) << 4 | (entry & 0xf);
@@ -452,9 +418,9 @@ refresh_palette() {
 			}
 		}
 
-		video_palette.entries[i] = (uint32_t)(r << 16) | ((uint32_t)g << 8) | ((uint32_t)b);
+		vera.video_palette.entries[i] = (uint32_t)(r << 16) | ((uint32_t)g << 8) | ((uint32_t)b);
 	}
-	video_palette.dirty = false;
+	vera.video_palette.dirty = false;
 }
 
 static void
@@ -474,15 +440,15 @@ expand_4bpp_data(uint8_t *dst, const uint8_t *src, int dst_size)
 static void
 render_sprite_line(const uint16_t y)
 {
-	memset(sprite_line_col, 0, SCREEN_WIDTH);
-	memset(sprite_line_z, 0, SCREEN_WIDTH);
-	memset(sprite_line_mask, 0, SCREEN_WIDTH);
+	memset(vera.sprite_line_col, 0, SCREEN_WIDTH);
+	memset(vera.sprite_line_z, 0, SCREEN_WIDTH);
+	memset(vera.sprite_line_mask, 0, SCREEN_WIDTH);
 
 	uint16_t sprite_budget = 800 + 1;
 	for (int i = 0; i < NUM_SPRITES; i++) {
 		// one clock per lookup
 		sprite_budget--; if (sprite_budget == 0) break;
-		const struct video_sprite_properties *props = &sprite_properties[i];
+		const struct video_sprite_properties *props = &vera.sprite_properties[i];
 
 		if (props->sprite_zdepth == 0) {
 			continue;
@@ -498,7 +464,7 @@ render_sprite_line(const uint16_t y)
 		int16_t       eff_sx      = (props->hflip ? (props->sprite_width - 1) : 0);
 		const int16_t eff_sx_incr = props->hflip ? -1 : 1;
 
-		const uint8_t *bitmap_data = video_ram + props->sprite_address + (eff_sy << (props->sprite_width_log2 - (1 - props->color_mode)));
+		const uint8_t *bitmap_data = vera.video_ram + props->sprite_address + (eff_sy << (props->sprite_width_log2 - (1 - props->color_mode)));
 
 		uint8_t unpacked_sprite_line[64];
 		if (props->color_mode == 0) {
@@ -529,12 +495,12 @@ render_sprite_line(const uint16_t y)
 
 			// palette offset
 			if (col_index > 0) {
-				sprite_line_collisions |= sprite_line_mask[line_x] & props->sprite_collision_mask;
-				sprite_line_mask[line_x] |= props->sprite_collision_mask;
+				vera.sprite_line_collisions |= vera.sprite_line_mask[line_x] & props->sprite_collision_mask;
+				vera.sprite_line_mask[line_x] |= props->sprite_collision_mask;
 
-			if (props->sprite_zdepth > sprite_line_z[line_x]) {
-					sprite_line_col[line_x] = col_index + props->palette_offset;
-					sprite_line_z[line_x] = props->sprite_zdepth;
+			if (props->sprite_zdepth > vera.sprite_line_z[line_x]) {
+					vera.sprite_line_col[line_x] = col_index + props->palette_offset;
+					vera.sprite_line_z[line_x] = props->sprite_zdepth;
 				}
 			}
 		}
@@ -544,7 +510,7 @@ render_sprite_line(const uint16_t y)
 static void
 render_layer_line_text(uint8_t layer, uint16_t y)
 {
-	const struct video_layer_properties *props = &layer_properties[layer];
+	const struct video_layer_properties *props = &vera.layer_properties[layer];
 
 	const uint8_t max_pixels_per_byte = (8 >> props->color_depth) - 1;
 	const int     eff_y               = calc_layer_eff_y(props, y);
@@ -633,14 +599,14 @@ render_layer_line_text(uint8_t layer, uint16_t y)
 		// convert tile byte to indexed color
 		const uint8_t col_index = (s >> color_shift) & 1;
 		--color_shift;
-		layer_line[layer][x] = col_index ? fg_color : bg_color;
+		vera.layer_line[layer][x] = col_index ? fg_color : bg_color;
 	}
 }
 
 static void
 render_layer_line_tile(uint8_t layer, uint16_t y)
 {
-	struct video_layer_properties *props = &layer_properties[layer];
+	struct video_layer_properties *props = &vera.layer_properties[layer];
 
 	const uint8_t max_pixels_per_byte = (8 >> props->color_depth) - 1;
 	const int     eff_y               = calc_layer_eff_y(props, y);
@@ -749,7 +715,7 @@ render_layer_line_tile(uint8_t layer, uint16_t y)
 		if (palette_offset && col_index > 0 && col_index < 16) {
 			col_index += palette_offset;
 		}
-		layer_line[layer][x] = col_index;
+		vera.layer_line[layer][x] = col_index;
 	}
 }
 
@@ -757,7 +723,7 @@ render_layer_line_tile(uint8_t layer, uint16_t y)
 static void
 render_layer_line_bitmap(uint8_t layer, uint16_t y)
 {
-	struct video_layer_properties *props = &layer_properties[layer];
+	struct video_layer_properties *props = &vera.layer_properties[layer];
 
 	int yy = y % props->tileh;
 	// additional bytes to reach the correct line of the tile
@@ -768,7 +734,7 @@ render_layer_line_bitmap(uint8_t layer, uint16_t y)
 		int xx = x % props->tilew;
 
 		// extract all information from the map
-		uint8_t palette_offset = reg_layer[layer][4] & 0xf;
+		uint8_t palette_offset = vera.reg_layer[layer][4] & 0xf;
 
 		// additional bytes to reach the correct column of the tile
 		uint16_t x_add = (xx * props->bits_per_pixel) >> 3;
@@ -782,7 +748,7 @@ render_layer_line_bitmap(uint8_t layer, uint16_t y)
 		if (palette_offset && col_index > 0 && col_index < 16) {
 			col_index += palette_offset << 4;
 		}
-		layer_line[layer][x] = col_index;
+		vera.layer_line[layer][x] = col_index;
 	}
 }
 
@@ -806,47 +772,68 @@ static uint8_t calculate_line_col_index(uint8_t spr_zindex, uint8_t spr_col_inde
 	return col_index;
 }
 
+// Whether a line goes into the framebuffer. In warp mode that's only 1 in
+// warp_render_ratio frames, or none at all if it is 0 (blind), and with
+// run-ahead only the frames ahead that are shown, unless a GIF is being
+// recorded, -lockstep compares the framebuffers, the library asks for them
+// or a -control client may.
+static bool
+compose_line()
+{
+	if (record_gif != RECORD_GIF_DISABLED || compose_all || compose_offscreen || lockstep_enabled() || control_active()) {
+		return true;
+	}
+	if (headless || !runahead_composing()) {
+		return false;
+	}
+	if (warp_mode) {
+		return warp_render_ratio && vera.frame_count % warp_render_ratio == 0;
+	}
+	return true;
+}
+
 static void
 render_line(uint16_t y)
 {
-	uint8_t out_mode = reg_composer[0] & 3;
+	uint8_t out_mode = vera.reg_composer[0] & 3;
 
-	uint8_t border_color = reg_composer[3];
-	uint16_t hstart = reg_composer[4] << 2;
-	uint16_t hstop = reg_composer[5] << 2;
-	uint16_t vstart = reg_composer[6] << 1;
-	uint16_t vstop = reg_composer[7] << 1;
+	uint8_t border_color = vera.reg_composer[3];
+	uint16_t hstart = vera.reg_composer[4] << 2;
+	uint16_t hstop = vera.reg_composer[5] << 2;
+	uint16_t vstart = vera.reg_composer[6] << 1;
+	uint16_t vstop = vera.reg_composer[7] << 1;
 
-	int eff_y = (reg_composer[2] * (y - vstart)) >> 7;
+	int eff_y = (vera.reg_composer[2] * (y - vstart)) >> 7;
 
-	uint8_t dc_video = reg_composer[0];
-	layer_line_enable[0] = dc_video & 0x10;
-	layer_line_enable[1] = dc_video & 0x20;
-	sprite_line_enable   = dc_video & 0x40;
+	uint8_t dc_video = vera.reg_composer[0];
+	vera.layer_line_enable[0] = dc_video & 0x10;
+	vera.layer_line_enable[1] = dc_video & 0x20;
+	vera.sprite_line_enable   = dc_video & 0x40;
 
-	if (sprite_line_enable) {
+	if (vera.sprite_line_enable) {
 		render_sprite_line(eff_y);
 	}
 
-	if (warp_mode && (frame_count & 63)) {
-		// sprites were needed for the collision IRQ, but we can skip
-		// everything else if we're in warp mode, most of the time
+	if (!compose_line()) {
+		// sprites were needed for the collision IRQ, but nobody is
+		// going to see the rest
 		return;
 	}
+	frame_composed = true;
 
-	if (layer_line_enable[0]) {
-		if (layer_properties[0].text_mode) {
+	if (vera.layer_line_enable[0]) {
+		if (vera.layer_properties[0].text_mode) {
 			render_layer_line_text(0, eff_y);
-		} else if (layer_properties[0].bitmap_mode) {
+		} else if (vera.layer_properties[0].bitmap_mode) {
 			render_layer_line_bitmap(0, eff_y);
 		} else {
 			render_layer_line_tile(0, eff_y);
 		}
 	}
-	if (layer_line_enable[1]) {
-		if (layer_properties[1].text_mode) {
+	if (vera.layer_line_enable[1]) {
+		if (vera.layer_properties[1].text_mode) {
 			render_layer_line_text(1, eff_y);
-		} else if (layer_properties[1].bitmap_mode) {
+		} else if (vera.layer_properties[1].bitmap_mode) {
 			render_layer_line_bitmap(1, eff_y);
 		} else {
 			render_layer_line_tile(1, eff_y);
@@ -855,7 +842,7 @@ render_line(uint16_t y)
 
 	uint8_t col_line[SCREEN_WIDTH];
 
-	if (video_palette.dirty) {
+	if (vera.video_palette.dirty) {
 		refresh_palette();
 	}
 
@@ -878,29 +865,29 @@ render_line(uint16_t y)
 
 			int eff_x[LAYER_PIXELS_PER_ITERATION];
 			for (int i = 0; i < LAYER_PIXELS_PER_ITERATION; ++i) {
-				eff_x[i] = (reg_composer[1] * (x + i - hstart)) >> 7;
+				eff_x[i] = (vera.reg_composer[1] * (x + i - hstart)) >> 7;
 			}
 
-			if (sprite_line_enable) {
+			if (vera.sprite_line_enable) {
 				for (int i = 0; i < LAYER_PIXELS_PER_ITERATION; ++i) {
-					spr_col_index[i] = sprite_line_col[eff_x[i]];
+					spr_col_index[i] = vera.sprite_line_col[eff_x[i]];
 				}
 			}
 
-			if (layer_line_enable[0]) {
+			if (vera.layer_line_enable[0]) {
 				for (int i = 0; i < LAYER_PIXELS_PER_ITERATION; ++i) {
-					l1_col_index[i] = layer_line[0][eff_x[i]];
+					l1_col_index[i] = vera.layer_line[0][eff_x[i]];
 				}
 			}
 
-			if (layer_line_enable[1]) {
+			if (vera.layer_line_enable[1]) {
 				for (int i = 0; i < LAYER_PIXELS_PER_ITERATION; ++i) {
-					l2_col_index[i] = layer_line[1][eff_x[i]];
+					l2_col_index[i] = vera.layer_line[1][eff_x[i]];
 				}
 			}
 
 			for (int i = 0; i < LAYER_PIXELS_PER_ITERATION; ++i) {
-				spr_zindex[i] = sprite_line_z[eff_x[i]];
+				spr_zindex[i] = vera.sprite_line_z[eff_x[i]];
 			}
 
 			bool same_sprite = true;
@@ -958,12 +945,16 @@ render_line(uint16_t y)
 		}
 	}
 
+	if (offscreen_indices) {
+		memcpy(&offscreen_indices[y * SCREEN_WIDTH], col_line, SCREEN_WIDTH);
+	}
+
 	// Look up all color indices.
-	uint32_t* framebuffer4_begin = ((uint32_t*)framebuffer) + (y * SCREEN_WIDTH);
+	uint32_t* framebuffer4_begin = ((uint32_t*)vera.framebuffer) + (y * SCREEN_WIDTH);
 	{
 		uint32_t* framebuffer4 = framebuffer4_begin;
 		for (uint16_t x = 0; x < SCREEN_WIDTH; x++) {
-			*framebuffer4++ = video_palette.entries[col_line[x]];
+			*framebuffer4++ = vera.video_palette.entries[col_line[x]];
 		}
 	}
 
@@ -986,43 +977,66 @@ render_line(uint16_t y)
 	}
 }
 
+// The beam position within the line is kept in 1/1000 pixel per MHz of
+// the CPU clock, so it moves by the pixel clock in kHz with every CPU clock.
+static uint32_t
+pixel_freq(uint8_t out_mode)
+{
+	return (out_mode & 2) ? NTSC_PIXEL_FREQ : VGA_PIXEL_FREQ;
+}
+
+static uint32_t
+scan_width(float mhz)
+{
+	return SCAN_WIDTH * (uint32_t)(mhz * 1000);
+}
+
+// runs the video for the given number of CPU clocks, a scanline at a time;
+// returns true if a frame was completed
 bool
-video_step(float mhz)
+video_step(float mhz, uint32_t cycles)
 {
-	uint8_t out_mode = reg_composer[0] & 3;
+	uint8_t out_mode = vera.reg_composer[0] & 3;
+	uint32_t advance = pixel_freq(out_mode);
+	uint32_t width = scan_width(mhz);
 
 	bool new_frame = false;
-	float advance = ((out_mode & 2) ? NTSC_PIXEL_FREQ :  VGA_PIXEL_FREQ) / mhz;
-	scan_pos_x += advance;
-	if (scan_pos_x > SCAN_WIDTH) {
-		scan_pos_x -= SCAN_WIDTH;
+	for (;;) {
+		uint32_t to_line = (width - vera.scan_pos_x) / advance + 1;
+		if (cycles < to_line) {
+			vera.scan_pos_x += cycles * advance;
+			break;
+		}
+		cycles -= to_line;
+		vera.scan_pos_x += to_line * advance - width;
+
 		uint16_t front_porch = (out_mode & 2) ? NTSC_FRONT_PORCH_Y : VGA_FRONT_PORCH_Y;
-		uint16_t y = scan_pos_y - front_porch;
+		uint16_t y = vera.scan_pos_y - front_porch;
 		if (y < SCREEN_HEIGHT) {
 			render_line(y);
 		}
-		scan_pos_y++;
-		if (scan_pos_y == SCREEN_HEIGHT) {
-			if (ien & 4) {
-				if (sprite_line_collisions != 0) {
-					isr |= 4;
+		vera.scan_pos_y++;
+		if (vera.scan_pos_y == SCREEN_HEIGHT) {
+			if (vera.ien & 4) {
+				if (vera.sprite_line_collisions != 0) {
+					vera.isr |= 4;
 				}
-				isr = (isr & 0xf) | sprite_line_collisions;
+				vera.isr = (vera.isr & 0xf) | vera.sprite_line_collisions;
 			}
-			sprite_line_collisions = 0;
+			vera.sprite_line_collisions = 0;
 		}
-		if (scan_pos_y == SCAN_HEIGHT) {
-			scan_pos_y = 0;
+		if (vera.scan_pos_y == SCAN_HEIGHT) {
+			vera.scan_pos_y = 0;
 			new_frame = true;
-			frame_count++;
-			if (ien & 1) { // VSYNC IRQ
-				isr |= 1;
+			vera.frame_count++;
+			if (vera.ien & 1) { // VSYNC IRQ
+				vera.isr |= 1;
 			}
 		}
-		if (ien & 2) { // LINE IRQ
-			y = scan_pos_y - front_porch;
-			if (y < SCREEN_HEIGHT && y == irq_line) {
-				isr |= 2;
+		if (vera.ien & 2) { // LINE IRQ
+			y = vera.scan_pos_y - front_porch;
+			if (y < SCREEN_HEIGHT && y == vera.irq_line) {
+				vera.isr |= 2;
 			}
 		}
 	}
@@ -1030,11 +1044,43 @@ video_step(float mhz)
 	return new_frame;
 }
 
+// cycles until video_step() reaches the end of the scanline, the only
+// point where it renders and raises IRQs
+uint32_t
+video_cycles_to_line(float mhz)
+{
+	uint8_t out_mode = vera.reg_composer[0] & 3;
+
+	return (scan_width(mhz) - vera.scan_pos_x) / pixel_freq(out_mode) + 1;
+}
+
+// Renders the whole screen into the framebuffer at once, as the current
+// state of VERA shows it, even when headless. For a machine that doesn't
+// run any more.
+void
+video_render_screen()
+{
+	compose_all = true;
+	for (uint16_t y = 0; y < SCREEN_HEIGHT; y++) {
+		render_line(y);
+	}
+	compose_all = false;
+}
+
+// Composes every frame of the machines run on this thread, even when
+// headless. indices receives the palette index of every pixel, if not NULL.
+void
+video_set_offscreen(bool compose, uint8_t *indices)
+{
+	compose_offscreen = compose;
+	offscreen_indices = indices;
+}
+
 bool
 video_get_irq_out()
 {
-	uint8_t tmp_isr = isr | (pcm_is_fifo_almost_empty() ? 8 : 0);
-	return (tmp_isr & ien) != 0;
+	uint8_t tmp_isr = vera.isr | (pcm_is_fifo_almost_empty() ? 8 : 0);
+	return (tmp_isr & vera.ien) != 0;
 }
 
 //
@@ -1044,129 +1090,523 @@ video_get_irq_out()
 void
 video_save(SDL_RWops *f)
 {
-	SDL_RWwrite(f, &video_ram[0], sizeof(uint8_t), sizeof(video_ram));
-	SDL_RWwrite(f, &reg_composer[0], sizeof(uint8_t), sizeof(reg_composer));
-	SDL_RWwrite(f, &palette[0], sizeof(uint8_t), sizeof(palette));
-	SDL_RWwrite(f, &reg_layer[0][0], sizeof(uint8_t), sizeof(reg_layer));
-	SDL_RWwrite(f, &sprite_data[0], sizeof(uint8_t), sizeof(sprite_data));
+	SDL_RWwrite(f, &vera.video_ram[0], sizeof(uint8_t), sizeof(vera.video_ram));
+	SDL_RWwrite(f, &vera.reg_composer[0], sizeof(uint8_t), sizeof(vera.reg_composer));
+	SDL_RWwrite(f, &vera.palette[0], sizeof(uint8_t), sizeof(vera.palette));
+	SDL_RWwrite(f, &vera.reg_layer[0][0], sizeof(uint8_t), sizeof(vera.reg_layer));
+	SDL_RWwrite(f, &vera.sprite_data[0], sizeof(uint8_t), sizeof(vera.sprite_data));
 }
 
-bool
-video_update()
+// Shortcuts that act on the machine, passed on as SDL_USEREVENTs
+enum {
+	SHORTCUT_DUMP,
+	SHORTCUT_RESET,
+	SHORTCUT_PASTE,
+	SHORTCUT_WARP,
+	SHORTCUT_SDCARD_ATTACH,
+	SHORTCUT_SDCARD_DETACH,
+	SHORTCUT_REWIND_START,
+	SHORTCUT_REWIND_STOP,
+};
+
+// The part of event handling that needs the window: toggles fullscreen and
+// turns the other shortcuts into SDL_USEREVENTs. Returns true if the event
+// still has to go to the machine.
+static bool
+video_host_event(SDL_Event *event)
 {
 	static bool cmd_down = false;
+	static bool rewinding = false;
+
+	if (event->type == SDL_KEYDOWN) {
+		if (rewinding && event->key.keysym.sym == SDLK_BACKSPACE) {
+			// repeated while held down: still going back
+			return false;
+		}
+		if (cmd_down) {
+			int shortcut = -1;
+			if (event->key.keysym.sym == SDLK_s) {
+				shortcut = SHORTCUT_DUMP;
+			} else if (event->key.keysym.sym == SDLK_r) {
+				shortcut = SHORTCUT_RESET;
+			} else if (event->key.keysym.sym == SDLK_v) {
+				shortcut = SHORTCUT_PASTE;
+			} else if (event->key.keysym.sym == SDLK_f || event->key.keysym.sym == SDLK_RETURN) {
+				is_fullscreen = !is_fullscreen;
+				SDL_SetWindowFullscreen(window, is_fullscreen ? SDL_WINDOW_FULLSCREEN : 0);
+				return false;
+			} else if (event->key.keysym.sym == SDLK_PLUS || event->key.keysym.sym == SDLK_EQUALS) {
+				shortcut = SHORTCUT_WARP;
+			} else if (event->key.keysym.sym == SDLK_a) {
+				shortcut = SHORTCUT_SDCARD_ATTACH;
+			} else if (event->key.keysym.sym == SDLK_d) {
+				shortcut = SHORTCUT_SDCARD_DETACH;
+			} else if (event->key.keysym.sym == SDLK_BACKSPACE) {
+				rewinding = true;
+				shortcut = SHORTCUT_REWIND_START;
+			}
+			if (shortcut >= 0) {
+				event->type = SDL_USEREVENT;
+				event->user.code = shortcut;
+				event->user.data1 = shortcut == SHORTCUT_PASTE ? SDL_GetClipboardText() : NULL;
+				return true;
+			}
+		}
+		if (event->key.keysym.scancode == LSHORTCUT_KEY || event->key.keysym.scancode == RSHORTCUT_KEY) {
+			cmd_down = true;
+		}
+		return true;
+	}
+	if (event->type == SDL_KEYUP) {
+		if (event->key.keysym.scancode == LSHORTCUT_KEY || event->key.keysym.scancode == RSHORTCUT_KEY) {
+			cmd_down = false;
+		}
+		if (rewinding && event->key.keysym.sym == SDLK_BACKSPACE) {
+			rewinding = false;
+			event->type = SDL_USEREVENT;
+			event->user.code = SHORTCUT_REWIND_STOP;
+			event->user.data1 = NULL;
+		}
+		return true;
+	}
+	return event->type == SDL_QUIT ||
+		event->type == SDL_MOUSEBUTTONDOWN ||
+		event->type == SDL_MOUSEBUTTONUP ||
+		event->type == SDL_MOUSEMOTION;
+}
+
+// The part of event handling that changes the machine. Returns true for
+// key events; the next one has to wait for the next frame.
+static bool
+video_machine_event(const SDL_Event *event)
+{
+	if (event->type == SDL_USEREVENT) {
+		switch (event->user.code) {
+			case SHORTCUT_DUMP:
+				machine_dump();
+				break;
+			case SHORTCUT_RESET:
+				replay_input(INPUT_RESET, 0, 0, NULL);
+				break;
+			case SHORTCUT_PASTE:
+				replay_input(INPUT_PASTE, 0, 0, event->user.data1);
+				break;
+			case SHORTCUT_WARP:
+				machine_toggle_warp();
+				break;
+			case SHORTCUT_SDCARD_ATTACH:
+				replay_input(INPUT_SDCARD_ATTACH, 0, 0, NULL);
+				break;
+			case SHORTCUT_SDCARD_DETACH:
+				replay_input(INPUT_SDCARD_DETACH, 0, 0, NULL);
+				break;
+			case SHORTCUT_REWIND_START:
+				rewind_set_active(true);
+				break;
+			case SHORTCUT_REWIND_STOP:
+				rewind_set_active(false);
+				break;
+		}
+		return true;
+	}
+	if (event->type == SDL_KEYDOWN) {
+		replay_input(INPUT_KEY_DOWN, event->key.keysym.scancode, 0, NULL);
+		return true;
+	}
+	if (event->type == SDL_KEYUP) {
+		replay_input(INPUT_KEY_UP, event->key.keysym.scancode, 0, NULL);
+		return true;
+	}
+	if (event->type == SDL_MOUSEBUTTONDOWN) {
+		switch (event->button.button) {
+			case SDL_BUTTON_LEFT:
+				replay_input(INPUT_MOUSE_DOWN, 0, 0, NULL);
+				break;
+			case SDL_BUTTON_RIGHT:
+				replay_input(INPUT_MOUSE_DOWN, 1, 0, NULL);
+				break;
+		}
+	}
+	if (event->type == SDL_MOUSEBUTTONUP) {
+		switch (event->button.button) {
+			case SDL_BUTTON_LEFT:
+				replay_input(INPUT_MOUSE_UP, 0, 0, NULL);
+				break;
+			case SDL_BUTTON_RIGHT:
+				replay_input(INPUT_MOUSE_UP, 1, 0, NULL);
+				break;
+		}
+	}
+	if (event->type == SDL_MOUSEMOTION) {
+		static int mouse_x;
+		static int mouse_y;
+		replay_input(INPUT_MOUSE_MOVE, event->motion.x - mouse_x, event->motion.y - mouse_y, NULL);
+		mouse_x = event->motion.x;
+		mouse_y = event->motion.y;
+	}
+	return false;
+}
+
+// Returns false if writing the frame failed and the GIF has been closed.
+static bool
+video_gif_frame(uint8_t *framebuffer)
+{
+	if (!GifWriteFrame(&gif_writer, framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT, 2, 8, false)) {
+		GifEnd(&gif_writer);
+		printf("Unexpected end of recording.\n");
+		return false;
+	}
+	return true;
+}
+
+static bool
+input_push(const SDL_Event *event)
+{
+	int head = SDL_AtomicGet(&present.input_head);
+	int next = (head + 1) & (INPUT_QUEUE_SIZE - 1);
+	if (next == SDL_AtomicGet(&present.input_tail)) {
+		return false;
+	}
+	present.input[head] = *event;
+	SDL_AtomicSet(&present.input_head, next);
+	return true;
+}
+
+static bool
+input_pop(SDL_Event *event)
+{
+	int tail = SDL_AtomicGet(&present.input_tail);
+	if (tail == SDL_AtomicGet(&present.input_head)) {
+		return false;
+	}
+	*event = present.input[tail];
+	SDL_AtomicSet(&present.input_tail, (tail + 1) & (INPUT_QUEUE_SIZE - 1));
+	return true;
+}
 
+// Whether an event lets go of a key or button. These still go to the
+// machine while it is stopped, or whatever was held down when it stopped
+// would stay down.
+static bool
+video_release_event(const SDL_Event *event)
+{
+	return event->type == SDL_KEYUP ||
+		event->type == SDL_MOUSEBUTTONUP ||
+		(event->type == SDL_USEREVENT && event->user.code == SHORTCUT_REWIND_STOP);
+}
+
+// whether an event can't be dropped when the machine is too far behind
+static bool
+input_essential(const SDL_Event *event)
+{
+	return event->type == SDL_QUIT || video_release_event(event);
+}
+
+static bool
+input_same(const SDL_Event *a, const SDL_Event *b)
+{
+	if (a->type != b->type) {
+		return false;
+	}
+	switch (a->type) {
+		case SDL_KEYUP:
+			return a->key.keysym.scancode == b->key.keysym.scancode;
+		case SDL_MOUSEBUTTONUP:
+			return a->button.button == b->button.button;
+		default:
+			return true;
+	}
+}
+
+// Presentation thread: passes an event on to the emulation thread. While
+// the queue is full, the essential ones wait, and the others are dropped.
+// Waiting events go first, so the order is kept.
+static void
+input_send(const SDL_Event *event)
+{
+	while (present.pending_count && input_push(&present.pending[0])) {
+		present.pending_count--;
+		memmove(&present.pending[0], &present.pending[1], present.pending_count * sizeof(SDL_Event));
+	}
+	if (!event) {
+		return;
+	}
+	if (!present.pending_count && input_push(event)) {
+		return;
+	}
+	if (!input_essential(event)) {
+		return;
+	}
+	for (int i = 0; i < present.pending_count; i++) {
+		if (input_same(&present.pending[i], event)) {
+			return;
+		}
+	}
+	present.pending[present.pending_count++] = *event;
+}
+
+// Emulation thread: puts the frame into the middle buffer for the
+// presentation thread.
+static void
+video_hand_over(bool show, bool gif)
+{
+	memcpy(present.buffer[present.back], vera.framebuffer, sizeof(vera.framebuffer));
+	present.gif[present.back] = gif;
+	present.show[present.back] = show;
+
+	SDL_LockMutex(present.lock);
+	// frames that haven't been shown are dropped, but not from the GIF
+	while (gif && present.fresh && present.gif[present.middle]) {
+		SDL_CondWait(present.cond, present.lock);
+	}
+	int newest = present.back;
+	present.back = present.middle;
+	present.middle = newest;
+	present.fresh = true;
+	bool gif_failed = present.gif_failed;
+	SDL_CondBroadcast(present.cond);
+	SDL_UnlockMutex(present.lock);
+
+	if (gif_failed) {
+		record_gif = RECORD_GIF_DISABLED;
+	} else if (record_gif == RECORD_GIF_SINGLE) { // if single-shot stop recording
+		record_gif = RECORD_GIF_PAUSED;  // need to close in video_end()
+	}
+}
+
+// Emulation thread: hands the frame to the presentation thread if there is
+// anything to do with it and takes the input it has collected.
+static bool
+video_publish(bool show)
+{
+	bool gif = record_gif > RECORD_GIF_PAUSED;
+
+	if (show || gif) {
+		video_hand_over(show, gif);
+	}
+
+	SDL_Event event;
+	while (input_pop(&event)) {
+		if (event.type == SDL_QUIT) {
+			return false;
+		}
+		if (video_machine_event(&event)) {
+			break;
+		}
+	}
+	return true;
+}
+
+// Presentation thread: uploads and shows the newest frame, writes the GIF
+// and collects input until the emulation thread calls video_present_stop().
+void
+video_present_loop()
+{
+	bool gif_failed = false;
+
+	for (;;) {
+		char title[sizeof(present.title)];
+		bool title_changed;
+
+		SDL_LockMutex(present.lock);
+		if (!present.fresh && !present.stop) {
+			// don't stop taking input while the machine is slow
+			SDL_CondWaitTimeout(present.cond, present.lock, 10);
+		}
+		bool stop = present.stop;
+		bool fresh = present.fresh;
+		if (fresh) {
+			int newest = present.middle;
+			present.middle = present.front;
+			present.front = newest;
+			present.fresh = false;
+			SDL_CondBroadcast(present.cond);
+		}
+		title_changed = present.title_changed;
+		if (title_changed) {
+			memcpy(title, present.title, sizeof(title));
+			present.title_changed = false;
+		}
+		SDL_UnlockMutex(present.lock);
+
+		if (title_changed) {
+			SDL_SetWindowTitle(window, title);
+		}
+
+		if (fresh) {
+			uint8_t *framebuffer = present.buffer[present.front];
+
+			if (present.gif[present.front] && !gif_failed && !video_gif_frame(framebuffer)) {
+				gif_failed = true;
+				SDL_LockMutex(present.lock);
+				present.gif_failed = true;
+				SDL_UnlockMutex(present.lock);
+			}
+
+			if (present.show[present.front]) {
+				SDL_UpdateTexture(sdlTexture, NULL, framebuffer, SCREEN_WIDTH * 4);
+				SDL_RenderClear(renderer);
+				SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
+				SDL_RenderPresent(renderer);
+			}
+		}
+
+		if (stop) {
+			break;
+		}
+
+		SDL_Event event;
+		input_send(NULL);
+		while (SDL_PollEvent(&event)) {
+			if (video_host_event(&event)) {
+				input_send(&event);
+			}
+		}
+	}
+}
+
+// Takes the input while the machine is stopped, so the window stays
+// responsive; releases are passed on and everything else but a request to
+// quit is dropped. Returns false once there was one.
+bool
+video_idle()
+{
+	SDL_Event event;
+
+	if (present.thread) {
+		while (input_pop(&event)) {
+			if (event.type == SDL_QUIT) {
+				return false;
+			}
+			if (video_release_event(&event)) {
+				video_machine_event(&event);
+			}
+		}
+		return true;
+	}
+	while (SDL_PollEvent(&event)) {
+		if (!video_host_event(&event)) {
+			continue;
+		}
+		if (event.type == SDL_QUIT) {
+			return false;
+		}
+		if (video_release_event(&event)) {
+			video_machine_event(&event);
+		}
+	}
+	return true;
+}
+
+void
+video_present_stop()
+{
+	SDL_LockMutex(present.lock);
+	present.stop = true;
+	SDL_CondBroadcast(present.cond);
+	SDL_UnlockMutex(present.lock);
+}
+
+bool
+video_threaded()
+{
+	return present.thread;
+}
+
+// Whether the frame that just ended goes onto the screen: only if it was
+// rendered, and in warp mode no more than warp_present_fps times a second.
+static bool
+video_show_frame()
+{
+	bool composed = frame_composed;
+	frame_composed = false;
+
+	if (debugger_enabled) {
+		return true;
+	}
+	if (!composed || headless) {
+		return false;
+	}
+	if (warp_mode && warp_present_fps) {
+		uint64_t now = SDL_GetPerformanceCounter();
+		if (now - last_show < SDL_GetPerformanceFrequency() / warp_present_fps) {
+			return false;
+		}
+		last_show = now;
+	}
+	return true;
+}
+
+bool
+video_update()
+{
 	// if LED is on, stamp red 8x4 square into top right of framebuffer
-	if (led_status) {
+	if (machine->memory.led_status) {
 		for (int y = 0; y < 4; y++) {
 			for (int x = SCREEN_WIDTH - 8; x < SCREEN_WIDTH; x++) {
-				framebuffer[(y * SCREEN_WIDTH + x) * 4 + 0] = 0x00;
-				framebuffer[(y * SCREEN_WIDTH + x) * 4 + 1] = 0x00;
-				framebuffer[(y * SCREEN_WIDTH + x) * 4 + 2] = 0xff;
-				framebuffer[(y * SCREEN_WIDTH + x) * 4 + 3] = 0x00;
+				vera.framebuffer[(y * SCREEN_WIDTH + x) * 4 + 0] = 0x00;
+				vera.framebuffer[(y * SCREEN_WIDTH + x) * 4 + 1] = 0x00;
+				vera.framebuffer[(y * SCREEN_WIDTH + x) * 4 + 2] = 0xff;
+				vera.framebuffer[(y * SCREEN_WIDTH + x) * 4 + 3] = 0x00;
 			}
 		}
 	}
 
-	SDL_UpdateTexture(sdlTexture, NULL, framebuffer, SCREEN_WIDTH * 4);
+	bool show = video_show_frame();
+
+	if (present.thread) {
+		return video_publish(show);
+	}
+
+	if (show) {
+		SDL_UpdateTexture(sdlTexture, NULL, vera.framebuffer, SCREEN_WIDTH * 4);
+	}
 
 	if (record_gif > RECORD_GIF_PAUSED) {
-		if(!GifWriteFrame(&gif_writer, framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT, 2, 8, false)) {
+		if (!video_gif_frame(vera.framebuffer)) {
 			// if that failed, stop recording
-			GifEnd(&gif_writer);
 			record_gif = RECORD_GIF_DISABLED;
-			printf("Unexpected end of recording.\n");
 		}
 		if (record_gif == RECORD_GIF_SINGLE) { // if single-shot stop recording
 			record_gif = RECORD_GIF_PAUSED;  // need to close in video_end()
 		}
 	}
 
-	SDL_RenderClear(renderer);
-	SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
-
-	if (debugger_enabled && showDebugOnRender != 0) {
-		DEBUGRenderDisplay(SCREEN_WIDTH, SCREEN_HEIGHT);
-		SDL_RenderPresent(renderer);
+	if (headless) {
+		// no window: all there is to handle is a request to quit
+		SDL_Event event;
+		while (SDL_PollEvent(&event)) {
+			if (event.type == SDL_QUIT) {
+				return false;
+			}
+		}
 		return true;
 	}
 
-	SDL_RenderPresent(renderer);
+	if (show) {
+		SDL_RenderClear(renderer);
+		SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
+
+		if (debugger_enabled && showDebugOnRender != 0) {
+			DEBUGRenderDisplay(SCREEN_WIDTH, SCREEN_HEIGHT);
+			SDL_RenderPresent(renderer);
+			return true;
+		}
+
+		SDL_RenderPresent(renderer);
+	}
 
 	SDL_Event event;
 	while (SDL_PollEvent(&event)) {
+		if (!video_host_event(&event)) {
+			continue;
+		}
 		if (event.type == SDL_QUIT) {
 			return false;
 		}
-		if (event.type == SDL_KEYDOWN) {
-			bool consumed = false;
-			if (cmd_down) {
-				if (event.key.keysym.sym == SDLK_s) {
-					machine_dump();
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_r) {
-					machine_reset();
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_v) {
-					machine_paste(SDL_GetClipboardText());
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_f || event.key.keysym.sym == SDLK_RETURN) {
-					is_fullscreen = !is_fullscreen;
-					SDL_SetWindowFullscreen(window, is_fullscreen ? SDL_WINDOW_FULLSCREEN : 0);
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_PLUS || event.key.keysym.sym == SDLK_EQUALS) {
-					machine_toggle_warp();
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_a) {
-					sdcard_attach();
-					consumed = true;
-				} else if (event.key.keysym.sym == SDLK_d) {
-					sdcard_detach();
-					consumed = true;
-				}
-			}
-			if (!consumed) {
-				if (event.key.keysym.scancode == LSHORTCUT_KEY || event.key.keysym.scancode == RSHORTCUT_KEY) {
-					cmd_down = true;
-				}
-				handle_keyboard(true, event.key.keysym.sym, event.key.keysym.scancode);
-			}
-			return true;
-		}
-		if (event.type == SDL_KEYUP) {
-			if (event.key.keysym.scancode == LSHORTCUT_KEY || event.key.keysym.scancode == RSHORTCUT_KEY) {
-				cmd_down = false;
-			}
-			handle_keyboard(false, event.key.keysym.sym, event.key.keysym.scancode);
+		if (video_machine_event(&event)) {
 			return true;
 		}
-		if (event.type == SDL_MOUSEBUTTONDOWN) {
-			switch (event.button.button) {
-				case SDL_BUTTON_LEFT:
-					mouse_button_down(0);
-					break;
-				case SDL_BUTTON_RIGHT:
-					mouse_button_down(1);
-					break;
-			}
-		}
-		if (event.type == SDL_MOUSEBUTTONUP) {
-			switch (event.button.button) {
-				case SDL_BUTTON_LEFT:
-					mouse_button_up(0);
-					break;
-				case SDL_BUTTON_RIGHT:
-					mouse_button_up(1);
-					break;
-			}
-		}
-		if (event.type == SDL_MOUSEMOTION) {
-			static int mouse_x;
-			static int mouse_y;
-			mouse_move(event.motion.x - mouse_x, event.motion.y - mouse_y);
-			mouse_x = event.motion.x;
-			mouse_y = event.motion.y;
-		}
 	}
 	return true;
 }
@@ -1183,8 +1623,16 @@ video_end()
 		record_gif = RECORD_GIF_DISABLED;
 	}
 
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	if (present.thread) {
+		SDL_DestroyCond(present.cond);
+		SDL_DestroyMutex(present.lock);
+		present.thread = false;
+	}
+
+	if (!headless) {
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+	}
 }
 
 
@@ -1210,8 +1658,8 @@ static const int increments[32] = {
 uint32_t
 get_and_inc_address(uint8_t sel)
 {
-	uint32_t address = io_addr[sel];
-	io_addr[sel] += increments[io_inc[sel]];
+	uint32_t address = vera.io_addr[sel];
+	vera.io_addr[sel] += increments[vera.io_inc[sel]];
 	return address;
 }
 
@@ -1222,14 +1670,14 @@ get_and_inc_address(uint8_t sel)
 uint8_t
 video_space_read(uint32_t address)
 {
-	return video_ram[address & 0x1FFFF];
+	return vera.video_ram[address & 0x1FFFF];
 }
 
 static void
 video_space_read_range(uint8_t* dest, uint32_t address, uint32_t size)
 {
 	if (address >= ADDR_VRAM_START && (address+size) <= ADDR_VRAM_END) {
-		memcpy(dest, &video_ram[address], size);
+		memcpy(dest, &vera.video_ram[address], size);
 	} else {
 		for(int i = 0; i < size; ++i) {
 			*dest++ = video_space_read(address + i);
@@ -1240,15 +1688,15 @@ video_space_read_range(uint8_t* dest, uint32_t address, uint32_t size)
 void
 video_space_write(uint32_t address, uint8_t value)
 {
-	video_ram[address & 0x1FFFF] = value;
+	vera.video_ram[address & 0x1FFFF] = value;
 
 	if (address >= ADDR_PSG_START && address < ADDR_PSG_END) {
 		psg_writereg(address & 0x3f, value);
 	} else if (address >= ADDR_PALETTE_START && address < ADDR_PALETTE_END) {
-		palette[address & 0x1ff] = value;
-		video_palette.dirty = true;
+		vera.palette[address & 0x1ff] = value;
+		vera.video_palette.dirty = true;
 	} else if (address >= ADDR_SPRDATA_START && address < ADDR_SPRDATA_END) {
-		sprite_data[(address >> 3) & 0x7f][address & 0x7] = value;
+		vera.sprite_data[(address >> 3) & 0x7f][address & 0x7] = value;
 		refresh_sprite_properties((address >> 3) & 0x7f);
 	}
 }
@@ -1260,34 +1708,34 @@ video_space_write(uint32_t address, uint8_t value)
 
 uint8_t video_read(uint8_t reg, bool debugOn) {
 	switch (reg & 0x1F) {
-		case 0x00: return io_addr[io_addrsel] & 0xff;
-		case 0x01: return (io_addr[io_addrsel] >> 8) & 0xff;
-		case 0x02: return (io_addr[io_addrsel] >> 16) | (io_inc[io_addrsel] << 3);
+		case 0x00: return vera.io_addr[vera.io_addrsel] & 0xff;
+		case 0x01: return (vera.io_addr[vera.io_addrsel] >> 8) & 0xff;
+		case 0x02: return (vera.io_addr[vera.io_addrsel] >> 16) | (vera.io_inc[vera.io_addrsel] << 3);
 		case 0x03:
 		case 0x04: {
 			if (debugOn) {
-				return io_rddata[reg - 3];
+				return vera.io_rddata[reg - 3];
 			}
 
 			uint32_t address = get_and_inc_address(reg - 3);
 
-			uint8_t value = io_rddata[reg - 3];
-			io_rddata[reg - 3] = video_space_read(io_addr[reg - 3]);
+			uint8_t value = vera.io_rddata[reg - 3];
+			vera.io_rddata[reg - 3] = video_space_read(vera.io_addr[reg - 3]);
 
 			if (log_video) {
 				printf("READ  video_space[$%X] = $%02X\n", address, value);
 			}
 			return value;
 		}
-		case 0x05: return (io_dcsel << 1) | io_addrsel;
-		case 0x06: return ((irq_line & 0x100) >> 1) | (ien & 0xF);
-		case 0x07: return isr | (pcm_is_fifo_almost_empty() ? 8 : 0);
-		case 0x08: return irq_line & 0xFF;
+		case 0x05: return (vera.io_dcsel << 1) | vera.io_addrsel;
+		case 0x06: return ((vera.irq_line & 0x100) >> 1) | (vera.ien & 0xF);
+		case 0x07: return vera.isr | (pcm_is_fifo_almost_empty() ? 8 : 0);
+		case 0x08: return vera.irq_line & 0xFF;
 
 		case 0x09:
 		case 0x0A:
 		case 0x0B:
-		case 0x0C: return reg_composer[reg - 0x09 + (io_dcsel ? 4 : 0)];
+		case 0x0C: return vera.reg_composer[reg - 0x09 + (vera.io_dcsel ? 4 : 0)];
 
 		case 0x0D:
 		case 0x0E:
@@ -1295,7 +1743,7 @@ uint8_t video_read(uint8_t reg, bool debugOn) {
 		case 0x10:
 		case 0x11:
 		case 0x12:
-		case 0x13: return reg_layer[0][reg - 0x0D];
+		case 0x13: return vera.reg_layer[0][reg - 0x0D];
 
 		case 0x14:
 		case 0x15:
@@ -1303,7 +1751,7 @@ uint8_t video_read(uint8_t reg, bool debugOn) {
 		case 0x17:
 		case 0x18:
 		case 0x19:
-		case 0x1A: return reg_layer[1][reg - 0x14];
+		case 0x1A: return vera.reg_layer[1][reg - 0x14];
 
 		case 0x1B: return pcm_read_ctrl();
 		case 0x1C: return pcm_read_rate();
@@ -1322,17 +1770,17 @@ void video_write(uint8_t reg, uint8_t value) {
 	//	printf("ioregisters[%d] = $%02X\n", reg, value);
 	switch (reg & 0x1F) {
 		case 0x00:
-			io_addr[io_addrsel] = (io_addr[io_addrsel] & 0x1ff00) | value;
-			io_rddata[io_addrsel] = video_space_read(io_addr[io_addrsel]);
+			vera.io_addr[vera.io_addrsel] = (vera.io_addr[vera.io_addrsel] & 0x1ff00) | value;
+			vera.io_rddata[vera.io_addrsel] = video_space_read(vera.io_addr[vera.io_addrsel]);
 			break;
 		case 0x01:
-			io_addr[io_addrsel] = (io_addr[io_addrsel] & 0x100ff) | (value << 8);
-			io_rddata[io_addrsel] = video_space_read(io_addr[io_addrsel]);
+			vera.io_addr[vera.io_addrsel] = (vera.io_addr[vera.io_addrsel] & 0x100ff) | (value << 8);
+			vera.io_rddata[vera.io_addrsel] = video_space_read(vera.io_addr[vera.io_addrsel]);
 			break;
 		case 0x02:
-			io_addr[io_addrsel] = (io_addr[io_addrsel] & 0x0ffff) | ((value & 0x1) << 16);
-			io_inc[io_addrsel]  = value >> 3;
-			io_rddata[io_addrsel] = video_space_read(io_addr[io_addrsel]);
+			vera.io_addr[vera.io_addrsel] = (vera.io_addr[vera.io_addrsel] & 0x0ffff) | ((value & 0x1) << 16);
+			vera.io_inc[vera.io_addrsel]  = value >> 3;
+			vera.io_rddata[vera.io_addrsel] = video_space_read(vera.io_addr[vera.io_addrsel]);
 			break;
 		case 0x03:
 		case 0x04: {
@@ -1342,35 +1790,35 @@ void video_write(uint8_t reg, uint8_t value) {
 			}
 			video_space_write(address, value);
 
-			io_rddata[reg - 3] = video_space_read(io_addr[reg - 3]);
+			vera.io_rddata[reg - 3] = video_space_read(vera.io_addr[reg - 3]);
 			break;
 		}
 		case 0x05:
 			if (value & 0x80) {
 				video_reset();
 			}
-			io_dcsel = (value >> 1) & 1;
-			io_addrsel = value & 1;
+			vera.io_dcsel = (value >> 1) & 1;
+			vera.io_addrsel = value & 1;
 			break;
 		case 0x06:
-			irq_line = (irq_line & 0xFF) | ((value >> 7) << 8);
-			ien = value & 0xF;
+			vera.irq_line = (vera.irq_line & 0xFF) | ((value >> 7) << 8);
+			vera.ien = value & 0xF;
 			break;
 		case 0x07:
-			isr &= value ^ 0xff;
+			vera.isr &= value ^ 0xff;
 			break;
 		case 0x08:
-			irq_line = (irq_line & 0x100) | value;
+			vera.irq_line = (vera.irq_line & 0x100) | value;
 			break;
 
 		case 0x09:
 		case 0x0A:
 		case 0x0B:
 		case 0x0C: {
-			int i = reg - 0x09 + (io_dcsel ? 4 : 0);
-			reg_composer[i] = value;
+			int i = reg - 0x09 + (vera.io_dcsel ? 4 : 0);
+			vera.reg_composer[i] = value;
 			if (i == 0) {
-				video_palette.dirty = true;
+				vera.video_palette.dirty = true;
 			}
 			break;
 		}
@@ -1382,7 +1830,7 @@ void video_write(uint8_t reg, uint8_t value) {
 		case 0x11:
 		case 0x12:
 		case 0x13:
-			reg_layer[0][reg - 0x0D] = value;
+			vera.reg_layer[0][reg - 0x0D] = value;
 			refresh_layer_properties(0);
 			break;
 
@@ -1393,7 +1841,7 @@ void video_write(uint8_t reg, uint8_t value) {
 		case 0x18:
 		case 0x19:
 		case 0x1A:
-			reg_layer[1][reg - 0x14] = value;
+			vera.reg_layer[1][reg - 0x14] = value;
 			refresh_layer_properties(1);
 			break;
 
@@ -1411,13 +1859,20 @@ void video_write(uint8_t reg, uint8_t value) {
 void
 video_update_title(const char* window_title)
 {
-	SDL_SetWindowTitle(window, window_title);
+	if (present.thread) {
+		SDL_LockMutex(present.lock);
+		snprintf(present.title, sizeof(present.title), "%s", window_title);
+		present.title_changed = true;
+		SDL_UnlockMutex(present.lock);
+	} else if (!headless) {
+		SDL_SetWindowTitle(window, window_title);
+	}
 }
 
 bool video_is_tilemap_address(int addr)
 {
 	for (int l = 0; l < 2; ++l) {
-		struct video_layer_properties *props = &layer_properties[l];
+		struct video_layer_properties *props = &vera.layer_properties[l];
 		if (addr < props->map_base) {
 			continue;
 		}
@@ -1433,7 +1888,7 @@ bool video_is_tilemap_address(int addr)
 bool video_is_tiledata_address(int addr)
 {
 	for (int l = 0; l < 2; ++l) {
-		struct video_layer_properties *props = &layer_properties[l];
+		struct video_layer_properties *props = &vera.layer_properties[l];
 		if (addr < props->tile_base) {
 			continue;
 		}
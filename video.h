@@ -11,12 +11,128 @@
 #include <SDL.h>
 #include "glue.h"
 
+// visible area we're drawing
+#define SCREEN_WIDTH 640
+#define SCREEN_HEIGHT 480
+
+struct video_layer_properties
+{
+	uint8_t color_depth;
+	uint32_t map_base;
+	uint32_t tile_base;
+
+	bool text_mode;
+	bool text_mode_256c;
+	bool tile_mode;
+	bool bitmap_mode;
+
+	uint16_t hscroll;
+	uint16_t vscroll;
+
+	uint8_t  mapw_log2;
+	uint8_t  maph_log2;
+	uint16_t tilew;
+	uint16_t tileh;
+	uint8_t  tilew_log2;
+	uint8_t  tileh_log2;
+
+	uint16_t mapw_max;
+	uint16_t maph_max;
+	uint16_t tilew_max;
+	uint16_t tileh_max;
+	uint16_t layerw_max;
+	uint16_t layerh_max;
+
+	uint8_t tile_size_log2;
+
+	int min_eff_x;
+	int max_eff_x;
+
+	uint8_t bits_per_pixel;
+	uint8_t first_color_pos;
+	uint8_t color_mask;
+	uint8_t color_fields_max;
+};
+
+struct video_sprite_properties
+{
+	int8_t sprite_zdepth;
+	uint8_t sprite_collision_mask;
+
+	int16_t sprite_x;
+	int16_t sprite_y;
+	uint8_t sprite_width_log2;
+	uint8_t sprite_height_log2;
+	uint8_t sprite_width;
+	uint8_t sprite_height;
+
+	bool hflip;
+	bool vflip;
+
+	uint8_t color_mode;
+	uint32_t sprite_address;
+
+	uint16_t palette_offset;
+};
+
+struct video_palette
+{
+	uint32_t entries[256];
+	bool dirty;
+};
+
+typedef struct {
+	uint8_t video_ram[0x20000];
+	uint8_t palette[256 * 2];
+	uint8_t sprite_data[128][8];
+
+	// I/O registers
+	uint32_t io_addr[2];
+	uint8_t io_rddata[2];
+	uint8_t io_inc[2];
+	uint8_t io_addrsel;
+	uint8_t io_dcsel;
+
+	uint8_t ien;
+	uint8_t isr;
+
+	uint16_t irq_line;
+
+	uint8_t reg_layer[2][7];
+	uint8_t reg_composer[8];
+
+	uint8_t layer_line[2][SCREEN_WIDTH];
+	uint8_t sprite_line_col[SCREEN_WIDTH];
+	uint8_t sprite_line_z[SCREEN_WIDTH];
+	uint8_t sprite_line_mask[SCREEN_WIDTH];
+	uint8_t sprite_line_collisions;
+	bool layer_line_enable[2];
+	bool sprite_line_enable;
+
+	uint32_t scan_pos_x;
+	uint16_t scan_pos_y;
+	int frame_count;
+
+	uint8_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT * 4];
+
+	struct video_layer_properties layer_properties[2];
+	struct video_sprite_properties sprite_properties[128];
+	struct video_palette video_palette;
+} video_state_t;
+
 bool video_init(int window_scale, char *quality);
 void video_reset(void);
-bool video_step(float mhz);
+bool video_step(float mhz, uint32_t cycles);
+uint32_t video_cycles_to_line(float mhz);
 bool video_update(void);
+bool video_idle(void);
+bool video_threaded(void);
+void video_present_loop(void);
+void video_present_stop(void);
 void video_end(void);
 bool video_get_irq_out(void);
+void video_render_screen(void);
+void video_set_offscreen(bool compose, uint8_t *indices);
 void video_save(SDL_RWops *f);
 uint8_t video_read(uint8_t reg, bool debugOn);
 void video_write(uint8_t reg, uint8_t value);
@@ -0,0 +1,87 @@
+// Commander X16 Emulator
+// Copyright (c) 2019 Michael Steil
+// All rights reserved. License: 2-clause BSD
+
+#ifndef _X16EMU_H_
+#define _X16EMU_H_
+
+// The C API of libx16emu.a: the emulator without a window, sound device or
+// debugger, to be run by another program. Any number of machines can exist
+// at once, and machines can run on different threads, as long as each one
+// is only used by one thread at a time. They all share the SD card image,
+// taking turns for its blocks; the first x16emu_attach_sdcard() opens it and
+// has to return before machines on other threads run.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define X16EMU_SCREEN_WIDTH 640
+#define X16EMU_SCREEN_HEIGHT 480
+#define X16EMU_CLOCK 8000000 // CPU cycles per second
+#define X16EMU_SAMPLE_RATE (25000000 / 512) // stereo frames per second
+
+// SNES controller buttons for x16emu_joystick()
+#define X16EMU_BUTTON_B      (1 << 0)
+#define X16EMU_BUTTON_Y      (1 << 1)
+#define X16EMU_BUTTON_SELECT (1 << 2)
+#define X16EMU_BUTTON_START  (1 << 3)
+#define X16EMU_BUTTON_UP     (1 << 4)
+#define X16EMU_BUTTON_DOWN   (1 << 5)
+#define X16EMU_BUTTON_LEFT   (1 << 6)
+#define X16EMU_BUTTON_RIGHT  (1 << 7)
+#define X16EMU_BUTTON_A      (1 << 8)
+#define X16EMU_BUTTON_X      (1 << 9)
+#define X16EMU_BUTTON_L      (1 << 10)
+#define X16EMU_BUTTON_R      (1 << 11)
+
+typedef struct x16emu x16emu_t;
+
+typedef struct {
+	uint16_t pc;
+	uint8_t a, x, y, sp, status;
+	bool waiting; // in WAI
+	uint64_t clocks; // cycles run since the machine was created
+} x16emu_cpu_t;
+
+// the machine: 512 KB of banked RAM and no ROM until one is loaded
+x16emu_t *x16emu_create(void);
+void x16emu_destroy(x16emu_t *emu);
+bool x16emu_load_rom(x16emu_t *emu, const char *path); // and reset
+bool x16emu_load_prg(x16emu_t *emu, const char *path, int start); // start -1: from the file
+bool x16emu_attach_sdcard(x16emu_t *emu, const char *path);
+void x16emu_reset(x16emu_t *emu);
+bool x16emu_save_state(x16emu_t *emu, const char *path);
+bool x16emu_load_state(x16emu_t *emu, const char *path);
+
+// running: both return the number of frames completed
+uint32_t x16emu_run_cycles(x16emu_t *emu, uint32_t cycles); // at least that many
+uint32_t x16emu_run_frames(x16emu_t *emu, uint32_t frames);
+void x16emu_get_cpu(x16emu_t *emu, x16emu_cpu_t *cpu);
+
+// memory as the CPU sees it; bank selects the RAM bank at $A000-$BFFF and
+// the ROM bank at $C000-$FFFF, I/O reads have no side effects
+uint8_t x16emu_peek(x16emu_t *emu, uint16_t address, uint8_t bank);
+void x16emu_poke(x16emu_t *emu, uint16_t address, uint8_t bank, uint8_t value);
+uint8_t x16emu_peek_vram(x16emu_t *emu, uint32_t address);
+void x16emu_poke_vram(x16emu_t *emu, uint32_t address, uint8_t value);
+
+// The last frame, as 0x00RRGGBB pixels or as palette indices. Rendering can
+// be turned off to run faster.
+void x16emu_set_rendering(x16emu_t *emu, bool render);
+const uint32_t *x16emu_framebuffer_rgb(x16emu_t *emu);
+const uint8_t *x16emu_framebuffer_indexed(x16emu_t *emu);
+
+// input: keys by SDL scancode, text typed into the KERNAL's keyboard buffer
+// while the machine runs, relative mouse movement with buttons as bits 0-2
+// (left, right, middle), and the SNES buttons pressed on port 0 or 1
+void x16emu_key(x16emu_t *emu, int scancode, bool down);
+bool x16emu_type(x16emu_t *emu, const char *utf8);
+void x16emu_mouse(x16emu_t *emu, int dx, int dy, int buttons);
+void x16emu_joystick(x16emu_t *emu, int port, uint16_t buttons);
+
+// Takes up to frames stereo frames of the sound produced since the last
+// call; the oldest are lost if they aren't taken in time.
+size_t x16emu_read_audio(x16emu_t *emu, int16_t *samples, size_t frames);
+
+#endif